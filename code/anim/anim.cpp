@@ -5,41 +5,49 @@
 
 SRL_TYPE_DEFINE( ANIMSkel );
 SRL_TYPE_DEFINE( ANIMClip );
+SRL_TYPE_DEFINE( ANIMClipStream );
 
-ANIMContext* ContextInit( const ANIMSkel& skel, BXIAllocator* allocator )
+ANIMContext* ContextInit( const ANIMSkel& skel, BXIAllocator* allocator, uint32_t pose_stack_size, uint32_t cmd_array_size )
 {
 	const uint32_t poseMemorySize = skel.numJoints * sizeof( ANIMJoint );
 	
 	uint32_t memSize = 0;
 	memSize += sizeof( ANIMContext );
+	memSize += sizeof( ANIMJoint* ) * pose_stack_size;
+	memSize = (uint32_t)TYPE_ALIGN( memSize, 16 );
 	memSize += poseMemorySize * ANIMContext::ePOSE_CACHE_SIZE;
-	memSize += poseMemorySize * ANIMContext::ePOSE_STACK_SIZE;
-	memSize += sizeof( Cmd ) * ANIMContext::eCMD_ARRAY_SIZE;
+	memSize += poseMemorySize * pose_stack_size;
+	memSize += sizeof( Cmd ) * cmd_array_size;
 
 	uint8_t* memory = (uint8_t*)BX_MALLOC( allocator, memSize, 16 );
 	memset( memory, 0, memSize );
 
-	ANIMContext* ctx = (ANIMContext*)memory;
+	ANIMContext* ctx = new( memory ) ANIMContext();
 
 	uint8_t* current_pointer = memory + sizeof(ANIMContext);
+	ctx->poseStack = (ANIMJoint**)current_pointer;
+	current_pointer = (uint8_t*)TYPE_ALIGN( current_pointer + sizeof( ANIMJoint* ) * pose_stack_size, 16 );
+
 	for( uint32_t i = 0; i < ANIMContext::ePOSE_CACHE_SIZE; ++i )
 	{
 		ctx->poseCache[i] = (ANIMJoint*)current_pointer;
 		current_pointer += poseMemorySize;
 	}
 
-	for( uint32_t i = 0; i < ANIMContext::ePOSE_STACK_SIZE; ++i )
+	for( uint32_t i = 0; i < pose_stack_size; ++i )
 	{
 		ctx->poseStack[i] = (ANIMJoint*)current_pointer;
 		current_pointer += poseMemorySize;
 	}
 
 	ctx->cmdArray = (Cmd*)current_pointer;
-	current_pointer += sizeof(Cmd) * ANIMContext::eCMD_ARRAY_SIZE;
+	current_pointer += sizeof(Cmd) * cmd_array_size;
 	SYS_ASSERT( (uintptr_t)current_pointer == (uintptr_t)( memory + memSize ) );
     ctx->numJoints = skel.numJoints;
+    ctx->poseStackSize = pose_stack_size;
+    ctx->cmdArrayCapacity = cmd_array_size;
 
-    for( uint32_t i = 0; i < ANIMContext::ePOSE_STACK_SIZE; ++i )
+    for( uint32_t i = 0; i < pose_stack_size; ++i )
     {
         ANIMJoint* joints = ctx->poseStack[i];
         for( uint32_t j = 0; j < skel.numJoints; ++j )
@@ -147,14 +155,12 @@ namespace anim_ext
 
     void LocalJointsToWorldJoints( ANIMJoint* outJoints, const ANIMJoint* inJoints, const ANIMSkel* skel, const ANIMJoint& rootJoint )
     {
-        const uint16_t* parentIndices = TYPE_OFFSET_GET_POINTER( const uint16_t, skel->offsetParentIndices );
-        LocalJointsToWorldJoints( outJoints, inJoints, parentIndices, skel->numJoints, rootJoint );
+        ::LocalJointsToWorldJoints( outJoints, inJoints, skel, rootJoint );
     }
 
     void LocalJointsToWorldMatrices( mat44_t* outMatrices, const ANIMJoint* inJoints, const ANIMSkel* skel, const ANIMJoint& rootJoint )
     {
-        const uint16_t* parentIndices = TYPE_OFFSET_GET_POINTER( const uint16_t, skel->offsetParentIndices );
-        LocalJointsToWorldMatrices4x4( outMatrices, inJoints, parentIndices, skel->numJoints, rootJoint );
+        LocalJointsToWorldMatrices4x4( outMatrices, inJoints, skel, rootJoint );
     }
 
     void ProcessBlendTree( ANIMContext* ctx, uint16_t root_index, const ANIMBlendBranch* blend_branches, unsigned num_branches, const ANIMBlendLeaf* blend_leaves, unsigned num_leaves )
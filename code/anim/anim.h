@@ -4,12 +4,19 @@
 #include "anim_struct.h"
 #include "anim_common.h"
 
-ANIMContext* ContextInit( const ANIMSkel& skel, BXIAllocator* allocator );
+ANIMContext* ContextInit( const ANIMSkel& skel, BXIAllocator* allocator, uint32_t pose_stack_size = ANIMContext::ePOSE_STACK_SIZE, uint32_t cmd_array_size = ANIMContext::eCMD_ARRAY_SIZE );
 void ContextDeinit( ANIMContext** ctx );
 
+// Compiles tree into context command list. List can be evaluated many times as long as tree arrays are alive,
+// weights are read during evaluation so subtrees with zero weight are skipped without recompiling.
+void CompileBlendTree( ANIMContext* ctx, const ANIMBlendTree& tree );
 void EvaluateBlendTree( ANIMContext* ctx, const uint16_t root_index , const ANIMBlendBranch* blend_branches, uint32_t num_branches, const ANIMBlendLeaf* blend_leaves, uint32_t num_leaves );
 void EvaluateCommandList( ANIMContext* ctx );
 void BlendJointsLinear( ANIMJoint* out_joints, const ANIMJoint* left_joints, const ANIMJoint* right_joints, float blend_factor, uint32_t num_joints);
+void BlendJointsLinearMasked( ANIMJoint* out_joints, const ANIMJoint* left_joints, const ANIMJoint* right_joints, float blend_factor, const float* mask, uint32_t num_joints );
+
+// rotation = base * delta, position = base + delta, scale = base * delta, weighted by blend_factor (and mask when not null)
+void BlendJointsAdditive( ANIMJoint* out_joints, const ANIMJoint* base_joints, const ANIMJoint* delta_joints, float blend_factor, const float* mask, uint32_t num_joints );
 
 void EvaluateClip( ANIMJoint* out_joints, const ANIMClip* anim, float eval_time, uint32_t beginJoint = UINT32_MAX, uint32_t endJoint = UINT32_MAX );
 void EvaluateClip( ANIMJoint* out_joints, const ANIMClip* anim, uint32_t frame_integer, float frame_fraction, uint32_t beginJoint = UINT32_MAX, uint32_t endJoint = UINT32_MAX );
@@ -22,6 +29,10 @@ void EvaluateClipIndexed( ANIMJoint* out_joints, const ANIMClip* anim, uint32_t
 void LocalJointsToWorldMatrices4x4( mat44_t* out_matrices, const ANIMJoint* in_joints, const uint16_t* parent_indices, uint32_t count, const ANIMJoint& root_joint );
 void LocalJointsToWorldJoints( ANIMJoint* out_joints, const ANIMJoint* in_joints, const uint16_t* parent_indices, uint32_t count, const ANIMJoint& root_joint );
 
+// level scheduled versions, joints of the same depth are transformed 4 at once (SSE)
+void LocalJointsToWorldMatrices4x4( mat44_t* out_matrices, const ANIMJoint* in_joints, const ANIMSkel* skel, const ANIMJoint& root_joint );
+void LocalJointsToWorldJoints( ANIMJoint* out_joints, const ANIMJoint* in_joints, const ANIMSkel* skel, const ANIMJoint& root_joint );
+
 
 namespace anim_ext 
 {
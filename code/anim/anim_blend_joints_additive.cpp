@@ -0,0 +1,23 @@
+#include "anim.h"
+#include <foundation/math/vmath.h>
+#include <foundation/common.h>
+
+void BlendJointsAdditive( ANIMJoint* outJoints, const ANIMJoint* baseJoints, const ANIMJoint* deltaJoints, float blendFactor, const float* mask, uint32_t numJoints )
+{
+    const quat_t identity_rotation = quat_t::identity();
+    const vec4_t identity_scale( 1.f );
+
+    for( uint32_t i = 0; i < numJoints; ++i )
+    {
+        const float alpha = ( mask ) ? blendFactor * mask[i] : blendFactor;
+        const ANIMJoint& base = baseJoints[i];
+        const ANIMJoint& delta = deltaJoints[i];
+
+        const quat_t delta_rotation = slerp( alpha, identity_rotation, delta.rotation );
+        const vec4_t delta_scale = lerp( alpha, identity_scale, delta.scale );
+
+        outJoints[i].rotation = normalize( base.rotation * delta_rotation );
+        outJoints[i].position = base.position + vec4_t( delta.position.xyz() * alpha, 0.f );
+        outJoints[i].scale = mul_per_elem( base.scale, delta_scale );
+    }
+}
@@ -39,3 +39,17 @@ void BlendJointsLinear( ANIMJoint* outJoints, const ANIMJoint* leftJoints, const
 	} while ( ++i < numJoints );
 }
 
+
+void BlendJointsLinearMasked( ANIMJoint* outJoints, const ANIMJoint* leftJoints, const ANIMJoint* rightJoints, float blendFactor, const float* mask, uint32_t numJoints )
+{
+    for( uint32_t i = 0; i < numJoints; ++i )
+    {
+        const float alpha = blendFactor * mask[i];
+        const ANIMJoint& left = leftJoints[i];
+        const ANIMJoint& right = rightJoints[i];
+
+        outJoints[i].rotation = slerp( alpha, left.rotation, right.rotation );
+        outJoints[i].position = lerp( alpha, left.position, right.position );
+        outJoints[i].scale = lerp( alpha, left.scale, right.scale );
+    }
+}
@@ -0,0 +1,257 @@
+#include "anim.h"
+#include <foundation/debug.h>
+#include <foundation/math/vmath.h>
+#include <xmmintrin.h>
+
+//
+// Level scheduled variants of LocalJointsToWorldJoints / LocalJointsToWorldMatrices4x4.
+// Joints of one level (same depth in hierarchy) only read results of previous levels, so they are
+// transformed 4 at a time in SoA form. Level tables are built by skeleton compiler.
+//
+struct SoA4
+{
+    __m128 x, y, z, w;
+};
+
+// 4 x float4 (AoS) -> x,y,z,w (SoA)
+static VEC_FORCE_INLINE SoA4 Gather( const float* a, const float* b, const float* c, const float* d )
+{
+    __m128 r0 = _mm_loadu_ps( a );
+    __m128 r1 = _mm_loadu_ps( b );
+    __m128 r2 = _mm_loadu_ps( c );
+    __m128 r3 = _mm_loadu_ps( d );
+    _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+    return { r0, r1, r2, r3 };
+}
+
+// x,y,z,w (SoA) -> 4 x float4 (AoS)
+static VEC_FORCE_INLINE void Scatter( float* a, float* b, float* c, float* d, SoA4 v )
+{
+    _MM_TRANSPOSE4_PS( v.x, v.y, v.z, v.w );
+    _mm_storeu_ps( a, v.x );
+    _mm_storeu_ps( b, v.y );
+    _mm_storeu_ps( c, v.z );
+    _mm_storeu_ps( d, v.w );
+}
+
+#define ANIM_GATHER( ptrs, member ) Gather( (const float*)&ptrs[0]->member, (const float*)&ptrs[1]->member, (const float*)&ptrs[2]->member, (const float*)&ptrs[3]->member )
+#define ANIM_SCATTER( ptrs, member, value ) Scatter( (float*)&ptrs[0]->member, (float*)&ptrs[1]->member, (float*)&ptrs[2]->member, (float*)&ptrs[3]->member, value )
+
+static VEC_FORCE_INLINE __m128 Madd( __m128 a, __m128 b, __m128 c ) { return _mm_add_ps( _mm_mul_ps( a, b ), c ); }
+
+// indices of 4 joints from level range starting at 'i', missing lanes repeat last joint of the level
+static VEC_FORCE_INLINE void LevelBatch( uint16_t out[4], const uint16_t* level_joints, uint32_t i, uint32_t end )
+{
+    out[0] = level_joints[i];
+    out[1] = level_joints[min_of_2( i + 1, end - 1 )];
+    out[2] = level_joints[min_of_2( i + 2, end - 1 )];
+    out[3] = level_joints[min_of_2( i + 3, end - 1 )];
+}
+
+void LocalJointsToWorldJoints( ANIMJoint* out_joints, const ANIMJoint* in_joints, const ANIMSkel* skel, const ANIMJoint& root_joint )
+{
+    SYS_ASSERT( out_joints != in_joints );
+
+    const uint16_t* parent_indices = (const uint16_t*)ParentIndices( skel );
+    if( !skel->numLevels )
+    {
+        // skeleton built without level tables
+        LocalJointsToWorldJoints( out_joints, in_joints, parent_indices, skel->numJoints, root_joint );
+        return;
+    }
+
+    const uint16_t* level_joints = LevelJoints( skel );
+    const uint16_t* level_begin = LevelBegin( skel );
+
+    for( uint32_t ilevel = 0; ilevel < skel->numLevels; ++ilevel )
+    {
+        const uint32_t end = level_begin[ilevel + 1];
+        for( uint32_t i = level_begin[ilevel]; i < end; i += 4 )
+        {
+            uint16_t index[4];
+            LevelBatch( index, level_joints, i, end );
+
+            const ANIMJoint* local[4];
+            const ANIMJoint* parent[4];
+            ANIMJoint* world[4];
+            for( uint32_t k = 0; k < 4; ++k )
+            {
+                const uint16_t parent_idx = parent_indices[index[k]];
+                local[k] = in_joints + index[k];
+                parent[k] = ( parent_idx != 0xFFFF ) ? out_joints + parent_idx : &root_joint;
+                world[k] = out_joints + index[k];
+            }
+
+            const SoA4 lq = ANIM_GATHER( local, rotation );
+            const SoA4 lt = ANIM_GATHER( local, position );
+            const SoA4 ls = ANIM_GATHER( local, scale );
+            const SoA4 pq = ANIM_GATHER( parent, rotation );
+            const SoA4 pt = ANIM_GATHER( parent, position );
+            const SoA4 ps = ANIM_GATHER( parent, scale );
+
+            // rotation = normalize( parent.rotation * local.rotation )
+            SoA4 wq;
+            wq.x = _mm_sub_ps( Madd( pq.w, lq.x, Madd( lq.w, pq.x, _mm_mul_ps( pq.y, lq.z ) ) ), _mm_mul_ps( lq.y, pq.z ) );
+            wq.y = _mm_sub_ps( Madd( pq.w, lq.y, Madd( lq.w, pq.y, _mm_mul_ps( pq.z, lq.x ) ) ), _mm_mul_ps( lq.z, pq.x ) );
+            wq.z = _mm_sub_ps( Madd( pq.w, lq.z, Madd( lq.w, pq.z, _mm_mul_ps( pq.x, lq.y ) ) ), _mm_mul_ps( lq.x, pq.y ) );
+            wq.w = _mm_sub_ps( _mm_mul_ps( pq.w, lq.w ), Madd( lq.x, pq.x, Madd( pq.y, lq.y, _mm_mul_ps( lq.z, pq.z ) ) ) );
+
+            const __m128 qlen_sq = Madd( wq.x, wq.x, Madd( wq.y, wq.y, Madd( wq.z, wq.z, _mm_mul_ps( wq.w, wq.w ) ) ) );
+            const __m128 qlen_inv = _mm_div_ps( _mm_set1_ps( 1.f ), _mm_sqrt_ps( qlen_sq ) );
+            wq.x = _mm_mul_ps( wq.x, qlen_inv );
+            wq.y = _mm_mul_ps( wq.y, qlen_inv );
+            wq.z = _mm_mul_ps( wq.z, qlen_inv );
+            wq.w = _mm_mul_ps( wq.w, qlen_inv );
+
+            // scale = local.scale * parent.scale
+            const SoA4 ws = { _mm_mul_ps( ls.x, ps.x ), _mm_mul_ps( ls.y, ps.y ), _mm_mul_ps( ls.z, ps.z ), _mm_mul_ps( ls.w, ps.w ) };
+
+            // position = parent.position + rotate( parent.rotation, local.position * parent.scale )
+            const __m128 two = _mm_set1_ps( 2.f );
+            const __m128 vx = _mm_mul_ps( two, _mm_mul_ps( lt.x, ps.x ) );
+            const __m128 vy = _mm_mul_ps( two, _mm_mul_ps( lt.y, ps.y ) );
+            const __m128 vz = _mm_mul_ps( two, _mm_mul_ps( lt.z, ps.z ) );
+            const __m128 w2 = _mm_sub_ps( _mm_mul_ps( pq.w, pq.w ), _mm_set1_ps( 0.5f ) );
+            const __m128 dot2 = Madd( pq.x, vx, Madd( pq.y, vy, _mm_mul_ps( pq.z, vz ) ) );
+
+            SoA4 wt;
+            wt.x = _mm_add_ps( pt.x, Madd( vx, w2, Madd( _mm_sub_ps( _mm_mul_ps( pq.y, vz ), _mm_mul_ps( pq.z, vy ) ), pq.w, _mm_mul_ps( pq.x, dot2 ) ) ) );
+            wt.y = _mm_add_ps( pt.y, Madd( vy, w2, Madd( _mm_sub_ps( _mm_mul_ps( pq.z, vx ), _mm_mul_ps( pq.x, vz ) ), pq.w, _mm_mul_ps( pq.y, dot2 ) ) ) );
+            wt.z = _mm_add_ps( pt.z, Madd( vz, w2, Madd( _mm_sub_ps( _mm_mul_ps( pq.x, vy ), _mm_mul_ps( pq.y, vx ) ), pq.w, _mm_mul_ps( pq.z, dot2 ) ) ) );
+            wt.w = pt.w;
+
+            ANIM_SCATTER( world, rotation, wq );
+            ANIM_SCATTER( world, position, wt );
+            ANIM_SCATTER( world, scale, ws );
+        }
+    }
+}
+
+void LocalJointsToWorldMatrices4x4( mat44_t* out_matrices, const ANIMJoint* in_joints, const ANIMSkel* skel, const ANIMJoint& root_joint )
+{
+    if( !skel->numLevels )
+    {
+        LocalJointsToWorldMatrices4x4( out_matrices, in_joints, (const uint16_t*)ParentIndices( skel ), skel->numJoints, root_joint );
+        return;
+    }
+
+    mat44_t root = mat44_t( root_joint.rotation, root_joint.position );
+    root.c0 *= root_joint.scale.x;
+    root.c1 *= root_joint.scale.y;
+    root.c2 *= root_joint.scale.z;
+
+    const uint16_t* parent_indices = (const uint16_t*)ParentIndices( skel );
+    const uint16_t* level_joints = LevelJoints( skel );
+    const uint16_t* level_begin = LevelBegin( skel );
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps( 1.f );
+
+    for( uint32_t ilevel = 0; ilevel < skel->numLevels; ++ilevel )
+    {
+        const uint32_t end = level_begin[ilevel + 1];
+        for( uint32_t i = level_begin[ilevel]; i < end; i += 4 )
+        {
+            uint16_t index[4];
+            LevelBatch( index, level_joints, i, end );
+
+            const ANIMJoint* local[4];
+            const ANIMJoint* parent_local[4];
+            const mat44_t* parent[4];
+            mat44_t* world[4];
+            for( uint32_t k = 0; k < 4; ++k )
+            {
+                const uint16_t parent_idx = parent_indices[index[k]];
+                const bool is_root = parent_idx == 0xFFFF;
+                local[k] = in_joints + index[k];
+                parent_local[k] = ( is_root ) ? &root_joint : in_joints + parent_idx;
+                parent[k] = ( is_root ) ? &root : out_matrices + parent_idx;
+                world[k] = out_matrices + index[k];
+            }
+
+            const SoA4 p0 = ANIM_GATHER( parent, c0 );
+            const SoA4 p1 = ANIM_GATHER( parent, c1 );
+            const SoA4 p2 = ANIM_GATHER( parent, c2 );
+            const SoA4 p3 = ANIM_GATHER( parent, c3 );
+
+            const SoA4 lq = ANIM_GATHER( local, rotation );
+            const SoA4 lt = ANIM_GATHER( local, position );
+            const SoA4 ls = ANIM_GATHER( local, scale );
+            const SoA4 ps = ANIM_GATHER( parent_local, scale );
+
+            // local rotation matrix (see mat33_t( const quat_t& ))
+            const __m128 x2 = _mm_add_ps( lq.x, lq.x );
+            const __m128 y2 = _mm_add_ps( lq.y, lq.y );
+            const __m128 z2 = _mm_add_ps( lq.z, lq.z );
+            const __m128 xx = _mm_mul_ps( x2, lq.x );
+            const __m128 yy = _mm_mul_ps( y2, lq.y );
+            const __m128 zz = _mm_mul_ps( z2, lq.z );
+            const __m128 xy = _mm_mul_ps( x2, lq.y );
+            const __m128 xz = _mm_mul_ps( x2, lq.z );
+            const __m128 xw = _mm_mul_ps( x2, lq.w );
+            const __m128 yz = _mm_mul_ps( y2, lq.z );
+            const __m128 yw = _mm_mul_ps( y2, lq.w );
+            const __m128 zw = _mm_mul_ps( z2, lq.w );
+
+            SoA4 r0 = { _mm_sub_ps( _mm_sub_ps( one, yy ), zz ), _mm_add_ps( xy, zw ), _mm_sub_ps( xz, yw ), zero };
+            SoA4 r1 = { _mm_sub_ps( xy, zw ), _mm_sub_ps( _mm_sub_ps( one, xx ), zz ), _mm_add_ps( yz, xw ), zero };
+            SoA4 r2 = { _mm_add_ps( xz, yw ), _mm_sub_ps( yz, xw ), _mm_sub_ps( _mm_sub_ps( one, xx ), yy ), zero };
+
+            // worldMatrix = worldParent * localTranslate * localScaleCompensate * localRotation * localScale
+            SoA4 a0 = p0, a1 = p1, a2 = p2;
+            const __m128 uniform_local = _mm_and_ps( _mm_cmpeq_ps( ls.x, ls.y ), _mm_cmpeq_ps( ls.x, ls.z ) );
+            const __m128 uniform_parent = _mm_and_ps( _mm_cmpeq_ps( ps.x, ps.y ), _mm_cmpeq_ps( ps.x, ps.z ) );
+            if( _mm_movemask_ps( _mm_and_ps( uniform_local, uniform_parent ) ) == 0xF )
+            {
+                // uniform scale: compensation and local scale collapse to single factor
+                const __m128 f = _mm_div_ps( ls.x, ps.x );
+                r0.x = _mm_mul_ps( r0.x, f ); r0.y = _mm_mul_ps( r0.y, f ); r0.z = _mm_mul_ps( r0.z, f );
+                r1.x = _mm_mul_ps( r1.x, f ); r1.y = _mm_mul_ps( r1.y, f ); r1.z = _mm_mul_ps( r1.z, f );
+                r2.x = _mm_mul_ps( r2.x, f ); r2.y = _mm_mul_ps( r2.y, f ); r2.z = _mm_mul_ps( r2.z, f );
+            }
+            else
+            {
+                const __m128 cx = _mm_div_ps( one, ps.x );
+                const __m128 cy = _mm_div_ps( one, ps.y );
+                const __m128 cz = _mm_div_ps( one, ps.z );
+                a0.x = _mm_mul_ps( a0.x, cx ); a0.y = _mm_mul_ps( a0.y, cx ); a0.z = _mm_mul_ps( a0.z, cx );
+                a1.x = _mm_mul_ps( a1.x, cy ); a1.y = _mm_mul_ps( a1.y, cy ); a1.z = _mm_mul_ps( a1.z, cy );
+                a2.x = _mm_mul_ps( a2.x, cz ); a2.y = _mm_mul_ps( a2.y, cz ); a2.z = _mm_mul_ps( a2.z, cz );
+
+                r0.x = _mm_mul_ps( r0.x, ls.x ); r0.y = _mm_mul_ps( r0.y, ls.x ); r0.z = _mm_mul_ps( r0.z, ls.x );
+                r1.x = _mm_mul_ps( r1.x, ls.y ); r1.y = _mm_mul_ps( r1.y, ls.y ); r1.z = _mm_mul_ps( r1.z, ls.y );
+                r2.x = _mm_mul_ps( r2.x, ls.z ); r2.y = _mm_mul_ps( r2.y, ls.z ); r2.z = _mm_mul_ps( r2.z, ls.z );
+            }
+
+            auto transform_column = [&]( const SoA4& r ) -> SoA4
+            {
+                return {
+                    Madd( a0.x, r.x, Madd( a1.x, r.y, _mm_mul_ps( a2.x, r.z ) ) ),
+                    Madd( a0.y, r.x, Madd( a1.y, r.y, _mm_mul_ps( a2.y, r.z ) ) ),
+                    Madd( a0.z, r.x, Madd( a1.z, r.y, _mm_mul_ps( a2.z, r.z ) ) ),
+                    zero
+                };
+            };
+
+            const SoA4 w0 = transform_column( r0 );
+            const SoA4 w1 = transform_column( r1 );
+            const SoA4 w2 = transform_column( r2 );
+
+            // translation goes through uncompensated parent
+            const SoA4 w3 = {
+                Madd( p0.x, lt.x, Madd( p1.x, lt.y, Madd( p2.x, lt.z, _mm_mul_ps( p3.x, lt.w ) ) ) ),
+                Madd( p0.y, lt.x, Madd( p1.y, lt.y, Madd( p2.y, lt.z, _mm_mul_ps( p3.y, lt.w ) ) ) ),
+                Madd( p0.z, lt.x, Madd( p1.z, lt.y, Madd( p2.z, lt.z, _mm_mul_ps( p3.z, lt.w ) ) ) ),
+                one
+            };
+
+            ANIM_SCATTER( world, c0, w0 );
+            ANIM_SCATTER( world, c1, w1 );
+            ANIM_SCATTER( world, c2, w2 );
+            ANIM_SCATTER( world, c3, w3 );
+        }
+    }
+}
+
+#undef ANIM_GATHER
+#undef ANIM_SCATTER
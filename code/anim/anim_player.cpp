@@ -1,5 +1,6 @@
 #include "anim_player.h"
 #include "anim.h"
+#include "anim_stream.h"
 
 #include <memory/memory.h>
 #include <foundation/common.h>
@@ -303,34 +304,42 @@ void ANIMSimplePlayer::Unprepare()
 }
 
 void ANIMSimplePlayer::Play( const ANIMClip* clip, float startTime, float blendTime, uint64_t userData )
+{
+    Clip c;
+    c.clip = clip;
+    c.eval_time = startTime;
+    c.user_data = userData;
+    _Play( c, blendTime );
+}
+
+void ANIMSimplePlayer::Play( ANIMClipStreamer* stream, float startTime, float blendTime, uint64_t userData )
+{
+    Clip c;
+    c.stream = stream;
+    c.eval_time = startTime;
+    c.user_data = userData;
+    _Play( c, blendTime );
+}
+
+void ANIMSimplePlayer::_Play( const Clip& clip, float blendTime )
 {
     if( _num_clips == 2 )
         return;
 
-    if( _num_clips == 0 )
-    {
-        Clip& c0 = _clips[0];
-        c0.clip = clip;
-        c0.eval_time = startTime;
-        c0.user_data = userData;
-        _num_clips = 1;
-    }
-    else
-    {
-        Clip& c1 = _clips[1];
-        c1.clip = clip;
-        c1.eval_time = startTime;
-        c1.user_data = userData;
-        _num_clips = 2;
-    }
+    _clips[_num_clips++] = clip;
 
     _blend_time = 0.f;
     _blend_duration = blendTime;
-
 }
 
 void ANIMSimplePlayer::Tick( float deltaTime )
 {
+    for( uint32_t i = 0; i < _num_clips; ++i )
+    {
+        if( _clips[i].stream )
+            _clips[i].stream->Update( _clips[i].eval_time );
+    }
+
     memcpy( _prev_joints, LocalJoints(), _ctx->numJoints * sizeof( ANIMJoint ) );
     _Tick_processBlendTree();
     _Tick_updateTime( deltaTime );
@@ -338,12 +347,35 @@ void ANIMSimplePlayer::Tick( float deltaTime )
 
 void ANIMSimplePlayer::_ClipUpdateTime( Clip* clip, float deltaTime )
 {
-    clip->eval_time = ::fmodf( clip->eval_time + deltaTime, clip->clip->duration );
+    const float duration = _ClipDuration( *clip );
+    if( duration > 0.f )
+        clip->eval_time = ::fmodf( clip->eval_time + deltaTime, duration );
 }
 
 float ANIMSimplePlayer::_ClipPhase( const Clip& clip )
 {
-    return clip.eval_time / clip.clip->duration;
+    const float duration = _ClipDuration( clip );
+    return ( duration > 0.f ) ? clip.eval_time / duration : 0.f;
+}
+
+// streams report 0 until their header is loaded
+float ANIMSimplePlayer::_ClipDuration( const Clip& clip )
+{
+    return ( clip.stream ) ? clip.stream->Duration() : clip.clip->duration;
+}
+
+bool ANIMSimplePlayer::_ClipLeaf( ANIMBlendLeaf* leaf, const Clip& clip )
+{
+    if( !clip.stream )
+    {
+        leaf[0] = ANIMBlendLeaf( clip.clip, clip.eval_time );
+        return true;
+    }
+
+    float local_time = 0.f;
+    const ANIMClip* segment = clip.stream->SegmentClip( &local_time, clip.eval_time );
+    leaf[0] = ANIMBlendLeaf( segment, local_time );
+    return segment != nullptr;
 }
 
 void ANIMSimplePlayer::_Tick_processBlendTree()
@@ -354,21 +386,17 @@ void ANIMSimplePlayer::_Tick_processBlendTree()
     }
     else if( _num_clips == 1 )
     {
-        const Clip& c = _clips[0];
+        ANIMBlendLeaf leaf;
+        if( !_ClipLeaf( &leaf, _clips[0] ) )
+            return;
 
-        ANIMBlendLeaf leaf( c.clip, c.eval_time );
         anim_ext::ProcessBlendTree( _ctx, 0 | ANIMEBlendTreeIndex::LEAF, nullptr, 0, &leaf, 1 );
     }
     else
     {
-        const Clip& c0 = _clips[0];
-        const Clip& c1 = _clips[1];
-
-        ANIMBlendLeaf leaves[2] =
-        {
-            { c0.clip, c0.eval_time },
-            { c1.clip, c1.eval_time },
-        };
+        ANIMBlendLeaf leaves[2];
+        if( !_ClipLeaf( &leaves[0], _clips[0] ) || !_ClipLeaf( &leaves[1], _clips[1] ) )
+            return;
 
         const float blend_alpha = min_of_2( 1.f, _blend_time / _blend_duration );
         ANIMBlendBranch branch( 0 | ANIMEBlendTreeIndex::LEAF, 1 | ANIMEBlendTreeIndex::LEAF, blend_alpha );
@@ -394,20 +422,20 @@ void ANIMSimplePlayer::_Tick_updateTime( float deltaTime )
         //_ClipUpdateTime( &_clips[0], deltaTime );
         //_ClipUpdateTime( &_clips[1], deltaTime );
 
-        const ANIMClip* clipA = c0.clip;
-        const ANIMClip* clipB = c1.clip;
+        const float durationA = _ClipDuration( c0 );
+        const float durationB = _ClipDuration( c1 );
 
         const float blend_alpha = min_of_2( 1.f, _blend_time / _blend_duration );
-        const float clip_duration = lerp( blend_alpha, clipA->duration, clipB->duration );
-        const float delta_phase = deltaTime / clip_duration;
+        const float clip_duration = lerp( blend_alpha, durationA, durationB );
+        const float delta_phase = ( clip_duration > 0.f ) ? deltaTime / clip_duration : 0.f;
 
         float phaseA = _ClipPhase( c0 );
         float phaseB = _ClipPhase( c1 );
         phaseA = ::fmodf( phaseA + delta_phase, 1.f );
         phaseB = ::fmodf( phaseB + delta_phase, 1.f );
 
-        c0.eval_time = phaseA * clipA->duration;
-        c1.eval_time = phaseB * clipB->duration;
+        c0.eval_time = phaseA * durationA;
+        c1.eval_time = phaseB * durationB;
 
         if( _blend_time > _blend_duration )
         {
@@ -454,7 +482,7 @@ bool ANIMSimplePlayer::Duration( float* dst, uint32_t depth )
     if( depth >= _num_clips )
         return false;
 
-    dst[0] = _clips[depth].clip->duration;
+    dst[0] = _ClipDuration( _clips[depth] );
     return true;
 }
 
@@ -9,6 +9,8 @@ struct ANIMJoint;
 struct ANIMSkel;
 struct ANIMClip;
 struct ANIMContext;
+struct ANIMClipStreamer;
+struct ANIMBlendLeaf;
 
 struct ANIMCascadePlayer
 {
@@ -66,6 +68,7 @@ struct ANIMSimplePlayer
     struct Clip
     {
         const ANIMClip* clip = nullptr;
+        ANIMClipStreamer* stream = nullptr;
         uint64_t user_data = 0;
         float eval_time = 0.f;
     };
@@ -83,6 +86,9 @@ struct ANIMSimplePlayer
     void Unprepare();
 
     void Play( const ANIMClip* clip, float startTime, float blendTime, uint64_t userData );
+    // streamed clip. Tick updates stream with eval time, so playback drives segment prefetch.
+    // Pose is held while segment under eval time is loading. Stream is owned by caller
+    void Play( ANIMClipStreamer* stream, float startTime, float blendTime, uint64_t userData );
     void Tick( float deltaTime );
 
     bool Empty() const { return _num_clips == 0; }
@@ -101,6 +107,9 @@ struct ANIMSimplePlayer
 private:
     static void _ClipUpdateTime( Clip* clip, float deltaTime );
     static float _ClipPhase( const Clip& clip );
+    static float _ClipDuration( const Clip& clip );
+    static bool _ClipLeaf( ANIMBlendLeaf* leaf, const Clip& clip );
+    void _Play( const Clip& clip, float blendTime );
     void _Tick_processBlendTree();
     void _Tick_updateTime( float deltaTime );
 };
@@ -1,116 +1,233 @@
 #include "anim.h"
 #include <foundation/debug.h>
+#include <foundation/common.h>
 #include <string.h>
 
-static inline void PushCmdLeaf( Cmd* cmdArray, uint8_t* cmdArraySize, uint16_t currentLeaf, const ANIMBlendLeaf* blendLeaves, uint32_t numLeaves, ANIMECmdOp::Enum op )
+struct CmdListBuilder
 {
-	const uint16_t leaf_index = currentLeaf & (~ANIMEBlendTreeIndex::LEAF);
-	SYS_ASSERT( leaf_index < numLeaves );
-	SYS_ASSERT( *cmdArraySize < ANIMContext::eCMD_ARRAY_SIZE );
+    const ANIMBlendTree* tree;
+    Cmd* cmd_array;
+    uint32_t cmd_array_size;
+    uint32_t cmd_array_capacity;
+    uint32_t stack_depth;
+    uint32_t max_stack_depth;
+};
 
-	const ANIMBlendLeaf* leaf = blendLeaves + leaf_index;
+static inline Cmd* PushCmd( CmdListBuilder* builder, ANIMECmdOp::Enum op )
+{
+	SYS_ASSERT( builder->cmd_array_size < builder->cmd_array_capacity );
 
-	const uint8_t currentCmdArraySize = *cmdArraySize;
-	cmdArray[currentCmdArraySize].leaf = leaf;
-	cmdArray[currentCmdArraySize].command = op;
-	*cmdArraySize = currentCmdArraySize + 1;
+	Cmd* cmd = builder->cmd_array + builder->cmd_array_size++;
+	memset( cmd, 0, sizeof( Cmd ) );
+	cmd->command = op;
+	return cmd;
 }
-static inline void PushCmdBranch(  Cmd* cmdArray, uint8_t* cmdArraySize, const ANIMBlendBranch* branch, ANIMECmdOp::Enum op )
+
+static inline void StackPush( CmdListBuilder* builder )
 {
-	SYS_ASSERT( *cmdArraySize < ANIMContext::eCMD_ARRAY_SIZE );
-	SYS_ASSERT( op >= ANIMECmdOp::BLEND_STACK );
+    builder->stack_depth += 1;
+    builder->max_stack_depth = max_of_2( builder->max_stack_depth, builder->stack_depth );
+}
 
-	const uint8_t currentCmdArraySize = *cmdArraySize;
-	cmdArray[currentCmdArraySize].branch = branch;
-	cmdArray[currentCmdArraySize].command = op;
-	*cmdArraySize = currentCmdArraySize + 1;
+static inline void StackPop( CmdListBuilder* builder )
+{
+    SYS_ASSERT( builder->stack_depth > 0 );
+    builder->stack_depth -= 1;
 }
 
-static void TraverseBlendTree( Cmd* cmdArray, uint8_t* cmdArraySize, uint16_t currentBranch, const ANIMBlendBranch* blendBranches, uint32_t numBranches, const ANIMBlendLeaf* blendLeaves, uint32_t numLeaves )
+static inline const ANIMBlendLeaf* GetLeaf( const ANIMBlendTree& tree, uint16_t index )
 {
-	SYS_ASSERT( ( currentBranch & ANIMEBlendTreeIndex::BRANCH ) != 0 );
+	const uint16_t leaf_index = index & (~ANIMEBlendTreeIndex::LEAF);
+	SYS_ASSERT( leaf_index < tree.numLeaves );
+	return tree.leaves + leaf_index;
+}
 
-    const uint16_t branchIndex = currentBranch & ( ~ANIMEBlendTreeIndex::BRANCH );
+static inline const ANIMBlendBranch* GetBranch( const ANIMBlendTree& tree, uint16_t index )
+{
+    const uint16_t branch_index = index & ( ~ANIMEBlendTreeIndex::BRANCH );
+    SYS_ASSERT( branch_index < tree.numBranches );
+    return tree.branches + branch_index;
+}
 
-	SYS_ASSERT( branchIndex < numBranches );
+static inline const ANIMBlendNWay* GetNWay( const ANIMBlendTree& tree, uint16_t index )
+{
+    const uint16_t nway_index = index & ( ~ANIMEBlendTreeIndex::NWAY );
+    SYS_ASSERT( nway_index < tree.numNWays );
+    return tree.nways + nway_index;
+}
 
-	const ANIMBlendBranch* branch = blendBranches + branchIndex;
+static inline bool IsLeaf( uint16_t index ) { return ( index & ANIMEBlendTreeIndex::LEAF ) != 0; }
 
-    const uint16_t isLeftBranch  = branch->left  & ANIMEBlendTreeIndex::BRANCH;
-    const uint16_t isLeftLeaf    = branch->left  & ANIMEBlendTreeIndex::LEAF;
-    const uint16_t isRightBranch = branch->right & ANIMEBlendTreeIndex::BRANCH;
-    const uint16_t isRightLeaf   = branch->right & ANIMEBlendTreeIndex::LEAF;
+static void TraverseBlendTree( CmdListBuilder* builder, uint16_t node );
 
-	SYS_ASSERT( isLeftBranch != isLeftLeaf );
-	SYS_ASSERT( isRightBranch != isRightLeaf );
+// skip command in front of subtree, its range is patched when subtree is done
+static inline uint32_t BeginSkip( CmdListBuilder* builder, ANIMECmdOp::Enum op, const void* node, uint16_t child )
+{
+    Cmd* cmd = PushCmd( builder, op );
+    cmd->leaf = (const ANIMBlendLeaf*)node;
+    cmd->arg1 = child;
+    return builder->cmd_array_size - 1;
+}
 
-	if( isLeftBranch )
-	{
-		TraverseBlendTree( cmdArray, cmdArraySize, branch->left, blendBranches, numBranches, blendLeaves, numLeaves );
-	}
-	else if( isLeftLeaf )
-	{
-		const ANIMECmdOp::Enum op = ( isRightLeaf ) ? ANIMECmdOp::EVAL : ANIMECmdOp::PUSH_AND_EVAL;
-		PushCmdLeaf( cmdArray, cmdArraySize, branch->left, blendLeaves, numLeaves, op );
-	}
-	else
-	{
-		SYS_ASSERT( false );
-	}
+static inline void EndSkip( CmdListBuilder* builder, uint32_t skip_cmd_index )
+{
+    const uint32_t num_skipped = builder->cmd_array_size - skip_cmd_index - 1;
+    SYS_ASSERT( num_skipped <= UINT16_MAX );
+    builder->cmd_array[skip_cmd_index].arg0 = (uint16_t)num_skipped;
+}
 
-	if( isRightBranch )
-	{
-		TraverseBlendTree( cmdArray, cmdArraySize, branch->right, blendBranches, numBranches, blendLeaves, numLeaves );
-	}
-	else if( isRightLeaf )
-	{
-        const ANIMECmdOp::Enum op = ( isLeftLeaf ) ? ANIMECmdOp::EVAL : ANIMECmdOp::PUSH_AND_EVAL;
-		PushCmdLeaf( cmdArray, cmdArraySize, branch->right, blendLeaves, numLeaves, op );
-	}
-	else
-	{
-		SYS_ASSERT( false );
-	}
+static void PushCmdLeaf( CmdListBuilder* builder, uint16_t node )
+{
+    Cmd* cmd = PushCmd( builder, ANIMECmdOp::PUSH_AND_EVAL );
+    cmd->leaf = GetLeaf( *builder->tree, node );
+    StackPush( builder );
+}
+
+static void TraverseBranch( CmdListBuilder* builder, uint16_t node )
+{
+    const ANIMBlendBranch* branch = GetBranch( *builder->tree, node );
+
+	SYS_ASSERT( ( ( branch->left & ANIMEBlendTreeIndex::BRANCH ) != 0 ) + IsLeaf( branch->left ) + ( ( branch->left & ANIMEBlendTreeIndex::NWAY ) != 0 ) == 1 );
+	SYS_ASSERT( ( ( branch->right & ANIMEBlendTreeIndex::BRANCH ) != 0 ) + IsLeaf( branch->right ) + ( ( branch->right & ANIMEBlendTreeIndex::NWAY ) != 0 ) == 1 );
+    SYS_ASSERT( !( branch->flags & ANIMEBlendBranchFlag::MASKED ) || branch->mask < builder->tree->numMasks );
+
+    const bool is_plain = branch->flags == 0;
+
+    if( is_plain && IsLeaf( branch->left ) && IsLeaf( branch->right ) )
+    {
+        // both sides evaluated to pose cache, blend result goes to stack
+        for( uint16_t slot = 0; slot < ANIMContext::ePOSE_CACHE_SIZE; ++slot )
+        {
+            const uint32_t skip = BeginSkip( builder, ( slot == 0 ) ? ANIMECmdOp::SKIP_LEFT : ANIMECmdOp::SKIP_RIGHT, branch, 0 );
+            Cmd* cmd = PushCmd( builder, ANIMECmdOp::EVAL );
+            cmd->leaf = GetLeaf( *builder->tree, ( slot == 0 ) ? branch->left : branch->right );
+            cmd->arg0 = slot;
+            EndSkip( builder, skip );
+        }
+
+        Cmd* cmd = PushCmd( builder, ANIMECmdOp::BLEND_CACHE );
+        cmd->branch = branch;
+        StackPush( builder );
+        return;
+    }
 
-    const ANIMECmdOp::Enum op = ( isLeftLeaf && isRightLeaf ) ? ANIMECmdOp::BLEND_CACHE : ANIMECmdOp::BLEND_STACK;
-	PushCmdBranch( cmdArray, cmdArraySize, branch, op );
+    // left side is the base for additive and masked blends, so only plain branch can skip it
+    if( is_plain )
+    {
+        const uint32_t skip = BeginSkip( builder, ANIMECmdOp::SKIP_LEFT, branch, 0 );
+        TraverseBlendTree( builder, branch->left );
+        EndSkip( builder, skip );
+    }
+    else
+    {
+        TraverseBlendTree( builder, branch->left );
+    }
 
+    {
+        const uint32_t skip = BeginSkip( builder, ANIMECmdOp::SKIP_RIGHT, branch, 0 );
+        TraverseBlendTree( builder, branch->right );
+        EndSkip( builder, skip );
+    }
+
+    ANIMECmdOp::Enum op = ANIMECmdOp::BLEND_STACK;
+    if( branch->flags & ANIMEBlendBranchFlag::ADDITIVE )
+        op = ANIMECmdOp::BLEND_ADDITIVE;
+    else if( branch->flags & ANIMEBlendBranchFlag::MASKED )
+        op = ANIMECmdOp::BLEND_MASKED;
+
+    Cmd* cmd = PushCmd( builder, op );
+    cmd->branch = branch;
+    StackPop( builder );
 }
 
-void EvaluateBlendTree( ANIMContext* ctx, const uint16_t root_index , const ANIMBlendBranch* blend_branches, uint32_t num_branches, const ANIMBlendLeaf* blend_leaves, uint32_t num_leaves )
+static void TraverseNWay( CmdListBuilder* builder, uint16_t node )
+{
+    const ANIMBlendNWay* nway = GetNWay( *builder->tree, node );
+    SYS_ASSERT( nway->count > 0 );
+
+    for( uint16_t i = 0; i < nway->count; ++i )
+    {
+        const uint32_t skip = BeginSkip( builder, ANIMECmdOp::SKIP_NWAY, nway, i );
+        TraverseBlendTree( builder, nway->children[i] );
+        EndSkip( builder, skip );
+
+        Cmd* cmd = PushCmd( builder, ANIMECmdOp::BLEND_NWAY );
+        cmd->nway = nway;
+        cmd->arg0 = i;
+        if( i > 0 )
+            StackPop( builder );
+    }
+}
+
+static void TraverseBlendTree( CmdListBuilder* builder, uint16_t node )
 {
-	const uint16_t is_root_branch = root_index & ANIMEBlendTreeIndex::BRANCH;
-    const uint16_t is_root_leaf   = root_index & ANIMEBlendTreeIndex::LEAF;
+    if( node & ANIMEBlendTreeIndex::LEAF )
+        PushCmdLeaf( builder, node );
+    else if( node & ANIMEBlendTreeIndex::BRANCH )
+        TraverseBranch( builder, node );
+    else if( node & ANIMEBlendTreeIndex::NWAY )
+        TraverseNWay( builder, node );
+    else
+        SYS_ASSERT( false );
+}
 
-	SYS_ASSERT( is_root_leaf != is_root_branch );
+void CompileBlendTree( ANIMContext* ctx, const ANIMBlendTree& tree )
+{
+	CmdListBuilder builder = {};
+	builder.tree = &tree;
+	builder.cmd_array = ctx->cmdArray;
+	builder.cmd_array_capacity = ctx->cmdArrayCapacity - 1; // room for END_LIST
 
-	uint8_t cmd_array_size = 0;
-	Cmd* cmd_array = ctx->cmdArray;
-	memset( cmd_array, 0, sizeof(Cmd) * ANIMContext::eCMD_ARRAY_SIZE );
+	TraverseBlendTree( &builder, tree.root );
 
-	if( is_root_leaf )
-	{
-        PushCmdLeaf( cmd_array, &cmd_array_size, root_index, blend_leaves, num_leaves, ANIMECmdOp::PUSH_AND_EVAL );
-	}
-	else
-	{
-		TraverseBlendTree( cmd_array, &cmd_array_size, root_index, blend_branches, num_branches, blend_leaves, num_leaves );
-	}
+	SYS_ASSERT( builder.stack_depth == 1 );
+	SYS_ASSERT( builder.max_stack_depth <= ctx->poseStackSize );
 
-	SYS_ASSERT( cmd_array_size < ANIMContext::eCMD_ARRAY_SIZE );
+	builder.cmd_array_capacity += 1;
+	PushCmd( &builder, ANIMECmdOp::END_LIST );
+
+	ctx->cmdArraySize = builder.cmd_array_size;
+	ctx->tree = tree;
+}
+
+void EvaluateBlendTree( ANIMContext* ctx, const uint16_t root_index , const ANIMBlendBranch* blend_branches, uint32_t num_branches, const ANIMBlendLeaf* blend_leaves, uint32_t num_leaves )
+{
+    ANIMBlendTree tree;
+    tree.branches = blend_branches;
+    tree.numBranches = num_branches;
+    tree.leaves = blend_leaves;
+    tree.numLeaves = num_leaves;
+    tree.root = root_index;
+
+    CompileBlendTree( ctx, tree );
+}
+
+// normalized weight of nway child, children below epsilon get 0 and are not evaluated.
+// When whole nway has no weight first child is used so there is always pose on the stack.
+static float NWayWeight( const ANIMBlendNWay* nway, uint32_t child, float epsilon )
+{
+    float sum = 0.f;
+    for( uint32_t i = 0; i < nway->count; ++i )
+        sum += max_of_2( 0.f, nway->weights[i] );
 
-	Cmd* last_cmd = cmd_array + cmd_array_size;
-    last_cmd->command = ANIMECmdOp::END_LIST;
-	++cmd_array_size;
+    if( sum <= epsilon )
+        return ( child == 0 ) ? 1.f : 0.f;
 
-	ctx->cmdArraySize = cmd_array_size;
+    const float weight = max_of_2( 0.f, nway->weights[child] ) / sum;
+    return ( weight > epsilon ) ? weight : 0.f;
+}
+
+static inline void CopyPose( ANIMJoint* dst, const ANIMJoint* src, uint32_t num_joints )
+{
+    memcpy( dst, src, num_joints * sizeof( ANIMJoint ) );
 }
 
 void EvaluateCommandList( ANIMContext* ctx )
 {
     const Cmd* cmdList = ctx->cmdArray;
+    const float eps = ctx->weightEpsilon;
     ctx->poseStackIndex = UINT32_MAX;
-	
+
     while( cmdList->command != ANIMECmdOp::END_LIST )
 	{
 		const uint16_t cmd = cmdList->command;
@@ -119,7 +236,7 @@ void EvaluateCommandList( ANIMContext* ctx )
 		{
         case ANIMECmdOp::EVAL:
 			{
-				ANIMJoint* joints = AllocateTmpPose( ctx );
+				ANIMJoint* joints = ctx->poseCache[cmdList->arg0];
                 ANIMClip* clip = (ANIMClip*)cmdList->leaf->anim;
 				EvaluateClip( joints, clip, cmdList->leaf->evalTime );
 				break;
@@ -134,13 +251,17 @@ void EvaluateCommandList( ANIMContext* ctx )
 			}
         case ANIMECmdOp::BLEND_STACK:
 			{
+                // one side was skipped, the other one is already on top
+                const float alpha = cmdList->branch->alpha;
+                if( alpha <= eps || alpha >= 1.f - eps )
+                    break;
+
 				ANIMJoint* leftJoints  = PoseFromStack( ctx, 1 );
 				ANIMJoint* rightJoints = PoseFromStack( ctx, 0 );
-                //poseStackPush( ctx );
                 ANIMJoint* outJoints = PoseFromStack( ctx, 1 );
 
-				BlendJointsLinear( outJoints, leftJoints, rightJoints, cmdList->branch->alpha, ctx->numJoints );
-                
+				BlendJointsLinear( outJoints, leftJoints, rightJoints, alpha, ctx->numJoints );
+
                 PoseStackPop( ctx );
 				break;
 			}
@@ -148,15 +269,81 @@ void EvaluateCommandList( ANIMContext* ctx )
 			{
 				ANIMJoint* leftJoints  = ctx->poseCache[0];
 				ANIMJoint* rightJoints = ctx->poseCache[1];
-				
+
 				PoseStackPush( ctx );
                 ANIMJoint* outJoints = PoseFromStack( ctx, 0 );
 
-                BlendJointsLinear( outJoints, leftJoints, rightJoints, cmdList->branch->alpha, ctx->numJoints );
+                const float alpha = cmdList->branch->alpha;
+                if( alpha <= eps )
+                    CopyPose( outJoints, leftJoints, ctx->numJoints );
+                else if( alpha >= 1.f - eps )
+                    CopyPose( outJoints, rightJoints, ctx->numJoints );
+                else
+                    BlendJointsLinear( outJoints, leftJoints, rightJoints, alpha, ctx->numJoints );
 				break;
 			}
+        case ANIMECmdOp::BLEND_MASKED:
+        case ANIMECmdOp::BLEND_ADDITIVE:
+            {
+                const ANIMBlendBranch* branch = cmdList->branch;
+                if( branch->alpha <= eps )
+                    break;
+
+                const float* mask = ( branch->flags & ANIMEBlendBranchFlag::MASKED ) ? ctx->tree.masks[branch->mask] : nullptr;
+                ANIMJoint* leftJoints = PoseFromStack( ctx, 1 );
+                ANIMJoint* rightJoints = PoseFromStack( ctx, 0 );
+                ANIMJoint* outJoints = PoseFromStack( ctx, 1 );
+
+                if( cmd == ANIMECmdOp::BLEND_ADDITIVE )
+                    BlendJointsAdditive( outJoints, leftJoints, rightJoints, branch->alpha, mask, ctx->numJoints );
+                else
+                    BlendJointsLinearMasked( outJoints, leftJoints, rightJoints, branch->alpha, mask, ctx->numJoints );
+
+                PoseStackPop( ctx );
+                break;
+            }
+        case ANIMECmdOp::BLEND_NWAY:
+            {
+                // running normalized blend: acc = lerp( acc, child, w / ( sum of previous weights + w ) )
+                const ANIMBlendNWay* nway = cmdList->nway;
+                const uint32_t child = cmdList->arg0;
+                const float weight = NWayWeight( nway, child, eps );
+                if( weight == 0.f )
+                    break;
+
+                float prev_weight = 0.f;
+                for( uint32_t i = 0; i < child; ++i )
+                    prev_weight += NWayWeight( nway, i, eps );
+
+                if( prev_weight == 0.f )
+                    break;
+
+                ANIMJoint* accJoints = PoseFromStack( ctx, 1 );
+                ANIMJoint* childJoints = PoseFromStack( ctx, 0 );
+                BlendJointsLinear( accJoints, accJoints, childJoints, weight / ( prev_weight + weight ), ctx->numJoints );
+
+                PoseStackPop( ctx );
+                break;
+            }
+        case ANIMECmdOp::SKIP_LEFT:
+            {
+                if( cmdList->branch->alpha >= 1.f - eps )
+                    cmdList += cmdList->arg0;
+                break;
+            }
+        case ANIMECmdOp::SKIP_RIGHT:
+            {
+                if( cmdList->branch->alpha <= eps )
+                    cmdList += cmdList->arg0;
+                break;
+            }
+        case ANIMECmdOp::SKIP_NWAY:
+            {
+                if( NWayWeight( cmdList->nway, cmdList->arg1, eps ) == 0.f )
+                    cmdList += cmdList->arg0;
+                break;
+            }
 		}
 		++cmdList;
 	}
 }
-
@@ -0,0 +1,158 @@
+#include "anim_stream.h"
+#include "anim.h"
+
+#include <foundation/debug.h>
+#include <foundation/common.h>
+#include <foundation/serializer.h>
+
+static inline uint32_t SegmentIndex( const ANIMClipStream* stream, float eval_time )
+{
+    const float t = max_of_2( 0.f, eval_time );
+    return min_of_2( (uint32_t)( t / stream->segmentDuration ), (uint32_t)stream->numSegments - 1 );
+}
+
+bool ANIMClipStreamer::Open( const char* stream_path, float prefetch_time )
+{
+    SYS_ASSERT( !RSM::IsAlive( _header ) );
+
+    const size_t path_len = strlen( stream_path );
+    if( path_len >= eMAX_PATH )
+        return false;
+
+    _header = RSM::Load( stream_path );
+    if( _header.i == 0 )
+        return false;
+
+    memcpy( _path, stream_path, path_len + 1 );
+    _prefetch_time = prefetch_time;
+    _stream = nullptr;
+    return true;
+}
+
+void ANIMClipStreamer::Close()
+{
+    for( Segment& segment : _segments )
+    {
+        if( segment.index != UINT32_MAX )
+            RSM::Release( segment.rid );
+
+        segment = {};
+    }
+
+    if( _header.i )
+        RSM::Release( _header );
+
+    _header = RSMResourceID::Null();
+    _stream = nullptr;
+}
+
+float ANIMClipStreamer::Duration() const
+{
+    return ( _stream ) ? _stream->duration : 0.f;
+}
+
+void ANIMClipStreamer::Update( float eval_time )
+{
+    if( !_stream )
+    {
+        if( RSM::State( _header ) != RSMEState::READY )
+            return;
+
+        const srl_file_t* file = (const srl_file_t*)RSM::Get( _header );
+        _stream = file->data<ANIMClipStream>();
+    }
+
+    // segments to keep: current one, then following ones (wrapped) which start within prefetch time
+    uint32_t wanted[eMAX_RESIDENT_SEGMENTS];
+    uint32_t num_wanted = 0;
+
+    const uint32_t current = SegmentIndex( _stream, eval_time );
+    wanted[num_wanted++] = current;
+
+    float next_start = ( current + 1 ) * _stream->segmentDuration - eval_time;
+    uint32_t next = current;
+    while( num_wanted < eMAX_RESIDENT_SEGMENTS && next_start <= _prefetch_time )
+    {
+        next = ( next + 1 ) % _stream->numSegments;
+        if( next == current )
+            break;
+
+        wanted[num_wanted++] = next;
+        next_start += _stream->segmentDuration;
+    }
+
+    auto is_wanted = [&]( uint32_t index )
+    {
+        for( uint32_t i = 0; i < num_wanted; ++i )
+            if( wanted[i] == index )
+                return true;
+        return false;
+    };
+
+    for( Segment& segment : _segments )
+    {
+        if( segment.index != UINT32_MAX && !is_wanted( segment.index ) )
+        {
+            RSM::Release( segment.rid );
+            segment = {};
+        }
+    }
+
+    for( uint32_t i = 0; i < num_wanted; ++i )
+    {
+        Segment* free_slot = nullptr;
+        bool resident = false;
+        for( Segment& segment : _segments )
+        {
+            resident |= segment.index == wanted[i];
+            free_slot = ( !free_slot && segment.index == UINT32_MAX ) ? &segment : free_slot;
+        }
+
+        if( resident || !free_slot )
+            continue;
+
+        char segment_path[eMAX_PATH];
+        ClipSegmentPath( segment_path, eMAX_PATH, _path, wanted[i] );
+
+        const RSMResourceID rid = RSM::Load( segment_path );
+        if( rid.i )
+        {
+            free_slot->rid = rid;
+            free_slot->index = wanted[i];
+        }
+    }
+}
+
+const ANIMClip* ANIMClipStreamer::SegmentClip( float* local_time, float eval_time ) const
+{
+    if( !_stream )
+        return nullptr;
+
+    const uint32_t index = SegmentIndex( _stream, eval_time );
+    for( const Segment& segment : _segments )
+    {
+        if( segment.index != index )
+            continue;
+
+        if( RSM::State( segment.rid ) != RSMEState::READY )
+            return nullptr;
+
+        const srl_file_t* file = (const srl_file_t*)RSM::Get( segment.rid );
+        const ANIMClip* clip = file->data<ANIMClip>();
+
+        local_time[0] = min_of_2( eval_time - index * _stream->segmentDuration, clip->duration );
+        return clip;
+    }
+    return nullptr;
+}
+
+bool ANIMClipStreamer::Evaluate( ANIMJoint* out_joints, float eval_time ) const
+{
+    float local_time = 0.f;
+    const ANIMClip* clip = SegmentClip( &local_time, eval_time );
+    if( !clip )
+        return false;
+
+    EvaluateClip( out_joints, clip, local_time );
+    return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <foundation/type.h>
+#include <resource_manager/resource_manager.h>
+#include <stdio.h>
+#include <string.h>
+
+struct ANIMJoint;
+struct ANIMClip;
+struct ANIMClipStream;
+
+// segment file of "anim/walk.clipstream" is "anim/walk_<index>.clipseg"
+inline void ClipSegmentPath( char* out, uint32_t out_size, const char* stream_path, uint32_t segment_index )
+{
+    const char* ext = strrchr( stream_path, '.' );
+    const int base_len = ( ext ) ? (int)( ext - stream_path ) : (int)strlen( stream_path );
+    snprintf( out, out_size, "%.*s_%03u.clipseg", base_len, stream_path, segment_index );
+}
+
+struct ANIMClipStreamLoader : RSMLoader
+{
+    RSM_DEFINE_LOADER( ANIMClipStreamLoader );
+    virtual const char* SupportedType() const override { return "clipstream"; }
+    virtual bool IsBinary() const override { return true; }
+};
+
+struct ANIMClipSegmentLoader : RSMLoader
+{
+    RSM_DEFINE_LOADER( ANIMClipSegmentLoader );
+    virtual const char* SupportedType() const override { return "clipseg"; }
+    virtual bool IsBinary() const override { return true; }
+};
+
+// Keeps only segments around eval time resident. Update() requests the segment under eval time and the ones
+// starting within prefetch time (wrapping around clip end), segments left behind are released to RSM.
+// ANIMSimplePlayer calls Update() on its own for streams passed to Play().
+struct ANIMClipStreamer
+{
+    enum {
+        eMAX_RESIDENT_SEGMENTS = 4,
+        eMAX_PATH = 256,
+    };
+
+    struct Segment
+    {
+        RSMResourceID rid = RSMResourceID::Null();
+        uint32_t index = UINT32_MAX;
+    };
+
+    RSMResourceID _header = RSMResourceID::Null();
+    const ANIMClipStream* _stream = nullptr;
+    Segment _segments[eMAX_RESIDENT_SEGMENTS];
+    float _prefetch_time = 0.f;
+    char _path[eMAX_PATH] = {};
+
+    bool Open( const char* stream_path, float prefetch_time = 0.5f );
+    void Close();
+
+    void Update( float eval_time );
+
+    bool IsReady() const { return _stream != nullptr; }
+    float Duration() const;
+
+    // segment clip under eval_time with time relative to it, nullptr while it is still loading
+    const ANIMClip* SegmentClip( float* local_time, float eval_time ) const;
+
+    // false while segment is loading, out_joints are left untouched then
+    bool Evaluate( ANIMJoint* out_joints, float eval_time ) const;
+};
@@ -9,29 +9,36 @@ struct ANIMJoint;
 
 struct BIT_ALIGNMENT_16 ANIMSkel
 {
-    static constexpr u32 VERSION = BX_UTIL_MAKE_VERSION( 1, 0, 1 );
+    static constexpr u32 VERSION = BX_UTIL_MAKE_VERSION( 1, 0, 2 );
     static constexpr u32 TAG = BX_UTIL_TAG32( 'S', 'K', 'E', 'L' );
 
 	uint16_t numJoints;
-	uint16_t pad0__[1];
+	uint16_t numLevels;
 	u32 offsetBasePose;
 	u32 offsetParentIndices;
 	u32 offsetJointNames;
     u32 offsetJointNamesStrings;
-    u32 pad1__[3];
+    u32 offsetLevelJoints;  // joint indices sorted by depth in hierarchy
+    u32 offsetLevelBegin;   // numLevels + 1 entries, level i is [levelBegin[i], levelBegin[i+1]) range of levelJoints
+    u32 pad1__[1];
 
     SRL_TYPE( ANIMSkel,
         SRL_PROPERTY( numJoints );
+        SRL_PROPERTY( numLevels );
         SRL_PROPERTY( offsetBasePose );
         SRL_PROPERTY( offsetParentIndices );
         SRL_PROPERTY( offsetJointNames );
         SRL_PROPERTY( offsetJointNamesStrings );
+        SRL_PROPERTY( offsetLevelJoints );
+        SRL_PROPERTY( offsetLevelBegin );
     );
 };
 
 inline const int16_t*   ParentIndices( const ANIMSkel* skel ) { return TYPE_OFFSET_GET_POINTER( int16_t, skel->offsetParentIndices ); }
 inline const u32*       JointNames   ( const ANIMSkel* skel ) { return TYPE_OFFSET_GET_POINTER( u32, skel->offsetJointNames ); }
 inline const ANIMJoint* BasePose     ( const ANIMSkel* skel ) { return TYPE_OFFSET_GET_POINTER( ANIMJoint, skel->offsetBasePose ); }
+inline const uint16_t*  LevelJoints  ( const ANIMSkel* skel ) { return TYPE_OFFSET_GET_POINTER( uint16_t, skel->offsetLevelJoints ); }
+inline const uint16_t*  LevelBegin   ( const ANIMSkel* skel ) { return TYPE_OFFSET_GET_POINTER( uint16_t, skel->offsetLevelBegin ); }
 
 
 struct BIT_ALIGNMENT_16 ANIMClip
@@ -61,19 +68,56 @@ struct BIT_ALIGNMENT_16 ANIMClip
     );
 };
 
+// Clip split into time segments, streamed through RSM (see anim_stream.h). Every segment is a standalone ANIMClip
+// file with frames [i * segmentFrames, (i + 1) * segmentFrames], the boundary frame is stored in both neighbours
+// so evaluation never needs two segments.
+struct BIT_ALIGNMENT_16 ANIMClipStream
+{
+    static constexpr u32 VERSION = BX_UTIL_MAKE_VERSION( 1, 1, 0 );
+    static constexpr u32 TAG = BX_UTIL_TAG32( 'C', 'L', 'P', 'S' );
+
+    f32 duration;
+    f32 sampleFrequency;
+    f32 segmentDuration;
+    u16 numJoints;
+    u16 numSegments;
+    u32 numFrames;
+    u32 segmentFrames;
+    u32 __padding[2];
+
+    SRL_TYPE( ANIMClipStream,
+        SRL_PROPERTY( duration );
+        SRL_PROPERTY( sampleFrequency );
+        SRL_PROPERTY( segmentDuration );
+        SRL_PROPERTY( numJoints );
+        SRL_PROPERTY( numSegments );
+        SRL_PROPERTY( numFrames );
+        SRL_PROPERTY( segmentFrames );
+    );
+};
+
+namespace ANIMEBlendBranchFlag
+{
+    enum Enum : uint16_t
+    {
+        ADDITIVE = 0x1, /* right is additive layer applied on top of left with alpha weight */
+        MASKED = 0x2,   /* alpha is scaled per joint by ANIMBlendTree::masks[mask] */
+    };
+};
+
 struct BIT_ALIGNMENT_16 ANIMBlendBranch
 {
-	inline ANIMBlendBranch( uint16_t left_index, uint16_t right_index, f32 blend_alpha, uint16_t f = 0 )
-		: left( left_index ), right( right_index ), alpha( blend_alpha ), flags(f)
+	inline ANIMBlendBranch( uint16_t left_index, uint16_t right_index, f32 blend_alpha, uint16_t f = 0, uint16_t mask_index = 0 )
+		: left( left_index ), right( right_index ), flags(f), mask( mask_index ), alpha( blend_alpha )
 	{}
 	
     inline ANIMBlendBranch()
-		: left(0), right(0), flags(0), alpha(0.f)
+		: left(0), right(0), flags(0), mask(0), alpha(0.f)
 	{}
 	u16 left;
 	u16 right;
 	u16 flags;
-	u16 pad0__[1];
+	u16 mask;
 	f32 alpha;
 	u32 pad1__[1];
 };
@@ -92,26 +136,57 @@ struct BIT_ALIGNMENT_16 ANIMBlendLeaf
 	u32 pad0__[1];
 };
 
+// weighted blend of 'count' children, weights don't need to be normalized
+struct ANIMBlendNWay
+{
+    const u16* children = nullptr; /* tree indices (LEAF, BRANCH or NWAY) */
+    const f32* weights = nullptr;
+    u32 count = 0;
+};
+
 namespace ANIMEBlendTreeIndex
 {
     enum Enum
     {
         LEAF = 0x8000,
         BRANCH = 0x4000,
+        NWAY = 0x2000,
     };
 };
 
+// Arrays are referenced by compiled command list, so they have to stay alive as long as the list is used.
+// Weights and eval times can be changed in place between EvaluateCommandList calls.
+struct ANIMBlendTree
+{
+    const ANIMBlendBranch* branches = nullptr;
+    const ANIMBlendLeaf* leaves = nullptr;
+    const ANIMBlendNWay* nways = nullptr;
+    const f32* const* masks = nullptr;  /* per joint weights, one array per mask */
+    u32 numBranches = 0;
+    u32 numLeaves = 0;
+    u32 numNWays = 0;
+    u32 numMasks = 0;
+    u16 root = 0;
+};
+
 namespace ANIMECmdOp
 {
     enum Enum : uint16_t
     {
         END_LIST = 0,	/* end of command list marker */
 
-        EVAL,			/* evaluate anim to top of pose cache*/
+        EVAL,			/* evaluate anim to pose cache slot arg0 */
         PUSH_AND_EVAL,  /* evaluate anim to top of pose stack*/
 
         BLEND_STACK,	/* blend poses from stack*/
         BLEND_CACHE,	/* blend poses from cache */
+        BLEND_MASKED,   /* blend poses from stack with per joint mask */
+        BLEND_ADDITIVE, /* apply top of stack as additive layer on pose below */
+        BLEND_NWAY,     /* accumulate child arg0 of nway into pose below */
+
+        SKIP_LEFT,      /* skip next arg0 commands when left side of branch has no weight */
+        SKIP_RIGHT,     /* skip next arg0 commands when right side of branch has no weight */
+        SKIP_NWAY,      /* skip next arg0 commands when child arg1 of nway has no weight */
     };
 };
 
@@ -120,10 +195,12 @@ struct Cmd
 {
     ANIMECmdOp::Enum command;		/* see AnimCommandOp */
 	uint16_t arg0;			/* helper argument used by some commands */
+	uint16_t arg1;
 	union
 	{
 		const ANIMBlendLeaf*	  leaf;
 		const ANIMBlendBranch* branch;
+		const ANIMBlendNWay*   nway;
 	};
 };
 
@@ -134,18 +211,22 @@ struct ANIMContext
 	enum
 	{
 		ePOSE_CACHE_SIZE = 2,
-		ePOSE_STACK_SIZE = 4,
+		ePOSE_STACK_SIZE = 4,   /* defaults, see ContextInit */
 		eCMD_ARRAY_SIZE = 64,
 	};
 
     BXIAllocator* allocator = nullptr;
 
 	ANIMJoint* poseCache[ePOSE_CACHE_SIZE];
-	ANIMJoint* poseStack[ePOSE_STACK_SIZE];
+	ANIMJoint** poseStack = nullptr;
 	Cmd* cmdArray = nullptr;
+    ANIMBlendTree tree;         /* tree compiled into cmdArray */
+    f32 weightEpsilon = 0.001f; /* subtrees with lower weight are not evaluated */
     u32 poseCacheIndex = 0;
     u32 poseStackIndex = 0;
+    u32 poseStackSize = 0;
     u32 cmdArraySize = 0;
+    u32 cmdArrayCapacity = 0;
     u32 numJoints = 0;
 };
  
@@ -164,7 +245,7 @@ inline void PoseStackPop( ANIMContext* ctx )
 
 inline u32 PoseStackPush( ANIMContext* ctx )
 {
-    ctx->poseStackIndex = ( ctx->poseStackIndex + 1 ) % ANIMContext::ePOSE_STACK_SIZE;
+    ctx->poseStackIndex = ( ctx->poseStackIndex + 1 ) % ctx->poseStackSize;
     return ctx->poseStackIndex;
 }
 
@@ -172,7 +253,7 @@ inline u32 PoseStackPush( ANIMContext* ctx )
 inline u32 PoseStackIndex( const ANIMContext* ctx, i32 depth )
 {
     const i32 iindex = (i32)ctx->poseStackIndex - depth;
-    SYS_ASSERT( iindex < ANIMContext::ePOSE_STACK_SIZE );
+    SYS_ASSERT( iindex < (i32)ctx->poseStackSize );
     SYS_ASSERT( iindex >= 0 );
     //const uint8_t index = (uint8_t)iindex % bxAnim_Context::ePOSE_STACK_SIZE;
     return iindex;
@@ -82,7 +82,7 @@ void ANIMTool::Tick( CMNEngine* e, const TOOLContext& ctx, float dt )
                 BX_FREE0( _allocator, _joints_ms );
 
                 blob_t skel_blob = tool::anim::CompileSkeleton( *_in_skel, _allocator, tool::anim::SKEL_CLO_INCLUDE_STRING_NAMES );
-                blob_t clip_blob = tool::anim::CompileClip( *_in_anim, *_in_skel, _allocator );
+                blob_t clip_blob = tool::anim::CompileClip( *_in_anim, *_in_skel, _allocator, ( _resample ) ? &_resample_params : nullptr, &_resample_report );
 
                 _skel_file = srl_file::serialize<ANIMSkel>( skel_blob, _allocator );
                 _clip_file = srl_file::serialize<ANIMClip>( clip_blob, _allocator );
@@ -258,6 +258,14 @@ void ANIMTool::DrawMenu( CMNEngine* e, const TOOLContext& ctx )
             {
                 _flags.save_clip = 1;
             }
+
+            const tool::anim::ResampleReport& report = _resample_report;
+            ImGui::Text( "frames: %u -> %u (%.2f Hz)", report.src_num_frames, report.num_frames, report.sample_frequency );
+            if( report.worst_joint < _in_skel->jointNames.size() )
+            {
+                ImGui::Text( "max error: %.5f (%s at %.3fs)", report.max_error, _in_skel->jointNames[report.worst_joint].c_str(), report.joint_error_time[report.worst_joint] );
+                ImGui::Text( "root motion error: %.5f", report.root_motion_error );
+            }
         }
 
         ImGui::Separator();
@@ -299,6 +307,12 @@ void ANIMTool::DrawMenu( CMNEngine* e, const TOOLContext& ctx )
             ImGui::InputFloat( "scale", &_import_params.scale, 0.01f, 0.1f, 3 );
             ImGui::Checkbox( "extract root motion", &_import_params.extract_root_motion );
             ImGui::Checkbox( "remove root motion", &_import_params.remove_root_motion );
+            ImGui::Checkbox( "resample", &_resample );
+            if( _resample )
+            {
+                ImGui::InputFloat( "resample tolerance", &_resample_params.tolerance, 0.0001f, 0.001f, 5 );
+                ImGui::Checkbox( "additive", &_resample_params.additive );
+            }
 
             if( _in_skel )
             {
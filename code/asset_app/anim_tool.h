@@ -31,6 +31,9 @@ struct ANIMTool : TOOLInterface
     tool::anim::Skeleton* _in_skel = nullptr;
     tool::anim::Animation* _in_anim = nullptr;
     tool::anim::ImportParams _import_params = {};
+    tool::anim::ResampleParams _resample_params = {};
+    tool::anim::ResampleReport _resample_report = {};
+    bool _resample = true;
     
     srl_file_t* _skel_file = nullptr;
     srl_file_t* _clip_file = nullptr;
@@ -8,6 +8,7 @@
 #include <rdix/rdix_debug_draw.h>
 
 #include <gui/gui.h>
+#include <resource_manager/resource_manager.h>
 #include <3rd_party/imgui/imgui.h>
 
 #include <entity/entity_system.h>
@@ -151,6 +152,7 @@ bool BXAssetApp::Update( BXWindow* win, unsigned long long deltaTimeUS, BXIAlloc
         return false;
 
     GUI::NewFrame();
+    RSM::Update();
 
 	const float delta_time_sec = (float)BXTime::Micro_2_Sec( deltaTimeUS );
     if( ImGui::Begin( "Frame info" ) )
@@ -10,6 +10,7 @@
 #include "filesystem/filesystem_plugin.h"
 #include "rdix/rdix_type.h"
 #include "rdix/rdix.h"
+#include "rdix/rdix_vertex_codec.h"
 
 #include "common/common.h"
 #include "foundation/hashed_string.h"
@@ -26,7 +27,10 @@ namespace helper
               .AddSlot( RDIEVertexSlot::NORMAL )
               .AddSlot( RDIEVertexSlot::TEXCOORD0 )
               .AddSlot( RDIEVertexSlot::BLENDWEIGHT )
-              .AddSlot( RDIEVertexSlot::BLENDINDICES );
+              .AddSlot( RDIEVertexSlot::BLENDINDICES )
+              .QuantizeAll()
+              .Lods( 4 )
+              .Meshlets();
     }
 
     static void SetToDefaults( tool::mesh::ImportOptions* opt, const char* filename )
@@ -124,12 +128,30 @@ void MESHTool::Tick( CMNEngine* e, const TOOLContext& ctx, float dt )
                     }
 
 
+                    int num_lods = (int)_compile_options.num_lods;
+                    if( ImGui::SliderInt( "LODs", &num_lods, 1, tool::mesh::CompileOptions::MAX_LODS ) )
+                    {
+                        _compile_options.Lods( (uint32_t)num_lods );
+                    }
+                    ImGui::Checkbox( "Meshlets", &_compile_options.meshlets );
+
                     ImGui::Separator();
                     if( ImGui::TreeNodeEx( "Stats", ImGuiTreeNodeFlags_DefaultOpen ) )
                     {
                         ImGui::Value( "Num vertices", streams.num_vertices );
                         ImGui::Value( "Num indices" , streams.num_indices );
                         ImGui::Value( "Num bones"   , streams.num_bones );
+                        if( _compile_report.num_input_vertices )
+                        {
+                            const tool::mesh::CompileReport& r = _compile_report;
+                            ImGui::Text( "ACMR: %.3f -> %.3f", r.input.acmr, r.output.acmr );
+                            ImGui::Text( "ATVR: %.3f -> %.3f", r.input.atvr, r.output.atvr );
+                            ImGui::Text( "Compiled vertices: %u (%u parts)", r.num_output_vertices, r.num_parts );
+                            for( uint32_t ilod = 0; ilod < r.num_lods; ++ilod )
+                                ImGui::Text( "LOD%u: %u triangles, error %f", ilod, r.lod_triangles[ilod], r.lod_error[ilod] );
+                            if( r.num_meshlets )
+                                ImGui::Text( "Meshlets: %u", r.num_meshlets );
+                        }
                         ImGui::TreePop();
                     }
 
@@ -149,6 +171,15 @@ void MESHTool::Tick( CMNEngine* e, const TOOLContext& ctx, float dt )
                                 {
                                     _compile_options.EnableSlot( (RDIEVertexSlot::Enum)islot, has_slot );
                                 }
+
+                                bool quantize = _compile_options.IsQuantized( islot );
+                                ImGui::SameLine();
+                                ImGui::PushID( islot );
+                                if( ImGui::Checkbox( "quantize", &quantize ) )
+                                {
+                                    _compile_options.Quantize( (RDIEVertexSlot::Enum)islot, quantize );
+                                }
+                                ImGui::PopID();
                             }
                         }
                         ImGui::TreePop();
@@ -249,7 +280,7 @@ bool MESHTool::_Import( CMNEngine* e )
 
 void MESHTool::_Compile( CMNEngine* e, const TOOLContext& ctx, const tool::mesh::Streams& streams )
 {
-    blob_t cmesh = tool::mesh::Compile( streams, _compile_options, _allocator );
+    blob_t cmesh = tool::mesh::Compile( streams, _compile_options, _allocator, &_compile_report );
     if( !cmesh.empty() )
     {
         RDIXMeshFile* mesh_file = (RDIXMeshFile*)cmesh.raw;
@@ -269,8 +300,26 @@ void VoxelizeMesh( VoxelizedMesh* output, const RDIXMeshFile* mesh, f32 voxel_si
 {
     AABB bounds = AABB::Prepare();
 
-    array_span_t<const u16> indices = GetIndexStream16( mesh );
-    array_span_t<const vec3_t> positions = GetVertexStream<vec3_t>( mesh, RDIEVertexSlot::POSITION );
+    // indices of compiled parts are relative to their draw range base vertex
+    array_span_t<const u16> part_indices = GetIndexStream16( mesh );
+    std::vector<u32> indices_data( part_indices.begin(), part_indices.end() );
+    for( const RDIXRenderSourceRange& range : GetDrawRanges( mesh ) )
+    {
+        for( uint32_t j = 0; j < range.count; ++j )
+            indices_data[range.begin + j] += range.base_vertex;
+    }
+    array_span_t<const u32> indices( indices_data.data(), (uint32_t)indices_data.size() );
+
+    const uint32_t position_stream = FindVertexStream( mesh, RDIEVertexSlot::POSITION );
+    if( position_stream == UINT32_MAX || mesh->descs[position_stream].ByteWidth() != sizeof( vec3_t ) )
+    {
+        SYS_LOG_ERROR( "VoxelizeMesh: mesh has no float3 positions" );
+        return;
+    }
+
+    std::vector<vec3_t> positions_data( mesh->num_vertices );
+    DecodeVertexStream( positions_data.data(), mesh, position_stream );
+    array_span_t<const vec3_t> positions( positions_data.data(), (uint32_t)positions_data.size() );
     for( const vec3_t& pos : positions )
     {
         bounds = AABB::Extend( bounds, pos );
@@ -287,11 +336,16 @@ void VoxelizeMesh( VoxelizedMesh* output, const RDIXMeshFile* mesh, f32 voxel_si
     array::resize( output->voxels, output->grid.NumCells() );
     memset( output->voxels.begin(), 0x00, array::size_in_bytes( output->voxels ) );
 
-    Voxelize(
-        to_array_span( output->voxels.begin(), output->voxels.size ),
-        output->grid.width, output->grid.height, output->grid.depth,
-        bounds,
-        positions, indices );
+    VoxelizeDesc desc;
+    desc.width = output->grid.width;
+    desc.height = output->grid.height;
+    desc.depth = output->grid.depth;
+    desc.bounds = bounds;
+
+    VoxelizeOutput voxelize_output;
+    voxelize_output.bytes = to_array_span( output->voxels.begin(), output->voxels.size );
+
+    Voxelize( desc, voxelize_output, positions, indices );
 }
 
 void MESHTool::_Load( CMNEngine* e, const TOOLContext& ctx, const char* filename )
@@ -52,6 +52,7 @@ struct MESHTool : TOOLInterface
     tool::mesh::StreamsArray _loaded_streams;
     tool::mesh::CompileOptions _compile_options;
     tool::mesh::ImportOptions _import_options;
+    tool::mesh::CompileReport _compile_report;
 
     srl_file_t* _mesh_file = nullptr;
 
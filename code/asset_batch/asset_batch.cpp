@@ -0,0 +1,422 @@
+#include "asset_batch.h"
+
+#include <memory/memory.h>
+#include <foundation/io.h>
+#include <foundation/hash.h>
+#include <foundation/serializer.h>
+#include <foundation/thread/thread_pool.h>
+#include <rdix/rdix_type.h>
+#include <anim/anim_struct.h>
+#include <anim/anim_stream.h>
+#include <filesystem/dirent.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+namespace tool { namespace batch {
+
+    // bump when compilers change output without changing file format version, invalidates all cached outputs
+    static constexpr uint32_t RULES_VERSION = 1;
+
+    static std::mutex g_log_lock;
+
+#define batch_log( str, ... ) do{ std::lock_guard<std::mutex> lock( g_log_lock ); fprintf( stdout, str, __VA_ARGS__ ); fflush( stdout ); }while(0)
+
+    Settings::Settings()
+    {
+        mesh_compile.slot_mask = 0;
+        mesh_compile.AddSlot( RDIEVertexSlot::POSITION )
+                    .AddSlot( RDIEVertexSlot::NORMAL )
+                    .AddSlot( RDIEVertexSlot::TEXCOORD0 )
+                    .AddSlot( RDIEVertexSlot::BLENDWEIGHT )
+                    .AddSlot( RDIEVertexSlot::BLENDINDICES )
+                    .QuantizeAll()
+                    .Lods( 4 )
+                    .Meshlets();
+    }
+
+    struct Source
+    {
+        std::string path;                  // relative to input dir
+        std::string hash;
+        std::vector<std::string> outputs;  // relative to output dir
+
+        enum EResult : uint8_t { FAILED = 0, COMPILED, CACHED, };
+        EResult result = FAILED;
+    };
+
+    struct ManifestEntry
+    {
+        std::string hash;
+        std::vector<std::string> outputs;
+    };
+    using Manifest = std::unordered_map<std::string, ManifestEntry>;
+
+    // --- paths
+    static void NormalizeDir( std::string* dir )
+    {
+        std::replace( dir->begin(), dir->end(), '\\', '/' );
+        if( !dir->empty() && dir->back() != '/' )
+            dir->push_back( '/' );
+    }
+
+    static bool HasExtension( const char* name, const char* ext )
+    {
+        const char* name_ext = strrchr( name, '.' );
+        if( !name_ext )
+            return false;
+
+        for( ; *name_ext && *ext; ++name_ext, ++ext )
+        {
+            if( tolower( *name_ext ) != *ext )
+                return false;
+        }
+        return *name_ext == *ext;
+    }
+
+    static bool IsSceneFile( const char* name )
+    {
+        return HasExtension( name, ".fbx" ) || HasExtension( name, ".obj" ) || HasExtension( name, ".dae" );
+    }
+
+    static void ListSources( std::vector<Source>* sources, const std::string& root, const std::string& relative_dir )
+    {
+        const std::string abs_dir = root + relative_dir;
+        DIR* dir = opendir( abs_dir.c_str() );
+        if( !dir )
+            return;
+
+        while( struct dirent* ent = readdir( dir ) )
+        {
+            if( !strcmp( ent->d_name, "." ) || !strcmp( ent->d_name, ".." ) )
+                continue;
+
+            if( ent->d_type == DT_DIR )
+            {
+                ListSources( sources, root, relative_dir + ent->d_name + "/" );
+            }
+            else if( ent->d_type == DT_REG && IsSceneFile( ent->d_name ) )
+            {
+                Source source;
+                source.path = relative_dir + ent->d_name;
+                sources->push_back( std::move( source ) );
+            }
+        }
+        closedir( dir );
+    }
+
+    static void CreateDirs( const std::string& root, const std::string& relative_file )
+    {
+        for( size_t pos = relative_file.find( '/' ); pos != std::string::npos; pos = relative_file.find( '/', pos + 1 ) )
+        {
+            const std::string dir = root + relative_file.substr( 0, pos );
+            CreateDir( dir.c_str() );
+        }
+    }
+
+    static bool FileExists( const std::string& path )
+    {
+        FILE* f = fopen( path.c_str(), "rb" );
+        if( f )
+            fclose( f );
+
+        return f != nullptr;
+    }
+
+    // --- hashing
+    struct HashStream
+    {
+        std::vector<uint8_t> bytes;
+
+        template< typename T >
+        HashStream& Add( const T& value )
+        {
+            const uint8_t* begin = (const uint8_t*)&value;
+            bytes.insert( bytes.end(), begin, begin + sizeof( T ) );
+            return *this;
+        }
+    };
+
+    // everything what affects outputs apart from source content. Fields are added one by one to skip padding
+    static HashStream HashSettings( const Settings& settings )
+    {
+        const mesh::CompileOptions& mc = settings.mesh_compile;
+        const anim::ImportParams& ai = settings.anim_import;
+        const anim::ResampleParams& ar = settings.anim_resample;
+
+        HashStream hs;
+        hs.Add( RULES_VERSION ).Add( RDIXMeshFile::VERSION ).Add( ANIMSkel::VERSION ).Add( ANIMClip::VERSION ).Add( ANIMClipStream::VERSION );
+        hs.Add( mc.slot_mask ).Add( mc.quantize_mask ).Add( mc.num_lods ).Add( mc.lod_ratio ).Add( mc.lod_error ).Add( (uint8_t)mc.meshlets );
+        hs.Add( ai.scale ).Add( ai.root_motion_joint ).Add( (uint8_t)ai.extract_root_motion ).Add( (uint8_t)ai.remove_root_motion ).Add( (uint8_t)ai.strip_namespace_name );
+        hs.Add( ar.tolerance ).Add( ar.shell_distance ).Add( (uint8_t)ar.additive );
+        hs.Add( settings.anim_stream_min_duration ).Add( settings.anim_segment_duration );
+        hs.Add( settings.mesh_fbx_scale );
+        return hs;
+    }
+
+    static std::string HashSource( const void* data, uint32_t data_size, const HashStream& settings_hash )
+    {
+        uint64_t content_hash[2] = {};
+        murmur3_hash128( content_hash, data, data_size, 0 );
+
+        HashStream hs = settings_hash;
+        hs.Add( content_hash ).Add( data_size );
+
+        uint64_t hash[2] = {};
+        murmur3_hash128( hash, hs.bytes.data(), (uint32_t)hs.bytes.size(), 0 );
+
+        char str[33] = {};
+        snprintf( str, sizeof( str ), "%016llx%016llx", (unsigned long long)hash[0], (unsigned long long)hash[1] );
+        return str;
+    }
+
+    // --- manifest: one line per source, tab separated: hash, source, outputs...
+    static void ReadManifest( Manifest* manifest, const std::string& filename, BXIAllocator* allocator )
+    {
+        unsigned char* data = nullptr;
+        unsigned data_size = 0;
+        if( ReadTextFile( &data, &data_size, filename.c_str(), allocator ) != IO_OK )
+            return;
+
+        const char* line = (const char*)data;
+        const char* data_end = line + data_size;
+        while( line < data_end )
+        {
+            const char* line_end = (const char*)memchr( line, '\n', data_end - line );
+            line_end = ( line_end ) ? line_end : data_end;
+
+            std::vector<std::string> fields;
+            for( const char* field = line; field < line_end; )
+            {
+                const char* field_end = (const char*)memchr( field, '\t', line_end - field );
+                field_end = ( field_end ) ? field_end : line_end;
+                fields.emplace_back( field, field_end - field );
+                field = field_end + 1;
+            }
+
+            if( fields.size() >= 2 && fields[0][0] != '#' )
+            {
+                ManifestEntry& entry = (*manifest)[fields[1]];
+                entry.hash = fields[0];
+                entry.outputs.assign( fields.begin() + 2, fields.end() );
+            }
+            line = line_end + 1;
+        }
+
+        BX_FREE( allocator, data );
+    }
+
+    static bool WriteManifest( const std::string& filename, const std::vector<Source>& sources )
+    {
+        std::string text = "# hash\tsource\toutputs\n";
+        for( const Source& source : sources )
+        {
+            if( source.result == Source::FAILED )
+                continue;
+
+            text += source.hash + "\t" + source.path;
+            for( const std::string& output : source.outputs )
+                text += "\t" + output;
+            text += "\n";
+        }
+        return WriteFile( filename.c_str(), text.data(), text.size() ) >= 0;
+    }
+
+    // --- compilation
+    template< typename T >
+    static bool WriteSerialized( Source* source, const Options& options, const std::string& output, blob_t blob, BXIAllocator* allocator )
+    {
+        if( blob.empty() )
+            return false;
+
+        srl_file_t* file = srl_file::serialize<T>( blob, allocator );
+        blob.destroy();
+
+        CreateDirs( options.output_dir, output );
+        const std::string path = options.output_dir + output;
+        const bool written = WriteFile( path.c_str(), file, file->size ) >= 0;
+        BX_FREE( allocator, file );
+
+        if( written )
+            source->outputs.push_back( output );
+        else
+            batch_log( "error: cannot write '%s'\n", path.c_str() );
+
+        return written;
+    }
+
+    static std::string SanitizeName( const std::string& name )
+    {
+        std::string result = name;
+        for( char& c : result )
+            c = ( isalnum( (unsigned char)c ) || c == '_' || c == '-' ) ? c : '_';
+
+        return result;
+    }
+
+    static bool Compile( Source* source, const Options& options, const void* data, uint32_t data_size, BXIAllocator* allocator )
+    {
+        const Settings& settings = options.settings;
+        const std::string base_name = source->path.substr( 0, source->path.find_last_of( '.' ) );
+
+        bool success = true;
+
+        mesh::ImportOptions import_options;
+        import_options.scale = vec3_t( HasExtension( source->path.c_str(), ".fbx" ) ? settings.mesh_fbx_scale : 1.f );
+
+        const mesh::StreamsArray streams_array = mesh::Import( data, data_size, import_options );
+        bool imported = !streams_array.empty();
+        for( size_t i = 0; i < streams_array.size(); ++i )
+        {
+            const mesh::Streams& streams = streams_array[i];
+
+            std::string output = base_name;
+            if( streams_array.size() > 1 )
+                output += "." + ( streams.name.empty() ? std::to_string( i ) : SanitizeName( streams.name ) );
+            output += ".mesh";
+
+            success &= WriteSerialized<RDIXMeshFile>( source, options, output, mesh::Compile( streams, settings.mesh_compile, allocator ), allocator );
+        }
+
+        anim::Skeleton skeleton;
+        anim::Animation animation;
+        if( anim::Import( &skeleton, &animation, data, data_size, settings.anim_import ) )
+        {
+            imported = true;
+            blob_t skel_blob = anim::CompileSkeleton( skeleton, allocator, anim::SKEL_CLO_INCLUDE_STRING_NAMES );
+            success &= WriteSerialized<ANIMSkel>( source, options, base_name + ".skel", skel_blob, allocator );
+
+            const float duration = animation.endTime - animation.startTime;
+            if( settings.anim_stream_min_duration > 0.f && duration >= settings.anim_stream_min_duration )
+            {
+                std::vector<blob_t> segment_blobs;
+                const std::string stream_name = base_name + ".clipstream";
+                blob_t stream_blob = anim::CompileClipStream( &segment_blobs, animation, skeleton, settings.anim_segment_duration, allocator, &settings.anim_resample );
+                success &= WriteSerialized<ANIMClipStream>( source, options, stream_name, stream_blob, allocator );
+
+                for( uint32_t i = 0; i < (uint32_t)segment_blobs.size(); ++i )
+                {
+                    char segment_name[512];
+                    ClipSegmentPath( segment_name, sizeof( segment_name ), stream_name.c_str(), i );
+                    success &= WriteSerialized<ANIMClip>( source, options, segment_name, segment_blobs[i], allocator );
+                }
+            }
+            else
+            {
+                blob_t clip_blob = anim::CompileClip( animation, skeleton, allocator, &settings.anim_resample );
+                success &= WriteSerialized<ANIMClip>( source, options, base_name + ".clip", clip_blob, allocator );
+            }
+        }
+
+        if( !imported )
+        {
+            batch_log( "error: '%s' has neither meshes nor animation\n", source->path.c_str() );
+            return false;
+        }
+        return success;
+    }
+
+    static void Process( Source* source, const Options& options, const HashStream& settings_hash, const Manifest& manifest, BXIAllocator* allocator )
+    {
+        const std::string path = options.input_dir + source->path;
+
+        unsigned char* data = nullptr;
+        unsigned data_size = 0;
+        if( ReadFile( &data, &data_size, path.c_str(), allocator ) != IO_OK )
+        {
+            batch_log( "error: cannot read '%s'\n", path.c_str() );
+            return;
+        }
+
+        source->hash = HashSource( data, data_size, settings_hash );
+
+        const Manifest::const_iterator cached = manifest.find( source->path );
+        if( cached != manifest.end() && cached->second.hash == source->hash )
+        {
+            bool outputs_exist = !cached->second.outputs.empty();
+            for( const std::string& output : cached->second.outputs )
+                outputs_exist = outputs_exist && FileExists( options.output_dir + output );
+
+            if( outputs_exist )
+            {
+                source->outputs = cached->second.outputs;
+                source->result = Source::CACHED;
+            }
+        }
+
+        if( source->result != Source::CACHED )
+        {
+            batch_log( "%s...\n", source->path.c_str() );
+            source->result = ( Compile( source, options, data, data_size, allocator ) ) ? Source::COMPILED : Source::FAILED;
+        }
+        else if( options.verbose )
+        {
+            batch_log( "%s (up to date)\n", source->path.c_str() );
+        }
+
+        BX_FREE( allocator, data );
+    }
+
+    int Run( const Options& in_options, BXIAllocator* allocator, Report* report )
+    {
+        Options options = in_options;
+        NormalizeDir( &options.input_dir );
+        NormalizeDir( &options.output_dir );
+
+        std::vector<Source> sources;
+        ListSources( &sources, options.input_dir, "" );
+        std::sort( sources.begin(), sources.end(), []( const Source& a, const Source& b ) { return a.path < b.path; } );
+
+        CreateDir( options.output_dir.c_str() );
+        const std::string manifest_filename = options.output_dir + MANIFEST_FILENAME;
+
+        Manifest manifest;
+        if( !options.force )
+            ReadManifest( &manifest, manifest_filename, allocator );
+
+        const HashStream settings_hash = HashSettings( options.settings );
+
+        // calling thread is one of the jobs
+        thread_pool_t* pool = nullptr;
+        if( options.num_jobs != 1 && sources.size() > 1 )
+            pool = thread_pool::create( allocator, ( options.num_jobs ) ? options.num_jobs - 1 : 0 );
+
+        auto process = [&]( uint32_t begin, uint32_t end, uint32_t )
+        {
+            for( uint32_t i = begin; i < end; ++i )
+                Process( &sources[i], options, settings_hash, manifest, allocator );
+        };
+        thread_pool::parallel_for( pool, (uint32_t)sources.size(), 1, process );
+        thread_pool::destroy( &pool );
+
+        Report result;
+        result.num_sources = (uint32_t)sources.size();
+        for( const Source& source : sources )
+        {
+            result.num_compiled += ( source.result == Source::COMPILED ) ? 1 : 0;
+            result.num_cached += ( source.result == Source::CACHED ) ? 1 : 0;
+            result.num_failed += ( source.result == Source::FAILED ) ? 1 : 0;
+            result.num_outputs += (uint32_t)source.outputs.size();
+        }
+
+        // failed sources are left out, so they are retried next time
+        if( !WriteManifest( manifest_filename, sources ) )
+        {
+            batch_log( "error: cannot write '%s'\n", manifest_filename.c_str() );
+            result.num_failed += 1;
+        }
+
+        batch_log( "%u sources: %u compiled, %u up to date, %u failed\n", result.num_sources, result.num_compiled, result.num_cached, result.num_failed );
+
+        if( report )
+            report[0] = result;
+
+        return ( result.num_failed ) ? -1 : 0;
+    }
+
+}}//
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <asset_compiler/mesh/mesh_compiler.h>
+#include <asset_compiler/anim/anim_compiler.h>
+
+struct BXIAllocator;
+
+// Headless compilation of a source tree. Every scene file (.fbx, .obj, .dae) produces .mesh file per mesh
+// and .skel/.clip pair when it contains animation (long clips go to .clipstream + .clipseg segments).
+// Outputs mirror source directories.
+// Sources whose content hash (together with settings and file format versions) matches manifest entry
+// from previous run are skipped as long as all their outputs still exist.
+namespace tool { namespace batch {
+
+    static constexpr char MANIFEST_FILENAME[] = "asset_manifest.txt";
+
+    struct Settings
+    {
+        mesh::CompileOptions mesh_compile;
+        anim::ImportParams anim_import;
+        anim::ResampleParams anim_resample;
+        float anim_stream_min_duration = 10.f;  // longer clips are written as .clipstream + segments, 0 disables
+        float anim_segment_duration = 1.f;
+        float mesh_fbx_scale = 0.01f;   // mesh import scale for .fbx, other formats are imported as is
+
+        Settings(); // defaults match asset_app
+    };
+
+    struct Options
+    {
+        std::string input_dir;
+        std::string output_dir;
+        Settings settings;
+        uint32_t num_jobs = 0;   // 0 uses all hardware threads
+        bool force = false;      // ignore manifest from previous run
+        bool verbose = false;    // report cached sources too
+    };
+
+    struct Report
+    {
+        uint32_t num_sources = 0;
+        uint32_t num_compiled = 0;
+        uint32_t num_cached = 0;
+        uint32_t num_failed = 0;
+        uint32_t num_outputs = 0;
+    };
+
+    // returns 0 when no source failed (compiled or up to date), -1 otherwise
+    int Run( const Options& options, BXIAllocator* allocator, Report* report = nullptr );
+
+}}//
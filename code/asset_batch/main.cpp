@@ -0,0 +1,60 @@
+#include "asset_batch.h"
+#include <memory/memory.h>
+#include <3rd_party/AnyOption/anyoption.h>
+#include "memory/memory_plugin.h"
+
+#include <stdlib.h>
+
+int main( int argc, char** argv )
+{
+    AnyOption opt;
+    opt.addUsage( "" );
+    opt.addUsage( "Usage:" );
+    opt.addUsage( "" );
+    opt.addUsage( "--input-dir      source tree root (absolute path)" );
+    opt.addUsage( "--output-dir     output directory, keeps asset_manifest.txt (absolute path)" );
+    opt.addUsage( "--jobs           number of parallel jobs (default: all hardware threads)" );
+    opt.addUsage( "--force          recompile everything, ignore manifest" );
+    opt.addUsage( "--verbose        report up to date sources too" );
+
+    opt.setOption( "input-dir" );
+    opt.setOption( "output-dir" );
+    opt.setOption( "jobs" );
+    opt.setFlag( "force" );
+    opt.setFlag( "verbose" );
+
+    opt.processCommandArgs( argc, argv );
+    if( !opt.hasOptions() )
+    {
+        opt.printUsage();
+        return -1;
+    }
+
+    const char* input_dir = opt.getValue( "input-dir" );
+    const char* output_dir = opt.getValue( "output-dir" );
+    const char* jobs = opt.getValue( "jobs" );
+
+    if( !input_dir || !output_dir )
+    {
+        opt.printUsage();
+        return -2;
+    }
+
+    BXMemoryStartUp();
+    BXIAllocator* allocator = BXDefaultAllocator();
+
+    int result = 0;
+    {
+        tool::batch::Options options;
+        options.input_dir = input_dir;
+        options.output_dir = output_dir;
+        options.num_jobs = ( jobs ) ? (uint32_t)atoi( jobs ) : 0;
+        options.force = opt.getFlag( "force" );
+        options.verbose = opt.getFlag( "verbose" );
+
+        result = tool::batch::Run( options, allocator );
+    }
+
+    BXMemoryShutDown();
+    return result;
+}
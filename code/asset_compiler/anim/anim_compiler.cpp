@@ -237,6 +237,12 @@ namespace tool{ namespace anim {
     bool Import( Skeleton* skeleton, Animation* animation, const void* data, uint32_t data_size, const ImportParams& params )
     {
         const aiScene* scene = aiImportFileFromMemory( (const char*)data, data_size, 0, nullptr );
+        if( scene && !scene->HasAnimations() )
+        {
+            aiReleaseImport( scene );
+            scene = nullptr;
+        }
+
         if( scene )
         {
             _ExtractSkeleton( skeleton, scene );
@@ -325,6 +331,35 @@ namespace tool{ namespace anim {
         const uint32_t base_pose_size = num_joints * sizeof( Joint );
         const uint32_t joint_name_hashes_size = num_joints * sizeof( hashed_string_t );
 
+        // joints grouped by depth, joints within one level don't depend on each other
+        // and are transformed together (see anim_local_joints_to_world_levels.cpp)
+        std::vector<uint16_t> joint_depth( num_joints, 0 );
+        uint32_t num_levels = 0;
+        for( uint32_t i = 0; i < num_joints; ++i )
+        {
+            const uint16_t parent_idx = in_skeleton.parentIndices[i];
+            SYS_ASSERT( parent_idx == 0xFFFF || parent_idx < i );
+            joint_depth[i] = ( parent_idx == 0xFFFF ) ? 0 : joint_depth[parent_idx] + 1;
+            num_levels = max_of_2( num_levels, (uint32_t)joint_depth[i] + 1 );
+        }
+        SYS_ASSERT( num_levels <= UINT16_MAX );
+
+        std::vector<uint16_t> level_begin( num_levels + 1, 0 );
+        for( uint32_t i = 0; i < num_joints; ++i )
+            level_begin[joint_depth[i] + 1] += 1;
+        for( uint32_t i = 0; i < num_levels; ++i )
+            level_begin[i + 1] += level_begin[i];
+
+        std::vector<uint16_t> level_joints( num_joints );
+        {
+            std::vector<uint16_t> level_cursor( level_begin.begin(), level_begin.end() - 1 );
+            for( uint32_t i = 0; i < num_joints; ++i )
+                level_joints[level_cursor[joint_depth[i]]++] = (uint16_t)i;
+        }
+
+        const uint32_t level_joints_size = num_joints * sizeof( uint16_t );
+        const uint32_t level_begin_size = ( num_levels + 1 ) * sizeof( uint16_t );
+
         u32 joint_name_strings_size = 0;
         if( flags & SKEL_CLO_INCLUDE_STRING_NAMES )
         {
@@ -339,6 +374,8 @@ namespace tool{ namespace anim {
         memory_size += base_pose_size;
         memory_size += parent_indices_size;
         memory_size += joint_name_hashes_size;
+        memory_size += level_joints_size;
+        memory_size += level_begin_size;
         memory_size += joint_name_strings_size;
 
         blob_t blob = blob_t::allocate( allocator, memory_size, 16 );
@@ -351,11 +388,16 @@ namespace tool{ namespace anim {
         uint8_t* base_pose_address = chunker.Add<u8>( base_pose_size );
         uint8_t* parent_indices_address = chunker.Add<u8>( parent_indices_size );
         uint8_t* joint_name_hashes_address = chunker.Add<u8>( joint_name_hashes_size );
+        uint8_t* level_joints_address = chunker.Add<u8>( level_joints_size );
+        uint8_t* level_begin_address = chunker.Add<u8>( level_begin_size );
         
         out_skeleton->numJoints = num_joints;
+        out_skeleton->numLevels = num_levels;
         out_skeleton->offsetBasePose = TYPE_POINTER_GET_OFFSET( &out_skeleton->offsetBasePose, base_pose_address );
         out_skeleton->offsetParentIndices = TYPE_POINTER_GET_OFFSET( &out_skeleton->offsetParentIndices, parent_indices_address );
         out_skeleton->offsetJointNames = TYPE_POINTER_GET_OFFSET( &out_skeleton->offsetJointNames, joint_name_hashes_address );
+        out_skeleton->offsetLevelJoints = TYPE_POINTER_GET_OFFSET( &out_skeleton->offsetLevelJoints, level_joints_address );
+        out_skeleton->offsetLevelBegin = TYPE_POINTER_GET_OFFSET( &out_skeleton->offsetLevelBegin, level_begin_address );
 
         std::vector< ANIMJoint > world_bind_pose;
         world_bind_pose.resize( num_joints );
@@ -365,6 +407,8 @@ namespace tool{ namespace anim {
 
         memcpy( base_pose_address, world_bind_pose.data(), base_pose_size );
         memcpy( parent_indices_address, &in_skeleton.parentIndices[0], parent_indices_size );
+        memcpy( level_joints_address, level_joints.data(), level_joints_size );
+        memcpy( level_begin_address, level_begin.data(), level_begin_size );
 
         hashed_string_t* joint_name_hashes = (hashed_string_t*)joint_name_hashes_address;
         for( size_t i = 0; i < in_skeleton.jointNames.size(); ++i )
@@ -397,8 +441,16 @@ namespace tool{ namespace anim {
         return blob;
     }
 
-    blob_t CompileClip( const Animation& in_animation, const Skeleton& in_skeleton, BXIAllocator* allocator )
+    blob_t CompileClip( const Animation& in_animation_src, const Skeleton& in_skeleton, BXIAllocator* allocator, const ResampleParams* resample, ResampleReport* report )
     {
+        Animation resampled;
+        if( resample )
+        {
+            resampled = in_animation_src;
+            Resample( &resampled, in_skeleton, *resample, report );
+        }
+        const Animation& in_animation = ( resample ) ? resampled : in_animation_src;
+
         const uint32_t num_joints = (uint32_t)in_skeleton.jointNames.size();
         const uint32_t num_frames = in_animation.numFrames;
         const uint32_t channel_data_size = num_joints * num_frames * sizeof( float4_t );
@@ -483,6 +535,78 @@ namespace tool{ namespace anim {
         return blob;
     }
 
+    static void CopyKeys( JointAnimation* dst, const JointAnimation& src, uint32_t first, uint32_t last )
+    {
+        dst->name = src.name;
+        dst->weight = src.weight;
+        dst->rotation.assign( src.rotation.begin() + first, src.rotation.begin() + last + 1 );
+        dst->translation.assign( src.translation.begin() + first, src.translation.begin() + last + 1 );
+        dst->scale.assign( src.scale.begin() + first, src.scale.begin() + last + 1 );
+    }
+
+    blob_t CompileClipStream( std::vector<blob_t>* out_segments, const Animation& in_animation_src, const Skeleton& in_skeleton, float segment_duration, BXIAllocator* allocator, const ResampleParams* resample, ResampleReport* report )
+    {
+        Animation resampled;
+        if( resample )
+        {
+            resampled = in_animation_src;
+            Resample( &resampled, in_skeleton, *resample, report );
+        }
+        const Animation& in_animation = ( resample ) ? resampled : in_animation_src;
+
+        const uint32_t num_joints = (uint32_t)in_skeleton.jointNames.size();
+        const uint32_t num_frames = in_animation.numFrames;
+        const float frequency = in_animation.sampleFrequency;
+        const uint32_t segment_frames = max_of_2( 1u, (uint32_t)( segment_duration * frequency + 0.5f ) );
+        const uint32_t num_segments = max_of_2( 1u, ( num_frames - 1 + segment_frames - 1 ) / segment_frames );
+        const bool has_root_motion = Size( in_animation.root_motion ) == num_frames;
+        SYS_ASSERT( num_segments <= UINT16_MAX );
+
+        out_segments->clear();
+        out_segments->reserve( num_segments );
+
+        for( uint32_t iseg = 0; iseg < num_segments; ++iseg )
+        {
+            const uint32_t first = iseg * segment_frames;
+            const uint32_t last = min_of_2( first + segment_frames, num_frames - 1 );
+
+            // last segment keeps whatever is left after last frame, so wrap around at clip end behaves as before
+            Animation segment;
+            segment.startTime = 0.f;
+            segment.endTime = ( iseg + 1 == num_segments ) ? ( in_animation.endTime - in_animation.startTime ) - first / frequency : ( last - first ) / frequency;
+            segment.sampleFrequency = frequency;
+            segment.numFrames = last - first + 1;
+
+            segment.joints.resize( num_joints );
+            for( uint32_t j = 0; j < num_joints; ++j )
+                CopyKeys( &segment.joints[j], in_animation.joints[j], first, last );
+
+            if( has_root_motion )
+                CopyKeys( &segment.root_motion, in_animation.root_motion, first, last );
+
+            out_segments->push_back( CompileClip( segment, in_skeleton, allocator ) );
+        }
+
+        blob_t blob = blob_t::allocate( allocator, sizeof( ANIMClipStream ), 16 );
+
+        BufferChunker chunker( blob.raw, (u32)blob.size );
+
+        ANIMClipStream* stream = chunker.Add<ANIMClipStream>();
+        memset( stream, 0, sizeof( ANIMClipStream ) );
+
+        stream->duration = in_animation.endTime - in_animation.startTime;
+        stream->sampleFrequency = frequency;
+        stream->segmentDuration = segment_frames / frequency;
+        stream->numJoints = num_joints;
+        stream->numSegments = num_segments;
+        stream->numFrames = num_frames;
+        stream->segmentFrames = segment_frames;
+
+        chunker.Check();
+
+        return blob;
+    }
+
     ////
     ////
     bool ExportSkeletonToFile( const char* out_filename, const Skeleton& in_skeleton, BXIAllocator* allocator )
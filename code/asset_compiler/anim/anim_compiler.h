@@ -62,6 +62,33 @@ namespace tool { namespace anim {
         };
 
         bool Import( Skeleton* skeleton, Animation* animation, const void* data, uint32_t data_size, const ImportParams& params = {} );
+
+        struct ResampleParams
+        {
+            float tolerance = 0.001f;       // max model space error, in imported units (after ImportParams::scale)
+            float shell_distance = 0.03f;   // rotation and scale error is measured at points this far from each joint
+            bool additive = false;          // clip holds deltas on top of skeleton base pose (rot: base * delta, pos: base + delta, scale: base * delta)
+        };
+
+        struct ResampleReport
+        {
+            float src_sample_frequency = 0.f;
+            uint32_t src_num_frames = 0;
+            float sample_frequency = 0.f;
+            uint32_t num_frames = 0;
+
+            // model space error of resampled clip, measured at source frame times
+            std::vector<float> joint_error;
+            std::vector<float> joint_error_time;
+            uint32_t worst_joint = UINT32_MAX;
+            float max_error = 0.f;
+            float root_motion_error = 0.f;
+        };
+
+        // Replaces keys with uniform frames at the lowest rate for which every joint (with its whole parent chain)
+        // and root motion stay within tolerance. Frames are placed so the last one lands exactly on clip end.
+        // Returns false when clip is too short to resample, animation is left untouched then.
+        bool Resample( Animation* animation, const Skeleton& skeleton, const ResampleParams& params, ResampleReport* report = nullptr );
         
         enum ComplileOptions
         {
@@ -70,7 +97,12 @@ namespace tool { namespace anim {
         // produces data with ANIMSkel header
         blob_t CompileSkeleton( const Skeleton& in_skeleton, BXIAllocator* allocator, u32 flags = 0 );
         // produces data with ANIMClip header
-        blob_t CompileClip( const Animation& in_animation, const Skeleton& in_skeleton, BXIAllocator* allocator );
+        // resample: optional Resample() pass on a copy of in_animation
+        blob_t CompileClip( const Animation& in_animation, const Skeleton& in_skeleton, BXIAllocator* allocator, const ResampleParams* resample = nullptr, ResampleReport* report = nullptr );
+
+        // produces data with ANIMClipStream header, out_segments receive one blob with ANIMClip header per segment
+        // (to be written as ClipSegmentPath() files next to the stream file)
+        blob_t CompileClipStream( std::vector<blob_t>* out_segments, const Animation& in_animation, const Skeleton& in_skeleton, float segment_duration, BXIAllocator* allocator, const ResampleParams* resample = nullptr, ResampleReport* report = nullptr );
 
         bool ExportSkeletonToFile( const char* out_filename, const Skeleton& in_skeleton, BXIAllocator* allocator );
         bool ExportAnimationToFile( const char* out_filename, const Animation& in_animation, const Skeleton& in_skeleton, BXIAllocator* allocator );
@@ -0,0 +1,347 @@
+#include "anim_compiler.h"
+
+#include <foundation/debug.h>
+#include <foundation/common.h>
+#include <foundation/math/vmath.h>
+#include <anim/anim.h>
+
+#include <algorithm>
+#include <math.h>
+
+namespace tool { namespace anim {
+
+    static inline quat_t ToQuat( const float4_t& f ) { return quat_t( f.x, f.y, f.z, f.w ); }
+    static inline vec4_t ToVec4( const float4_t& f ) { return vec4_t( f.x, f.y, f.z, f.w ); }
+    static inline float4_t ToFloat4( const quat_t& q ) { return float4_t( q.x, q.y, q.z, q.w ); }
+    static inline float4_t ToFloat4( const vec4_t& v ) { return float4_t( v.x, v.y, v.z, v.w ); }
+
+    static void FindKeys( uint32_t* k0, uint32_t* k1, float* alpha, const std::vector<AnimKeyframe>& keys, float time )
+    {
+        const auto it = std::upper_bound( keys.begin(), keys.end(), time, []( float t, const AnimKeyframe& key ) { return t < key.time; } );
+        const uint32_t next = (uint32_t)( it - keys.begin() );
+        if( next == 0 || next == keys.size() )
+        {
+            k0[0] = k1[0] = ( next == 0 ) ? 0 : next - 1;
+            alpha[0] = 0.f;
+            return;
+        }
+
+        k0[0] = next - 1;
+        k1[0] = next;
+        const float dt = keys[next].time - keys[next - 1].time;
+        alpha[0] = ( dt > 0.f ) ? ( time - keys[next - 1].time ) / dt : 0.f;
+    }
+
+    static quat_t SampleRotation( const std::vector<AnimKeyframe>& keys, float time )
+    {
+        uint32_t k0, k1; float alpha;
+        FindKeys( &k0, &k1, &alpha, keys, time );
+        return ( k0 == k1 ) ? ToQuat( keys[k0].data ) : slerp( alpha, ToQuat( keys[k0].data ), ToQuat( keys[k1].data ) );
+    }
+
+    static vec4_t SampleVector( const std::vector<AnimKeyframe>& keys, float time )
+    {
+        uint32_t k0, k1; float alpha;
+        FindKeys( &k0, &k1, &alpha, keys, time );
+        return lerp( alpha, ToVec4( keys[k0].data ), ToVec4( keys[k1].data ) );
+    }
+
+    // value of channels without keys. Additive clips hold deltas, so there it's identity delta instead of base pose
+    static ANIMJoint EmptyChannelJoint( const Joint& base_pose, bool additive )
+    {
+        if( additive )
+            return ANIMJoint::identity();
+
+        ANIMJoint joint;
+        joint.rotation = ToQuat( base_pose.rotation );
+        joint.position = ToVec4( base_pose.translation );
+        joint.scale = ToVec4( base_pose.scale );
+        return joint;
+    }
+
+    // source keys, evaluated by time
+    static ANIMJoint SampleJoint( const JointAnimation& janim, const ANIMJoint& empty_channel, float time )
+    {
+        ANIMJoint joint;
+        joint.rotation = ( janim.rotation.empty() ) ? empty_channel.rotation : SampleRotation( janim.rotation, time );
+        joint.position = ( janim.translation.empty() ) ? empty_channel.position : SampleVector( janim.translation, time );
+        joint.scale = ( janim.scale.empty() ) ? empty_channel.scale : SampleVector( janim.scale, time );
+        return joint;
+    }
+
+    // uniform frames, evaluated the same way as EvaluateClip does at runtime
+    static ANIMJoint SampleFrames( const ANIMJoint* frames, uint32_t num_joints, uint32_t num_segments, uint32_t joint, float frame )
+    {
+        const uint32_t k = min_of_2( (uint32_t)frame, num_segments - 1 );
+        const float alpha = frame - (float)k;
+
+        const ANIMJoint& a = frames[k * num_joints + joint];
+        const ANIMJoint& b = frames[( k + 1 ) * num_joints + joint];
+
+        ANIMJoint result;
+        result.rotation = slerp( alpha, a.rotation, b.rotation );
+        result.position = lerp( alpha, a.position, b.position );
+        result.scale = lerp( alpha, a.scale, b.scale );
+        return result;
+    }
+
+    static ANIMJoint ApplyAdditive( const ANIMJoint& delta, const Joint& base_pose )
+    {
+        ANIMJoint joint;
+        joint.rotation = normalize( ToQuat( base_pose.rotation ) * delta.rotation );
+        joint.position = ToVec4( base_pose.translation ) + vec4_t( delta.position.xyz(), 0.f );
+        joint.scale = mul_per_elem( ToVec4( base_pose.scale ), delta.scale );
+        return joint;
+    }
+
+    static inline vec3_t TransformPoint( const ANIMJoint& joint, const vec3_t& point )
+    {
+        return joint.position.xyz() + rotate( joint.rotation, mul_per_elem( vec4_t( point, 0.f ), joint.scale ).xyz() );
+    }
+
+    struct ResampleContext
+    {
+        const Animation* animation = nullptr;
+        const Skeleton* skeleton = nullptr;
+        const ResampleParams* params = nullptr;
+
+        uint32_t num_joints = 0;
+        float duration = 0.f;
+        std::vector<float> eval_times;          // source frame times
+        std::vector<ANIMJoint> reference_ms;    // eval_times.size() * num_joints
+        std::vector<vec3_t> reference_root;     // eval_times.size(), empty without root motion
+        std::vector<ANIMJoint> empty_channel;   // num_joints, see EmptyChannelJoint
+
+        // scratch
+        std::vector<ANIMJoint> frames;
+        std::vector<vec3_t> frames_root;
+        std::vector<ANIMJoint> pose_ls;
+        std::vector<ANIMJoint> pose_ms;
+    };
+
+    static void ToModelSpace( ANIMJoint* pose_ms, ANIMJoint* pose_ls, const ResampleContext& ctx )
+    {
+        if( ctx.params->additive )
+        {
+            for( uint32_t j = 0; j < ctx.num_joints; ++j )
+                pose_ls[j] = ApplyAdditive( pose_ls[j], ctx.skeleton->basePose[j] );
+        }
+        LocalJointsToWorldJoints( pose_ms, pose_ls, ctx.skeleton->parentIndices.data(), ctx.num_joints, ANIMJoint::identity() );
+    }
+
+    static float JointError( const ANIMJoint& a, const ANIMJoint& b, float shell_distance )
+    {
+        const vec3_t points[] =
+        {
+            vec3_t( 0.f ),
+            vec3_t( shell_distance, 0.f, 0.f ),
+            vec3_t( 0.f, shell_distance, 0.f ),
+            vec3_t( 0.f, 0.f, shell_distance ),
+        };
+
+        float error = 0.f;
+        for( const vec3_t& p : points )
+            error = max_of_2( error, length( TransformPoint( a, p ) - TransformPoint( b, p ) ) );
+
+        return error;
+    }
+
+    static void BuildFrames( ResampleContext* ctx, uint32_t num_segments )
+    {
+        const Animation& anim = *ctx->animation;
+        const uint32_t num_joints = ctx->num_joints;
+
+        ctx->frames.resize( ( num_segments + 1 ) * num_joints );
+        ctx->frames_root.resize( ( ctx->reference_root.empty() ) ? 0 : num_segments + 1 );
+
+        for( uint32_t k = 0; k <= num_segments; ++k )
+        {
+            const float time = anim.startTime + ctx->duration * (float)k / (float)num_segments;
+            for( uint32_t j = 0; j < num_joints; ++j )
+                ctx->frames[k * num_joints + j] = SampleJoint( anim.joints[j], ctx->empty_channel[j], time );
+
+            if( !ctx->frames_root.empty() )
+                ctx->frames_root[k] = SampleVector( anim.root_motion.translation, time ).xyz();
+        }
+    }
+
+    // returns max error, fills per joint errors when requested
+    static float MeasureError( ResampleContext* ctx, uint32_t num_segments, ResampleReport* report )
+    {
+        BuildFrames( ctx, num_segments );
+
+        const uint32_t num_joints = ctx->num_joints;
+        const float frames_per_second = (float)num_segments / ctx->duration;
+
+        float max_error = 0.f;
+        for( size_t i = 0; i < ctx->eval_times.size(); ++i )
+        {
+            const float frame = ( ctx->eval_times[i] - ctx->animation->startTime ) * frames_per_second;
+            for( uint32_t j = 0; j < num_joints; ++j )
+                ctx->pose_ls[j] = SampleFrames( ctx->frames.data(), num_joints, num_segments, j, frame );
+
+            ToModelSpace( ctx->pose_ms.data(), ctx->pose_ls.data(), *ctx );
+
+            const ANIMJoint* reference = &ctx->reference_ms[i * num_joints];
+            for( uint32_t j = 0; j < num_joints; ++j )
+            {
+                const float error = JointError( reference[j], ctx->pose_ms[j], ctx->params->shell_distance );
+                max_error = max_of_2( max_error, error );
+
+                if( report && error > report->joint_error[j] )
+                {
+                    report->joint_error[j] = error;
+                    report->joint_error_time[j] = ctx->eval_times[i];
+                }
+            }
+
+            if( !ctx->frames_root.empty() )
+            {
+                const uint32_t k = min_of_2( (uint32_t)frame, num_segments - 1 );
+                const vec3_t root = lerp( frame - (float)k, ctx->frames_root[k], ctx->frames_root[k + 1] );
+                const float error = length( root - ctx->reference_root[i] );
+                max_error = max_of_2( max_error, error );
+
+                if( report )
+                    report->root_motion_error = max_of_2( report->root_motion_error, error );
+            }
+        }
+        return max_error;
+    }
+
+    static void ReplaceKeys( std::vector<AnimKeyframe>* keys, const float4_t* values, uint32_t stride, uint32_t num_frames, float start_time, float dt )
+    {
+        keys->resize( num_frames );
+        for( uint32_t k = 0; k < num_frames; ++k )
+        {
+            (*keys)[k].time = start_time + dt * (float)k;
+            (*keys)[k].data = values[k * stride];
+        }
+    }
+
+    bool Resample( Animation* animation, const Skeleton& skeleton, const ResampleParams& params, ResampleReport* report )
+    {
+        const uint32_t num_joints = (uint32_t)skeleton.parentIndices.size();
+        const float duration = animation->endTime - animation->startTime;
+
+        if( report )
+        {
+            report[0] = ResampleReport();
+            report->src_sample_frequency = report->sample_frequency = animation->sampleFrequency;
+            report->src_num_frames = report->num_frames = animation->numFrames;
+        }
+
+        if( animation->numFrames < 3 || duration <= 0.f || num_joints == 0 || animation->joints.size() != num_joints )
+            return false;
+
+        ResampleContext ctx;
+        ctx.animation = animation;
+        ctx.skeleton = &skeleton;
+        ctx.params = &params;
+        ctx.num_joints = num_joints;
+        ctx.duration = duration;
+        ctx.pose_ls.resize( num_joints );
+        ctx.pose_ms.resize( num_joints );
+        ctx.empty_channel.resize( num_joints );
+        for( uint32_t j = 0; j < num_joints; ++j )
+            ctx.empty_channel[j] = EmptyChannelJoint( skeleton.basePose[j], params.additive );
+
+        const float src_dt = 1.f / animation->sampleFrequency;
+        for( uint32_t i = 0; i < animation->numFrames; ++i )
+        {
+            const float time = animation->startTime + src_dt * (float)i;
+            if( time > animation->endTime )
+                break;
+
+            ctx.eval_times.push_back( time );
+        }
+        if( ctx.eval_times.back() < animation->endTime )
+            ctx.eval_times.push_back( animation->endTime );
+
+        const bool has_root_motion = !animation->root_motion.translation.empty();
+
+        const uint32_t num_eval_times = (uint32_t)ctx.eval_times.size();
+        ctx.reference_ms.resize( num_eval_times * num_joints );
+        ctx.reference_root.resize( ( has_root_motion ) ? num_eval_times : 0 );
+        for( uint32_t i = 0; i < num_eval_times; ++i )
+        {
+            for( uint32_t j = 0; j < num_joints; ++j )
+                ctx.pose_ls[j] = SampleJoint( animation->joints[j], ctx.empty_channel[j], ctx.eval_times[i] );
+
+            ToModelSpace( &ctx.reference_ms[i * num_joints], ctx.pose_ls.data(), ctx );
+
+            if( has_root_motion )
+                ctx.reference_root[i] = SampleVector( animation->root_motion.translation, ctx.eval_times[i] ).xyz();
+        }
+
+        // error grows (almost) monotonically when rate goes down, so binary search for the lowest rate within tolerance.
+        // Source rate is upper bound, it reproduces source keys
+        const uint32_t max_segments = min_of_2( (uint32_t)UINT16_MAX - 1, max_of_2( 1u, (uint32_t)( duration * animation->sampleFrequency + 0.5f ) ) );
+        uint32_t lo = 1;
+        uint32_t hi = max_segments;
+        while( lo < hi )
+        {
+            const uint32_t mid = ( lo + hi ) / 2;
+            if( MeasureError( &ctx, mid, nullptr ) <= params.tolerance )
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        const uint32_t num_segments = hi;
+
+        if( report )
+        {
+            report->joint_error.assign( num_joints, 0.f );
+            report->joint_error_time.assign( num_joints, 0.f );
+        }
+        const float max_error = MeasureError( &ctx, num_segments, report );
+
+        const uint32_t num_frames = num_segments + 1;
+        const float dt = duration / (float)num_segments;
+
+        std::vector<float4_t> values( num_frames * 3 );
+        for( uint32_t j = 0; j < num_joints; ++j )
+        {
+            JointAnimation& janim = animation->joints[j];
+            for( uint32_t k = 0; k < num_frames; ++k )
+            {
+                const ANIMJoint& joint = ctx.frames[k * num_joints + j];
+                values[k * 3 + 0] = ToFloat4( joint.rotation );
+                values[k * 3 + 1] = ToFloat4( joint.position );
+                values[k * 3 + 2] = ToFloat4( joint.scale );
+            }
+            ReplaceKeys( &janim.rotation, &values[0], 3, num_frames, animation->startTime, dt );
+            ReplaceKeys( &janim.translation, &values[1], 3, num_frames, animation->startTime, dt );
+            ReplaceKeys( &janim.scale, &values[2], 3, num_frames, animation->startTime, dt );
+        }
+
+        if( has_root_motion )
+        {
+            JointAnimation& root_motion = animation->root_motion;
+            for( uint32_t k = 0; k < num_frames; ++k )
+            {
+                const float time = animation->startTime + dt * (float)k;
+                values[k * 3 + 0] = ( root_motion.rotation.empty() ) ? float4_t( 0.f, 0.f, 0.f, 1.f ) : ToFloat4( SampleRotation( root_motion.rotation, time ) );
+                values[k * 3 + 1] = ToFloat4( vec4_t( ctx.frames_root[k], 1.f ) );
+                values[k * 3 + 2] = ( root_motion.scale.empty() ) ? float4_t( 1.f, 1.f, 1.f, 1.f ) : ToFloat4( SampleVector( root_motion.scale, time ) );
+            }
+            ReplaceKeys( &root_motion.rotation, &values[0], 3, num_frames, animation->startTime, dt );
+            ReplaceKeys( &root_motion.translation, &values[1], 3, num_frames, animation->startTime, dt );
+            ReplaceKeys( &root_motion.scale, &values[2], 3, num_frames, animation->startTime, dt );
+        }
+
+        animation->numFrames = num_frames;
+        animation->sampleFrequency = (float)num_segments / duration;
+
+        if( report )
+        {
+            report->sample_frequency = animation->sampleFrequency;
+            report->num_frames = num_frames;
+            report->max_error = max_error;
+            report->worst_joint = (uint32_t)( std::max_element( report->joint_error.begin(), report->joint_error.end() ) - report->joint_error.begin() );
+        }
+
+        return true;
+    }
+
+}}//
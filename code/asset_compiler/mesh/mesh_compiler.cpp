@@ -6,6 +6,11 @@
 #include <foundation/buffer.h>
 #include <foundation/hashed_string.h>
 #include "rdix/rdix_type.h"
+#include "rdix/rdix_vertex_codec.h"
+#include "util/bbox.h"
+#include "mesh_simplifier.h"
+
+#include <float.h>
 
 #include <3rd_party/assimp/cimport.h>
 #include <3rd_party/assimp/scene.h>
@@ -282,12 +287,398 @@ namespace tool { namespace mesh {
         return *this;
     }
 
-    blob_t Compile( const Streams& streams, const CompileOptions& opt, BXIAllocator* allocator )
+    CompileOptions& CompileOptions::Quantize( RDIEVertexSlot::Enum slot, bool value )
+    {
+        if( value )
+            quantize_mask |= 1 << slot;
+        else
+            quantize_mask &= ~(1 << slot);
+
+        return *this;
+    }
+
+    CompileOptions& CompileOptions::QuantizeAll( bool value )
+    {
+        quantize_mask = ( value ) ? UINT32_MAX : 0;
+        return *this;
+    }
+
+    CompileOptions& CompileOptions::Lods( uint32_t count, float ratio_step, float max_error )
+    {
+        num_lods = ( count < 1 ) ? 1 : ( count > MAX_LODS ) ? MAX_LODS : count;
+
+        float ratio = 1.f;
+        for( uint32_t i = 0; i < MAX_LODS; ++i )
+        {
+            lod_ratio[i] = ratio;
+            lod_error[i] = ( i ) ? max_error : 0.f;
+            ratio *= ratio_step;
+        }
+        return *this;
+    }
+
+    CompileOptions& CompileOptions::Meshlets( bool value )
+    {
+        meshlets = value;
+        return *this;
+    }
+
+    static RDIXPositionBox ComputePositionBox( const VertexDataArray& positions )
+    {
+        RDIXPositionBox box;
+        if( positions.empty() )
+            return box;
+
+        float pmax[3];
+        for( uint32_t c = 0; c < 3; ++c )
+            box.min[c] = pmax[c] = positions[0].f32[c];
+
+        for( const VertexData& p : positions )
+        {
+            for( uint32_t c = 0; c < 3; ++c )
+            {
+                box.min[c] = ( p.f32[c] < box.min[c] ) ? p.f32[c] : box.min[c];
+                pmax[c] = ( p.f32[c] > pmax[c] ) ? p.f32[c] : pmax[c];
+            }
+        }
+        for( uint32_t c = 0; c < 3; ++c )
+            box.extent[c] = pmax[c] - box.min[c];
+
+        return box;
+    }
+
+    // AABB and the tighter of AABB-centered and Ritter's bounding sphere
+    static RDIXMeshBounds ComputeBounds( const std::vector<vec3_t>& points )
+    {
+        RDIXMeshBounds bounds;
+        if( points.empty() )
+        {
+            bounds.sphere[3] = -1.f;
+            return bounds;
+        }
+
+        AABB aabb = AABB::Prepare();
+        for( const vec3_t& p : points )
+            aabb = AABB::Extend( aabb, p );
+
+        const vec3_t aabb_center = AABB::Center( aabb );
+        float aabb_radius_sqr = 0.f;
+        for( const vec3_t& p : points )
+            aabb_radius_sqr = max_of_2( aabb_radius_sqr, length_sqr( p - aabb_center ) );
+
+        // Ritter: start from most distant pair along first point, then grow
+        const vec3_t& x = points[0];
+        vec3_t y = x;
+        for( const vec3_t& p : points )
+            y = ( length_sqr( p - x ) > length_sqr( y - x ) ) ? p : y;
+        vec3_t z = y;
+        for( const vec3_t& p : points )
+            z = ( length_sqr( p - y ) > length_sqr( z - y ) ) ? p : z;
+
+        vec3_t center = ( y + z ) * 0.5f;
+        float radius = length( z - y ) * 0.5f;
+        for( const vec3_t& p : points )
+        {
+            const float d = length( p - center );
+            if( d > radius )
+            {
+                const float new_radius = ( radius + d ) * 0.5f;
+                center = center + ( p - center ) * ( ( new_radius - radius ) / d );
+                radius = new_radius;
+            }
+        }
+
+        const float aabb_radius = ::sqrtf( aabb_radius_sqr );
+        if( aabb_radius <= radius )
+        {
+            center = aabb_center;
+            radius = aabb_radius;
+        }
+
+        for( uint32_t i = 0; i < 3; ++i )
+        {
+            bounds.aabb_min[i] = aabb.pmin[i];
+            bounds.aabb_max[i] = aabb.pmax[i];
+            bounds.sphere[i] = center[i];
+        }
+        bounds.sphere[3] = radius;
+        return bounds;
+    }
+
+    // LOD chain, triangle order for post-transform cache and overdraw, vertex order for fetch,
+    // parts small enough to be addressed with 16bit indices (relative to part's base vertex)
+    struct OptimizedTopology
+    {
+        std::vector<uint32_t> indices;               // all LODs
+        std::vector<uint32_t> vertex_remap;
+        std::vector<VertexFetchPart> parts;
+        std::vector<RDIXRenderSourceRange> ranges;   // LOD by LOD, part by part
+        std::vector<RDIXRenderSourceLod> lods;
+    };
+
+    // collapses in simplifier are limited to vertices influenced mostly by the same bone
+    static void ComputeDominantBones( std::vector<uint32_t>* output, const Streams& streams )
+    {
+        const VertexDataArray& blendw = streams.data[RDIEVertexSlot::BLENDWEIGHT];
+        const VertexDataArray& blendi = streams.data[RDIEVertexSlot::BLENDINDICES];
+        if( blendw.empty() || blendi.empty() )
+            return;
+
+        output->resize( streams.num_vertices );
+        for( uint32_t i = 0; i < streams.num_vertices; ++i )
+        {
+            uint32_t best = 0;
+            for( uint32_t iw = 1; iw < 4; ++iw )
+                best = ( blendw[i].f32[iw] > blendw[i].f32[best] ) ? iw : best;
+
+            output[0][i] = blendi[i].u8[best];
+        }
+    }
+
+    static void OptimizeTopology( OptimizedTopology* out, const Streams& streams, const CompileOptions& opt, CompileReport* report )
+    {
+        const uint32_t num_vertices = streams.num_vertices;
+        std::vector<uint32_t> lod0;
+        if( streams.flag_use_16bit_indices )
+            lod0.assign( streams.indices16.begin(), streams.indices16.end() );
+        else
+            lod0.assign( streams.indices32.begin(), streams.indices32.end() );
+
+        const uint32_t lod0_num_indices = (uint32_t)lod0.size();
+
+        if( report )
+        {
+            report->input = AnalyzeVertexCache( lod0.data(), lod0_num_indices, num_vertices );
+            report->num_input_vertices = num_vertices;
+        }
+
+        const VertexDataArray& positions = streams.data[RDIEVertexSlot::POSITION];
+
+        std::vector< std::vector<uint32_t> > lods_indices;
+        std::vector<float> lods_error;
+        lods_indices.reserve( CompileOptions::MAX_LODS ); // LOD0 is referenced while coarser LODs are appended
+        lods_indices.push_back( std::move( lod0 ) );
+        lods_error.push_back( 0.f );
+
+        if( opt.num_lods > 1 && !positions.empty() )
+        {
+            const RDIXPositionBox box = ComputePositionBox( positions );
+            const float mesh_size = ::sqrtf( box.extent[0] * box.extent[0] + box.extent[1] * box.extent[1] + box.extent[2] * box.extent[2] );
+
+            std::vector<uint32_t> dominant_bones;
+            ComputeDominantBones( &dominant_bones, streams );
+
+            SimplifyDesc desc;
+            desc.positions = positions.data();
+            desc.position_stride = sizeof( VertexData );
+            desc.num_vertices = num_vertices;
+            desc.vertex_class = ( dominant_bones.empty() ) ? nullptr : dominant_bones.data();
+
+            const std::vector<uint32_t>& source = lods_indices[0];
+            for( uint32_t ilod = 1; ilod < opt.num_lods && ilod < CompileOptions::MAX_LODS; ++ilod )
+            {
+                desc.target_num_indices = (uint32_t)( lod0_num_indices * opt.lod_ratio[ilod] ) / 3 * 3;
+                desc.target_error = opt.lod_error[ilod] * mesh_size;
+
+                std::vector<uint32_t> simplified( source.size() );
+                float error = 0.f;
+                const uint32_t num_indices = SimplifyMesh( simplified.data(), source.data(), (uint32_t)source.size(), desc, &error );
+                simplified.resize( num_indices );
+
+                if( !num_indices || num_indices > lods_indices.back().size() * 9 / 10 )
+                    break;
+
+                lods_indices.push_back( std::move( simplified ) );
+                lods_error.push_back( max_of_2( error, lods_error.back() ) );
+            }
+        }
+
+        const uint32_t num_lods = (uint32_t)lods_indices.size();
+        std::vector<uint32_t> lod_begin( num_lods + 1, 0 );
+        for( uint32_t ilod = 0; ilod < num_lods; ++ilod )
+        {
+            std::vector<uint32_t>& lod = lods_indices[ilod];
+            OptimizeVertexCache( lod.data(), (uint32_t)lod.size(), num_vertices );
+            if( !positions.empty() )
+                OptimizeOverdraw( lod.data(), (uint32_t)lod.size(), positions.data(), sizeof( VertexData ), num_vertices );
+
+            out->indices.insert( out->indices.end(), lod.begin(), lod.end() );
+            lod_begin[ilod + 1] = (uint32_t)out->indices.size();
+        }
+
+        // vertex order is driven by LOD0, coarser LODs reference subset of its vertices
+        OptimizeVertexFetch( &out->vertex_remap, &out->parts, out->indices.data(), (uint32_t)out->indices.size(), num_vertices );
+
+        for( uint32_t ilod = 0; ilod < num_lods; ++ilod )
+        {
+            RDIXRenderSourceLod lod;
+            lod.first_range = (uint16_t)out->ranges.size();
+            lod.error = lods_error[ilod];
+
+            for( const VertexFetchPart& part : out->parts )
+            {
+                const uint32_t begin = max_of_2( part.first_index, lod_begin[ilod] );
+                const uint32_t end = min_of_2( part.first_index + part.num_indices, lod_begin[ilod + 1] );
+                if( begin < end )
+                    out->ranges.push_back( RDIXRenderSourceRange( begin, end - begin, part.base_vertex ) );
+            }
+
+            lod.num_ranges = (uint16_t)( out->ranges.size() - lod.first_range );
+            out->lods.push_back( lod );
+        }
+
+        if( report )
+        {
+            const uint32_t lod0_end = lod_begin[1];
+            std::vector<uint32_t> absolute_indices( out->indices.begin(), out->indices.begin() + lod0_end );
+            for( const VertexFetchPart& part : out->parts )
+            {
+                for( uint32_t i = part.first_index; i < part.first_index + part.num_indices && i < lod0_end; ++i )
+                    absolute_indices[i] += part.base_vertex;
+            }
+
+            report->output = AnalyzeVertexCache( absolute_indices.data(), lod0_end, (uint32_t)out->vertex_remap.size() );
+            report->num_output_vertices = (uint32_t)out->vertex_remap.size();
+            report->num_parts = (uint32_t)out->parts.size();
+            report->num_lods = num_lods;
+            for( uint32_t ilod = 0; ilod < num_lods; ++ilod )
+            {
+                report->lod_triangles[ilod] = ( lod_begin[ilod + 1] - lod_begin[ilod] ) / 3;
+                report->lod_error[ilod] = lods_error[ilod];
+            }
+        }
+    }
+
+    // greedy scan over triangles of each draw range (already in cache friendly order).
+    // range_meshlets receives first meshlet of each range, plus total count at the end
+    static void BuildMeshlets( std::vector<RDIXMeshlet>* meshlets, std::vector<uint32_t>* range_meshlets, const OptimizedTopology& topology )
+    {
+        std::vector<uint32_t> vertex_stamp( topology.vertex_remap.size(), UINT32_MAX );
+
+        for( const RDIXRenderSourceRange& range : topology.ranges )
+        {
+            range_meshlets->push_back( (uint32_t)meshlets->size() );
+
+            RDIXMeshlet meshlet;
+            meshlet.first_index = range.begin;
+            for( uint32_t i = range.begin; i < range.begin + range.count; i += 3 )
+            {
+                const uint32_t* tri = &topology.indices[i];
+
+                // vertex stamp is index of meshlet which already references vertex
+                uint32_t stamp = (uint32_t)meshlets->size();
+                uint32_t new_vertices = 0;
+                for( uint32_t c = 0; c < 3; ++c )
+                    new_vertices += ( vertex_stamp[range.base_vertex + tri[c]] != stamp ) ? 1 : 0;
+
+                if( meshlet.num_vertices + new_vertices > RDIXMeshlet::MAX_VERTICES || meshlet.num_indices == RDIXMeshlet::MAX_TRIANGLES * 3 )
+                {
+                    meshlets->push_back( meshlet );
+                    meshlet = RDIXMeshlet();
+                    meshlet.first_index = i;
+                    stamp += 1;
+                }
+
+                for( uint32_t c = 0; c < 3; ++c )
+                {
+                    uint32_t& vstamp = vertex_stamp[range.base_vertex + tri[c]];
+                    meshlet.num_vertices += ( vstamp != stamp ) ? 1 : 0;
+                    vstamp = stamp;
+                }
+                meshlet.num_indices += 3;
+            }
+
+            if( meshlet.num_indices )
+                meshlets->push_back( meshlet );
+        }
+
+        range_meshlets->push_back( (uint32_t)meshlets->size() );
+    }
+
+    // sphere from meshlet vertices, cone axis is average of triangle normals (counter clockwise front faces).
+    // Cone is stored as sine of angle between axis and the most diverging normal (gfx backface test),
+    // spread close to or above 90 degrees disables the test
+    static void ComputeMeshletBounds( RDIXMeshlet* meshlet, const std::vector<vec3_t>& positions, const uint32_t* indices, uint32_t base_vertex )
+    {
+        std::vector<vec3_t> points( meshlet->num_indices );
+        for( uint32_t i = 0; i < meshlet->num_indices; ++i )
+            points[i] = positions[base_vertex + indices[meshlet->first_index + i]];
+
+        const RDIXMeshBounds bounds = ComputeBounds( points );
+        memcpy( meshlet->sphere, bounds.sphere, sizeof( meshlet->sphere ) );
+
+        std::vector<vec3_t> normals;
+        normals.reserve( meshlet->num_indices / 3 );
+        vec3_t axis( 0.f );
+        for( uint32_t i = 0; i < meshlet->num_indices; i += 3 )
+        {
+            const vec3_t n = cross( points[i + 1] - points[i], points[i + 2] - points[i] );
+            const float len = length( n );
+            if( len > FLT_EPSILON )
+            {
+                normals.push_back( n / len );
+                axis += normals.back();
+            }
+        }
+
+        meshlet->cone_cutoff = 1.f;
+        const float axis_len = length( axis );
+        if( normals.empty() || axis_len <= FLT_EPSILON )
+            return;
+
+        axis /= axis_len;
+        float min_dot = 1.f;
+        for( const vec3_t& n : normals )
+            min_dot = min_of_2( min_dot, dot( n, axis ) );
+
+        for( uint32_t i = 0; i < 3; ++i )
+            meshlet->cone_axis[i] = axis[i];
+
+        if( min_dot > 0.1f )
+            meshlet->cone_cutoff = ::sqrtf( 1.f - min_dot * min_dot );
+    }
+
+    blob_t Compile( const Streams& streams, const CompileOptions& opt, BXIAllocator* allocator, CompileReport* report )
     {
         constexpr uint32_t MAX_STREAMS = RDIEVertexSlot::COUNT;
 
+        OptimizedTopology topology;
+        if( streams.num_indices )
+        {
+            OptimizeTopology( &topology, streams, opt, report );
+        }
+        else if( report )
+        {
+            report[0] = CompileReport();
+            report->num_input_vertices = report->num_output_vertices = streams.num_vertices;
+        }
+
+        const bool is_indexed = !topology.parts.empty();
+        const uint32_t num_vertices = ( is_indexed ) ? (uint32_t)topology.vertex_remap.size() : streams.num_vertices;
+        const uint32_t num_indices = (uint32_t)topology.indices.size();
+        const uint32_t num_draw_ranges = (uint32_t)topology.ranges.size();
+        const uint32_t num_lods = (uint32_t)topology.lods.size();
+        if( num_draw_ranges >= UINT16_MAX )
+        {
+            SYS_LOG_ERROR( "mesh compiler: too many draw ranges (%u), reduce num_lods or vertex count", num_draw_ranges );
+            return {};
+        }
+
+        std::vector<RDIXMeshlet> meshlets;
+        std::vector<uint32_t> range_meshlets;
+        if( opt.meshlets && is_indexed )
+        {
+            BuildMeshlets( &meshlets, &range_meshlets, topology );
+        }
+        if( report )
+        {
+            report->num_meshlets = (uint32_t)meshlets.size();
+        }
+        const uint32_t num_meshlets = (uint32_t)meshlets.size();
+
         uint32_t memory_size_streams[MAX_STREAMS] = {};
         RDIVertexBufferDesc streams_descs[MAX_STREAMS] = {};
+        RDIXEVertexEncoding::Enum streams_encodings[MAX_STREAMS] = {};
         uint32_t num_streams = 0;
 
         for( uint32_t istream = 0; istream < MAX_STREAMS; ++istream )
@@ -298,16 +689,36 @@ namespace tool { namespace mesh {
             const uint32_t index = num_streams++;
 
             const RDIVertexBufferDesc desc = streams.slots[istream];
+
+            RDIXEVertexEncoding::Enum encoding = RDIXEVertexEncoding::NONE;
+            if( opt.IsQuantized( istream ) )
+            {
+                encoding = DefaultVertexEncoding( (RDIEVertexSlot::Enum)istream );
+                if( !CanEncodeVertexStream( desc, encoding ) )
+                    encoding = RDIXEVertexEncoding::NONE;
+            }
+
             streams_descs[index] = desc;
-            memory_size_streams[index] = desc.ByteWidth() * streams.num_vertices;
+            streams_encodings[index] = encoding;
+            memory_size_streams[index] = EncodedVertexStride( desc, encoding ) * num_vertices;
         }
 
-        const uint32_t index_size_in_bytes = (streams.flag_use_16bit_indices) ? sizeof( uint16_t ) : sizeof( uint32_t );
-        const uint32_t memory_size_for_indices = index_size_in_bytes * streams.num_indices;
+        const RDIXPositionBox position_box = ComputePositionBox( streams.data[RDIEVertexSlot::POSITION] );
+
+        // every part fits in 16bit indices
+        const uint32_t use_16bit_indices = ( is_indexed ) ? 1 : streams.flag_use_16bit_indices;
+        const uint32_t index_size_in_bytes = ( use_16bit_indices ) ? sizeof( uint16_t ) : sizeof( uint32_t );
+        const uint32_t memory_size_for_indices = index_size_in_bytes * num_indices;
 
         const uint32_t bone_size_in_bytes = sizeof( BoneDataArray::value_type );
         const uint32_t memory_size_for_bones = bone_size_in_bytes * streams.num_bones;
         const uint32_t memory_size_for_bones_names = sizeof( hashed_string_t ) * streams.num_bones;
+        const uint32_t memory_size_for_draw_ranges = sizeof( RDIXRenderSourceRange ) * num_draw_ranges;
+        const uint32_t memory_size_for_draw_ranges_bounds = sizeof( RDIXMeshBounds ) * num_draw_ranges;
+        const uint32_t memory_size_for_lods = sizeof( RDIXRenderSourceLod ) * num_lods;
+        const uint32_t memory_size_for_meshlets = sizeof( RDIXMeshlet ) * num_meshlets;
+        const uint32_t memory_size_for_range_meshlets = sizeof( uint32_t ) * (uint32_t)range_meshlets.size();
+        const uint32_t memory_size_for_bones_bounds = sizeof( RDIXMeshBounds ) * streams.num_bones;
 
 
         uint32_t memory_size_for_all_streams = 0;
@@ -318,6 +729,12 @@ namespace tool { namespace mesh {
         memory_size_for_all_streams = TYPE_ALIGN( memory_size_for_all_streams, 16 );
         memory_size_for_all_streams += memory_size_for_bones;
         memory_size_for_all_streams += memory_size_for_bones_names;
+        memory_size_for_all_streams += memory_size_for_draw_ranges;
+        memory_size_for_all_streams += memory_size_for_draw_ranges_bounds;
+        memory_size_for_all_streams += memory_size_for_lods;
+        memory_size_for_all_streams += memory_size_for_meshlets;
+        memory_size_for_all_streams += memory_size_for_range_meshlets;
+        memory_size_for_all_streams += memory_size_for_bones_bounds;
         memory_size_for_all_streams += memory_size_for_indices;
 
         
@@ -332,36 +749,44 @@ namespace tool { namespace mesh {
         // fill header
         RDIXMeshFile* header = new( blob.raw )(RDIXMeshFile);
         header->num_streams = num_streams;
-        header->num_vertices = streams.num_vertices;
-        header->num_indices = streams.num_indices;
+        header->num_vertices = num_vertices;
+        header->num_indices = num_indices;
         header->num_bones = streams.num_bones;
-        header->num_draw_ranges = 0;
-        header->flag_use_16bit_indices = streams.flag_use_16bit_indices;
+        header->num_draw_ranges = num_draw_ranges;
+        header->num_lods = num_lods;
+        header->num_meshlets = num_meshlets;
+        header->flag_use_16bit_indices = use_16bit_indices;
+        memcpy( header->position_min, position_box.min, sizeof( header->position_min ) );
+        memcpy( header->position_extent, position_box.extent, sizeof( header->position_extent ) );
 
         // fill data
         uint8_t* data_memory = (uint8_t*)(header + 1);
         BufferChunker chunker( data_memory, memory_size_for_all_streams );
 
         // streams
+        VertexDataArray remapped_vertices;
         for( uint32_t i = 0; i < num_streams; ++i )
         {
             const RDIVertexBufferDesc desc = streams_descs[i];
+            const RDIXEVertexEncoding::Enum encoding = streams_encodings[i];
 
-            const uint32_t vertex_stride = desc.ByteWidth();
-            
             BufferChunker::Block data_block = chunker.AddBlock( memory_size_streams[i], 4 );
-            uint8_t* data_iterator = data_block.begin;
 
-            const VertexDataArray& src_vertices = streams.data[desc.slot];
-            for( uint32_t ivertex = 0; ivertex < streams.num_vertices; ++ivertex )
+            const VertexData* src_vertices = streams.data[desc.slot].data();
+            if( is_indexed )
             {
-                const uint8_t* src = &src_vertices[ivertex].u8[0];
-                memcpy( data_iterator, src, vertex_stride );
-                data_iterator += vertex_stride;
+                remapped_vertices.resize( num_vertices );
+                for( uint32_t iv = 0; iv < num_vertices; ++iv )
+                    remapped_vertices[iv] = src_vertices[topology.vertex_remap[iv]];
+
+                src_vertices = remapped_vertices.data();
             }
-            chunker.Checkpoint( data_iterator );
+
+            EncodeVertexStream( data_block.begin, src_vertices, sizeof( VertexData ), num_vertices, desc, encoding, position_box );
+            chunker.Checkpoint( data_block.begin + memory_size_streams[i] );
         
             header->descs[i] = streams_descs[i];
+            header->encodings[i] = encoding;
             header->offset_streams[i] = TYPE_POINTER_GET_OFFSET( &header->offset_streams[i], data_block.begin );
         }
 
@@ -373,6 +798,26 @@ namespace tool { namespace mesh {
             chunker.Checkpoint( tmp );
         }
 
+        // bounds are computed from positions as seen by runtime (after quantization)
+        std::vector<vec3_t> positions;
+        {
+            const VertexDataArray& src_positions = streams.data[RDIEVertexSlot::POSITION];
+            if( !src_positions.empty() )
+            {
+                positions.resize( num_vertices );
+                for( uint32_t iv = 0; iv < num_vertices; ++iv )
+                {
+                    const VertexData& src = src_positions[( is_indexed ) ? topology.vertex_remap[iv] : iv];
+                    positions[iv] = vec3_t( src.f32[0], src.f32[1], src.f32[2] );
+                }
+            }
+
+            const uint32_t position_stream = FindVertexStream( header, RDIEVertexSlot::POSITION );
+            if( position_stream != UINT32_MAX && header->descs[position_stream].ByteWidth() == sizeof( vec3_t ) )
+                DecodeVertexStream( positions.data(), header, position_stream );
+        }
+        header->bounds = ComputeBounds( positions );
+
         
 
         // bones
@@ -404,16 +849,131 @@ namespace tool { namespace mesh {
             header->offset_bones_names = TYPE_POINTER_GET_OFFSET( &header->offset_bones_names, data_block.begin );
         }
 
+        // draw ranges (part of LOD each)
+        {
+            BufferChunker::Block data_block = chunker.AddBlock( memory_size_for_draw_ranges, 4 );
+
+            RDIXRenderSourceRange* dst_ranges = (RDIXRenderSourceRange*)data_block.begin;
+            for( const RDIXRenderSourceRange& range : topology.ranges )
+            {
+                dst_ranges[0] = range;
+                ++dst_ranges;
+            }
+            chunker.Checkpoint( dst_ranges );
+
+            header->offset_draw_ranges = TYPE_POINTER_GET_OFFSET( &header->offset_draw_ranges, data_block.begin );
+        }
+
+        // draw ranges bounds
+        {
+            BufferChunker::Block data_block = chunker.AddBlock( memory_size_for_draw_ranges_bounds, 4 );
+
+            RDIXMeshBounds* dst_bounds = (RDIXMeshBounds*)data_block.begin;
+            std::vector<vec3_t> range_positions;
+            for( const RDIXRenderSourceRange& range : topology.ranges )
+            {
+                range_positions.clear();
+                if( !positions.empty() )
+                {
+                    for( uint32_t i = 0; i < range.count; ++i )
+                        range_positions.push_back( positions[range.base_vertex + topology.indices[range.begin + i]] );
+                }
+                dst_bounds[0] = ComputeBounds( range_positions );
+                ++dst_bounds;
+            }
+            chunker.Checkpoint( dst_bounds );
+
+            header->offset_draw_ranges_bounds = TYPE_POINTER_GET_OFFSET( &header->offset_draw_ranges_bounds, data_block.begin );
+        }
+
+        // lods
+        {
+            BufferChunker::Block data_block = chunker.AddBlock( memory_size_for_lods, 4 );
+
+            RDIXRenderSourceLod* dst_lods = (RDIXRenderSourceLod*)data_block.begin;
+            for( const RDIXRenderSourceLod& lod : topology.lods )
+            {
+                dst_lods[0] = lod;
+                ++dst_lods;
+            }
+            chunker.Checkpoint( dst_lods );
+
+            header->offset_lods = TYPE_POINTER_GET_OFFSET( &header->offset_lods, data_block.begin );
+        }
+
+        // meshlets, range by range
+        if( num_meshlets )
+        {
+            BufferChunker::Block data_block = chunker.AddBlock( memory_size_for_meshlets, 4 );
+
+            RDIXMeshlet* dst_meshlets = (RDIXMeshlet*)data_block.begin;
+            for( uint32_t irange = 0; irange < num_draw_ranges; ++irange )
+            {
+                const uint32_t base_vertex = topology.ranges[irange].base_vertex;
+                for( uint32_t i = range_meshlets[irange]; i < range_meshlets[irange + 1]; ++i )
+                {
+                    dst_meshlets[0] = meshlets[i];
+                    if( !positions.empty() )
+                        ComputeMeshletBounds( dst_meshlets, positions, topology.indices.data(), base_vertex );
+                    ++dst_meshlets;
+                }
+            }
+            chunker.Checkpoint( dst_meshlets );
+
+            BufferChunker::Block range_block = chunker.AddBlock( memory_size_for_range_meshlets, 4 );
+            memcpy( range_block.begin, range_meshlets.data(), memory_size_for_range_meshlets );
+            chunker.Checkpoint( range_block.begin + memory_size_for_range_meshlets );
+
+            header->offset_meshlets = TYPE_POINTER_GET_OFFSET( &header->offset_meshlets, data_block.begin );
+            header->offset_range_meshlets = TYPE_POINTER_GET_OFFSET( &header->offset_range_meshlets, range_block.begin );
+        }
+
+        // bones bounds, from vertices with non zero weight
+        {
+            BufferChunker::Block data_block = chunker.AddBlock( memory_size_for_bones_bounds, 4 );
+
+            std::vector< std::vector<vec3_t> > bone_positions( streams.num_bones );
+            const VertexDataArray& blendw = streams.data[RDIEVertexSlot::BLENDWEIGHT];
+            const VertexDataArray& blendi = streams.data[RDIEVertexSlot::BLENDINDICES];
+            if( !positions.empty() && !blendw.empty() && !blendi.empty() )
+            {
+                for( uint32_t iv = 0; iv < num_vertices; ++iv )
+                {
+                    const uint32_t src_index = ( is_indexed ) ? topology.vertex_remap[iv] : iv;
+                    for( uint32_t iw = 0; iw < 4; ++iw )
+                    {
+                        if( blendw[src_index].f32[iw] <= 0.f )
+                            continue;
+
+                        const uint32_t ibone = blendi[src_index].u8[iw];
+                        SYS_ASSERT( ibone < streams.num_bones );
+                        bone_positions[ibone].push_back( mul_as_point( streams.bones[ibone], positions[iv] ) );
+                    }
+                }
+            }
+
+            RDIXMeshBounds* dst_bounds = (RDIXMeshBounds*)data_block.begin;
+            for( uint32_t i = 0; i < streams.num_bones; ++i )
+            {
+                dst_bounds[0] = ComputeBounds( bone_positions[i] );
+                ++dst_bounds;
+            }
+            chunker.Checkpoint( dst_bounds );
+
+            header->offset_bones_bounds = TYPE_POINTER_GET_OFFSET( &header->offset_bones_bounds, data_block.begin );
+        }
+
         // indices
         {
             BufferChunker::Block data_block = chunker.AddBlock( memory_size_for_indices, 2 );
 
-            if( streams.flag_use_16bit_indices )
+            if( use_16bit_indices )
             {
                 uint16_t* dst_indices16 = (uint16_t*)data_block.begin;
-                for( uint32_t i = 0; i < streams.num_indices; ++i )
+                for( uint32_t i = 0; i < num_indices; ++i )
                 {
-                    dst_indices16[0] = streams.indices16[i];
+                    SYS_ASSERT( topology.indices[i] <= UINT16_MAX );
+                    dst_indices16[0] = (uint16_t)topology.indices[i];
                     ++dst_indices16;
                 }
                 chunker.Checkpoint( dst_indices16 );
@@ -421,9 +981,9 @@ namespace tool { namespace mesh {
             else
             {
                 uint32_t* dst_indices32 = (uint32_t*)data_block.begin;
-                for( uint32_t i = 0; i < streams.num_indices; ++i )
+                for( uint32_t i = 0; i < num_indices; ++i )
                 {
-                    dst_indices32[0] = streams.indices32[i];
+                    dst_indices32[0] = topology.indices[i];
                     ++dst_indices32;
                 }
                 chunker.Checkpoint( dst_indices32 );
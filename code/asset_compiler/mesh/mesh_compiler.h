@@ -5,6 +5,7 @@
 #include <foundation/blob.h>
 #include <rdi_backend\rdi_backend_type.h>
 #include<foundation\math\vmath_type.h>
+#include "mesh_optimizer.h"
 
 namespace tool { namespace mesh {
 
@@ -47,16 +48,47 @@ namespace tool { namespace mesh {
 
     struct CompileOptions
     {
+        static constexpr uint32_t MAX_LODS = 8;
+
         uint32_t slot_mask = UINT32_MAX;
+        uint32_t quantize_mask = 0; // slots stored with DefaultVertexEncoding() (rdix_vertex_codec.h)
+
+        // LOD0 is the source mesh. Each next LOD is simplified from LOD0 until it reaches either target triangle ratio
+        // or max error (relative to mesh bounding box diagonal, 0 for unlimited). Chain ends early when LOD doesn't get
+        // at least 10% smaller than previous one.
+        uint32_t num_lods = 1;
+        float lod_ratio[MAX_LODS] = { 1.f, 0.5f, 0.25f, 0.125f, 0.0625f, 0.03125f, 0.015625f, 0.0078125f };
+        float lod_error[MAX_LODS] = {};
+
+        // split draw ranges into RDIXMeshlet clusters (bounds + normal cone) for CPU culling
+        bool meshlets = false;
 
         CompileOptions( uint32_t default_slots = UINT32_MAX );
         CompileOptions& AddSlot( RDIEVertexSlot::Enum slot );
         CompileOptions& RemSlot( RDIEVertexSlot::Enum slot );
         CompileOptions& EnableSlot( RDIEVertexSlot::Enum slot, bool value );
+        CompileOptions& Quantize( RDIEVertexSlot::Enum slot, bool value = true );
+        CompileOptions& QuantizeAll( bool value = true );
+        CompileOptions& Lods( uint32_t count, float ratio_step = 0.5f, float max_error = 0.f );
+        CompileOptions& Meshlets( bool value = true );
 
         bool HasSlot( uint32_t slot ) const { return ( slot_mask & (1 << slot) ) != 0; }
+        bool IsQuantized( uint32_t slot ) const { return ( quantize_mask & (1 << slot) ) != 0; }
+    };
+
+    struct CompileReport
+    {
+        VertexCacheStats input;           // FIFO-16 cache, triangle order as imported
+        VertexCacheStats output;          // FIFO-16 cache, compiled order (LOD0)
+        uint32_t num_input_vertices = 0;
+        uint32_t num_output_vertices = 0; // vertices shared by parts are duplicated
+        uint32_t num_parts = 0;           // stored as RDIXMeshFile draw ranges
+        uint32_t num_lods = 0;
+        uint32_t lod_triangles[CompileOptions::MAX_LODS] = {};
+        float lod_error[CompileOptions::MAX_LODS] = {};   // object space
+        uint32_t num_meshlets = 0;
     };
 
     StreamsArray Import( const void* data, uint32_t data_size, const ImportOptions& options = ImportOptions() );
-    blob_t Compile( const Streams& streams, const CompileOptions& opt, BXIAllocator* allocator );
+    blob_t Compile( const Streams& streams, const CompileOptions& opt, BXIAllocator* allocator, CompileReport* report = nullptr );
 }}
\ No newline at end of file
@@ -0,0 +1,400 @@
+#include "mesh_optimizer.h"
+
+#include <foundation/type.h>
+#include <foundation/debug.h>
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace tool { namespace mesh {
+
+namespace
+{
+    // --- Forsyth, "Linear-Speed Vertex Cache Optimisation"
+    constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+    constexpr uint32_t FORSYTH_MAX_VALENCE = 32;
+    constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+    constexpr float FORSYTH_LAST_TRI_SCORE = 0.75f;
+    constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+    struct ForsythScores
+    {
+        float cache[FORSYTH_CACHE_SIZE];
+        float valence[FORSYTH_MAX_VALENCE];
+
+        ForsythScores()
+        {
+            for( uint32_t i = 0; i < FORSYTH_CACHE_SIZE; ++i )
+            {
+                if( i < 3 )
+                {
+                    cache[i] = FORSYTH_LAST_TRI_SCORE;
+                }
+                else
+                {
+                    const float scaler = 1.f / ( FORSYTH_CACHE_SIZE - 3 );
+                    cache[i] = powf( 1.f - ( i - 3 ) * scaler, FORSYTH_CACHE_DECAY_POWER );
+                }
+            }
+
+            valence[0] = 0.f;
+            for( uint32_t i = 1; i < FORSYTH_MAX_VALENCE; ++i )
+                valence[i] = FORSYTH_VALENCE_BOOST_SCALE * powf( (float)i, -FORSYTH_VALENCE_BOOST_POWER );
+        }
+
+        float VertexScore( int cache_pos, uint32_t remaining ) const
+        {
+            if( !remaining )
+                return -1.f;
+
+            const float score = ( cache_pos >= 0 ) ? cache[cache_pos] : 0.f;
+            return score + valence[( remaining < FORSYTH_MAX_VALENCE ) ? remaining : FORSYTH_MAX_VALENCE - 1];
+        }
+    };
+
+    uint32_t CountFifoMisses( std::vector<uint32_t>& timestamps, uint32_t& time, const uint32_t* tri, uint32_t cache_size )
+    {
+        uint32_t misses = 0;
+        for( uint32_t i = 0; i < 3; ++i )
+        {
+            const uint32_t v = tri[i];
+            if( time - timestamps[v] > cache_size )
+            {
+                timestamps[v] = time++;
+                ++misses;
+            }
+        }
+        return misses;
+    }
+
+    struct Vec3f
+    {
+        float x, y, z;
+    };
+
+    inline Vec3f LoadPosition( const void* positions, uint32_t stride, uint32_t index )
+    {
+        const float* p = (const float*)( (const uint8_t*)positions + (size_t)index * stride );
+        return { p[0], p[1], p[2] };
+    }
+}//
+
+VertexCacheStats AnalyzeVertexCache( const uint32_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size )
+{
+    VertexCacheStats stats;
+    if( num_indices < 3 )
+        return stats;
+
+    std::vector<uint32_t> timestamps( num_vertices, 0 );
+    std::vector<uint8_t> referenced( num_vertices, 0 );
+    uint32_t time = cache_size + 1;
+    uint32_t misses = 0;
+    uint32_t unique = 0;
+
+    for( uint32_t i = 0; i + 2 < num_indices; i += 3 )
+    {
+        misses += CountFifoMisses( timestamps, time, indices + i, cache_size );
+        for( uint32_t c = 0; c < 3; ++c )
+        {
+            unique += ( referenced[indices[i + c]] == 0 );
+            referenced[indices[i + c]] = 1;
+        }
+    }
+
+    stats.acmr = (float)misses / (float)( num_indices / 3 );
+    stats.atvr = ( unique ) ? (float)misses / (float)unique : 0.f;
+    return stats;
+}
+
+void OptimizeVertexCache( uint32_t* indices, uint32_t num_indices, uint32_t num_vertices )
+{
+    const uint32_t num_tris = num_indices / 3;
+    if( num_tris < 2 )
+        return;
+
+    static const ForsythScores scores;
+
+    // vertex -> triangles adjacency, active triangles of vertex v are adjacency[offsets[v], offsets[v] + remaining[v])
+    std::vector<uint32_t> remaining( num_vertices, 0 );
+    for( uint32_t i = 0; i < num_tris * 3; ++i )
+        ++remaining[indices[i]];
+
+    std::vector<uint32_t> offsets( num_vertices + 1, 0 );
+    for( uint32_t v = 0; v < num_vertices; ++v )
+        offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<uint32_t> adjacency( num_tris * 3 );
+    {
+        std::vector<uint32_t> cursor( offsets.begin(), offsets.end() - 1 );
+        for( uint32_t i = 0; i < num_tris * 3; ++i )
+            adjacency[cursor[indices[i]]++] = i / 3;
+    }
+
+    std::vector<int> cache_pos( num_vertices, -1 );
+    std::vector<float> vertex_score( num_vertices );
+    for( uint32_t v = 0; v < num_vertices; ++v )
+        vertex_score[v] = scores.VertexScore( -1, remaining[v] );
+
+    std::vector<float> tri_score( num_tris );
+    std::vector<uint8_t> emitted( num_tris, 0 );
+    for( uint32_t t = 0; t < num_tris; ++t )
+        tri_score[t] = vertex_score[indices[t*3+0]] + vertex_score[indices[t*3+1]] + vertex_score[indices[t*3+2]];
+
+    std::vector<uint32_t> output;
+    output.reserve( num_tris * 3 );
+
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t cache_count = 0;
+
+    int best_tri = -1;
+    uint32_t scan_pos = 0;
+
+    for( uint32_t iout = 0; iout < num_tris; ++iout )
+    {
+        // dead end, continue with next triangle in input order
+        if( best_tri < 0 )
+        {
+            while( emitted[scan_pos] )
+                ++scan_pos;
+            best_tri = (int)scan_pos;
+        }
+
+        const uint32_t tri = (uint32_t)best_tri;
+        const uint32_t* tri_indices = indices + tri * 3;
+        emitted[tri] = 1;
+
+        for( uint32_t c = 0; c < 3; ++c )
+        {
+            const uint32_t v = tri_indices[c];
+            output.push_back( v );
+
+            uint32_t* begin = adjacency.data() + offsets[v];
+            uint32_t* end = begin + remaining[v];
+            uint32_t* it = std::find( begin, end, tri );
+            SYS_ASSERT( it != end );
+            *it = end[-1];
+            --remaining[v];
+        }
+
+        // emitted triangle goes to the front, evicted vertices drop out of the cache
+        uint32_t new_cache[FORSYTH_CACHE_SIZE + 3];
+        uint32_t new_count = 0;
+        for( uint32_t c = 0; c < 3; ++c )
+        {
+            const uint32_t v = tri_indices[c];
+            if( std::find( new_cache, new_cache + new_count, v ) == new_cache + new_count )
+                new_cache[new_count++] = v;
+        }
+        for( uint32_t i = 0; i < cache_count; ++i )
+        {
+            const uint32_t v = cache[i];
+            if( v != tri_indices[0] && v != tri_indices[1] && v != tri_indices[2] )
+                new_cache[new_count++] = v;
+        }
+
+        for( uint32_t i = 0; i < new_count; ++i )
+            cache_pos[new_cache[i]] = ( i < FORSYTH_CACHE_SIZE ) ? (int)i : -1;
+
+        for( uint32_t i = 0; i < new_count; ++i )
+        {
+            const uint32_t v = new_cache[i];
+            const float score = scores.VertexScore( cache_pos[v], remaining[v] );
+            const float diff = score - vertex_score[v];
+            vertex_score[v] = score;
+
+            const uint32_t* begin = adjacency.data() + offsets[v];
+            for( uint32_t j = 0; j < remaining[v]; ++j )
+                tri_score[begin[j]] += diff;
+        }
+
+        best_tri = -1;
+        float best_score = -1.f;
+        for( uint32_t i = 0; i < new_count; ++i )
+        {
+            const uint32_t v = new_cache[i];
+            const uint32_t* begin = adjacency.data() + offsets[v];
+            for( uint32_t j = 0; j < remaining[v]; ++j )
+            {
+                const uint32_t t = begin[j];
+                if( tri_score[t] > best_score )
+                {
+                    best_score = tri_score[t];
+                    best_tri = (int)t;
+                }
+            }
+        }
+
+        cache_count = ( new_count < FORSYTH_CACHE_SIZE ) ? new_count : FORSYTH_CACHE_SIZE;
+        memcpy( cache, new_cache, cache_count * sizeof( uint32_t ) );
+    }
+
+    memcpy( indices, output.data(), num_tris * 3 * sizeof( uint32_t ) );
+}
+
+void OptimizeOverdraw( uint32_t* indices, uint32_t num_indices, const void* positions, uint32_t position_stride, uint32_t num_vertices, float threshold )
+{
+    const uint32_t num_tris = num_indices / 3;
+    if( num_tris < 2 || !positions )
+        return;
+
+    const uint32_t cache_size = 16;
+
+    // cluster boundaries where cache is effectively cold (all 3 vertices miss),
+    // moving such clusters around has little effect on vertex cache efficiency
+    std::vector<uint32_t> cluster_begin;
+    {
+        std::vector<uint32_t> timestamps( num_vertices, 0 );
+        uint32_t time = cache_size + 1;
+        for( uint32_t t = 0; t < num_tris; ++t )
+        {
+            const uint32_t misses = CountFifoMisses( timestamps, time, indices + t * 3, cache_size );
+            if( t == 0 || misses == 3 )
+                cluster_begin.push_back( t );
+        }
+    }
+
+    const uint32_t num_clusters = (uint32_t)cluster_begin.size();
+    if( num_clusters < 2 )
+        return;
+
+    cluster_begin.push_back( num_tris );
+
+    struct Cluster
+    {
+        Vec3f centroid;
+        Vec3f normal;
+        float area;
+    };
+    std::vector<Cluster> clusters( num_clusters );
+
+    Vec3f mesh_centroid = { 0.f, 0.f, 0.f };
+    float mesh_area = 0.f;
+
+    for( uint32_t ic = 0; ic < num_clusters; ++ic )
+    {
+        Cluster& cl = clusters[ic];
+        cl = {};
+
+        for( uint32_t t = cluster_begin[ic]; t < cluster_begin[ic + 1]; ++t )
+        {
+            const Vec3f a = LoadPosition( positions, position_stride, indices[t*3+0] );
+            const Vec3f b = LoadPosition( positions, position_stride, indices[t*3+1] );
+            const Vec3f c = LoadPosition( positions, position_stride, indices[t*3+2] );
+
+            const Vec3f e0 = { b.x - a.x, b.y - a.y, b.z - a.z };
+            const Vec3f e1 = { c.x - a.x, c.y - a.y, c.z - a.z };
+            const Vec3f n = { e0.y*e1.z - e0.z*e1.y, e0.z*e1.x - e0.x*e1.z, e0.x*e1.y - e0.y*e1.x };
+            const float area = sqrtf( n.x*n.x + n.y*n.y + n.z*n.z );
+
+            cl.centroid.x += ( a.x + b.x + c.x ) * area;
+            cl.centroid.y += ( a.y + b.y + c.y ) * area;
+            cl.centroid.z += ( a.z + b.z + c.z ) * area;
+            cl.normal.x += n.x;
+            cl.normal.y += n.y;
+            cl.normal.z += n.z;
+            cl.area += area;
+        }
+
+        mesh_centroid.x += cl.centroid.x;
+        mesh_centroid.y += cl.centroid.y;
+        mesh_centroid.z += cl.centroid.z;
+        mesh_area += cl.area;
+
+        const float inv = ( cl.area > 0.f ) ? 1.f / ( cl.area * 3.f ) : 0.f;
+        cl.centroid = { cl.centroid.x * inv, cl.centroid.y * inv, cl.centroid.z * inv };
+    }
+
+    {
+        const float inv = ( mesh_area > 0.f ) ? 1.f / ( mesh_area * 3.f ) : 0.f;
+        mesh_centroid = { mesh_centroid.x * inv, mesh_centroid.y * inv, mesh_centroid.z * inv };
+    }
+
+    // clusters facing away from mesh center are likely to occlude others, draw them first
+    std::vector<float> sort_key( num_clusters );
+    for( uint32_t ic = 0; ic < num_clusters; ++ic )
+    {
+        const Cluster& cl = clusters[ic];
+        const float len = sqrtf( cl.normal.x*cl.normal.x + cl.normal.y*cl.normal.y + cl.normal.z*cl.normal.z );
+        const float inv_len = ( len > 0.f ) ? 1.f / len : 0.f;
+        const Vec3f d = { cl.centroid.x - mesh_centroid.x, cl.centroid.y - mesh_centroid.y, cl.centroid.z - mesh_centroid.z };
+        sort_key[ic] = ( d.x*cl.normal.x + d.y*cl.normal.y + d.z*cl.normal.z ) * inv_len;
+    }
+
+    std::vector<uint32_t> order( num_clusters );
+    for( uint32_t ic = 0; ic < num_clusters; ++ic )
+        order[ic] = ic;
+
+    std::stable_sort( order.begin(), order.end(), [&sort_key]( uint32_t a, uint32_t b ) { return sort_key[a] > sort_key[b]; } );
+
+    std::vector<uint32_t> output;
+    output.reserve( num_tris * 3 );
+    for( uint32_t ic : order )
+        output.insert( output.end(), indices + cluster_begin[ic] * 3, indices + cluster_begin[ic + 1] * 3 );
+
+    const VertexCacheStats before = AnalyzeVertexCache( indices, num_tris * 3, num_vertices, cache_size );
+    const VertexCacheStats after = AnalyzeVertexCache( output.data(), num_tris * 3, num_vertices, cache_size );
+    if( after.acmr <= before.acmr * threshold )
+    {
+        memcpy( indices, output.data(), num_tris * 3 * sizeof( uint32_t ) );
+    }
+}
+
+void OptimizeVertexFetch( std::vector<uint32_t>* vertex_remap, std::vector<VertexFetchPart>* parts, uint32_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t max_part_vertices )
+{
+    SYS_ASSERT( max_part_vertices >= 3 );
+
+    vertex_remap->clear();
+    parts->clear();
+
+    const uint32_t num_tris = num_indices / 3;
+    if( !num_tris )
+        return;
+
+    std::vector<uint32_t> vertex_part( num_vertices, UINT32_MAX );
+    std::vector<uint32_t> local_index( num_vertices, 0 );
+
+    uint32_t part_index = 0;
+    VertexFetchPart part;
+
+    for( uint32_t t = 0; t < num_tris; ++t )
+    {
+        uint32_t* tri = indices + t * 3;
+
+        uint32_t new_vertices = 0;
+        for( uint32_t c = 0; c < 3; ++c )
+        {
+            const bool duplicate = ( c > 0 && tri[c] == tri[0] ) || ( c > 1 && tri[c] == tri[1] );
+            new_vertices += ( vertex_part[tri[c]] != part_index && !duplicate );
+        }
+
+        if( part.num_vertices + new_vertices > max_part_vertices )
+        {
+            part.num_indices = t * 3 - part.first_index;
+            parts->push_back( part );
+
+            ++part_index;
+            part = VertexFetchPart();
+            part.first_index = t * 3;
+            part.base_vertex = (uint32_t)vertex_remap->size();
+        }
+
+        for( uint32_t c = 0; c < 3; ++c )
+        {
+            const uint32_t v = tri[c];
+            if( vertex_part[v] != part_index )
+            {
+                vertex_part[v] = part_index;
+                local_index[v] = part.num_vertices++;
+                vertex_remap->push_back( v );
+            }
+            tri[c] = local_index[v];
+        }
+    }
+
+    part.num_indices = num_tris * 3 - part.first_index;
+    parts->push_back( part );
+}
+
+}}//
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// Offline triangle/vertex reordering used by tool::mesh::Compile. All passes are deterministic.
+namespace tool { namespace mesh {
+
+    struct VertexCacheStats
+    {
+        float acmr = 0.f; // cache misses per triangle
+        float atvr = 0.f; // cache misses per referenced vertex (1.0 is optimal)
+    };
+
+    // FIFO post-transform cache simulation
+    VertexCacheStats AnalyzeVertexCache( const uint32_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size = 16 );
+
+    // Forsyth's linear-speed vertex cache optimization (LRU cache model)
+    void OptimizeVertexCache( uint32_t* indices, uint32_t num_indices, uint32_t num_vertices );
+
+    // Reorders clusters of cache-optimized triangles front to back (Sander et al. 2007).
+    // positions: 'position_stride' bytes apart, xyz floats. Order is kept when ACMR would grow above 'threshold' times the input.
+    void OptimizeOverdraw( uint32_t* indices, uint32_t num_indices, const void* positions, uint32_t position_stride, uint32_t num_vertices, float threshold = 1.05f );
+
+    struct VertexFetchPart
+    {
+        uint32_t first_index = 0;
+        uint32_t num_indices = 0;
+        uint32_t base_vertex = 0;
+        uint32_t num_vertices = 0;
+    };
+
+    // Orders vertices by first use and splits triangle list into parts of at most 'max_part_vertices' unique vertices.
+    // vertex_remap receives source vertex for each output vertex (vertices shared by parts are duplicated),
+    // indices are rewritten in place to be relative to part's base_vertex.
+    void OptimizeVertexFetch( std::vector<uint32_t>* vertex_remap, std::vector<VertexFetchPart>* parts, uint32_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t max_part_vertices = UINT16_MAX + 1 );
+
+}}//
@@ -0,0 +1,414 @@
+#include "mesh_simplifier.h"
+
+#include <foundation/type.h>
+#include <foundation/debug.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+namespace tool { namespace mesh {
+
+namespace
+{
+    // border planes are weighted higher so open edges keep their silhouette
+    constexpr double BORDER_WEIGHT = 10.0;
+
+    namespace EVertexKind
+    {
+        enum E : uint8_t
+        {
+            MANIFOLD = 0, // collapses onto any neighbour
+            BORDER,       // collapses along open border only
+            LOCKED,       // seam or non manifold, never moves
+        };
+    }//
+
+    struct Vec3d
+    {
+        double x, y, z;
+    };
+    inline Vec3d operator - ( const Vec3d& a, const Vec3d& b ) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    inline Vec3d Cross( const Vec3d& a, const Vec3d& b ) { return { a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x }; }
+    inline double Dot( const Vec3d& a, const Vec3d& b ) { return a.x*b.x + a.y*b.y + a.z*b.z; }
+
+    // symmetric 4x4 matrix of plane equation products, stored as upper triangle
+    struct Quadric
+    {
+        double a00 = 0, a11 = 0, a22 = 0;
+        double a01 = 0, a02 = 0, a12 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double w = 0;
+
+        void AddPlane( const Vec3d& n, double d, double weight )
+        {
+            a00 += weight * n.x * n.x;
+            a11 += weight * n.y * n.y;
+            a22 += weight * n.z * n.z;
+            a01 += weight * n.x * n.y;
+            a02 += weight * n.x * n.z;
+            a12 += weight * n.y * n.z;
+            b0 += weight * n.x * d;
+            b1 += weight * n.y * d;
+            b2 += weight * n.z * d;
+            c  += weight * d * d;
+            w  += weight;
+        }
+
+        void Add( const Quadric& q )
+        {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22;
+            a01 += q.a01; a02 += q.a02; a12 += q.a12;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+            w += q.w;
+        }
+
+        // sum of weighted squared distances to planes
+        double Eval( const Vec3d& p ) const
+        {
+            const double rx = a00 * p.x + a01 * p.y + a02 * p.z + b0 * 2.0;
+            const double ry = a01 * p.x + a11 * p.y + a12 * p.z + b1 * 2.0;
+            const double rz = a02 * p.x + a12 * p.y + a22 * p.z + b2 * 2.0;
+            const double r = rx * p.x + ry * p.y + rz * p.z + c;
+            return ( r > 0.0 ) ? r : 0.0;
+        }
+    };
+
+    // squared distance, normalized by total weight
+    inline double CollapseError( const Quadric& q0, const Quadric& q1, const Vec3d& p )
+    {
+        Quadric q = q0;
+        q.Add( q1 );
+        return ( q.w > 0.0 ) ? q.Eval( p ) / q.w : 0.0;
+    }
+
+    struct Collapse
+    {
+        uint32_t v0;
+        uint32_t v1;
+        double error;
+    };
+
+    inline uint64_t EdgeKey( uint32_t a, uint32_t b )
+    {
+        return ( (uint64_t)a << 32 ) | b;
+    }
+
+    struct PositionKey
+    {
+        uint32_t bits[3];
+        bool operator == ( const PositionKey& other ) const { return memcmp( bits, other.bits, sizeof( bits ) ) == 0; }
+    };
+    struct PositionKeyHash
+    {
+        size_t operator()( const PositionKey& k ) const
+        {
+            return ( k.bits[0] * 73856093u ) ^ ( k.bits[1] * 19349663u ) ^ ( k.bits[2] * 83492791u );
+        }
+    };
+}//
+
+uint32_t SimplifyMesh( uint32_t* dst, const uint32_t* indices, uint32_t num_indices, const SimplifyDesc& desc, float* result_error )
+{
+    SYS_ASSERT( desc.positions && desc.position_stride >= 3 * sizeof( float ) );
+
+    const uint32_t num_vertices = desc.num_vertices;
+    const uint32_t target_num_indices = desc.target_num_indices;
+    const double max_error = ( desc.target_error > 0.f ) ? (double)desc.target_error * desc.target_error : DBL_MAX;
+
+    std::vector<uint32_t> result( indices, indices + ( num_indices / 3 ) * 3 );
+    double current_error = 0.0;
+
+    std::vector<Vec3d> positions( num_vertices );
+    for( uint32_t i = 0; i < num_vertices; ++i )
+    {
+        const float* p = (const float*)( (const uint8_t*)desc.positions + (size_t)i * desc.position_stride );
+        positions[i] = { p[0], p[1], p[2] };
+    }
+
+    // vertices sharing position are treated as one for topology. First vertex with given position represents the group
+    std::vector<uint32_t> position_remap( num_vertices );
+    std::vector<uint32_t> group_size( num_vertices, 0 );
+    {
+        std::unordered_map<PositionKey, uint32_t, PositionKeyHash> position_map;
+        position_map.reserve( num_vertices );
+        for( uint32_t i = 0; i < num_vertices; ++i )
+        {
+            PositionKey key;
+            const float* p = (const float*)( (const uint8_t*)desc.positions + (size_t)i * desc.position_stride );
+            memcpy( key.bits, p, sizeof( key.bits ) );
+
+            auto it = position_map.emplace( key, i ).first;
+            position_remap[i] = it->second;
+            ++group_size[it->second];
+        }
+    }
+
+    // classify vertices by looking for opposite half edges
+    std::vector<uint8_t> kind( num_vertices, EVertexKind::MANIFOLD );
+    std::vector<uint32_t> border_next( num_vertices, UINT32_MAX );
+    std::vector<uint32_t> border_prev( num_vertices, UINT32_MAX );
+    std::vector<Quadric> quadrics( num_vertices );
+    {
+        std::unordered_map<uint64_t, uint32_t> half_edges;
+        half_edges.reserve( result.size() );
+        for( size_t i = 0; i < result.size(); i += 3 )
+        {
+            for( uint32_t e = 0; e < 3; ++e )
+            {
+                const uint32_t a = position_remap[result[i + e]];
+                const uint32_t b = position_remap[result[i + ( e + 1 ) % 3]];
+                ++half_edges[EdgeKey( a, b )];
+            }
+        }
+
+        std::vector<uint8_t> open_out( num_vertices, 0 );
+        std::vector<uint8_t> open_in( num_vertices, 0 );
+        for( size_t i = 0; i < result.size(); i += 3 )
+        {
+            const Vec3d& p0 = positions[result[i + 0]];
+            const Vec3d& p1 = positions[result[i + 1]];
+            const Vec3d& p2 = positions[result[i + 2]];
+            Vec3d n = Cross( p1 - p0, p2 - p0 );
+            const double area2 = sqrt( Dot( n, n ) );
+            if( area2 > 0.0 )
+                n = { n.x / area2, n.y / area2, n.z / area2 };
+
+            for( uint32_t e = 0; e < 3; ++e )
+            {
+                const uint32_t a = position_remap[result[i + e]];
+                const uint32_t b = position_remap[result[i + ( e + 1 ) % 3]];
+
+                quadrics[a].AddPlane( n, -Dot( n, positions[a] ), area2 * 0.5 );
+
+                const uint32_t count = half_edges[EdgeKey( a, b )];
+                const auto opposite = half_edges.find( EdgeKey( b, a ) );
+                const uint32_t opposite_count = ( opposite != half_edges.end() ) ? opposite->second : 0;
+                if( count > 1 || opposite_count > 1 )
+                {
+                    kind[a] = kind[b] = EVertexKind::LOCKED;
+                }
+                else if( opposite_count == 0 )
+                {
+                    open_out[a] = ( open_out[a] < UINT8_MAX ) ? open_out[a] + 1 : open_out[a];
+                    open_in[b] = ( open_in[b] < UINT8_MAX ) ? open_in[b] + 1 : open_in[b];
+                    border_next[a] = b;
+                    border_prev[b] = a;
+
+                    // plane through the edge, perpendicular to triangle
+                    const Vec3d edge = positions[b] - positions[a];
+                    const double edge_len_sqr = Dot( edge, edge );
+                    Vec3d bn = Cross( edge, n );
+                    const double bn_len = sqrt( Dot( bn, bn ) );
+                    if( bn_len > 0.0 )
+                    {
+                        bn = { bn.x / bn_len, bn.y / bn_len, bn.z / bn_len };
+                        quadrics[a].AddPlane( bn, -Dot( bn, positions[a] ), edge_len_sqr * BORDER_WEIGHT );
+                        quadrics[b].AddPlane( bn, -Dot( bn, positions[b] ), edge_len_sqr * BORDER_WEIGHT );
+                    }
+                }
+            }
+        }
+
+        for( uint32_t i = 0; i < num_vertices; ++i )
+        {
+            const uint32_t r = position_remap[i];
+            if( group_size[r] > 1 )
+            {
+                kind[i] = EVertexKind::LOCKED;
+            }
+            else if( kind[r] != EVertexKind::LOCKED && ( open_out[r] || open_in[r] ) )
+            {
+                kind[i] = ( open_out[r] == 1 && open_in[r] == 1 ) ? EVertexKind::BORDER : EVertexKind::LOCKED;
+            }
+        }
+    }
+
+    std::vector<uint32_t> adjacency_offsets( num_vertices + 1 );
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> collapse_remap( num_vertices );
+    std::vector<uint8_t> locked( num_vertices );
+
+    while( result.size() > target_num_indices )
+    {
+        const uint32_t num_tris = (uint32_t)result.size() / 3;
+
+        // vertex -> triangles
+        std::fill( adjacency_offsets.begin(), adjacency_offsets.end(), 0 );
+        for( uint32_t idx : result )
+            ++adjacency_offsets[idx + 1];
+        for( uint32_t i = 0; i < num_vertices; ++i )
+            adjacency_offsets[i + 1] += adjacency_offsets[i];
+
+        adjacency.resize( result.size() );
+        {
+            std::vector<uint32_t> cursor( adjacency_offsets.begin(), adjacency_offsets.end() - 1 );
+            for( uint32_t i = 0; i < num_tris * 3; ++i )
+                adjacency[cursor[result[i]]++] = i / 3;
+        }
+
+        // candidates, both directions of every edge
+        collapses.clear();
+        for( uint32_t i = 0; i < num_tris * 3; i += 3 )
+        {
+            for( uint32_t e = 0; e < 3; ++e )
+            {
+                const uint32_t a = result[i + e];
+                const uint32_t b = result[i + ( e + 1 ) % 3];
+
+                for( uint32_t dir = 0; dir < 2; ++dir )
+                {
+                    const uint32_t v0 = ( dir ) ? b : a;
+                    const uint32_t v1 = ( dir ) ? a : b;
+                    const uint32_t r0 = position_remap[v0];
+                    const uint32_t r1 = position_remap[v1];
+
+                    if( r0 == r1 || kind[v0] == EVertexKind::LOCKED )
+                        continue;
+                    if( kind[v0] == EVertexKind::BORDER && border_next[r0] != r1 && border_prev[r0] != r1 )
+                        continue;
+                    if( desc.vertex_class && desc.vertex_class[v0] != desc.vertex_class[v1] )
+                        continue;
+
+                    const double error = CollapseError( quadrics[r0], quadrics[r1], positions[v1] );
+                    if( error <= max_error )
+                        collapses.push_back( { v0, v1, error } );
+                }
+            }
+        }
+
+        if( collapses.empty() )
+            break;
+
+        std::sort( collapses.begin(), collapses.end(), []( const Collapse& a, const Collapse& b )
+        {
+            if( a.error != b.error ) return a.error < b.error;
+            if( a.v0 != b.v0 ) return a.v0 < b.v0;
+            return a.v1 < b.v1;
+        } );
+
+        for( uint32_t i = 0; i < num_vertices; ++i )
+            collapse_remap[i] = i;
+        std::fill( locked.begin(), locked.end(), 0 );
+
+        // each collapse removes (usually) 2 triangles
+        const uint32_t triangles_to_remove = ( (uint32_t)result.size() - target_num_indices + 2 ) / 3;
+        uint32_t triangles_removed = 0;
+        uint32_t num_collapses = 0;
+
+        for( const Collapse& c : collapses )
+        {
+            if( triangles_removed >= triangles_to_remove )
+                break;
+
+            const uint32_t v0 = c.v0;
+            const uint32_t v1 = c.v1;
+            const uint32_t* tris = adjacency.data() + adjacency_offsets[v0];
+            const uint32_t num_adjacent = adjacency_offsets[v0 + 1] - adjacency_offsets[v0];
+
+            // triangles around v0 can't be touched by other collapses in this pass
+            bool valid = true;
+            uint32_t removed = 0;
+            for( uint32_t j = 0; j < num_adjacent && valid; ++j )
+            {
+                const uint32_t* tri = result.data() + tris[j] * 3;
+                for( uint32_t k = 0; k < 3; ++k )
+                {
+                    const uint32_t v = tri[k];
+                    valid &= ( locked[v] == 0 );
+
+                    // would weld v1 with another vertex of the same position (other side of a seam)
+                    valid &= ( v == v1 || v == v0 || position_remap[v] != position_remap[v1] );
+                }
+
+                if( tri[0] == v1 || tri[1] == v1 || tri[2] == v1 )
+                {
+                    ++removed;
+                    continue;
+                }
+
+                // reject flipped triangles
+                Vec3d p[3];
+                Vec3d q[3];
+                for( uint32_t k = 0; k < 3; ++k )
+                {
+                    p[k] = positions[tri[k]];
+                    q[k] = ( tri[k] == v0 ) ? positions[v1] : p[k];
+                }
+                const Vec3d n0 = Cross( p[1] - p[0], p[2] - p[0] );
+                const Vec3d n1 = Cross( q[1] - q[0], q[2] - q[0] );
+                valid &= Dot( n0, n1 ) > 0.25 * sqrt( Dot( n0, n0 ) * Dot( n1, n1 ) );
+            }
+
+            if( !valid || locked[v1] )
+                continue;
+
+            for( uint32_t j = 0; j < num_adjacent; ++j )
+            {
+                const uint32_t* tri = result.data() + tris[j] * 3;
+                locked[tri[0]] = locked[tri[1]] = locked[tri[2]] = 1;
+            }
+
+            collapse_remap[v0] = v1;
+
+            const uint32_t r0 = position_remap[v0];
+            const uint32_t r1 = position_remap[v1];
+            quadrics[r1].Add( quadrics[r0] );
+
+            // keep border loop linked around removed vertex
+            if( kind[v0] == EVertexKind::BORDER )
+            {
+                const uint32_t prev = border_prev[r0];
+                const uint32_t next = border_next[r0];
+                if( next == r1 )
+                {
+                    border_prev[r1] = prev;
+                    if( prev != UINT32_MAX )
+                        border_next[prev] = r1;
+                }
+                else
+                {
+                    border_next[r1] = next;
+                    if( next != UINT32_MAX )
+                        border_prev[next] = r1;
+                }
+            }
+
+            current_error = ( c.error > current_error ) ? c.error : current_error;
+            triangles_removed += removed;
+            ++num_collapses;
+        }
+
+        if( !num_collapses )
+            break;
+
+        uint32_t write = 0;
+        for( uint32_t i = 0; i < num_tris * 3; i += 3 )
+        {
+            const uint32_t a = collapse_remap[result[i + 0]];
+            const uint32_t b = collapse_remap[result[i + 1]];
+            const uint32_t c = collapse_remap[result[i + 2]];
+            if( a == b || b == c || c == a )
+                continue;
+
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize( write );
+    }
+
+    memcpy( dst, result.data(), result.size() * sizeof( uint32_t ) );
+    if( result_error )
+        result_error[0] = (float)sqrt( current_error );
+
+    return (uint32_t)result.size();
+}
+
+}}//
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+// Quadric error metric edge collapse (Garland & Heckbert 1997). Vertices are only collapsed onto existing vertices,
+// so simplified index lists keep referencing (and share) the source vertex buffer and its attributes are never blended.
+namespace tool { namespace mesh {
+
+    struct SimplifyDesc
+    {
+        const void* positions = nullptr; // xyz floats, 'position_stride' bytes apart
+        uint32_t position_stride = 0;
+        uint32_t num_vertices = 0;
+
+        // optional, per vertex. Collapses happen only between vertices of the same class (eg. dominant bone)
+        const uint32_t* vertex_class = nullptr;
+
+        uint32_t target_num_indices = 0;
+        float target_error = 0.f;        // object space distance, 0 for unlimited
+    };
+
+    // Vertices sharing position with other vertices (attribute seams) and non manifold vertices are never moved,
+    // open borders collapse only along the border. Returns number of indices written to 'dst' (at most num_indices).
+    // result_error: object space distance between simplified and source surface (approximated by quadrics).
+    uint32_t SimplifyMesh( uint32_t* dst, const uint32_t* indices, uint32_t num_indices, const SimplifyDesc& desc, float* result_error = nullptr );
+
+}}//
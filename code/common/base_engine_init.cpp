@@ -29,7 +29,7 @@ bool CMNBaseEngine::Startup( CMNBaseEngine* e, int argc, const char** argv, BXPl
     e->filesystem = (BXIFilesystem*)BXGetPlugin( plugins, BX_FILESYSTEM_PLUGIN_NAME );
     e->filesystem->SetRoot( "x:/dev/assets/" );
 
-    RSM::StartUp( e->filesystem, e->allocator );
+    RSM::StartUp( e->filesystem, e->allocator, true );
 
     BXIWindow* win_plugin = (BXIWindow*)BXGetPlugin( plugins, BX_WINDOW_PLUGIN_NAME );
     const BXWindow* window = win_plugin->GetWindow();
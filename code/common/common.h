@@ -82,13 +82,22 @@ namespace common
             BXFileWaitResult load_result = LoadFileSync( fs, filename, BXEFIleMode::BIN, allocator );
             if( load_result.status == BXEFileStatus::READY )
             {
-                _allocator = allocator;
-                file = (srl_file_t*)load_result.file.pointer;
-                data = file->data<T>();
-                result = true;
+                const srl_file_t* loaded = (srl_file_t*)load_result.file.pointer;
+                if( loaded->tag == T::TAG && loaded->version == T::VERSION )
+                {
+                    _allocator = allocator;
+                    file = loaded;
+                    data = file->data<T>();
+                    result = true;
+                }
+                else
+                {
+                    // stale asset (eg. skeleton compiled before level tables), needs recompilation
+                    SYS_LOG_ERROR( "%s: wrong tag or version (%u, expected %u)", filename, loaded->version, T::VERSION );
+                }
             }
 
-            fs->CloseFile( &load_result.handle, false );
+            fs->CloseFile( &load_result.handle, !result );
             return result;
         }
 
@@ -107,11 +107,11 @@ namespace
 {
     static inline bool IsEntityAlive( ENT::ENTSystem* sys, ENTEntityID id )
     {
-        const id_t eid = { id.i };
+        const id_handle_t eid = { id.i };
         return id_array::has( sys->entity_id_alloc, eid );
     }
 
-    static inline ENTEntityStorage* GetEntityStorage( ENT::ENTSystem* sys, id_t eid )
+    static inline ENTEntityStorage* GetEntityStorage( ENT::ENTSystem* sys, id_handle_t eid )
     {
         const uint32_t index = id_array::index( sys->entity_id_alloc, eid );
         return &sys->entity_storage[index];
@@ -119,13 +119,13 @@ namespace
 
     static inline ENTEntityStorage* GetEntityStorage( ENT::ENTSystem* sys, ENTEntityID id )
     {
-        const id_t eid = { id.i };
+        const id_handle_t eid = { id.i };
         return GetEntityStorage( sys, eid );
     }
 
     static inline bool IsComponentAlive( ENT::ENTSystem* sys, ENTComponentID id )
     {
-        const id_t cid = { id.i };
+        const id_handle_t cid = { id.i };
         return id_table::has( sys->comp_id_alloc, cid );
     }
 
@@ -144,14 +144,14 @@ namespace
     {
         SYS_ASSERT( IsComponentAlive( sys, id ) );
 
-        const id_t iid = { id.i };
+        const id_handle_t iid = { id.i };
         return sys->comp_storage.impl[iid.index];
     }
     static inline ENTEntityID GetOwnerEntityId( ENT::ENTSystem* sys, ENTComponentID id )
     {
         SYS_ASSERT( IsComponentAlive( sys, id ) );
 
-        const id_t iid = { id.i };
+        const id_handle_t iid = { id.i };
         return sys->comp_storage.entity_id[iid.index];
     }
 
@@ -206,7 +206,7 @@ namespace
             {
                 SYS_ASSERT( pending.to_add == 0 );
                 
-                const id_t eid = { pending.entity_id.i };
+                const id_handle_t eid = { pending.entity_id.i };
                 ENTEntityStorage* storage = GetEntityStorage( ent, eid );
 
                 ENTComponentStorage& comp_storage = ent->comp_storage;
@@ -261,7 +261,7 @@ namespace
 
 ENTEntityID ENT::CreateEntity()
 {
-    id_t id = { 0 };
+    id_handle_t id = { 0 };
     {
         scope_lock_t<mutex_t> guard( _ent->entity_lock );
         id = id_array::create( _ent->entity_id_alloc );
@@ -279,7 +279,7 @@ void ENT::DestroyEntity( ENTEntityID entity_id )
         scope_lock_t<mutex_t> guard( _ent->entity_lock );
         if( id_array::has( _ent->entity_id_alloc, { entity_id.i } ) )
         {
-            id_t new_id = id_array::invalidate( _ent->entity_id_alloc, { entity_id.i } );
+            id_handle_t new_id = id_array::invalidate( _ent->entity_id_alloc, { entity_id.i } );
             entity_id.i = new_id.hash;
             
             const uint32_t index = id_array::index( _ent->entity_id_alloc, new_id );
@@ -347,7 +347,7 @@ ENTComponentID ENT::CreateComponent( ENTEntityID eid, const char* type_name )
     if( !impl )
         return { 0 };
 
-    id_t id = {};
+    id_handle_t id = {};
     {
         scope_mutex_t guard( _ent->component_lock );
         id = id_table::create( _ent->comp_id_alloc );
@@ -1,10 +1,21 @@
 #include "filesystem_plugin.h"
-#include "filesystem_windows.h"
 
 #include <util/file_system_name.h>
 #include <foundation/string_util.h>
 #include <foundation/io.h>
+
+#if defined( _WIN32 )
+#include "filesystem_windows.h"
 #include "dirent.h"
+using FilesystemImpl = bx::FilesystemWindows;
+#else
+#include "filesystem_posix.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdio.h>
+using FilesystemImpl = bx::FilesystemPosix;
+#endif
 
 static BXFileWaitResult LoadFileSyncImpl( BXIFilesystem* fs, const char * relativePath, BXEFIleMode::E mode, BXIAllocator* allocator )
 {
@@ -39,6 +50,25 @@ static void AppendRelativePath( string_buffer_t* s, const char* relative_path )
     }
 }
 
+static int EntryType( DIR* dir, const struct dirent* ent )
+{
+#if !defined( _WIN32 )
+    // some filesystems don't fill d_type
+    if( ent->d_type == DT_UNKNOWN )
+    {
+        struct stat st;
+        if( fstatat( dirfd( dir ), ent->d_name, &st, AT_SYMLINK_NOFOLLOW ) == 0 )
+        {
+            if( S_ISREG( st.st_mode ) )
+                return DT_REG;
+            if( S_ISDIR( st.st_mode ) )
+                return DT_DIR;
+        }
+    }
+#endif
+    return ent->d_type;
+}
+
 static void ListFiles( BXIFilesystem* fs, string_buffer_t* s, const char* relative_path, uint32_t flags, BXIAllocator* allocator )
 {
     FSName abs_path;
@@ -54,32 +84,35 @@ static void ListFiles( BXIFilesystem* fs, string_buffer_t* s, const char* relati
     {
         while( ent = readdir( dir ) )
         {
-            const bool dot = ent->d_namlen == 1 && ent->d_name[0] == '.';
-            const bool dotdot = ent->d_namlen == 2 && string::equal( ent->d_name, ".." );
+            // d_namlen is not posix
+            const uint32_t name_len = string::length( ent->d_name );
+            const bool dot = name_len == 1 && ent->d_name[0] == '.';
+            const bool dotdot = name_len == 2 && string::equal( ent->d_name, ".." );
             if( dot || dotdot )
                 continue;
 
-            if( ent->d_type == DT_REG )
+            const int type = EntryType( dir, ent );
+            if( type == DT_REG )
             {
                 string::append( s, "F" );
                 if( append_relative_name )
                 {
                     AppendRelativePath( s, relative_path );
                 }
-                string::appendn( s, ent->d_name, (uint32_t)ent->d_namlen );
+                string::appendn( s, ent->d_name, name_len );
             }
-            else if( ent->d_type == DT_DIR )
+            else if( type == DT_DIR )
             {
                 string::append( s, "D+" );
                 if( append_relative_name )
                 {
                     AppendRelativePath( s, relative_path );
                 }
-                string::appendn( s, ent->d_name, (uint32_t)ent->d_namlen );
+                string::appendn( s, ent->d_name, name_len );
                 if( flags & BXEFileListFlag::RECURSE )
                 {
                     char child_relative_path[256] = {};
-                    sprintf_s( child_relative_path, 255, "%s%s/", relative_path, ent->d_name );
+                    snprintf( child_relative_path, 255, "%s%s/", relative_path, ent->d_name );
                     ListFiles( fs, s, child_relative_path, flags, allocator );
                 }
                 string::append( s, "D-" );
@@ -92,7 +125,7 @@ static void ListFiles( BXIFilesystem* fs, string_buffer_t* s, const char* relati
 
 PLUGIN_EXPORT void* BXLoad_filesystem( BXIAllocator * allocator )
 {
-	bx::FilesystemWindows* fs = BX_NEW( allocator, bx::FilesystemWindows, allocator );
+	FilesystemImpl* fs = BX_NEW( allocator, FilesystemImpl, allocator );
 	fs->LoadFileSync = LoadFileSyncImpl;
     fs->WriteFileSync = WriteFileSyncImpl;
     fs->ListFiles = ListFiles;
@@ -102,7 +135,7 @@ PLUGIN_EXPORT void* BXLoad_filesystem( BXIAllocator * allocator )
 
 PLUGIN_EXPORT void BXUnload_filesystem( void* plugin, BXIAllocator * allocator )
 {
-	bx::FilesystemWindows* fs = (bx::FilesystemWindows*)plugin;
+	FilesystemImpl* fs = (FilesystemImpl*)plugin;
 	fs->Shutdown();
 	BX_DELETE( allocator, fs );
 }
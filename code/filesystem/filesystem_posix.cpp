@@ -0,0 +1,290 @@
+#if !defined( _WIN32 )
+
+#include "filesystem_posix.h"
+
+#include <memory/memory.h>
+#include <foundation/debug.h>
+#include <foundation/queue.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+namespace bx
+{
+
+// ---
+//
+FilesystemPosix::FilesystemPosix( BXIAllocator* allocator )
+	: _to_load( allocator )
+	, _allocator( allocator )
+{
+}
+bool FilesystemPosix::Startup( uint32_t num_readers )
+{
+	if( num_readers == 0 )
+		num_readers = std::thread::hardware_concurrency();
+
+	_num_readers = ( num_readers < 1 ) ? 1 : ( num_readers > (uint32_t)MAX_READERS ) ? (uint32_t)MAX_READERS : num_readers;
+
+	_is_running = 1;
+	for( uint32_t i = 0; i < _num_readers; ++i )
+		_readers[i] = std::thread( ReaderThreadStatic, this );
+
+	return true;
+}
+void FilesystemPosix::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> guard( _to_load_lock );
+		_is_running = 0;
+	}
+	_to_load_cv.notify_all();
+
+	for( uint32_t i = 0; i < _num_readers; ++i )
+		_readers[i].join();
+
+	_num_readers = 0;
+}
+void FilesystemPosix::SetRoot( const char * absoluteDirPath )
+{
+	_root.Clear();
+	bool bres = _root.Append( absoluteDirPath );
+	SYS_ASSERT( bres );
+}
+
+const char* FilesystemPosix::GetRoot() const
+{
+	return _root.AbsolutePath();
+}
+
+bool FilesystemPosix::IsValid( BXFileHandle fhandle )
+{
+	const id_handle_t id = { fhandle.i };
+	return id_table::has( _ids, id );
+}
+
+BXFileHandle FilesystemPosix::LoadFile( const char* relativePath, BXEFIleMode::E mode, BXPostLoadCallback callback, BXIAllocator* allocator )
+{
+	if( !allocator )
+		allocator = _allocator;
+
+	id_handle_t id = { 0 };
+
+	_id_lock.lock();
+	id = id_table::create( _ids );
+	_id_lock.unlock();
+
+	_files_status[id.index].store( BXEFileStatus::LOADING );
+
+	FileReadRequest& request = _requests[id.index];
+	request._mode = mode;
+	request._name.Clear();
+	request._name.AppendRelativePath( relativePath );
+	request._callback = callback;
+	request._allocator = allocator;
+
+	BXFileHandle fhandle;
+	fhandle.i = id.hash;
+
+	{
+		std::lock_guard<std::mutex> guard( _to_load_lock );
+		queue::push_back( _to_load, fhandle );
+	}
+	_to_load_cv.notify_one();
+
+	return fhandle;
+}
+
+void FilesystemPosix::CloseFile( BXFileHandle* fhandle, bool freeData )
+{
+	if( !IsValid( *fhandle ) )
+		return;
+
+	const id_handle_t id = { fhandle->i };
+	_files_status[id.index].store( BXEFileStatus::EMPTY );
+
+	BXFile file = _files[id.index];
+
+	_id_lock.lock();
+	id_table::destroy( _ids, id );
+	_id_lock.unlock();
+
+	// freed right away, there is no unload thread
+	if( freeData )
+	{
+		BX_FREE( file.allocator, file.pointer );
+	}
+
+	_files[id.index] = {};
+	fhandle[0] = {};
+}
+
+BXEFileStatus::E FilesystemPosix::File( BXFile* file, BXFileHandle fhandle )
+{
+	if( !IsValid( fhandle ) )
+		return BXEFileStatus::EMPTY;
+
+	const id_handle_t id = { fhandle.i };
+
+	BXEFileStatus::E status = (BXEFileStatus::E)_files_status[id.index].load();
+	if( status == BXEFileStatus::READY )
+		file[0] = _files[id.index];
+
+	return status;
+}
+
+void FilesystemPosix::ReaderThreadStatic( FilesystemPosix* fs )
+{
+	fs->ReaderThread();
+}
+
+void FilesystemPosix::ReaderThread()
+{
+	BXFileHandle batch[BATCH_SIZE];
+	while( true )
+	{
+		uint32_t count = 0;
+		{
+			std::unique_lock<std::mutex> guard( _to_load_lock );
+			_to_load_cv.wait( guard, [this]() { return !_is_running || !queue::empty( _to_load ); } );
+			if( !_is_running )
+				break;
+
+			// share queued work between readers instead of first one taking whole batch
+			const uint32_t num_queued = queue::size( _to_load );
+			uint32_t batch_size = ( num_queued + _num_readers - 1 ) / _num_readers;
+			batch_size = ( batch_size > (uint32_t)BATCH_SIZE ) ? (uint32_t)BATCH_SIZE : batch_size;
+
+			while( count < batch_size && !queue::empty( _to_load ) )
+			{
+				batch[count++] = queue::front( _to_load );
+				queue::pop_front( _to_load );
+			}
+		}
+
+		// more work left, wake up another reader
+		_to_load_cv.notify_one();
+
+		ReadBatch( batch, count );
+	}
+}
+
+static bool ReadAll( int fd, uint8_t* dst, uint32_t size )
+{
+	uint32_t offset = 0;
+	while( offset < size )
+	{
+		const ssize_t n = pread( fd, dst + offset, size - offset, offset );
+		if( n < 0 && errno == EINTR )
+			continue;
+		if( n <= 0 )
+			return false;
+
+		offset += (uint32_t)n;
+	}
+	return true;
+}
+
+void FilesystemPosix::ReadBatch( const BXFileHandle* fhandles, uint32_t count )
+{
+	int fds[BATCH_SIZE];
+	uint32_t sizes[BATCH_SIZE];
+
+	// open whole batch and ask for readahead first, so kernel reads next files while we copy previous ones
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		fds[i] = -1;
+		sizes[i] = 0;
+
+		const id_handle_t id = { fhandles[i].i };
+		const FileReadRequest& request = _requests[id.index];
+
+		FSName path;
+		path.Append( _root.AbsolutePath() );
+		if( !path.AppendRelativePath( request._name.AbsolutePath() ) )
+		{
+			SYS_LOG_ERROR( "Filesystem: path '%s' is too long", request._name.AbsolutePath() );
+			continue;
+		}
+
+		const int fd = open( path.AbsolutePath(), O_RDONLY | O_CLOEXEC );
+		if( fd < 0 )
+		{
+			SYS_LOG_ERROR( "Can not open file %s (errno: %d)\n", path.AbsolutePath(), errno );
+			continue;
+		}
+
+		struct stat st;
+		if( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) || st.st_size > UINT32_MAX - 1 )
+		{
+			close( fd );
+			continue;
+		}
+
+		fds[i] = fd;
+		sizes[i] = (uint32_t)st.st_size;
+#if defined( POSIX_FADV_WILLNEED )
+		posix_fadvise( fd, 0, st.st_size, POSIX_FADV_SEQUENTIAL );
+		posix_fadvise( fd, 0, st.st_size, POSIX_FADV_WILLNEED );
+#endif
+	}
+
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		if( fds[i] < 0 )
+		{
+			Finish( fhandles[i], BXEFileStatus::NOT_FOUND );
+			continue;
+		}
+
+		const id_handle_t id = { fhandles[i].i };
+		const FileReadRequest& request = _requests[id.index];
+		const bool is_text = request._mode == BXEFIleMode::TXT;
+		const uint32_t size = sizes[i];
+
+		// text files are null terminated and terminator is included in size, like in ReadTextFile
+		uint8_t* buf = (uint8_t*)BX_MALLOC( request._allocator, size + 1, 1 );
+		SYS_ASSERT( buf && "out of memory?" );
+		const bool read_ok = ReadAll( fds[i], buf, size );
+		const int read_errno = errno;
+		close( fds[i] );
+
+		if( !read_ok )
+		{
+			SYS_LOG_ERROR( "Can not read file %s (errno: %d)\n", request._name.AbsolutePath(), read_errno );
+			BX_FREE( request._allocator, buf );
+			Finish( fhandles[i], BXEFileStatus::NOT_FOUND );
+			continue;
+		}
+
+		BXFile& file = _files[id.index];
+		file.allocator = request._allocator;
+		file.bin = buf;
+		file.size = size;
+		if( is_text )
+		{
+			buf[size] = 0;
+			file.size += 1;
+		}
+
+		Finish( fhandles[i], BXEFileStatus::READY );
+	}
+}
+
+void FilesystemPosix::Finish( BXFileHandle fhandle, BXEFileStatus::E status )
+{
+	const id_handle_t id = { fhandle.i };
+	const FileReadRequest& request = _requests[id.index];
+
+	_files_status[id.index].store( status );
+	if( request._callback.callback )
+	{
+		(*request._callback.callback)( this, fhandle, status, request._callback.user_data0, request._callback.user_data1, request._callback.user_data2 );
+	}
+}
+
+}//
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "filesystem_plugin.h"
+
+#include <foundation/debug.h>
+#include <foundation/id_table.h>
+#include <foundation/queue.h>
+#include <util/file_system_name.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+
+namespace bx
+{
+    struct FileReadRequest
+    {
+        FSName _name;
+        BXEFIleMode::E _mode;
+        BXPostLoadCallback _callback;
+        BXIAllocator* _allocator;
+    };
+
+// Same interface as FilesystemWindows, but files are read by pool of reader threads.
+// Each reader takes batch of requests, opens all of them and hints kernel with posix_fadvise before reading,
+// so reads of whole batch are in flight together.
+struct FilesystemPosix : BXIFilesystem
+{
+	FilesystemPosix( BXIAllocator* allocator );
+
+	// 0 means one reader per hardware thread, up to MAX_READERS
+	bool		 Startup( uint32_t num_readers = 0 );
+	void		 Shutdown();
+	// --- interface
+	bool			 IsValid( BXFileHandle fhandle );
+	void			 SetRoot( const char* absoluteDirPath ) override final;
+	const char*      GetRoot() const override;
+	BXFileHandle	 LoadFile( const char* relativePath, BXEFIleMode::E mode, BXPostLoadCallback callback, BXIAllocator* allocator = nullptr ) override final;
+	void			 CloseFile( BXFileHandle* fhandle, bool freeData ) override final;
+	BXEFileStatus::E File( BXFile* file, BXFileHandle fhandle ) override final;
+
+	// ---
+	static void ReaderThreadStatic( FilesystemPosix* fs );
+	void ReaderThread();
+	void ReadBatch( const BXFileHandle* fhandles, uint32_t count );
+	void Finish( BXFileHandle fhandle, BXEFileStatus::E status );
+
+	// --- data
+	enum
+	{
+		MAX_HANDLES = 1024,
+		MAX_READERS = 8,
+		BATCH_SIZE = 16,
+	};
+	using IdManager = id_table_t< MAX_HANDLES >;
+
+	std::thread				_readers[MAX_READERS];
+	uint32_t				_num_readers = 0;
+	std::atomic_uint32_t	_is_running = 0;
+
+	IdManager     _ids;
+	std::mutex    _id_lock;
+
+	FileReadRequest		_requests    [MAX_HANDLES] = {};
+	BXFile				_files       [MAX_HANDLES] = {};
+	std::atomic_int32_t _files_status[MAX_HANDLES] = {};
+
+	queue_t<BXFileHandle>   _to_load;
+	std::mutex              _to_load_lock;
+	std::condition_variable _to_load_cv;
+
+	FSName		  _root;
+	BXIAllocator* _allocator = nullptr;
+};
+
+}//
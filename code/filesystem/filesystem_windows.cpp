@@ -1,3 +1,5 @@
+#if defined( _WIN32 )
+
 #include "filesystem_windows.h"
 
 #include <memory/memory.h>
@@ -47,7 +49,7 @@ const char* FilesystemWindows::GetRoot() const
 
 bool FilesystemWindows::IsValid( BXFileHandle fhandle )
 {
-	const id_t id = { fhandle.i };
+	const id_handle_t id = { fhandle.i };
 	return id_table::has( _ids, id );
 }
 
@@ -56,7 +58,7 @@ BXFileHandle FilesystemWindows::LoadFile( const char* relativePath, BXEFIleMode:
 	if( !allocator )
 		allocator = _allocator;
 
-	id_t id = { 0 };
+	id_handle_t id = { 0 };
 	
 	_id_lock.lock();
 	id = id_table::create( _ids );
@@ -87,7 +89,7 @@ void FilesystemWindows::CloseFile( BXFileHandle* fhandle, bool freeData )
 	if( !IsValid( *fhandle ) )
 		return;
 
-	const id_t id = { fhandle->i };
+	const id_handle_t id = { fhandle->i };
 	_files_status[id.index].store( BXEFileStatus::EMPTY );
 
 	BXFile file = _files[id.index];
@@ -113,7 +115,7 @@ BXEFileStatus::E FilesystemWindows::File( BXFile* file, BXFileHandle fhandle )
 	if( !IsValid( fhandle ) )
 		return BXEFileStatus::EMPTY;
 
-	const id_t id = { fhandle.i };
+	const id_handle_t id = { fhandle.i };
 
 	BXEFileStatus::E status = (BXEFileStatus::E)_files_status[id.index].load();
 	if( status == BXEFileStatus::READY )
@@ -155,7 +157,7 @@ void FilesystemWindows::ThreadProc()
 			if( !PopFromQueueSafe( &fhandle, _to_load, _to_load_lock ) )
 				break;
 				
-			const id_t id = { fhandle.i };
+			const id_handle_t id = { fhandle.i };
 			const FileInputInfo& info = _input_info[id.index];
 
 			FSName path;
@@ -181,7 +183,7 @@ void FilesystemWindows::ThreadProc()
 			}
 			else
 			{
-				SYS_LOG_ERROR( "Filesystem: path '%s' is to long", info._name.AbsolutePath() );
+				SYS_LOG_ERROR( "Filesystem: path '%s' is too long", info._name.AbsolutePath() );
 				CloseFile( &fhandle, false );
 			}
 		}
@@ -201,3 +203,4 @@ void FilesystemWindows::ThreadProc()
 
 }//
 
+#endif
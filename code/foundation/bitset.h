@@ -1,7 +1,9 @@
 #pragma once
 
 #include "containers.h"
+#if defined( _MSC_VER )
 #include <intrin.h>
+#endif
 
 namespace bitset
 {
@@ -32,32 +34,65 @@ namespace bitset
         template< typename T >
         FORCE_INLINE uint8_t bitscan_forward( uint32_t* index, T mask ) { return 0; }
 
+#if defined( _MSC_VER )
         template<>
         FORCE_INLINE uint8_t bitscan_forward<uint32_t>( uint32_t* index, uint32_t mask )
         {
-            return _BitScanForward( (unsigned long*)index, mask );
+            unsigned long i = 0;
+            const uint8_t result = _BitScanForward( &i, mask );
+            *index = (uint32_t)i;
+            return result;
         }
 
         template<>
         FORCE_INLINE uint8_t bitscan_forward<uint64_t>( uint32_t* index, uint64_t mask )
         {
-            return _BitScanForward64( (unsigned long*)index, mask );
+            unsigned long i = 0;
+            const uint8_t result = _BitScanForward64( &i, mask );
+            *index = (uint32_t)i;
+            return result;
+        }
+#else
+        template<>
+        FORCE_INLINE uint8_t bitscan_forward<uint32_t>( uint32_t* index, uint32_t mask )
+        {
+            if( !mask )
+                return 0;
+            *index = (uint32_t)__builtin_ctz( mask );
+            return 1;
         }
 
+        template<>
+        FORCE_INLINE uint8_t bitscan_forward<uint64_t>( uint32_t* index, uint64_t mask )
+        {
+            if( !mask )
+                return 0;
+            *index = (uint32_t)__builtin_ctzll( mask );
+            return 1;
+        }
+#endif
+
         template< typename T >
         FORCE_INLINE uint32_t population( T mask ) { return 0; }
 
+#if defined( _MSC_VER )
         template<>
         FORCE_INLINE uint32_t population( uint32_t mask ) { return __popcnt( mask ); }
         template<>
         FORCE_INLINE uint32_t population( uint64_t mask ) { return (uint32_t)__popcnt64( mask ); }
+#else
+        template<>
+        FORCE_INLINE uint32_t population( uint32_t mask ) { return (uint32_t)__builtin_popcount( mask ); }
+        template<>
+        FORCE_INLINE uint32_t population( uint64_t mask ) { return (uint32_t)__builtin_popcountll( mask ); }
+#endif
 
     }
 
     template< BITSET_TEMPLATE_ARGS > void set_all( BITSET_T& bs )
     {
         for( uint32_t i = 0; i < bs.NUM_ELEMENTS; ++i )
-            bs.bits[i] = ~BITSET_T::type_t(0);
+            bs.bits[i] = ~typename BITSET_T::type_t(0);
     }
 
     template< BITSET_TEMPLATE_ARGS > void clear_all( BITSET_T& bs )
@@ -68,17 +103,17 @@ namespace bitset
     template< BITSET_TEMPLATE_ARGS > void clear( BITSET_T& bs, uint32_t index )
     {
         const _internal::bit_address_t bit_addr = _internal::compute_bit_address( bs, index );
-        bs.bits[bit_addr.element] &= ~(bit_addr.mask<BITSET_T::type_t>());
+        bs.bits[bit_addr.element] &= ~(bit_addr.mask<typename BITSET_T::type_t>());
     }
     template< BITSET_TEMPLATE_ARGS > void set( BITSET_T& bs, uint32_t index )
     {
         const _internal::bit_address_t bit_addr = _internal::compute_bit_address( bs, index );
-        bs.bits[bit_addr.element] |= (bit_addr.mask<BITSET_T::type_t>());
+        bs.bits[bit_addr.element] |= (bit_addr.mask<typename BITSET_T::type_t>());
     }
     template< BITSET_TEMPLATE_ARGS > bool get( const BITSET_T& bs, uint32_t index )
     {
         const _internal::bit_address_t bit_addr = _internal::compute_bit_address( bs, index );
-        return ( bs.bits[bit_addr.element] & bit_addr.mask<BITSET_T::type_t>() ) != 0;
+        return ( bs.bits[bit_addr.element] & bit_addr.mask<typename BITSET_T::type_t>() ) != 0;
     }
 
     template< BITSET_TEMPLATE_ARGS > bool is_any_set( const BITSET_T& bs )
@@ -118,7 +153,7 @@ namespace bitset
 
         const _internal::bit_address_t bit_addr = _internal::compute_bit_address( bs, begin );
         
-        using value_type_t = BITSET_T::type_t;
+        using value_type_t = typename BITSET_T::type_t;
 
         value_type_t element_index = bit_addr.element;
         value_type_t shift = bit_addr.bit;
@@ -2,7 +2,7 @@
 
 #include "type.h"
 #include "debug.h"
-#include <memory\memory.h>
+#include <memory/memory.h>
 
 struct BufferChunker
 {
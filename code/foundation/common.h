@@ -124,6 +124,9 @@ inline void Swap( T& a, T& b )
 }
 
 //////////////////////////////////////////////////////////////////////////
+#if !defined( _MSC_VER )
+#define __pragma( x )
+#endif
 #define DECL_WRAP_INC( type_name, type, stype, bit_mask ) \
 	static inline type wrap_inc_##type_name( const type val, const type min, const type max ) \
 { \
@@ -3,6 +3,8 @@
 #include "type.h"
 #include "buffer.h"
 
+#include <string.h>
+
 #define container_soa_add_stream( desc, type, field )\
     desc.add( offsetof( type, field ), sizeof( *type::field ), ALIGNOF( decltype(*type::field ) ) )
 
@@ -263,7 +263,7 @@ struct data_buffer_t
     uint8_t* end()   { return data + write_offset; }
 };
 
-union id_t
+union id_handle_t
 {
     uint32_t hash;
     struct{
@@ -271,10 +271,10 @@ union id_t
         uint16_t index;
     };
 };
-inline bool operator == ( id_t a, id_t b ) { return a.hash == b.hash; }
+inline bool operator == ( id_handle_t a, id_handle_t b ) { return a.hash == b.hash; }
 
-inline id_t make_id( uint32_t hash ){
-    id_t id = { hash };
+inline id_handle_t make_id( uint32_t hash ){
+    id_handle_t id = { hash };
     return id;
 }
 
@@ -284,7 +284,7 @@ struct id_array_destroy_info_t
     uint16_t copy_data_to_index;
 };
 
-template <uint32_t MAX, typename Tid = id_t >
+template <uint32_t MAX, typename Tid = id_handle_t >
 struct id_array_t
 {
     id_array_t() : _freelist( MAX ) , _next_id( 0 ) , _size( 0 )
@@ -306,7 +306,7 @@ struct id_array_t
     uint16_t _dense_to_sparse[MAX];
 };
 
-template <uint32_t MAX, typename Tid = id_t>
+template <uint32_t MAX, typename Tid = id_handle_t>
 struct id_table_t
 {
     id_table_t() : _freelist( MAX ) , _next_id( 0 ) , _size( 0 )
@@ -336,7 +336,7 @@ struct id_allocator_dense_t
     uint32_t size;
     uint16_t free_index;
 
-    id_t*     sparse_id;
+    id_handle_t*     sparse_id;
     uint16_t* sparse_to_dense_index;
     uint16_t* dense_to_sparse_index;
 
@@ -2,7 +2,7 @@
 #include "debug.h"
 #include "array.h"
 #include "common.h"
-#include <memory\memory.h>
+#include <memory/memory.h>
 
 data_buffer_t::~data_buffer_t()
 {
@@ -19,6 +19,7 @@ namespace data_buffer
         SYS_ASSERT( initial_capacity > 0 );
 
         buff->data = (uint8_t*)BX_MALLOC( allocator, initial_capacity, alignment );
+        buff->capacity = initial_capacity;
         buff->read_offset = 0;
         buff->write_offset = 0;
 
@@ -1,5 +1,6 @@
 #include "debug.h"
 
+#if defined( _WIN32 )
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
@@ -10,6 +11,12 @@
 #include <windows.h>
 
 #include <crtdbg.h>
+#else
+#include <stdlib.h>
+#define vsprintf_s vsnprintf
+#define vprintf_s vprintf
+#endif
+
 #include <stdarg.h>
 #include <stdio.h>
 #include <float.h>
@@ -34,9 +41,14 @@ void BXDebugAssert( int expression, const char *format, ... )
 
 void BXDebugHalt( char *str )
 {
+#if defined( _WIN32 )
 	MessageBox( 0, str, "error", MB_OK );
 	//__asm { int 3 }
 	__debugbreak();
+#else
+	fputs( str, stderr );
+	abort();
+#endif
 }   
 
 void BXCheckFloat( float x )
@@ -35,7 +35,11 @@ extern void BXLog( const char* fmt, ... );
 
 #define AT __FILE__ ":" MAKE_STR(__LINE__)
 #define SYS_ASSERT( expression ) BXDebugAssert( expression, "ASSERTION FAILED " AT " " #expression "\n" )
+#if defined( _MSC_VER )
 #define SYS_ASSERT_TXT( expression, txt, ... ) BXDebugAssert( expression, "ASSERTION FAILED " AT " " #expression "\n" #txt, __VA_ARGS__ )
+#else
+#define SYS_ASSERT_TXT( expression, txt, ... ) BXDebugAssert( expression, "ASSERTION FAILED " AT " " #expression "\n" #txt, ##__VA_ARGS__ )
+#endif
 
 #define SYS_STATIC_ASSERT( expression ) static_assert( expression, "" )
 #define SYS_NOT_IMPLEMENTED SYS_ASSERT( false && "not implemented" )
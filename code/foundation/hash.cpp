@@ -438,7 +438,7 @@ make it easy to compose the values of multiple blocks.
 @end deftypefn
 */
 
-__forceinline unsigned int xcrc32( const unsigned char *buf, int len, unsigned int init )
+FORCE_INLINE unsigned int xcrc32( const unsigned char *buf, int len, unsigned int init )
 {
     unsigned int crc = init;
     while( len-- )
@@ -6,9 +6,11 @@ using hashed_string_t = uint64_t;
 
 namespace hashed_string_internal
 {
-    inline hashed_string_t hash_function( const char* str );
+    constexpr hashed_string_t hash_function( const char* str );
 }
-inline hashed_string_t hashed_string( const char* str )
+
+// 64 bit FNV-1a, can be evaluated at compile time for string literals
+constexpr hashed_string_t hashed_string( const char* str )
 {
     return hashed_string_internal::hash_function( str );
 }
@@ -16,20 +18,19 @@ inline hashed_string_t hashed_string( const char* str )
 
 namespace hashed_string_internal
 {
-    inline hashed_string_t hash_function( const char* str )
+    constexpr hashed_string_t hash_function( const char* str )
     {
-        static constexpr uint64_t OFFSET = 14695981039346656037;
-        static constexpr uint64_t PRIME = 1099511628211;
+        constexpr uint64_t OFFSET = 14695981039346656037ull;
+        constexpr uint64_t PRIME = 1099511628211ull;
 
         uint64_t hash = OFFSET;
-        unsigned char *s = (unsigned char *)str;
-        while( *s )
+        for( uint32_t i = 0; str[i]; ++i )
         {
             /* xor the bottom with the current octet */
-            hash ^= (uint64_t)*s++;
+            hash ^= (uint64_t)(unsigned char)str[i];
             /* multiply by the 64 bit FNV magic prime mod 2^64 */
             hash *= PRIME;
         }
         return hash;
     }
-}
\ No newline at end of file
+}
@@ -87,6 +87,8 @@ namespace hash_internal
         return ei;
     }
 
+    template<BX_HASHMAP_TARGS_DECL> FindResult find( const hash_t<BX_HASHMAP_TARGS_INST> &h, const K& key );
+
     template<BX_HASHMAP_TARGS_DECL> void erase( hash_t<BX_HASHMAP_TARGS_INST> &h, const FindResult &fr )
     {
         if( fr.data_prev == END_OF_LIST )
@@ -18,7 +18,7 @@ namespace id_allocator
 
         BufferChunker chunker( memory, mem_size );
         id_allocator_dense_t* alloc = chunker.Add<id_allocator_dense_t>();
-        alloc->sparse_id = chunker.Add<id_t>( capacity );
+        alloc->sparse_id = chunker.Add<id_handle_t>( capacity );
         alloc->sparse_to_dense_index = chunker.Add<uint16_t>( capacity );
         alloc->dense_to_sparse_index = chunker.Add<uint16_t>( capacity );
         chunker.Check();
@@ -45,11 +45,11 @@ namespace id_allocator
         BX_FREE0( allocator, idalloc[0] );
     }
 
-    id_t alloc( id_allocator_dense_t* a )
+    id_handle_t alloc( id_allocator_dense_t* a )
     {
         SYS_ASSERT_TXT( a->size < a->capacity, "Object list full" );
 
-        id_t id = makeInvalidHandle<id_t>();
+        id_handle_t id = makeInvalidHandle<id_handle_t>();
 
         if( a->free_index != 0xFFFF )
         {
@@ -71,7 +71,7 @@ namespace id_allocator
         return id;
     }
 
-    id_t invalidate( id_allocator_dense_t* a, id_t id )
+    id_handle_t invalidate( id_allocator_dense_t* a, id_handle_t id )
     {
         SYS_ASSERT_TXT( has( a, id ), "IdArray does not have ID: %d,%d", id.id, id.index );
         a->sparse_id[id.index].id += 1;
@@ -79,7 +79,7 @@ namespace id_allocator
         return a->sparse_id[id.index];
     }
 
-    id_allocator_dense_t::delete_info_t free( id_allocator_dense_t* a, id_t id )
+    id_allocator_dense_t::delete_info_t free( id_allocator_dense_t* a, id_handle_t id )
     {
         SYS_ASSERT_TXT( has( a, id ), "IdArray does not have ID: %d,%d", id.id, id.index );
 
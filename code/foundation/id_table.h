@@ -7,6 +7,12 @@
 
 namespace id_table
 {
+    template <BX_ID_TABLE_T_DEF>
+    inline bool has( const id_table_t<BX_ID_TABLE_T_ARG>& a, Tid id )
+    {
+        return id.index < MAX && a._ids[id.index].id == id.id;
+    }
+
     template <BX_ID_TABLE_T_DEF>
     inline Tid create( id_table_t<BX_ID_TABLE_T_ARG>& a )
     {
@@ -52,12 +58,6 @@ namespace id_table
         a._size--;
     }
 
-    template <BX_ID_TABLE_T_DEF>
-    inline bool has( const id_table_t<BX_ID_TABLE_T_ARG>& a, Tid id )
-    {
-        return id.index < MAX && a._ids[id.index].id == id.id;
-    }
-
     template <BX_ID_TABLE_T_DEF>
     inline Tid id( const id_table_t<BX_ID_TABLE_T_ARG>& a, uint32_t index )
     {
@@ -5,9 +5,14 @@
 
 #include "type.h"
 #include "debug.h"
-#include "memory\memory.h"
+#include "memory/memory.h"
 
+#if defined( _WIN32 )
 #include <direct.h>
+#else
+#include <errno.h>
+#include <sys/stat.h>
+#endif
 
 static FILE* OpenFile( const char* path, const char* mode )
 {
@@ -18,7 +23,12 @@ static FILE* OpenFile( const char* path, const char* mode )
 	}
 
 	FILE* f = nullptr;
+#if defined( _WIN32 )
 	errno_t err = fopen_s( &f, path, mode );
+#else
+	f = fopen( path, mode );
+	const int err = ( f ) ? 0 : errno;
+#endif
 	if( err != 0 )
 	{
 		SYS_LOG_ERROR( "Can not open file %s (mode: %s | errno: %d)\n", path, mode, err );
@@ -109,6 +119,11 @@ int32_t CopyFile( const char* absDstPath, const char* absSrcPath, BXIAllocator*
 }
 int32_t CreateDir( const char* absPath )
 {
+#if defined( _WIN32 )
 	const int res = _mkdir( absPath );
 	return (res == ENOENT) ? IO_ERROR : IO_OK;
+#else
+	const int res = mkdir( absPath, 0755 );
+	return ( res == 0 || errno == EEXIST ) ? IO_OK : IO_ERROR;
+#endif
 }
\ No newline at end of file
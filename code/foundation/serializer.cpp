@@ -1,4 +1,5 @@
 #include "serializer.h"
+#include <memory/memory.h>
 
 SRLInstance SRLInstance::CreateReader( uint32_t v, const void* data, uint32_t data_size, BXIAllocator* allocator )
 {
@@ -34,6 +35,326 @@ SRLInstance SRLInstance::CreateWriterDynamic( uint32_t v, uint32_t data_size, BX
     return srl;
 }
 
+bool SRLInstance::CreateFrameReader( SRLInstance* srl, const void* frame, uint32_t frame_size, BXIAllocator* allocator )
+{
+    if( frame_size < sizeof( srl_frame_t ) )
+        return false;
+
+    const srl_frame_t* header = (const srl_frame_t*)frame;
+    if( header->tag != srl_frame_t::TAG || frame_size - sizeof( srl_frame_t ) < header->stored_size )
+        return false;
+
+    srl->version = header->version;
+    srl->allocator = allocator;
+    srl->is_writting = 0;
+
+    if( !header->is_compressed() )
+    {
+        data_buffer::create( &srl->data, (void*)header->payload(), header->raw_size );
+        data_buffer::seek_write( &srl->data, header->raw_size );
+        return true;
+    }
+
+    // 16 so SerializeSpanInPlace works for any math type
+    data_buffer::create( &srl->data, header->raw_size, allocator, 16 );
+    const int32_t n = srl_lz4::decompress( srl->data.data, header->raw_size, header->payload(), header->stored_size );
+    if( n != (int32_t)header->raw_size )
+    {
+        data_buffer::destroy( &srl->data );
+        return false;
+    }
+    data_buffer::seek_write( &srl->data, header->raw_size );
+    return true;
+}
+
+// bulk
+bool srl_internal::Align( SRLInstance* srl, uint32_t alignment )
+{
+    if( srl->is_writting )
+    {
+        static const uint8_t zeros[16] = {};
+        uint32_t pad = ( alignment - ( srl->data.write_offset % alignment ) ) % alignment;
+        while( pad )
+        {
+            const uint32_t n = min_of_2( pad, (uint32_t)sizeof( zeros ) );
+            data_buffer::write( &srl->data, zeros, 1, n );
+            pad -= n;
+        }
+        return true;
+    }
+
+    const uint32_t pad = ( alignment - ( srl->data.read_offset % alignment ) ) % alignment;
+    if( srl->data.write_offset - srl->data.read_offset < pad )
+        return false;
+
+    srl->data.read_offset += pad;
+    return true;
+}
+
+// varint
+void srl_varint::write( data_buffer_t* buff, const uint64_t* values, uint32_t count )
+{
+    uint8_t bytes[64 * MAX_BYTES];
+    uint32_t nbytes = 0;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        if( nbytes + MAX_BYTES > sizeof( bytes ) )
+        {
+            data_buffer::write( buff, bytes, 1, nbytes );
+            nbytes = 0;
+        }
+
+        uint64_t v = values[i];
+        while( v >= 0x80 )
+        {
+            bytes[nbytes++] = (uint8_t)( v | 0x80 );
+            v >>= 7;
+        }
+        bytes[nbytes++] = (uint8_t)v;
+    }
+
+    if( nbytes )
+        data_buffer::write( buff, bytes, 1, nbytes );
+}
+
+bool srl_varint::read( uint64_t* values, uint32_t count, data_buffer_t* buff )
+{
+    const uint8_t* p = buff->data + buff->read_offset;
+    const uint8_t* end = buff->data + buff->write_offset;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        uint64_t v = 0;
+        uint32_t shift = 0;
+        for( ;; )
+        {
+            if( p == end || shift >= 64 )
+                return false;
+
+            const uint8_t b = *p++;
+            v |= (uint64_t)( b & 0x7f ) << shift;
+            if( !( b & 0x80 ) )
+                break;
+
+            shift += 7;
+        }
+        values[i] = v;
+    }
+
+    buff->read_offset = (uint32_t)( p - buff->data );
+    return true;
+}
+
+// lz4
+namespace srl_lz4
+{
+    static constexpr uint32_t MIN_MATCH = 4;
+    static constexpr uint32_t LAST_LITERALS = 5;  // block has to end with at least that many literals
+    static constexpr uint32_t MF_LIMIT = 12;      // last match has to start at least that far from block end
+    static constexpr uint32_t MAX_OFFSET = 65535;
+    static constexpr uint32_t HASH_BITS = 12;
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    static inline uint32_t Read32( const uint8_t* p )
+    {
+        uint32_t v;
+        memcpy( &v, p, sizeof( v ) );
+        return v;
+    }
+    static inline uint32_t Hash( uint32_t sequence )
+    {
+        return ( sequence * 2654435761u ) >> ( 32 - HASH_BITS );
+    }
+    static inline uint8_t* WriteLength( uint8_t* op, uint32_t len )
+    {
+        while( len >= 255 )
+        {
+            *op++ = 255;
+            len -= 255;
+        }
+        *op++ = (uint8_t)len;
+        return op;
+    }
+
+    // match_len == 0 means last sequence (literals only)
+    static bool WriteSequence( uint8_t** out, const uint8_t* out_end, const uint8_t* literals, uint32_t literal_len, uint32_t offset, uint32_t match_len )
+    {
+        uint8_t* op = *out;
+        const uint32_t ml = ( match_len ) ? match_len - MIN_MATCH : 0;
+        const size_t required = 1 + literal_len + ( literal_len / 255 ) + 1 + ( ( match_len ) ? 2 + ( ml / 255 ) + 1 : 0 );
+        if( (size_t)( out_end - op ) < required )
+            return false;
+
+        uint8_t* token = op++;
+        *token = (uint8_t)( min_of_2( literal_len, 15u ) << 4 );
+        if( literal_len >= 15 )
+            op = WriteLength( op, literal_len - 15 );
+
+        if( literal_len )
+            memcpy( op, literals, literal_len );
+        op += literal_len;
+
+        if( match_len )
+        {
+            *op++ = (uint8_t)( offset & 0xff );
+            *op++ = (uint8_t)( offset >> 8 );
+
+            *token |= (uint8_t)min_of_2( ml, 15u );
+            if( ml >= 15 )
+                op = WriteLength( op, ml - 15 );
+        }
+
+        *out = op;
+        return true;
+    }
+
+    uint32_t compress( void* dst, uint32_t dst_capacity, const void* src_ptr, uint32_t src_size )
+    {
+        const uint8_t* src = (const uint8_t*)src_ptr;
+        uint8_t* op = (uint8_t*)dst;
+        const uint8_t* op_end = op + dst_capacity;
+
+        uint32_t anchor = 0;
+        if( src_size > MF_LIMIT )
+        {
+            uint32_t table[1 << HASH_BITS];
+            for( uint32_t& e : table )
+                e = EMPTY;
+
+            const uint32_t match_limit = src_size - MF_LIMIT;
+            uint32_t pos = 0;
+            while( pos <= match_limit )
+            {
+                const uint32_t sequence = Read32( src + pos );
+                const uint32_t h = Hash( sequence );
+                const uint32_t candidate = table[h];
+                table[h] = pos;
+
+                if( candidate == EMPTY || pos - candidate > MAX_OFFSET || Read32( src + candidate ) != sequence )
+                {
+                    ++pos;
+                    continue;
+                }
+
+                uint32_t len = MIN_MATCH;
+                const uint32_t max_len = src_size - LAST_LITERALS - pos;
+                while( len < max_len && src[candidate + len] == src[pos + len] )
+                    ++len;
+
+                if( !WriteSequence( &op, op_end, src + anchor, pos - anchor, pos - candidate, len ) )
+                    return 0;
+
+                pos += len;
+                anchor = pos;
+            }
+        }
+
+        if( !WriteSequence( &op, op_end, src + anchor, src_size - anchor, 0, 0 ) )
+            return 0;
+
+        return (uint32_t)( op - (uint8_t*)dst );
+    }
+
+    int32_t decompress( void* dst, uint32_t dst_capacity, const void* src, uint32_t src_size )
+    {
+        const uint8_t* ip = (const uint8_t*)src;
+        const uint8_t* ip_end = ip + src_size;
+        uint8_t* const out = (uint8_t*)dst;
+        uint8_t* op = out;
+        const uint8_t* op_end = op + dst_capacity;
+
+        while( ip < ip_end )
+        {
+            const uint8_t token = *ip++;
+
+            size_t literal_len = token >> 4;
+            if( literal_len == 15 )
+            {
+                uint8_t b;
+                do
+                {
+                    if( ip == ip_end )
+                        return -1;
+                    b = *ip++;
+                    literal_len += b;
+                } while( b == 255 );
+            }
+
+            if( (size_t)( ip_end - ip ) < literal_len || (size_t)( op_end - op ) < literal_len )
+                return -1;
+
+            memcpy( op, ip, literal_len );
+            op += literal_len;
+            ip += literal_len;
+
+            if( ip == ip_end )
+                break;
+
+            if( ip_end - ip < 2 )
+                return -1;
+
+            const size_t offset = ip[0] | ( ip[1] << 8 );
+            ip += 2;
+            if( offset == 0 || offset > (size_t)( op - out ) )
+                return -1;
+
+            size_t match_len = token & 15;
+            if( match_len == 15 )
+            {
+                uint8_t b;
+                do
+                {
+                    if( ip == ip_end )
+                        return -1;
+                    b = *ip++;
+                    match_len += b;
+                } while( b == 255 );
+            }
+            match_len += MIN_MATCH;
+
+            if( (size_t)( op_end - op ) < match_len )
+                return -1;
+
+            // byte by byte, match can overlap output
+            const uint8_t* match = op - offset;
+            for( size_t i = 0; i < match_len; ++i )
+                op[i] = match[i];
+            op += match_len;
+        }
+
+        return (int32_t)( op - out );
+    }
+}//
+
+// frame
+void srl_frame::write( data_buffer_t* output, const SRLInstance& writer, bool compress, BXIAllocator* scratch_allocator )
+{
+    const uint32_t raw_size = data_buffer::size( writer.data );
+
+    srl_frame_t header;
+    header.tag = srl_frame_t::TAG;
+    header.version = writer.version;
+    header.raw_size = raw_size;
+    header.stored_size = raw_size;
+
+    uint8_t* packed = nullptr;
+    if( compress && raw_size )
+    {
+        const uint32_t bound = srl_lz4::compress_bound( raw_size );
+        packed = (uint8_t*)BX_MALLOC( scratch_allocator, bound, 1 );
+        const uint32_t packed_size = srl_lz4::compress( packed, bound, writer.data.begin(), raw_size );
+        if( packed_size && packed_size < raw_size )
+            header.stored_size = packed_size;
+    }
+
+    data_buffer::write( output, &header, sizeof( header ), 1 );
+    if( header.is_compressed() )
+        data_buffer::write( output, packed, header.stored_size, 1 );
+    else if( raw_size )
+        data_buffer::write( output, writer.data.begin(), raw_size, 1 );
+
+    BX_FREE( scratch_allocator, packed );
+}
+
 // property
 void* srl_property_t::value_raw( void* instance ) const
 {
@@ -85,3 +406,136 @@ void srl_file::serialize_properties_and_data( srl_file_t* output, const void* in
     uint8_t* dst_data = (uint8_t*)output + calc_header_size( num_properties );
     memcpy( dst_data, instance, instance_memory_size );
 }
+
+const uint8_t* srl_file_t::data_raw() const
+{
+    return (const uint8_t*)this + srl_file::calc_header_size( num_properties );
+}
+
+static inline bool IsSameKind( const srl_property_t& a, const srl_property_t& b )
+{
+    return a.value_size == b.value_size &&
+        a.flags.is_pointer == b.flags.is_pointer &&
+        a.flags.is_float == b.flags.is_float &&
+        a.flags.is_integral == b.flags.is_integral &&
+        a.flags.is_signed == b.flags.is_signed;
+}
+
+uint32_t srl_file::upgrade( void* instance, const srl_property_t* properties, uint32_t num_properties, const srl_file_t* file )
+{
+    // 64 bit, so corrupted num_properties does not wrap around
+    const uint64_t header_size = sizeof( srl_file_t ) + (uint64_t)file->num_properties * sizeof( srl_property_t );
+    if( header_size > file->size )
+        return 0;
+
+    const srl_property_t* file_properties = file->properties();
+    const uint8_t* file_data = file->data_raw();
+    const uint64_t file_data_size = file->size - header_size;
+
+    uint32_t num_copied = 0;
+    for( uint32_t i = 0; i < num_properties; ++i )
+    {
+        const srl_property_t& dst = properties[i];
+        if( dst.flags.is_pointer )
+            continue;
+
+        const srl_property_t* src = srl_property::find( dst.name, file_properties, file->num_properties );
+        if( !src || !IsSameKind( dst, *src ) )
+            continue;
+
+        const uint32_t num_elements = min_of_2( dst.num_elements, src->num_elements );
+        if( (uint64_t)src->value_offset + (uint64_t)num_elements * dst.value_size > file_data_size )
+            continue;
+
+        memcpy( dst.value_raw( instance ), file_data + src->value_offset, num_elements * dst.value_size );
+        ++num_copied;
+    }
+    return num_copied;
+}
+
+// patch
+uint32_t srl_patch::diff( data_buffer_t* output, const void* from, const void* to, const srl_property_t* properties, uint32_t num_properties, uint32_t type_tag, uint32_t type_version )
+{
+    const uint32_t header_offset = data_buffer::size( *output );
+
+    srl_patch_t header;
+    header.tag = srl_patch_t::TAG;
+    header.type_tag = type_tag;
+    header.type_version = type_version;
+    data_buffer::write( output, &header, sizeof( header ), 1 );
+
+    static const uint8_t zeros[8] = {};
+    for( uint32_t i = 0; i < num_properties; ++i )
+    {
+        const srl_property_t& prop = properties[i];
+        if( prop.flags.is_pointer )
+            continue;
+
+        const uint8_t* a = (const uint8_t*)prop.value_raw( const_cast<void*>( from ) );
+        const uint8_t* b = (const uint8_t*)prop.value_raw( const_cast<void*>( to ) );
+
+        uint32_t first = UINT32_MAX;
+        uint32_t last = 0;
+        for( uint32_t e = 0; e < prop.num_elements; ++e )
+        {
+            const uint32_t offset = e * prop.value_size;
+            if( memcmp( a + offset, b + offset, prop.value_size ) == 0 )
+                continue;
+
+            first = min_of_2( first, e );
+            last = e;
+        }
+        if( first == UINT32_MAX )
+            continue;
+
+        srl_patch_entry_t entry;
+        entry.name = prop.name;
+        entry.value_size = prop.value_size;
+        entry.first_element = (uint16_t)first;
+        entry.num_elements = (uint16_t)( last - first + 1 );
+
+        const uint32_t values_size = entry.num_elements * entry.value_size;
+        data_buffer::write( output, &entry, sizeof( entry ), 1 );
+        data_buffer::write( output, b + first * prop.value_size, values_size, 1 );
+        data_buffer::write( output, zeros, 1, entry.stride() - sizeof( entry ) - values_size );
+        ++header.num_entries;
+    }
+
+    if( !header.num_entries )
+    {
+        data_buffer::seek_write( output, header_offset );
+        return 0;
+    }
+
+    header.size = data_buffer::size( *output ) - header_offset;
+    memcpy( output->data + header_offset, &header, sizeof( header ) );
+    return header.num_entries;
+}
+
+uint32_t srl_patch::apply( void* instance, const srl_property_t* properties, uint32_t num_properties, const srl_patch_t* patch )
+{
+    if( patch->tag != srl_patch_t::TAG || patch->size < sizeof( srl_patch_t ) )
+        return 0;
+
+    const uint8_t* patch_end = (const uint8_t*)patch + patch->size;
+    const srl_patch_entry_t* entry = (const srl_patch_entry_t*)( patch + 1 );
+
+    uint32_t num_applied = 0;
+    for( uint32_t i = 0; i < patch->num_entries; ++i )
+    {
+        if( (const uint8_t*)entry + sizeof( srl_patch_entry_t ) > patch_end || (const uint8_t*)entry + entry->stride() > patch_end )
+            break;
+
+        const srl_property_t* prop = srl_property::find( entry->name, properties, num_properties );
+        if( prop && !prop->flags.is_pointer && prop->value_size == entry->value_size && entry->first_element < prop->num_elements )
+        {
+            const uint32_t num_elements = min_of_2( (uint32_t)entry->num_elements, (uint32_t)( prop->num_elements - entry->first_element ) );
+            uint8_t* dst = (uint8_t*)prop->value_raw( instance ) + entry->first_element * prop->value_size;
+            memcpy( dst, entry->values(), num_elements * entry->value_size );
+            ++num_applied;
+        }
+
+        entry = (const srl_patch_entry_t*)( (const uint8_t*)entry + entry->stride() );
+    }
+    return num_applied;
+}
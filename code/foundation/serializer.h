@@ -2,6 +2,9 @@
 
 #include "data_buffer.h"
 #include "blob.h"
+#include "array.h"
+#include "tag.h"
+#include "common.h"
 
 #define SRL_ADD( version_added, field )\
     if( srl->version >= version_added )\
@@ -28,6 +31,10 @@ struct SRLInstance
 
     static SRLInstance CreateWriterStatic( uint32_t v, const void* data, uint32_t data_size, BXIAllocator* allocator );
     static SRLInstance CreateWriterDynamic( uint32_t v, uint32_t data_size, BXIAllocator* allocator );
+
+    // reads srl_frame_t written by srl_frame::write. Version is taken from the frame.
+    // Uncompressed frames are read in place, compressed ones are unpacked to memory owned by 'srl' (freed with srl).
+    static bool CreateFrameReader( SRLInstance* srl, const void* frame, uint32_t frame_size, BXIAllocator* allocator );
 };
 
 
@@ -66,6 +73,213 @@ inline void Serialize<string_t>( SRLInstance* srl, string_t* p )
     }
 }
 
+// --- bulk
+// POD range in one call. Element count is not stored.
+template< typename T >
+inline void SerializeSpan( SRLInstance* srl, T* p, uint32_t count )
+{
+    SYS_STATIC_ASSERT( std::is_trivially_copyable<T>::value );
+    SYS_STATIC_ASSERT( !std::is_pointer<T>::value );
+
+    if( !count )
+        return;
+
+    if( srl->is_writting )
+    {
+        data_buffer::write( &srl->data, p, sizeof( T ), count );
+    }
+    else
+    {
+        data_buffer::read( p, sizeof( T ), count, &srl->data );
+    }
+}
+
+namespace srl_internal
+{
+    template< typename T >
+    inline void SerializeElements( SRLInstance* srl, T* p, uint32_t count, std::true_type /*is_pod*/ )
+    {
+        SerializeSpan( srl, p, count );
+    }
+    template< typename T >
+    inline void SerializeElements( SRLInstance* srl, T* p, uint32_t count, std::false_type /*is_pod*/ )
+    {
+        for( uint32_t i = 0; i < count; ++i )
+            Serialize( srl, p + i );
+    }
+
+    // pads stream to 'alignment' relative to the buffer begin. Returns false when reader runs out of data.
+    bool Align( SRLInstance* srl, uint32_t alignment );
+}
+
+// count followed by elements. POD elements go through SerializeSpan.
+template< typename T >
+inline void Serialize( SRLInstance* srl, array_t<T>* arr )
+{
+    uint32_t count = arr->size;
+    Serialize( srl, &count );
+    if( !srl->is_writting )
+        array::resize( *arr, (int)count );
+
+    srl_internal::SerializeElements( srl, arr->begin(), count, std::integral_constant<bool, std::is_trivially_copyable<T>::value>() );
+}
+
+// POD range aligned to alignof(T) in the stream. Writer returns 'p',
+// reader returns pointer into source buffer (valid as long as the buffer is) or nullptr when data is missing.
+// Source buffer has to be at least alignof(T) aligned.
+template< typename T >
+inline const T* SerializeSpanInPlace( SRLInstance* srl, const T* p, uint32_t count )
+{
+    SYS_STATIC_ASSERT( std::is_trivially_copyable<T>::value );
+    SYS_STATIC_ASSERT( !std::is_pointer<T>::value );
+
+    if( !srl_internal::Align( srl, alignof( T ) ) )
+        return nullptr;
+
+    if( srl->is_writting )
+    {
+        if( count )
+            data_buffer::write( &srl->data, p, sizeof( T ), count );
+        return p;
+    }
+
+    const uint32_t size = count * sizeof( T );
+    if( srl->data.write_offset - srl->data.read_offset < size )
+        return nullptr;
+
+    const T* result = (const T*)( srl->data.data + srl->data.read_offset );
+    SYS_ASSERT( ( (uintptr_t)result % alignof( T ) ) == 0 );
+    srl->data.read_offset += size;
+    return result;
+}
+
+// --- varint
+// LEB128, 7 bits per byte, so byte order of the stream does not depend on the host
+namespace srl_varint
+{
+    static constexpr uint32_t MAX_BYTES = 10;
+
+    void write( data_buffer_t* buff, const uint64_t* values, uint32_t count );
+    bool read( uint64_t* values, uint32_t count, data_buffer_t* buff );
+
+    inline uint64_t zigzag_encode( int64_t v ) { return ( (uint64_t)v << 1 ) ^ (uint64_t)( v >> 63 ); }
+    inline int64_t  zigzag_decode( uint64_t v ) { return (int64_t)( v >> 1 ) ^ -(int64_t)( v & 1 ); }
+
+    template< typename T >
+    inline uint64_t encode( T v )
+    {
+        return ( std::is_signed<T>::value ) ? zigzag_encode( (int64_t)v ) : (uint64_t)v;
+    }
+    template< typename T >
+    inline T decode( uint64_t v )
+    {
+        return ( std::is_signed<T>::value ) ? (T)zigzag_decode( v ) : (T)v;
+    }
+}
+
+// integers as varints. Signed values are zigzag encoded, so small negative values stay small.
+template< typename T >
+inline bool SerializeVarint( SRLInstance* srl, T* values, uint32_t count )
+{
+    SYS_STATIC_ASSERT( std::is_integral<T>::value );
+
+    static constexpr uint32_t CHUNK = 64;
+    uint64_t chunk[CHUNK];
+    for( uint32_t begin = 0; begin < count; begin += CHUNK )
+    {
+        const uint32_t n = min_of_2( CHUNK, count - begin );
+        if( srl->is_writting )
+        {
+            for( uint32_t i = 0; i < n; ++i )
+                chunk[i] = srl_varint::encode( values[begin + i] );
+
+            srl_varint::write( &srl->data, chunk, n );
+        }
+        else
+        {
+            if( !srl_varint::read( chunk, n, &srl->data ) )
+                return false;
+
+            for( uint32_t i = 0; i < n; ++i )
+                values[begin + i] = srl_varint::decode<T>( chunk[i] );
+        }
+    }
+    return true;
+}
+
+// sorted or slowly changing integers (ids, indices, frame numbers).
+// Each value is stored as zigzag varint of difference to the previous one.
+template< typename T >
+inline bool SerializeDelta( SRLInstance* srl, T* values, uint32_t count )
+{
+    SYS_STATIC_ASSERT( std::is_integral<T>::value );
+
+    static constexpr uint32_t CHUNK = 64;
+    uint64_t chunk[CHUNK];
+    uint64_t prev = 0;
+    for( uint32_t begin = 0; begin < count; begin += CHUNK )
+    {
+        const uint32_t n = min_of_2( CHUNK, count - begin );
+        if( srl->is_writting )
+        {
+            for( uint32_t i = 0; i < n; ++i )
+            {
+                const uint64_t value = (uint64_t)values[begin + i];
+                chunk[i] = srl_varint::zigzag_encode( (int64_t)( value - prev ) );
+                prev = value;
+            }
+            srl_varint::write( &srl->data, chunk, n );
+        }
+        else
+        {
+            if( !srl_varint::read( chunk, n, &srl->data ) )
+                return false;
+
+            for( uint32_t i = 0; i < n; ++i )
+            {
+                prev += (uint64_t)srl_varint::zigzag_decode( chunk[i] );
+                values[begin + i] = (T)prev;
+            }
+        }
+    }
+    return true;
+}
+
+// --- lz4
+// LZ4 block format (no frame, no checksum). Compatible with reference lz4 block decoder.
+namespace srl_lz4
+{
+    inline uint32_t compress_bound( uint32_t src_size ) { return src_size + ( src_size / 255 ) + 16; }
+
+    // returns compressed size or 0 when 'dst_capacity' is too small
+    uint32_t compress( void* dst, uint32_t dst_capacity, const void* src, uint32_t src_size );
+
+    // returns decompressed size or -1 when input is malformed or does not fit in 'dst_capacity'
+    int32_t decompress( void* dst, uint32_t dst_capacity, const void* src, uint32_t src_size );
+}
+
+// --- frame
+// Header + data of SRLInstance writer. All fields little endian.
+struct srl_frame_t
+{
+    static constexpr uint32_t TAG = BX_UTIL_TAG32( 'S', 'R', 'L', 'F' );
+
+    uint32_t tag = 0;
+    uint32_t version = 0;       // SRLInstance::version of the data
+    uint32_t raw_size = 0;
+    uint32_t stored_size = 0;   // equal to raw_size when data is not compressed
+
+    bool is_compressed() const { return stored_size != raw_size; }
+    const uint8_t* payload() const { return (const uint8_t*)( this + 1 ); }
+};
+
+namespace srl_frame
+{
+    // appends frame with data written to 'writer' to 'output'.
+    // When 'compress' is set data is LZ4 compressed, but only if it actually gets smaller.
+    void write( data_buffer_t* output, const SRLInstance& writer, bool compress, BXIAllocator* scratch_allocator );
+}
+
 #include "hashed_string.h"
 #include <memory.h>
 
@@ -96,7 +310,7 @@ struct srl_property_t
     template<typename T>
     T* value_ptr( void* instance ) const
     {
-        SYS_ASSERT( value_size == sizeof( std::remove_pointer<T>::type ) );
+        SYS_ASSERT( value_size == sizeof( typename std::remove_pointer<T>::type ) );
         return (T*)value_raw( instance );
     }
 
@@ -121,8 +335,8 @@ namespace srl_property
         srl_property_t prop = {};
         prop.name         = hashed_string( n );
         prop.value_offset = value_offset;
-        prop.value_size   = sizeof( std::remove_extent<T>::type );
-        prop.num_elements = sizeof( T ) / sizeof( std::remove_extent<T>::type );
+        prop.value_size   = sizeof( typename std::remove_extent<T>::type );
+        prop.num_elements = sizeof( T ) / sizeof( typename std::remove_extent<T>::type );
 
         prop.flags.is_pointer  = std::is_pointer<T>::value;
         prop.flags.is_float    = std::is_floating_point<T>::value;
@@ -145,7 +359,8 @@ struct srl_file_t
     uint32_t num_properties = 0;
     uint32_t size = 0;
 
-    const srl_property_t* properties() { return (srl_property_t*)(this + 1); }
+    const srl_property_t* properties() const { return (srl_property_t*)(this + 1); }
+    const uint8_t* data_raw() const;
 
     template< typename T >
     const T* data() const
@@ -153,7 +368,7 @@ struct srl_file_t
         SYS_ASSERT( num_properties != 0 );
         SYS_ASSERT( version == T::VERSION );
         SYS_ASSERT( tag == T::TAG );
-        return (T*)( (uint8_t*)this + srl_file::calc_header_size( num_properties ) );
+        return (const T*)data_raw();
     }
 };
 
@@ -200,6 +415,74 @@ namespace srl_file
     }
 }//
 
+namespace srl_file
+{
+    // copies properties stored in 'file' to 'instance' matching them by name, so files written before fields
+    // were added, removed or moved still load. Element size and kind (float/integral/signed) has to match,
+    // arrays copy common element count. Missing properties keep their current value.
+    // Memory past the properties (TYPE_OFFSET data) is not touched. Returns number of copied properties.
+    uint32_t upgrade( void* instance, const srl_property_t* properties, uint32_t num_properties, const srl_file_t* file );
+
+    template< typename T >
+    inline uint32_t upgrade( T* instance, const srl_file_t* file )
+    {
+        SYS_ASSERT( file->tag == T::TAG );
+        return upgrade( instance, T::__props._array, T::__props._count, file );
+    }
+}//
+
+// patch
+// Changed properties of SRL_TYPE instance addressed by property name, so patch can be applied to newer layout.
+// Like upgrade, it covers properties only. Pointer properties are skipped.
+struct srl_patch_t
+{
+    static constexpr uint32_t TAG = BX_UTIL_TAG32( 'S', 'R', 'L', 'P' );
+
+    uint32_t tag = 0;
+    uint32_t type_tag = 0;
+    uint32_t type_version = 0;
+    uint32_t num_entries = 0;
+    uint32_t size = 0; // whole patch including header
+    uint32_t padding__ = 0;
+};
+
+struct srl_patch_entry_t
+{
+    hashed_string_t name;
+    uint32_t value_size;    // one element
+    uint16_t first_element;
+    uint16_t num_elements;
+    // num_elements * value_size bytes, padded to 8
+
+    const uint8_t* values() const { return (const uint8_t*)( this + 1 ); }
+    uint32_t stride() const { return sizeof( srl_patch_entry_t ) + ( ( num_elements * value_size + 7 ) & ~7u ); }
+};
+
+namespace srl_patch
+{
+    // appends patch turning 'from' into 'to' to 'output'. Returns number of changed properties, nothing is written when 0.
+    uint32_t diff( data_buffer_t* output, const void* from, const void* to, const srl_property_t* properties, uint32_t num_properties, uint32_t type_tag, uint32_t type_version );
+
+    // entries without matching property (name, element size) are skipped, array ranges are clipped to property size.
+    // Returns number of applied entries.
+    uint32_t apply( void* instance, const srl_property_t* properties, uint32_t num_properties, const srl_patch_t* patch );
+
+    template< typename T >
+    inline uint32_t diff( data_buffer_t* output, const T& from, const T& to )
+    {
+        return diff( output, &from, &to, T::__props._array, T::__props._count, T::TAG, T::VERSION );
+    }
+
+    template< typename T >
+    inline uint32_t apply( T* instance, const srl_patch_t* patch )
+    {
+        if( patch->tag != srl_patch_t::TAG || patch->type_tag != T::TAG )
+            return 0;
+
+        return apply( instance, T::__props._array, T::__props._count, patch );
+    }
+}//
+
 #define SRL_PROPERTY( name ) const srl_property_t name = srl_property::create<decltype(__this_type::name)>( #name, offsetof( __this_type, name ) )
 
 #define SRL_TYPE( type, properties_block ) \
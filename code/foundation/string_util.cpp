@@ -8,6 +8,23 @@
 #include "memory/memory.h"
 #include "common.h"
 
+#if !defined( _WIN32 )
+// secure CRT subset used below
+static inline int strncpy_s( char* dst, size_t dst_size, const char* src, size_t count )
+{
+    size_t n = strnlen( src, count );
+    n = ( n < dst_size ) ? n : dst_size - 1;
+    memcpy( dst, src, n );
+    dst[n] = 0;
+    return 0;
+}
+static inline int strcpy_s( char* dst, size_t dst_size, const char* src ) { return strncpy_s( dst, dst_size, src, dst_size ); }
+template< size_t N >
+static inline int strcpy_s( char( &dst )[N], const char* src ) { return strcpy_s( dst, N, src ); }
+#define vsprintf_s vsnprintf
+#define sprintf_s snprintf
+#endif
+
 char* string::token( char* str, char* tok, size_t toklen, char* delim )
 {
     if( !str )
@@ -55,7 +72,7 @@ char* string::create( const char* str, size_t len, BXIAllocator* allocator )
     SYS_ASSERT( strlen( str ) >= len );
     char* out = (char*)BX_MALLOC( allocator, (unsigned)len + 1, 1 ); //memory_alloc( len + 1 );
     out[len] = 0;
-    strncpy_s( out, len, str, len );
+    strncpy_s( out, len + 1, str, len );
 
     return out;
 }
@@ -190,7 +207,7 @@ namespace string
             strcpy_s( s->_static, data );
         }
     }
-    void string::reserve( string_t* s, uint32_t length, BXIAllocator* allocator )
+    void reserve( string_t* s, uint32_t length, BXIAllocator* allocator )
     {
         string::free( s );
         if( length > string_t::MAX_STATIC_LENGTH )
@@ -199,7 +216,7 @@ namespace string
             s->_allocator = allocator;
         }
     }
-    void string::copy( string_t* dst, const string_t& src )
+    void copy( string_t* dst, const string_t& src )
     {
         
         if( src._allocator )
@@ -217,7 +234,7 @@ namespace string
             memcpy( dst->_static, src._static, string_t::MAX_STATIC_SIZE );
         }
     }
-    void string::move( string_t* dst, string_t&& src )
+    void move( string_t* dst, string_t&& src )
     {
         dst->_allocator = src._allocator;
         if( dst->_allocator )
@@ -303,7 +320,7 @@ namespace string
         return dst;
     }
 
-    string_buffer_it string::iterate( const string_buffer_t& s, const string_buffer_it current )
+    string_buffer_it iterate( const string_buffer_t& s, const string_buffer_it current )
     {
         string_buffer_it it = current;
         if( it.null() )
@@ -1,5 +1,10 @@
 #include "mutex.h"
 
+#include "../type.h"
+#include "../debug.h"
+
+#if defined( _WIN32 )
+
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
@@ -10,9 +15,6 @@
 #include <windows.h>
 #include <memory.h>
 
-#include "../type.h"
-#include "../debug.h"
-
 
 mutex_t::mutex_t( unsigned spin_count )
 {
@@ -37,3 +39,33 @@ void mutex_t::unlock()
 {
     LeaveCriticalSection( (CRITICAL_SECTION*)&_prv[0] );
 }
+
+#else
+
+#include <pthread.h>
+
+// spin count is ignored, pthread mutex spins on its own
+mutex_t::mutex_t( unsigned spin_count )
+{
+    SYS_STATIC_ASSERT( sizeof( pthread_mutex_t ) <= INTERNAL_DATA_SIZE );
+
+    const int result = pthread_mutex_init( (pthread_mutex_t*)&_prv[0], nullptr );
+    SYS_ASSERT( result == 0 );
+}
+
+mutex_t::~mutex_t()
+{
+    pthread_mutex_destroy( (pthread_mutex_t*)&_prv[0] );
+}
+
+void mutex_t::lock()
+{
+    pthread_mutex_lock( (pthread_mutex_t*)&_prv[0] );
+}
+
+void mutex_t::unlock()
+{
+    pthread_mutex_unlock( (pthread_mutex_t*)&_prv[0] );
+}
+
+#endif
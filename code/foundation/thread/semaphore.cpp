@@ -4,6 +4,8 @@
 #include "../debug.h"
 #include "../type.h"
 
+#if defined( _WIN32 )
+
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
@@ -35,6 +37,42 @@ void semaphore_t::wait()
 	WaitForSingleObject( (HANDLE)_handle, INFINITE );
 }
 
+#else
+
+#include <semaphore.h>
+#include <errno.h>
+#include <stdlib.h>
+
+semaphore_t::semaphore_t( int32_t initialCount )
+{
+	SYS_ASSERT(initialCount >= 0);
+
+	sem_t* sem = (sem_t*)malloc( sizeof( sem_t ) );
+	const int result = sem_init( sem, 0, (unsigned)initialCount );
+	SYS_ASSERT( result == 0 );
+	_handle = (uintptr_t)sem;
+}
+
+semaphore_t::~semaphore_t()
+{
+	sem_destroy( (sem_t*)_handle );
+	free( (sem_t*)_handle );
+}
+
+void semaphore_t::signal( int32_t count )
+{
+	for( int32_t i = 0; i < count; ++i )
+		sem_post( (sem_t*)_handle );
+}
+
+void semaphore_t::wait()
+{
+	while( sem_wait( (sem_t*)_handle ) != 0 && errno == EINTR )
+	{}
+}
+
+#endif
+
 // ---
 light_semaphore_t::light_semaphore_t( int initialCount ) 
 	: _count( initialCount )
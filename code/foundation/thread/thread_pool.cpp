@@ -0,0 +1,175 @@
+#include "thread_pool.h"
+
+#include "../debug.h"
+#include <memory/memory.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+struct thread_pool_job_t
+{
+    thread_pool_range_func_t* func = nullptr;
+    void* user_data = nullptr;
+    uint32_t count = 0;
+    uint32_t grain = 1;
+    std::atomic<uint32_t> next{ 0 };
+};
+
+struct thread_pool_t
+{
+    BXIAllocator* allocator = nullptr;
+    std::thread* workers = nullptr;
+    uint32_t num_workers = 0;
+
+    std::mutex lock;
+    std::condition_variable wake_cv;
+    std::condition_variable done_cv;
+    uint64_t generation = 0;
+    uint32_t num_busy = 0;
+    bool quit = false;
+
+    // only one job is in flight at the time
+    std::mutex submit_lock;
+    thread_pool_job_t job;
+};
+
+static thread_local uint32_t tl_worker_index = UINT32_MAX;
+
+static void RunRanges( thread_pool_job_t* job, uint32_t worker_index )
+{
+    while( true )
+    {
+        const uint32_t begin = job->next.fetch_add( job->grain, std::memory_order_relaxed );
+        if( begin >= job->count )
+            break;
+
+        const uint32_t end = ( job->count - begin < job->grain ) ? job->count : begin + job->grain;
+        (*job->func)( begin, end, worker_index, job->user_data );
+    }
+}
+
+static void WorkerProc( thread_pool_t* pool, uint32_t worker_index )
+{
+    tl_worker_index = worker_index;
+
+    uint64_t seen_generation = 0;
+    while( true )
+    {
+        {
+            std::unique_lock<std::mutex> guard( pool->lock );
+            pool->wake_cv.wait( guard, [pool, seen_generation]() { return pool->quit || pool->generation != seen_generation; } );
+            if( pool->quit )
+                break;
+
+            seen_generation = pool->generation;
+        }
+
+        RunRanges( &pool->job, worker_index );
+
+        {
+            std::lock_guard<std::mutex> guard( pool->lock );
+            if( --pool->num_busy == 0 )
+                pool->done_cv.notify_one();
+        }
+    }
+}
+
+namespace thread_pool
+{
+    thread_pool_t* create( BXIAllocator* allocator, uint32_t num_workers )
+    {
+        if( num_workers == 0 )
+        {
+            const uint32_t hw = std::thread::hardware_concurrency();
+            num_workers = ( hw > 1 ) ? hw - 1 : 0;
+        }
+
+        thread_pool_t* pool = BX_NEW( allocator, thread_pool_t );
+        pool->allocator = allocator;
+        pool->num_workers = num_workers;
+        if( num_workers )
+        {
+            pool->workers = (std::thread*)BX_MALLOC( allocator, num_workers * sizeof( std::thread ), ALIGNOF( std::thread ) );
+            for( uint32_t i = 0; i < num_workers; ++i )
+            {
+                new( &pool->workers[i] ) std::thread( WorkerProc, pool, i + 1 );
+            }
+        }
+        return pool;
+    }
+
+    void destroy( thread_pool_t** pool_handle )
+    {
+        thread_pool_t* pool = pool_handle[0];
+        if( !pool )
+            return;
+
+        {
+            std::lock_guard<std::mutex> guard( pool->lock );
+            pool->quit = true;
+        }
+        pool->wake_cv.notify_all();
+
+        for( uint32_t i = 0; i < pool->num_workers; ++i )
+        {
+            pool->workers[i].join();
+            pool->workers[i].~thread();
+        }
+
+        BXIAllocator* allocator = pool->allocator;
+        BX_FREE( allocator, pool->workers );
+        BX_DELETE( allocator, pool );
+        pool_handle[0] = nullptr;
+    }
+
+    uint32_t num_threads( const thread_pool_t* pool )
+    {
+        return ( pool ) ? pool->num_workers + 1 : 1;
+    }
+
+    void parallel_for( thread_pool_t* pool, uint32_t count, uint32_t grain, thread_pool_range_func_t* func, void* user_data )
+    {
+        if( count == 0 )
+            return;
+
+        if( grain == 0 )
+            grain = 1;
+
+        const bool run_inline = !pool || pool->num_workers == 0 || count <= grain || tl_worker_index != UINT32_MAX;
+        if( run_inline )
+        {
+            const uint32_t worker_index = ( tl_worker_index != UINT32_MAX ) ? tl_worker_index : 0;
+            for( uint32_t begin = 0; begin < count; begin += grain )
+            {
+                const uint32_t end = ( count - begin < grain ) ? count : begin + grain;
+                (*func)( begin, end, worker_index, user_data );
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> submit_guard( pool->submit_lock );
+
+        thread_pool_job_t& job = pool->job;
+        job.func = func;
+        job.user_data = user_data;
+        job.count = count;
+        job.grain = grain;
+        job.next.store( 0, std::memory_order_relaxed );
+
+        {
+            std::lock_guard<std::mutex> guard( pool->lock );
+            pool->num_busy = pool->num_workers;
+            pool->generation += 1;
+        }
+        pool->wake_cv.notify_all();
+
+        tl_worker_index = 0;
+        RunRanges( &job, 0 );
+        tl_worker_index = UINT32_MAX;
+
+        std::unique_lock<std::mutex> guard( pool->lock );
+        pool->done_cv.wait( guard, [pool]() { return pool->num_busy == 0; } );
+    }
+}//
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+struct BXIAllocator;
+struct thread_pool_t;
+
+// called for each [begin, end) range; worker_index is in [0, num_threads) and 0 is always the calling thread
+using thread_pool_range_func_t = void( uint32_t begin, uint32_t end, uint32_t worker_index, void* user_data );
+
+namespace thread_pool
+{
+    // num_workers == 0 creates (hardware_concurrency - 1) workers, calling thread participates in every job
+    thread_pool_t* create( BXIAllocator* allocator, uint32_t num_workers = 0 );
+    void destroy( thread_pool_t** pool );
+
+    // workers + calling thread
+    uint32_t num_threads( const thread_pool_t* pool );
+
+    // splits [0, count) into ranges of 'grain' elements and blocks until all of them are processed.
+    // pool can be null, in that case everything runs on the calling thread.
+    // Nested calls (from inside of range function) are executed inline.
+    void parallel_for( thread_pool_t* pool, uint32_t count, uint32_t grain, thread_pool_range_func_t* func, void* user_data );
+
+    template< typename F >
+    inline void parallel_for( thread_pool_t* pool, uint32_t count, uint32_t grain, F& func )
+    {
+        thread_pool_range_func_t* wrapper = []( uint32_t begin, uint32_t end, uint32_t worker_index, void* user_data )
+        {
+            (*(F*)user_data)( begin, end, worker_index );
+        };
+        parallel_for( pool, count, grain, wrapper, &func );
+    }
+}//
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <float.h>
 
 #ifdef _MSC_VER
@@ -40,7 +41,11 @@ union TypeReinterpert
     explicit TypeReinterpert( f32 v ) : f( v ) {}
 };
 
+#ifdef _MSC_VER
 #define FORCE_INLINE __forceinline
+#else
+#define FORCE_INLINE inline __attribute__((always_inline))
+#endif
 
 
 #define BIT_KILO_BYTE( x ) ( x << 10 )
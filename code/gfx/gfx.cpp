@@ -148,12 +148,12 @@ namespace gfx_internal
     {
         GFXMaterialContainer& mc = gfx->_material;
         {
-            static_array_t<id_t, GFX_MAX_MATERIALS> to_queue;
+            static_array_t<id_handle_t, GFX_MAX_MATERIALS> to_queue;
             
             scope_mutex_t guard( mc.to_refresh_lock );
             while( !array::empty( mc.to_refresh ) )
             {
-                const id_t id = array::back( mc.to_refresh );
+                const id_handle_t id = array::back( mc.to_refresh );
                 array::pop_back( mc.to_refresh );
 
                 if( !mc.IsAlive( id ) )
@@ -185,7 +185,51 @@ namespace gfx_internal
         }
     }
 
-    static void ReleaseMeshInstance( GFXSceneContainer* sc, id_t idscene, id_t idinst )
+    // bindings point to texture data, which is freed right after this call
+    static void OnTextureReloaded( RSMResourceID id, const void* old_data, const void* new_data, void* user_data )
+    {
+        GFXSystem* gfx = (GFXSystem*)user_data;
+        GFXMaterialContainer& mc = gfx->_material;
+        for( uint32_t i = 0; i < GFX_MAX_MATERIALS; ++i )
+        {
+            const id_handle_t idmat = mc.idself[i];
+            if( !mc.IsAlive( idmat ) || mc.flags[i] != GFXEMaterialFlag::PIPELINE_FULL )
+                continue;
+
+            bool uses_texture = false;
+            for( uint32_t itex = 0; itex < GFXEMaterialTextureSlot::_COUNT_; ++itex )
+                uses_texture |= mc.textures[i].id[itex].i == id.i;
+
+            if( !uses_texture )
+                continue;
+
+            ClearTextures( mc.binding[i] );
+
+            scope_mutex_t guard( mc.to_refresh_lock );
+            if( array::find( mc.to_refresh, idmat ) == array::npos )
+                array::push_back( mc.to_refresh, idmat );
+        }
+    }
+    static void SubscribeTextures( GFXSystem* gfx, uint32_t index )
+    {
+        GFXMaterialContainer& mc = gfx->_material;
+        for( uint32_t itex = 0; itex < GFXEMaterialTextureSlot::_COUNT_; ++itex )
+        {
+            const RSMResourceID idtex = mc.textures[index].id[itex];
+            if( RSM::IsAlive( idtex ) )
+                mc.texture_reload[index][itex] = RSM::Subscribe( idtex, OnTextureReloaded, gfx );
+        }
+    }
+    static void UnsubscribeTextures( GFXMaterialContainer* mc, uint32_t index )
+    {
+        for( uint32_t itex = 0; itex < GFXEMaterialTextureSlot::_COUNT_; ++itex )
+        {
+            RSM::Unsubscribe( mc->texture_reload[index][itex] );
+            mc->texture_reload[index][itex] = {};
+        }
+    }
+
+    static void ReleaseMeshInstance( GFXSceneContainer* sc, id_handle_t idscene, id_handle_t idinst )
     {
         if( !sc->IsMeshAlive( idscene, idinst ) )
             return;
@@ -221,7 +265,7 @@ namespace gfx_internal
             scope_mutex_t guard( cc.to_remove_lock );
             while( !array::empty( cc.to_remove ) )
             {
-                id_t id = array::back( cc.to_remove );
+                id_handle_t id = array::back( cc.to_remove );
                 array::pop_back( cc.to_remove );
 
                 const uint32_t data_index = cc.DataIndex( id );
@@ -251,13 +295,13 @@ namespace gfx_internal
             scope_lock_t<mutex_t> lock_guard( sc.to_remove_lock );
             while( !array::empty( sc.to_remove ) )
             {
-                id_t id = array::back( sc.to_remove );
+                id_handle_t id = array::back( sc.to_remove );
                 array::pop_back( sc.to_remove );
 
                 while( container_soa::size( sc.mesh_data[id.index] ) )
                 {
                     const uint32_t last_index = container_soa::size( sc.mesh_data[id.index] ) - 1;
-                    const id_t idinst = sc.mesh_data[id.index]->idinstance[last_index];
+                    const id_handle_t idinst = sc.mesh_data[id.index]->idinstance[last_index];
                     ReleaseMeshInstance( &sc, id, idinst );
                 }
 
@@ -283,15 +327,16 @@ namespace gfx_internal
             scope_lock_t<mutex_t> lock_guard( mc.to_remove_lock );
             while ( !array::empty( mc.to_remove ) )
             {
-                id_t id = array::back( mc.to_remove );
+                id_handle_t id = array::back( mc.to_remove );
                 array::pop_back( mc.to_remove );
 
                 string::free( &mc.name[id.index] );
-                mc.idself[id.index] = makeInvalidHandle<id_t>();
+                mc.idself[id.index] = makeInvalidHandle<id_handle_t>();
 
                 DestroyResourceBinding( &mc.binding[id.index] );
                 //Destroy( &mc.data_gpu[id.index] );
                 
+                UnsubscribeTextures( &mc, id.index );
                 for( uint32_t itex = 0; itex < GFXEMaterialTextureSlot::_COUNT_; ++itex )
                     RSM::Release( mc.textures[id.index].id[itex] );
 
@@ -303,11 +348,11 @@ namespace gfx_internal
         }
     }
 
-    static bool IsMaterialAlive( GFXSystem* gfx, id_t id )
+    static bool IsMaterialAlive( GFXSystem* gfx, id_handle_t id )
     {
         return id_table::has( gfx->_material.idtable, id );
     }
-    static  id_t FindMaterial( GFXSystem* gfx, const char* name )
+    static  id_handle_t FindMaterial( GFXSystem* gfx, const char* name )
     {
         const GFXMaterialContainer& materials = gfx->_material;
         for( uint32_t i = 0; i < GFX_MAX_MATERIALS; ++i )
@@ -318,10 +363,10 @@ namespace gfx_internal
                     return materials.idself[i];
             }
         }
-        return makeInvalidHandle<id_t>();
+        return makeInvalidHandle<id_handle_t>();
     }
 
-    static void UploadMaterial( GFXSystem* gfx, id_t id, const gfx_shader::Material& data )
+    static void UploadMaterial( GFXSystem* gfx, id_handle_t id, const gfx_shader::Material& data )
     {
         GFXMaterialContainer& mc = gfx->_material;
         mc.data[id.index] = data;
@@ -337,7 +382,7 @@ namespace gfx_internal
             //    array::push_back( mc->resource_to_release, id );
         }
     }
-    static void ChangeTextures( GFXSystem* gfx, id_t id, const GFXMaterialTexture& tex )
+    static void ChangeTextures( GFXSystem* gfx, id_handle_t id, const GFXMaterialTexture& tex )
     {
         GFXMaterialContainer& mc = gfx->_material;
         const uint32_t index = mc.DataIndex( id );
@@ -354,8 +399,10 @@ namespace gfx_internal
                 mc.binding[index] = CloneResourceBinding( ResourceBinding( mc.pipeline.full ), gfx->_allocator );
                 mc.flags[index] = GFXEMaterialFlag::PIPELINE_FULL;
             }
+            UnsubscribeTextures( &mc, index );
             ReleaseResources( array_span_t<RSMResourceID>( mc.textures[index].id, GFXEMaterialTextureSlot::_COUNT_ ) );
             mc.textures[index] = tex;
+            SubscribeTextures( gfx, index );
 
             ClearTextures( mc.binding[index] );
             {
@@ -367,6 +414,7 @@ namespace gfx_internal
         {
             if( mc.flags[index] == GFXEMaterialFlag::PIPELINE_FULL || mc.flags[index] == 0 )
             {
+                UnsubscribeTextures( &mc, index );
                 ReleaseResources( array_span_t<RSMResourceID>( mc.textures[index].id, GFXEMaterialTextureSlot::_COUNT_ ) );
                 DestroyResourceBinding( &mc.binding[index] );
                 mc.binding[index] = CloneResourceBinding( ResourceBinding( mc.pipeline.base_with_skybox ), gfx->_allocator );
@@ -376,16 +424,16 @@ namespace gfx_internal
             mc.textures[index] = {};
         }
     }
-    static RDIXResourceBinding* GetMaterialBinding( GFXSystem* gfx, id_t id )
+    static RDIXResourceBinding* GetMaterialBinding( GFXSystem* gfx, id_handle_t id )
     {
         if( !IsMaterialAlive( gfx, id ) )
         {
-            id_t fallback_id = { gfx->_fallback_idmaterial.i };
+            id_handle_t fallback_id = { gfx->_fallback_idmaterial.i };
             return gfx->_material.binding[fallback_id.index];
         }
         return  gfx->_material.binding[id.index];
     }
-    static RDIXPipeline* GetMaterialPipeline( GFXSystem* gfx, id_t id )
+    static RDIXPipeline* GetMaterialPipeline( GFXSystem* gfx, id_handle_t id )
     {
         if( !IsMaterialAlive( gfx, id ) )
         {
@@ -396,6 +444,25 @@ namespace gfx_internal
         SYS_ASSERT( flags & (GFXEMaterialFlag::PIPELINE_BASE | GFXEMaterialFlag::PIPELINE_FULL) );
         return (flags & GFXEMaterialFlag::PIPELINE_BASE) ? gfx->_material.pipeline.base_with_skybox : gfx->_material.pipeline.full;
     }
+
+    // packed vertex streams of compiled meshes are decoded in vertex shader
+    static inline bool IsOctEncoded( const RDIXRenderSource* rsource, RDIEVertexSlot::Enum slot )
+    {
+        const RDIVertexBuffer vbuffer = FindVertexBuffer( rsource, slot );
+        return vbuffer.id && vbuffer.desc.dataType == RDIEType::SHORT && vbuffer.desc.numElements == 2 && vbuffer.desc.typeNorm;
+    }
+    static void SetVertexDecodeData( gfx_shader::InstanceData* idata, const RDIXRenderSource* rsource )
+    {
+        idata->vertex_flags = 0;
+        idata->vertex_flags |= ( IsOctEncoded( rsource, RDIEVertexSlot::NORMAL ) ) ? INSTANCE_VERTEX_OCT_NORMAL : 0;
+        idata->vertex_flags |= ( IsOctEncoded( rsource, RDIEVertexSlot::TANGENT ) ) ? INSTANCE_VERTEX_OCT_TANGENT : 0;
+        idata->vertex_flags |= ( IsOctEncoded( rsource, RDIEVertexSlot::BINORMAL ) ) ? INSTANCE_VERTEX_OCT_BINORMAL : 0;
+
+        const float* box_min = PositionBoxMin( rsource );
+        const float* box_extent = PositionBoxExtent( rsource );
+        idata->position_min = vec3_t( box_min[0], box_min[1], box_min[2] );
+        idata->position_extent = vec3_t( box_extent[0], box_extent[1], box_extent[2] );
+    }
 }
 
 static GFX* GFXAllocate( BXIAllocator* allocator )
@@ -433,6 +500,15 @@ GFX* GFX::StartUp( RDIDevice* dev, const GFXDesc& desc, BXIFilesystem* filesyste
     gfx->_allocator = allocator;
     gfx->_rdidev = dev;
 
+    gfx->_lod_pixel_error = desc.lod_pixel_error;
+    gfx->_meshlet_culling = desc.meshlet_culling;
+    gfx->_thread_pool = desc.thread_pool;
+    if( !gfx->_thread_pool )
+    {
+        gfx->_thread_pool = thread_pool::create( allocator );
+        gfx->_owns_thread_pool = true;
+    }
+
     { // loaders
         RSM::RegisterLoader<GFXMeshResourceLoader>();
         RSM::RegisterLoader<GFXTextureResourceLoader>();
@@ -651,6 +727,13 @@ void GFX::ShutDown( GFX** gfx_interface_handle )
     DestroyRenderTarget( dev, &gfx->_framebuffer );
    
     gfx_interface->utils->ShutDown( dev );
+
+    if( gfx->_owns_thread_pool )
+    {
+        thread_pool::destroy( &gfx->_thread_pool );
+    }
+    gfx->_thread_pool = nullptr;
+
     GFXFree( gfx_interface_handle, allocator );
 }
 
@@ -673,7 +756,7 @@ GFXCameraID GFX::CreateCamera( const char* name, const GFXCameraParams& params,
 {
     GFXCameraContainer& cc = gfx->_camera;
 
-    id_t id = {};
+    id_handle_t id = {};
     {
         scope_mutex_t guard( cc.id_lock );
         id = id_array::create( cc.id_alloc );
@@ -689,7 +772,7 @@ GFXCameraID GFX::CreateCamera( const char* name, const GFXCameraParams& params,
 
 void GFX::DestroyCamera( GFXCameraID idcam )
 {
-    id_t id = { idcam.i };
+    id_handle_t id = { idcam.i };
 
     GFXCameraContainer& cc = gfx->_camera;
     if( !cc.IsAlive( id ) )
@@ -769,7 +852,7 @@ void GFX::ComputeCamera( GFXCameraID idcam, GFXCameraMatrices* output )
 
 GFXMaterialID GFX::CreateMaterial( const char* name, const GFXMaterialDesc& desc )
 {
-    id_t id = gfx_internal::FindMaterial( gfx, name );
+    id_handle_t id = gfx_internal::FindMaterial( gfx, name );
     if( gfx_internal::IsMaterialAlive( gfx, id ) )
         return {0};
 
@@ -797,7 +880,7 @@ void GFX::DestroyMaterial( GFXMaterialID idmat )
 {
     GFXMaterialContainer& mc = gfx->_material;
 
-    id_t id = { idmat.i };
+    id_handle_t id = { idmat.i };
     if( !id_table::has( mc.idtable, id ) )
         return;
 
@@ -814,7 +897,7 @@ void GFX::SetMaterialData( GFXMaterialID idmat, const gfx_shader::Material& data
 {
     if( !IsMaterialAlive( idmat ) )
         return;
-    id_t id = { idmat.i };
+    id_handle_t id = { idmat.i };
     gfx_internal::UploadMaterial( gfx, id, data );
 }
 
@@ -823,7 +906,7 @@ void GFX::SetMaterialTextures( GFXMaterialID idmat, const GFXMaterialTexture& te
     if( !IsMaterialAlive( idmat ) )
         return;
     
-    const id_t id = { idmat.i };
+    const id_handle_t id = { idmat.i };
     gfx_internal::ChangeTextures( gfx, id, tex );
 }
 
@@ -839,7 +922,7 @@ bool GFX::IsMaterialAlive( GFXMaterialID idmat )
 
 RDIXResourceBinding* GFX::MaterialBinding( GFXMaterialID idmat )
 {
-    const id_t id = { idmat.i };
+    const id_handle_t id = { idmat.i };
     return gfx_internal::GetMaterialBinding( gfx, id );
 }
 
@@ -848,11 +931,12 @@ GFXSceneID GFX::CreateScene( const GFXSceneDesc& desc )
     GFXSceneContainer& sc = gfx->_scene;
 
     gfx->_scene.lock.lock();
-    id_t idscene = id_table::create( sc.idtable );
+    id_handle_t idscene = id_table::create( sc.idtable );
     gfx->_scene.lock.unlock();
 
     RDIXTransformBufferDesc transform_buffer_desc = {};
     transform_buffer_desc.capacity = desc.max_renderables;
+    transform_buffer_desc.instance_data_size = sizeof( gfx_shader::InstanceData );
     RDIXTransformBuffer* transform_buffer = CreateTransformBuffer( gfx->_rdidev, transform_buffer_desc, gfx->_allocator );
 
     const uint32_t cmd_buffer_size = 128;// desc.max_renderables * 8 + 128;
@@ -887,7 +971,7 @@ void GFX::DestroyScene( GFXSceneID idscene )
 {
     GFXSceneContainer& sc = gfx->_scene;
     
-    id_t id = { idscene.i };
+    id_handle_t id = { idscene.i };
     if( !sc.IsSceneAlive( id ) )
         return;
 
@@ -902,15 +986,15 @@ void GFX::DestroyScene( GFXSceneID idscene )
 
 namespace
 {
-    static inline GFXMeshInstanceID EncodeMeshInstanceID( id_t idscene, id_t idmesh )
+    static inline GFXMeshInstanceID EncodeMeshInstanceID( id_handle_t idscene, id_handle_t idmesh )
     {
         return { ((uint64_t)idscene.hash << 32ull) | (uint64_t)idmesh.hash };
     }
-    static inline id_t DecodeSceneID( GFXMeshInstanceID idmesh )
+    static inline id_handle_t DecodeSceneID( GFXMeshInstanceID idmesh )
     {
         return { (uint32_t)(idmesh.i >> 32) };
     }
-    static inline id_t DecodeMeshInstanceID( GFXMeshInstanceID idmesh )
+    static inline id_handle_t DecodeMeshInstanceID( GFXMeshInstanceID idmesh )
     {
         return { (uint32_t)idmesh.i };
     }
@@ -918,7 +1002,7 @@ namespace
 
 GFXMeshInstanceID GFX::AddMeshToScene( GFXSceneID idscene, const GFXMeshInstanceDesc& desc, const mat44_t& pose )
 {
-    const id_t idscn = { idscene.i };
+    const id_handle_t idscn = { idscene.i };
     GFXSceneContainer& sc = gfx->_scene;
     if( !sc.IsSceneAlive( idscn ) )
         return { 0 };
@@ -932,7 +1016,7 @@ GFXMeshInstanceID GFX::AddMeshToScene( GFXSceneID idscene, const GFXMeshInstance
     GFXSceneContainer::MeshData* data = sc.mesh_data[index];
     
     sc.mesh_lock[index].lock();
-    const id_t idinst = id_allocator::alloc( sc.mesh_idalloc[index] );
+    const id_handle_t idinst = id_allocator::alloc( sc.mesh_idalloc[index] );
     const uint32_t data_index = container_soa::push_back( data );
     sc.mesh_lock[index].unlock();
         
@@ -968,15 +1052,15 @@ GFXMeshInstanceID GFX::AddMeshToScene( GFXSceneID idscene, const GFXMeshInstance
 
 void GFX::RemoveMeshFromScene( GFXMeshInstanceID idmeshi )
 {
-    const id_t idscene = DecodeSceneID( idmeshi );
-    const id_t idinst = DecodeMeshInstanceID( idmeshi );
+    const id_handle_t idscene = DecodeSceneID( idmeshi );
+    const id_handle_t idinst = DecodeMeshInstanceID( idmeshi );
     
     GFXSceneContainer& sc = gfx->_scene;
     if( !sc.IsMeshAlive( idscene, idinst ) )
         return;
 
     sc.mesh_lock[idscene.index].lock();
-    const id_t new_idinst = id_allocator::invalidate( sc.mesh_idalloc[idscene.index], idinst );
+    const id_handle_t new_idinst = id_allocator::invalidate( sc.mesh_idalloc[idscene.index], idinst );
     sc.mesh_lock[idscene.index].unlock();
 
     const uint32_t instance_index = sc.MeshInstanceIndex( idscene, new_idinst );
@@ -993,8 +1077,8 @@ void GFX::RemoveMeshFromScene( GFXMeshInstanceID idmeshi )
 
 RSMResourceID GFX::Mesh( GFXMeshInstanceID idmeshi )
 {
-    const id_t idscene = DecodeSceneID( idmeshi );
-    const id_t idinst = DecodeMeshInstanceID( idmeshi );
+    const id_handle_t idscene = DecodeSceneID( idmeshi );
+    const id_handle_t idinst = DecodeMeshInstanceID( idmeshi );
 
     GFXSceneContainer& sc = gfx->_scene;
     if( !sc.IsMeshAlive( idscene, idinst ) )
@@ -1005,8 +1089,8 @@ RSMResourceID GFX::Mesh( GFXMeshInstanceID idmeshi )
 
 GFXMaterialID GFX::Material( GFXMeshInstanceID idmeshi )
 {
-    const id_t idscene = DecodeSceneID( idmeshi );
-    const id_t idinst = DecodeMeshInstanceID( idmeshi );
+    const id_handle_t idscene = DecodeSceneID( idmeshi );
+    const id_handle_t idinst = DecodeMeshInstanceID( idmeshi );
 
     GFXSceneContainer& sc = gfx->_scene;
     if( !sc.IsMeshAlive( idscene, idinst ) )
@@ -1017,8 +1101,8 @@ GFXMaterialID GFX::Material( GFXMeshInstanceID idmeshi )
 
 void GFX::SetWorldPose( GFXMeshInstanceID idmeshi, const mat44_t& pose )
 {
-    const id_t idscene = DecodeSceneID( idmeshi );
-    const id_t idinst = DecodeMeshInstanceID( idmeshi );
+    const id_handle_t idscene = DecodeSceneID( idmeshi );
+    const id_handle_t idinst = DecodeMeshInstanceID( idmeshi );
 
     GFXSceneContainer& sc = gfx->_scene;
     const uint32_t instance_index = sc.MeshInstanceIndex( idscene, idinst );
@@ -1028,8 +1112,8 @@ void GFX::SetWorldPose( GFXMeshInstanceID idmeshi, const mat44_t& pose )
 
 blob_t GFX::AcquireSkinnigDataToWrite( GFXMeshInstanceID idmeshi, uint32_t size_in_bytes )
 {
-    const id_t idscene = DecodeSceneID( idmeshi );
-    const id_t idinst = DecodeMeshInstanceID( idmeshi );
+    const id_handle_t idscene = DecodeSceneID( idmeshi );
+    const id_handle_t idinst = DecodeMeshInstanceID( idmeshi );
 
     blob_t result;
 
@@ -1142,20 +1226,33 @@ void GFX::DoSkinningCPU( RDICommandQueue* cmdq )
     GFXSkinningDataCPU& sd = sc.cpu_skinning_data;
     sd.Swap();
 
-    union BlendIndices
+    array_span_t<const float4_t> skinning_data_f4 = sd.BackBuffer<float4_t>();
+    const uint32_t num_meshes = std::atomic_exchange( &sc.num_meshes_to_skin_cpu, 0 );
+    if( !num_meshes )
+        return;
+
+    struct SkinningJob
+    {
+        GFXSkinningStreamsCPU streams;
+        RDIVertexBuffer vb[6];
+    };
+    struct SkinningBatch
     {
-        struct { uint8_t x, y, z, w; };
-        uint8_t i[4];
+        uint32_t job_index;
+        uint32_t begin;
+        uint32_t end;
     };
 
-    array_span_t<const float4_t> skinning_data_f4 = sd.BackBuffer<float4_t>();
-    const uint32_t num_meshes = std::atomic_exchange( &sc.num_meshes_to_skin_cpu, 0 );
-    
+    // map buffers serially, command queue can't be used from multiple threads
+    SkinningJob* jobs = (SkinningJob*)BX_MALLOC( gfx->_allocator, num_meshes * sizeof( SkinningJob ), ALIGNOF( SkinningJob ) );
+    uint32_t num_jobs = 0;
+    uint32_t num_batches = 0;
+
     for( uint32_t i = 0; i < num_meshes; ++i )
     {
         const GFXMeshInstanceID id_mesh = sc.mesh_to_skin_cpu[i];
-        const id_t idscene = DecodeSceneID( id_mesh );
-        const id_t idinst = DecodeMeshInstanceID( id_mesh );
+        const id_handle_t idscene = DecodeSceneID( id_mesh );
+        const id_handle_t idinst = DecodeMeshInstanceID( id_mesh );
                 
         if( !sc.IsMeshAlive( idscene, idinst ) )
             continue;
@@ -1166,64 +1263,73 @@ void GFX::DoSkinningCPU( RDICommandQueue* cmdq )
         SYS_ASSERT( !mesh_skinning.flag_gpu );
 
         const float4_t* data_begin = &skinning_data_f4[ mesh_skinning.pin_index ];
-        const array_span_t<mat44_t> skinning_matrices( (mat44_t*)data_begin, mesh_skinning.num_elements / 4 );
 
         const RSMResourceID base_id = sc.mesh_data[idscene.index]->idmesh_resource[idinst.index];
         const RDIXRenderSource* base = (RDIXRenderSource*)RSM::Get( base_id );
         const RDIXRenderSource* skinned = sc.mesh_data[idscene.index]->skinning_data[idinst.index].rsource;
 
-        const RDIVertexBuffer vb_blendweights      = FindVertexBuffer( base, RDIEVertexSlot::BLENDWEIGHT );
-        const RDIVertexBuffer vb_blendindices      = FindVertexBuffer( base, RDIEVertexSlot::BLENDINDICES );
-        const RDIVertexBuffer vb_base_positions    = FindVertexBuffer( base, RDIEVertexSlot::POSITION );
-        const RDIVertexBuffer vb_base_normals      = FindVertexBuffer( base, RDIEVertexSlot::NORMAL );
-      
-        const RDIVertexBuffer vb_skinned_positions = FindVertexBuffer( skinned, RDIEVertexSlot::POSITION );
-        const RDIVertexBuffer vb_skinned_normals   = FindVertexBuffer( skinned, RDIEVertexSlot::NORMAL );
-
-        const vec4_t* blendweights = (vec4_t*)Map( cmdq, vb_blendweights, RDIEMapType::READ );
-        const BlendIndices* blendindices = (BlendIndices*)Map( cmdq, vb_blendindices, RDIEMapType::READ );
-
-        const vec3_t* base_positions = (vec3_t*)Map( cmdq, vb_base_positions, RDIEMapType::READ );
-        const vec3_t* base_normals = (vec3_t*)Map( cmdq, vb_base_normals, RDIEMapType::READ );
+        SkinningJob& job = jobs[num_jobs++];
+        job.vb[0] = FindVertexBuffer( base, RDIEVertexSlot::BLENDWEIGHT );
+        job.vb[1] = FindVertexBuffer( base, RDIEVertexSlot::BLENDINDICES );
+        job.vb[2] = FindVertexBuffer( base, RDIEVertexSlot::POSITION );
+        job.vb[3] = FindVertexBuffer( base, RDIEVertexSlot::NORMAL );
+        job.vb[4] = FindVertexBuffer( skinned, RDIEVertexSlot::POSITION );
+        job.vb[5] = FindVertexBuffer( skinned, RDIEVertexSlot::NORMAL );
+
+        GFXSkinningStreamsCPU& streams = job.streams;
+        streams.matrices          = (const mat44_t*)data_begin;
+        streams.blendweights      = (const vec4_t*)Map( cmdq, job.vb[0], RDIEMapType::READ );
+        streams.blendindices      = (const uint8_t*)Map( cmdq, job.vb[1], RDIEMapType::READ );
+        streams.base_positions    = (const vec3_t*)Map( cmdq, job.vb[2], RDIEMapType::READ );
+        streams.base_normals      = (const vec3_t*)Map( cmdq, job.vb[3], RDIEMapType::READ );
+        streams.skinned_positions = (vec3_t*)Map( cmdq, job.vb[4], RDIEMapType::WRITE );
+        streams.skinned_normals   = (vec3_t*)Map( cmdq, job.vb[5], RDIEMapType::WRITE );
+        streams.num_vertices      = NumVertices( base );
+        SYS_ASSERT( NumVertices( skinned ) == streams.num_vertices );
+
+        num_batches += iceil( streams.num_vertices, GFX_SKINNING_CPU_VERTEX_BATCH );
+    }
 
-        vec3_t* skinned_positions = (vec3_t*)Map( cmdq, vb_skinned_positions, RDIEMapType::WRITE );
-        vec3_t* skinned_normals = (vec3_t*)Map( cmdq, vb_skinned_normals, RDIEMapType::WRITE );
+    if( !num_jobs )
+    {
+        BX_FREE( gfx->_allocator, jobs );
+        return;
+    }
 
-        const uint32_t num_vertices = NumVertices( base );
-        SYS_ASSERT( NumVertices( skinned ) == num_vertices );
+    // split meshes into vertex ranges, so big meshes are spread across threads too
+    SkinningBatch* batches = (SkinningBatch*)BX_MALLOC( gfx->_allocator, num_batches * sizeof( SkinningBatch ), ALIGNOF( SkinningBatch ) );
+    uint32_t ibatch = 0;
+    for( uint32_t ijob = 0; ijob < num_jobs; ++ijob )
+    {
+        const uint32_t num_vertices = jobs[ijob].streams.num_vertices;
+        for( uint32_t begin = 0; begin < num_vertices; begin += GFX_SKINNING_CPU_VERTEX_BATCH )
+        {
+            const uint32_t end = min_of_2( begin + GFX_SKINNING_CPU_VERTEX_BATCH, num_vertices );
+            batches[ibatch++] = { ijob, begin, end };
+        }
+    }
+    SYS_ASSERT( ibatch == num_batches );
 
-        for( uint32_t ivertex = 0; ivertex < num_vertices; ++ivertex )
+    auto skin_batches = [jobs, batches]( uint32_t begin, uint32_t end, uint32_t )
+    {
+        for( uint32_t i = begin; i < end; ++i )
         {
-            const vec4_t& bw = blendweights[ivertex];
-            const BlendIndices bi = blendindices[ivertex];
-                        
-            const vec3_t& base_pos = base_positions[ivertex];
-            const vec3_t& base_nrm = base_normals[ivertex];
-
-            vec3_t skinned_pos( 0.f );
-            vec3_t skinned_nrm( 0.f );
-            
-            skinned_pos += mul_as_point( skinning_matrices[bi.x], base_pos ) * bw.x;
-            skinned_pos += mul_as_point( skinning_matrices[bi.y], base_pos ) * bw.y;
-            skinned_pos += mul_as_point( skinning_matrices[bi.z], base_pos ) * bw.z;
-            skinned_pos += mul_as_point( skinning_matrices[bi.w], base_pos ) * bw.w;
-
-            skinned_nrm += rotate( skinning_matrices[bi.x], base_nrm ) * bw.x;
-            skinned_nrm += rotate( skinning_matrices[bi.y], base_nrm ) * bw.y;
-            skinned_nrm += rotate( skinning_matrices[bi.z], base_nrm ) * bw.z;
-            skinned_nrm += rotate( skinning_matrices[bi.w], base_nrm ) * bw.w;
-        
-            skinned_positions[ivertex] = skinned_pos;
-            skinned_normals[ivertex] = skinned_nrm;
+            const SkinningBatch& batch = batches[i];
+            SkinVerticesCPU( jobs[batch.job_index].streams, batch.begin, batch.end );
         }
+    };
+    thread_pool::parallel_for( gfx->_thread_pool, num_batches, 1, skin_batches );
 
-        Unmap( cmdq, vb_skinned_normals );
-        Unmap( cmdq, vb_skinned_positions );
-        Unmap( cmdq, vb_base_normals );
-        Unmap( cmdq, vb_base_positions );
-        Unmap( cmdq, vb_blendindices );
-        Unmap( cmdq, vb_blendweights );
+    for( uint32_t ijob = 0; ijob < num_jobs; ++ijob )
+    {
+        for( int32_t ivb = (int32_t)sizeof_array( jobs[ijob].vb ) - 1; ivb >= 0; --ivb )
+        {
+            Unmap( cmdq, jobs[ijob].vb[ivb] );
+        }
     }
+
+    BX_FREE( gfx->_allocator, batches );
+    BX_FREE( gfx->_allocator, jobs );
 }
 
 void GFX::DoSkinningGPU( RDICommandQueue* cmdq )
@@ -1246,8 +1352,8 @@ void GFX::DoSkinningGPU( RDICommandQueue* cmdq )
     for( uint32_t i = 0; i < num_meshes; ++i )
     {
         const GFXMeshInstanceID id_mesh = sc.mesh_to_skin_gpu[i];
-        const id_t idscene = DecodeSceneID( id_mesh );
-        const id_t idinst = DecodeMeshInstanceID( id_mesh );
+        const id_handle_t idscene = DecodeSceneID( id_mesh );
+        const id_handle_t idinst = DecodeMeshInstanceID( id_mesh );
 
         if( !sc.IsMeshAlive( idscene, idinst ) )
             continue;
@@ -1333,6 +1439,7 @@ GFXFrameContext* GFX::BeginFrame( RDICommandQueue* cmdq )
 
     SYS_ASSERT( !gfx->_frame_ctx.Valid() );
     gfx->_frame_ctx.cmdq = cmdq;
+    gfx->_frame_ctx.stats = {};
     return &gfx->_frame_ctx;
 }
 
@@ -1342,6 +1449,11 @@ void GFX::EndFrame( GFXFrameContext* fctx )
 
     ::Swap( fctx->cmdq, gfx->_sync_interval );
     fctx->cmdq = nullptr;
+    gfx->_last_frame_stats = fctx->stats;
+}
+const GFXFrameStats& GFX::LastFrameStats() const
+{
+    return gfx->_last_frame_stats;
 }
 void GFX::RasterizeFramebuffer( RDICommandQueue* cmdq, uint32_t texture_index, GFXCameraID idcamera )
 {
@@ -1374,6 +1486,89 @@ namespace GFXEDrawStage
     };
 }//
 
+// coarsest LOD with projected error below max_pixel_error. pixel_scale converts view space size at distance 1 to pixels
+static uint32_t SelectMeshLod( const RDIXRenderSource* rsource, const mat44_t& world, const vec3_t& eye, float pixel_scale, float max_pixel_error )
+{
+    const uint32_t num_lods = NumLods( rsource );
+    if( num_lods < 2 )
+        return 0;
+
+    const float* sphere = BoundingSphere( rsource );
+    const float scale = max_of_2( max_of_2( length( world.c0.xyz() ), length( world.c1.xyz() ) ), length( world.c2.xyz() ) );
+    const vec3_t center = mul_as_point( world, vec3_t( sphere[0], sphere[1], sphere[2] ) );
+    const float distance = length( center - eye ) - sphere[3] * scale;
+    if( distance <= 0.f )
+        return 0;
+
+    const float error_to_pixels = scale * pixel_scale / distance;
+    for( uint32_t i = num_lods - 1; i > 0; --i )
+    {
+        if( Lod( rsource, i ).error * error_to_pixels <= max_pixel_error )
+            return i;
+    }
+    return 0;
+}
+
+// visible meshlets of draw ranges [first_range, first_range + num_ranges) merged into contiguous index ranges.
+// Frustum and eye are moved to object space, so tests hold for any world matrix (backface test is skipped for mirroring ones).
+// Returns UINT32_MAX when result doesn't fit in max_output
+static uint32_t CullMeshlets( RDIXRenderSourceRange* output, uint32_t max_output, const RDIXRenderSource* rsource, uint32_t first_range, uint32_t num_ranges,
+                              const mat44_t& world, const mat44_t& view_proj, const vec3_t& eye )
+{
+    // planes from rows of clip matrix, clip space z in [-w,w]
+    const mat44_t rows = transpose( view_proj * world );
+    vec4_t planes[6] =
+    {
+        rows.c3 + rows.c0, rows.c3 - rows.c0,
+        rows.c3 + rows.c1, rows.c3 - rows.c1,
+        rows.c3 + rows.c2, rows.c3 - rows.c2,
+    };
+    for( vec4_t& plane : planes )
+        plane /= length( plane.xyz() );
+
+    const bool mirrored = dot( cross( world.c0.xyz(), world.c1.xyz() ), world.c2.xyz() ) < 0.f;
+    const vec3_t local_eye = mul_as_point( inverse( world ), eye );
+
+    uint32_t num_output = 0;
+    for( uint32_t irange = first_range; irange < first_range + num_ranges; ++irange )
+    {
+        const uint32_t base_vertex = Range( rsource, irange ).base_vertex;
+        for( const RDIXMeshlet& meshlet : Meshlets( rsource, irange ) )
+        {
+            const vec4_t center( meshlet.sphere[0], meshlet.sphere[1], meshlet.sphere[2], 1.f );
+            const float radius = meshlet.sphere[3];
+
+            bool visible = true;
+            for( uint32_t i = 0; i < 6 && visible; ++i )
+                visible = dot( planes[i], center ) >= -radius;
+
+            if( visible && !mirrored )
+            {
+                const vec3_t to_center = center.xyz() - local_eye;
+                const vec3_t axis( meshlet.cone_axis[0], meshlet.cone_axis[1], meshlet.cone_axis[2] );
+                visible = dot( to_center, axis ) < meshlet.cone_cutoff * length( to_center ) + radius;
+            }
+
+            if( !visible )
+                continue;
+
+            RDIXRenderSourceRange* last = ( num_output ) ? &output[num_output - 1] : nullptr;
+            if( last && last->base_vertex == base_vertex && last->begin + last->count == meshlet.first_index )
+            {
+                last->count += meshlet.num_indices;
+            }
+            else
+            {
+                if( num_output == max_output )
+                    return UINT32_MAX;
+
+                output[num_output++] = RDIXRenderSourceRange( meshlet.first_index, meshlet.num_indices, base_vertex );
+            }
+        }
+    }
+    return num_output;
+}
+
 union GFXSortKey
 {
     uint64_t key = 0;
@@ -1440,7 +1635,7 @@ void GFX::GenerateCommandBuffer( GFXFrameContext* fctx, GFXSceneID idscene, GFXC
         for( uint32_t i = 0; i < num_meshes; ++i )
         {
             const mat44_t& instance_matrix = matrix_array[i];
-            const id_t mat_id = { idmat_array[i].i };
+            const id_handle_t mat_id = { idmat_array[i].i };
 
             const uint32_t instance_offset = AppendMatrix( transform_buffer, instance_matrix );
             gfx_shader::InstanceData& idata = idata_array[i];
@@ -1466,12 +1661,57 @@ void GFX::GenerateCommandBuffer( GFXFrameContext* fctx, GFXSceneID idscene, GFXC
 
     }
 
+    // projected size for LOD selection
+    const vec3_t eye = cameram.eye();
+    const float lod_pixel_scale = cameram.proj.c1.y * 0.5f * (float)Texture( gfx->_framebuffer, 0 ).info.height;
+    const mat44_t view_proj = cameram.proj * cameram.view;
+
+    static constexpr uint32_t MAX_VISIBLE_MESHLET_RANGES = 256;
+    RDIXRenderSourceRange visible_ranges[MAX_VISIBLE_MESHLET_RANGES];
+
     // color pass
     for( uint32_t i = 0; i < num_meshes; ++i )
     {
-        const id_t mat_id = { idmat_array[i].i };
-        const gfx_shader::InstanceData& idata = idata_array[i];
-        
+        const id_handle_t mat_id = { idmat_array[i].i };
+        gfx_shader::InstanceData idata = idata_array[i];
+
+        const GFXMeshSkinningData& skinning_data = skinned_mesh_array[i];
+        RDIXRenderSource* rsource = skinning_data.rsource;
+        if( !rsource || skinning_data.pin_index == GFX_DEFAULT_SKINNING_PIN )
+        {
+            rsource = (RDIXRenderSource*)RSM::Get( idmesh_array[i] );
+        }
+        rsource = rsource ? rsource : gfx->_fallback_mesh;
+        gfx_internal::SetVertexDecodeData( &idata, rsource );
+
+        // compiled meshes draw ranges of selected LOD. Otherwise all parts, or whole buffer when there are none
+        uint32_t first_range = 0;
+        uint32_t num_ranges = 1;
+        if( NumLods( rsource ) )
+        {
+            const uint32_t ilod = SelectMeshLod( rsource, matrix_array[i], eye, lod_pixel_scale, gfx->_lod_pixel_error );
+            const RDIXRenderSourceLod lod = Lod( rsource, ilod );
+            first_range = lod.first_range;
+            num_ranges = lod.num_ranges;
+        }
+        else if( NumPartRanges( rsource ) )
+        {
+            num_ranges = NumPartRanges( rsource );
+        }
+        else
+        {
+            first_range = DefaultRange( rsource );
+        }
+
+        // skinned clones have no meshlets (bounds are in bind pose)
+        uint32_t num_visible_ranges = UINT32_MAX;
+        if( gfx->_meshlet_culling && Meshlets( rsource, first_range ).size() )
+        {
+            num_visible_ranges = CullMeshlets( visible_ranges, MAX_VISIBLE_MESHLET_RANGES, rsource, first_range, num_ranges, matrix_array[i], view_proj, eye );
+            if( num_visible_ranges == 0 )
+                continue;
+        }
+
         RDIXCommandChain chain( cmdbuffer, nullptr );
 
         RDIXResourceBinding* binding = MaterialBinding( idmat_array[i] );
@@ -1482,17 +1722,23 @@ void GFX::GenerateCommandBuffer( GFXFrameContext* fctx, GFXSceneID idscene, GFXC
         chain.AppendCmd<RDIXSetPipelineCmd>( pipeline, false );
         chain.AppendCmd<RDIXSetResourcesCmd>( binding );
         
-        if( RDIXDrawRenderSourceCmd* draw_cmd = chain.AppendCmd<RDIXDrawRenderSourceCmd>() )
+        if( num_visible_ranges != UINT32_MAX )
         {
-            const GFXMeshSkinningData& skinning_data = skinned_mesh_array[i];
-            RDIXRenderSource* rsource = skinning_data.rsource;
-            if( !rsource || skinning_data.pin_index == GFX_DEFAULT_SKINNING_PIN )
+            const uint32_t ranges_size = num_visible_ranges * (uint32_t)sizeof( RDIXRenderSourceRange );
+            if( RDIXDrawRenderSourceRangesCmd* draw_cmd = chain.AppendCmdWithData<RDIXDrawRenderSourceRangesCmd>( ranges_size ) )
             {
-                rsource = (RDIXRenderSource*)RSM::Get( idmesh_array[i] );
+                draw_cmd->rsource = rsource;
+                draw_cmd->num_instances = 1;
+                draw_cmd->num_ranges = (uint16_t)num_visible_ranges;
+                memcpy( draw_cmd->Ranges(), visible_ranges, ranges_size );
             }
-            
-            draw_cmd->rsource = rsource ? rsource : gfx->_fallback_mesh;
+        }
+        else if( RDIXDrawRenderSourceCmd* draw_cmd = chain.AppendCmd<RDIXDrawRenderSourceCmd>() )
+        {
+            draw_cmd->rsource = rsource;
             draw_cmd->num_instances = 1;
+            draw_cmd->rsouce_range = (uint16_t)first_range;
+            draw_cmd->num_ranges = (uint16_t)num_ranges;
         }
 
         GFXSortKey sort_key;
@@ -1546,6 +1792,11 @@ void GFX::SubmitCommandBuffer( GFXFrameContext* fctx, GFXSceneID idscene )
 
     RDIXCommandBuffer* cmdbuffer = sc.command_buffer[scene_index];
     ::SubmitCommandBuffer( fctx->cmdq, cmdbuffer );
+
+    const RDIXDispatchStats& stats = DispatchStats( cmdbuffer );
+    fctx->stats.commands += stats.commands;
+    fctx->stats.binds += stats.binds;
+    fctx->stats.skipped_binds += stats.skipped_binds;
 }
 
 void GFX::PostProcess( GFXFrameContext* fctx, const GFXCameraID idcamera )
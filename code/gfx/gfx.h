@@ -73,6 +73,7 @@ struct GFX
     GFXFrameContext* BeginFrame( RDICommandQueue* cmdq );
     void             EndFrame( GFXFrameContext* fctx );
     void             RasterizeFramebuffer( RDICommandQueue* cmdq, uint32_t texture_index, GFXCameraID idcamera );
+    const GFXFrameStats& LastFrameStats() const;
 
     void GenerateCommandBuffer( GFXFrameContext* fctx, GFXSceneID idscene, GFXCameraID idcamera );
     void SubmitCommandBuffer( GFXFrameContext* fctx, GFXSceneID idscene );
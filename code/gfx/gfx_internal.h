@@ -1,6 +1,7 @@
 #pragma once
 
 #include <foundation/thread/mutex.h>
+#include <foundation/thread/thread_pool.h>
 #include <foundation/string_util.h>
 #include <foundation/id_table.h>
 #include <foundation/id_array.h>
@@ -54,7 +55,7 @@ namespace GFXEMaterialFlag
 }//
 
 
-using IDArray = array_t<id_t>;
+using IDArray = array_t<id_handle_t>;
 using ResourceIDArray = array_t<RSMResourceID>;
 
 struct GFXCameraContainer
@@ -71,8 +72,8 @@ struct GFXCameraContainer
 
     BXIAllocator* _names_allocator = nullptr;
 
-    bool IsAlive( id_t id ) const { return id_array::has( id_alloc, id );  }
-    uint32_t DataIndex( id_t id ) const { return id_array::index( id_alloc, id ); }
+    bool IsAlive( id_handle_t id ) const { return id_array::has( id_alloc, id );  }
+    uint32_t DataIndex( id_handle_t id ) const { return id_array::index( id_alloc, id ); }
     uint32_t Size()
     {
         scope_mutex_t guard( id_lock );
@@ -99,10 +100,11 @@ struct GFXMaterialContainer
     id_table_t<GFX_MAX_MATERIALS> idtable;
     gfx_shader::Material      data    [GFX_MAX_MATERIALS] = {};
     GFXMaterialTexture        textures[GFX_MAX_MATERIALS] = {};
+    RSMSubscription           texture_reload[GFX_MAX_MATERIALS][GFXEMaterialTextureSlot::_COUNT_] = {};
     RDIXResourceBinding*      binding [GFX_MAX_MATERIALS] = {};
     string_t                  name    [GFX_MAX_MATERIALS] = {};
     uint8_t                   flags   [GFX_MAX_MATERIALS] = {};
-    id_t                      idself  [GFX_MAX_MATERIALS] = {};
+    id_handle_t               idself  [GFX_MAX_MATERIALS] = {};
 
     mutex_t to_remove_lock;
     IDArray to_remove;
@@ -110,8 +112,8 @@ struct GFXMaterialContainer
     mutex_t to_refresh_lock;
     IDArray to_refresh;
 
-    bool IsAlive( id_t id ) const { return id_table::has( idtable, id ); }
-    uint32_t DataIndex( id_t id ) const { return id.index; }
+    bool IsAlive( id_handle_t id ) const { return id_table::has( idtable, id ); }
+    uint32_t DataIndex( id_handle_t id ) const { return id.index; }
 };
 
 
@@ -124,13 +126,13 @@ struct GFXSceneContainer
         RSMResourceID* idmesh_resource;
         GFXMeshSkinningData* skinning_data;
         GFXMaterialID* idmat;
-        id_t* idinstance;
+        id_handle_t* idinstance;
     };
        
     struct DeadMeshInstanceID
     {
-        id_t idscene;
-        id_t idinst;
+        id_handle_t idscene;
+        id_handle_t idinst;
     };
     struct SkyData
     {
@@ -171,19 +173,19 @@ struct GFXSceneContainer
     SkyData          sky_data[GFX_MAX_SCENES] = {};
     GFXShadowData    sun_shadow[GFX_MAX_SCENES] = {};
 
-    bool IsSceneAlive( id_t id ) const { return id_table::has( idtable, id ); }
-    bool IsMeshAlive( id_t idscene, id_t id ) const
+    bool IsSceneAlive( id_handle_t id ) const { return id_table::has( idtable, id ); }
+    bool IsMeshAlive( id_handle_t idscene, id_handle_t id ) const
     {
         const bool scene_ok = IsSceneAlive( idscene );
         const bool mesh_ok = id_allocator::has( mesh_idalloc[idscene.index], id );
         return (scene_ok && mesh_ok);
     }
 
-    uint32_t SceneIndexSafe( id_t id )
+    uint32_t SceneIndexSafe( id_handle_t id )
     {
         return IsSceneAlive( id ) ? id.index : UINT32_MAX;
     }
-    uint32_t MeshInstanceIndex( id_t idscene, id_t id )
+    uint32_t MeshInstanceIndex( id_handle_t idscene, id_handle_t id )
     {
         SYS_ASSERT( IsMeshAlive( idscene, id ) );
         return id_allocator::dense_index( mesh_idalloc[idscene.index], id );
@@ -203,10 +205,11 @@ struct GFXPostProcess
 struct GFXFrameContext
 {
     RDICommandQueue* cmdq = nullptr;
+    GFXFrameStats stats = {};
     bool Valid() const { return cmdq != nullptr; }
 };
 
-using IDArray = array_t<id_t>;
+using IDArray = array_t<id_handle_t>;
 struct GFXSystem
 {
     BXIAllocator* _allocator = nullptr;
@@ -215,6 +218,12 @@ struct GFXSystem
     RDIXRenderTarget* _framebuffer = nullptr;
     uint32_t _sync_interval = 0;
 
+    thread_pool_t* _thread_pool = nullptr;
+    bool _owns_thread_pool = false;
+
+    float _lod_pixel_error = 1.f;
+    bool _meshlet_culling = true;
+
     gfx_shader::ShaderSamplers _samplers;
     RDIConstantBuffer _gpu_camera_buffer;
     RDIConstantBuffer _gpu_frame_data_buffer;
@@ -229,15 +238,16 @@ struct GFXSystem
     GFXMaterialID _fallback_idmaterial;
 
     GFXFrameContext _frame_ctx = {};
+    GFXFrameStats   _last_frame_stats = {};
 
     GFXCameraContainer   _camera;
     GFXMaterialContainer _material;
     GFXSceneContainer    _scene;
     GFXPostProcess       _postprocess;
 
-    uint32_t MaterialDataIndex( id_t idmat ) const
+    uint32_t MaterialDataIndex( id_handle_t idmat ) const
     {
-        const id_t fallback_id = { _fallback_idmaterial.i };
+        const id_handle_t fallback_id = { _fallback_idmaterial.i };
         return _material.IsAlive( idmat ) ? _material.DataIndex( idmat ) : _material.DataIndex( fallback_id );
     }
 };
@@ -18,7 +18,7 @@ bool GFXTextureResourceLoader::Load( RSMResourceData* out, const void* data, uin
     texture[0] = CreateTextureFromDDS( gfx->Device(), data, size );
     out->allocator = allocator;
     out->pointer = texture;
-    out->size = sizeof( RDITextureRO );
+    out->size = size; // dds payload holds all mips, close to what lives on gpu
 
     return true;
 }
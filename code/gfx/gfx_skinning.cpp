@@ -170,3 +170,148 @@ uint64_t LocklessLinearStaticAllocator::Clear()
 {
     return std::atomic_exchange( &_offset, 0 );
 }
+
+//
+// CPU skinning kernel
+//
+#include <foundation/math/vmath.h>
+#include <xmmintrin.h>
+
+// 4 x vec3_t (AoS) -> x,y,z (SoA)
+static VEC_FORCE_INLINE void LoadSoA( __m128* x, __m128* y, __m128* z, const vec3_t* src )
+{
+    const float* f = &src->x;
+    const __m128 a = _mm_loadu_ps( f + 0 ); // x0 y0 z0 x1
+    const __m128 b = _mm_loadu_ps( f + 4 ); // y1 z1 x2 y2
+    const __m128 c = _mm_loadu_ps( f + 8 ); // z2 x3 y3 z3
+
+    const __m128 tx = _mm_shuffle_ps( b, c, _MM_SHUFFLE( 1, 0, 0, 2 ) );
+    x[0] = _mm_shuffle_ps( a, tx, _MM_SHUFFLE( 3, 0, 3, 0 ) );
+
+    const __m128 ty0 = _mm_shuffle_ps( a, b, _MM_SHUFFLE( 0, 0, 1, 1 ) );
+    const __m128 ty1 = _mm_shuffle_ps( b, c, _MM_SHUFFLE( 2, 2, 3, 3 ) );
+    y[0] = _mm_shuffle_ps( ty0, ty1, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+
+    const __m128 tz0 = _mm_shuffle_ps( a, b, _MM_SHUFFLE( 1, 1, 2, 2 ) );
+    const __m128 tz1 = _mm_shuffle_ps( c, c, _MM_SHUFFLE( 3, 3, 0, 0 ) );
+    z[0] = _mm_shuffle_ps( tz0, tz1, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+}
+
+// x,y,z (SoA) -> 4 x vec3_t (AoS)
+static VEC_FORCE_INLINE void StoreSoA( vec3_t* dst, __m128 x, __m128 y, __m128 z )
+{
+    const __m128 xy_lo = _mm_unpacklo_ps( x, y ); // x0 y0 x1 y1
+    const __m128 xy_hi = _mm_unpackhi_ps( x, y ); // x2 y2 x3 y3
+
+    const __m128 ta = _mm_shuffle_ps( z, x, _MM_SHUFFLE( 1, 1, 0, 0 ) );
+    const __m128 a = _mm_shuffle_ps( xy_lo, ta, _MM_SHUFFLE( 2, 0, 1, 0 ) );
+
+    const __m128 tb = _mm_shuffle_ps( y, z, _MM_SHUFFLE( 1, 1, 1, 1 ) );
+    const __m128 b = _mm_shuffle_ps( tb, xy_hi, _MM_SHUFFLE( 1, 0, 2, 0 ) );
+
+    const __m128 tc = _mm_shuffle_ps( z, xy_hi, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+    const __m128 c = _mm_shuffle_ps( tc, tc, _MM_SHUFFLE( 1, 3, 2, 0 ) );
+
+    float* f = &dst->x;
+    _mm_storeu_ps( f + 0, a );
+    _mm_storeu_ps( f + 4, b );
+    _mm_storeu_ps( f + 8, c );
+}
+
+// weighted sum of 4 bone matrices, one __m128 per column
+static VEC_FORCE_INLINE void BlendMatrix( __m128 out[4], const mat44_t* matrices, const vec4_t& weights, const uint8_t* indices )
+{
+    const __m128 w = _mm_loadu_ps( weights.xyzw );
+    const __m128 wx = _mm_shuffle_ps( w, w, _MM_SHUFFLE( 0, 0, 0, 0 ) );
+    const __m128 wy = _mm_shuffle_ps( w, w, _MM_SHUFFLE( 1, 1, 1, 1 ) );
+    const __m128 wz = _mm_shuffle_ps( w, w, _MM_SHUFFLE( 2, 2, 2, 2 ) );
+    const __m128 ww = _mm_shuffle_ps( w, w, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+
+    const float* m0 = matrices[indices[0]].c0.xyzw;
+    const float* m1 = matrices[indices[1]].c0.xyzw;
+    const float* m2 = matrices[indices[2]].c0.xyzw;
+    const float* m3 = matrices[indices[3]].c0.xyzw;
+
+    for( uint32_t c = 0; c < 4; ++c )
+    {
+        __m128 acc = _mm_mul_ps( _mm_loadu_ps( m0 + c * 4 ), wx );
+        acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( m1 + c * 4 ), wy ) );
+        acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( m2 + c * 4 ), wz ) );
+        acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( m3 + c * 4 ), ww ) );
+        out[c] = acc;
+    }
+}
+
+static inline void SkinVertexScalar( const GFXSkinningStreamsCPU& s, uint32_t ivertex )
+{
+    const vec4_t& bw = s.blendweights[ivertex];
+    const uint8_t* bi = s.blendindices + ivertex * 4;
+
+    const vec3_t& base_pos = s.base_positions[ivertex];
+    const vec3_t& base_nrm = s.base_normals[ivertex];
+
+    vec3_t skinned_pos( 0.f );
+    vec3_t skinned_nrm( 0.f );
+
+    skinned_pos += mul_as_point( s.matrices[bi[0]], base_pos ) * bw.x;
+    skinned_pos += mul_as_point( s.matrices[bi[1]], base_pos ) * bw.y;
+    skinned_pos += mul_as_point( s.matrices[bi[2]], base_pos ) * bw.z;
+    skinned_pos += mul_as_point( s.matrices[bi[3]], base_pos ) * bw.w;
+
+    skinned_nrm += rotate( s.matrices[bi[0]], base_nrm ) * bw.x;
+    skinned_nrm += rotate( s.matrices[bi[1]], base_nrm ) * bw.y;
+    skinned_nrm += rotate( s.matrices[bi[2]], base_nrm ) * bw.z;
+    skinned_nrm += rotate( s.matrices[bi[3]], base_nrm ) * bw.w;
+
+    s.skinned_positions[ivertex] = skinned_pos;
+    s.skinned_normals[ivertex] = skinned_nrm;
+}
+
+void SkinVerticesCPU( const GFXSkinningStreamsCPU& s, uint32_t begin, uint32_t end )
+{
+    SYS_ASSERT( end <= s.num_vertices );
+
+    uint32_t ivertex = begin;
+    for( ; ivertex + 4 <= end; ivertex += 4 )
+    {
+        // blended matrix per lane, transposed so every register holds one matrix element for 4 vertices
+        __m128 m[4][4];
+        for( uint32_t lane = 0; lane < 4; ++lane )
+        {
+            const uint32_t i = ivertex + lane;
+            BlendMatrix( m[lane], s.matrices, s.blendweights[i], s.blendindices + i * 4 );
+        }
+        for( uint32_t c = 0; c < 4; ++c )
+        {
+            _MM_TRANSPOSE4_PS( m[0][c], m[1][c], m[2][c], m[3][c] );
+        }
+        // m[row][column] now: row 0 = x, row 1 = y, row 2 = z
+
+        __m128 px, py, pz;
+        __m128 nx, ny, nz;
+        LoadSoA( &px, &py, &pz, s.base_positions + ivertex );
+        LoadSoA( &nx, &ny, &nz, s.base_normals + ivertex );
+
+        __m128 out_p[3];
+        __m128 out_n[3];
+        for( uint32_t r = 0; r < 3; ++r )
+        {
+            __m128 rot = _mm_mul_ps( m[r][0], px );
+            rot = _mm_add_ps( rot, _mm_mul_ps( m[r][1], py ) );
+            rot = _mm_add_ps( rot, _mm_mul_ps( m[r][2], pz ) );
+            out_p[r] = _mm_add_ps( rot, m[r][3] );
+
+            __m128 nrm = _mm_mul_ps( m[r][0], nx );
+            nrm = _mm_add_ps( nrm, _mm_mul_ps( m[r][1], ny ) );
+            out_n[r] = _mm_add_ps( nrm, _mm_mul_ps( m[r][2], nz ) );
+        }
+
+        StoreSoA( s.skinned_positions + ivertex, out_p[0], out_p[1], out_p[2] );
+        StoreSoA( s.skinned_normals + ivertex, out_n[0], out_n[1], out_n[2] );
+    }
+
+    for( ; ivertex < end; ++ivertex )
+    {
+        SkinVertexScalar( s, ivertex );
+    }
+}
@@ -2,6 +2,7 @@
 
 #include <foundation/type_compound.h>
 #include <foundation/containers.h>
+#include <foundation/math/vmath_type.h>
 #include <rdi_backend/rdi_backend_type.h>
 
 #include <atomic>
@@ -11,6 +12,7 @@ struct RDICommandQueue;
 struct RDIXRenderSource;
 
 static constexpr uint32_t GFX_DEFAULT_SKINNING_PIN = UINT32_MAX;
+static constexpr uint32_t GFX_SKINNING_CPU_VERTEX_BATCH = 1024 * 2;
 
 
 struct LocklessLinearStaticAllocator
@@ -101,3 +103,19 @@ struct GFXSkinningDataGPU
        
     GFXSkinningPin AcquirePin( uint32_t size_in_bytes );
 };
+
+// mapped streams of single mesh skinned on CPU
+struct GFXSkinningStreamsCPU
+{
+    const mat44_t* matrices = nullptr;
+    const vec4_t*  blendweights = nullptr;
+    const uint8_t* blendindices = nullptr; // 4 per vertex
+    const vec3_t*  base_positions = nullptr;
+    const vec3_t*  base_normals = nullptr;
+    vec3_t*        skinned_positions = nullptr;
+    vec3_t*        skinned_normals = nullptr;
+    uint32_t       num_vertices = 0;
+};
+
+// 4-bone linear blend skinning of vertices in range [begin, end). Runs 4 vertices at the time with SSE.
+void SkinVerticesCPU( const GFXSkinningStreamsCPU& streams, uint32_t begin, uint32_t end );
@@ -5,10 +5,20 @@
 #include <resource_manager/resource_manager.h>
 #include <foundation/string_util.h>
 
+struct thread_pool_t;
 struct GFXDesc
 {
     uint16_t framebuffer_width = 1920;
     uint16_t framebuffer_height = 1080;
+
+    // used for CPU side work (eg. skinning). If null GFX creates its own pool.
+    thread_pool_t* thread_pool = nullptr;
+
+    // mesh LOD is the coarsest one with projected error below this (in framebuffer pixels)
+    float lod_pixel_error = 1.f;
+
+    // meshes compiled with meshlets are culled per instance on CPU (frustum and backface cone)
+    bool meshlet_culling = true;
 };
 
 struct  GFXMaterialResource
@@ -45,6 +55,14 @@ struct GFXSceneDesc
     uint32_t max_renderables = 1024;
 };
 
+// command buffer dispatch counters, summed over all scenes submitted in frame
+struct GFXFrameStats
+{
+    uint32_t commands = 0;
+    uint32_t binds = 0;
+    uint32_t skipped_binds = 0;
+};
+
 using GFXDrawCallback = void( RDICommandQueue* cmdq, void* userdata );
 struct GFXMeshInstanceDesc
 {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 #define MEM_USE_DEBUG_ALLOC 1
 
 
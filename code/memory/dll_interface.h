@@ -1,7 +1,11 @@
 #pragma once
 
+#if defined( _WIN32 )
 #ifdef BX_DLL_memory
 #define MEMORY_PLUGIN_EXPORT __declspec(dllexport)
 #else
 #define MEMORY_PLUGIN_EXPORT __declspec(dllimport)
 #endif
+#else
+#define MEMORY_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
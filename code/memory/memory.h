@@ -3,6 +3,7 @@
 #include "allocator.h"
 
 #include <new>
+#include <utility>
 
 #ifndef alignof
 #define ALIGNOF(x) __alignof(x)
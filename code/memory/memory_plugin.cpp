@@ -9,15 +9,20 @@
 #include <string.h>
 
 #include <mutex>
+#include <atomic>
 #include <list>
 #include <vector>
 #include <algorithm>
 
+#if !defined( _WIN32 )
+#define strncpy_s strncpy
+#endif
+
 namespace bx
 {
     struct AllocatorDlmalloc : BXIAllocator
     {
-        size_t allocated_size = 0;
+        std::atomic<size_t> allocated_size{ 0 }; // allocator is used from worker threads
     };
     inline void ReportAlloc( BXIAllocator* _this, void* ptr )
     {
@@ -30,8 +35,9 @@ namespace bx
     {
         size_t usable_size = dlmalloc_usable_size( ptr );
         AllocatorDlmalloc* alloc = (AllocatorDlmalloc*)_this;
-        assert( alloc->allocated_size >= usable_size );
-        alloc->allocated_size -= usable_size;
+        const size_t prev_size = alloc->allocated_size.fetch_sub( usable_size );
+        assert( prev_size >= usable_size );
+        (void)prev_size;
     }
 
     static void* DefaultAlloc( BXIAllocator* _this, size_t size, size_t align )
@@ -142,7 +148,7 @@ namespace bx
     }
 }
 
-static __declspec(align( sizeof(void*))) bx::AllocatorDlmalloc __default_allocator;
+alignas( sizeof(void*) ) static bx::AllocatorDlmalloc __default_allocator;
 
 extern "C"
 {
@@ -1,4 +1,5 @@
 #include "mesh_component.h"
+#include "../node_serialize.h"
 #include <typeinfo>
 
 NODE_COMP_DEFINE( NODECompMesh );
@@ -32,3 +33,17 @@ void NODECompMesh::OnSerialize( NODE* node, NODETextSerializer* serializer )
 {
 
 }
+
+void NODECompMesh::OnSerialize( NODE* node, NODEBinarySerializer* serializer )
+{
+    if( serializer->is_reader )
+    {
+        ReadString( serializer, &_mesh_resource_path );
+        ReadString( serializer, &_material_name );
+    }
+    else
+    {
+        WriteString( serializer, _mesh_resource_path.c_str() );
+        WriteString( serializer, _material_name.c_str() );
+    }
+}
@@ -13,6 +13,7 @@ struct NODECompMesh : NODEComp
     virtual bool OnAttach      ( NODE* node, NODEAttachContext* ctx ) override;
     virtual void OnDetach      ( NODE* node, NODEAttachContext* ctx ) override;
     virtual void OnSerialize   ( NODE* node, NODETextSerializer* serializer ) override;
+    virtual void OnSerialize   ( NODE* node, NODEBinarySerializer* serializer ) override;
     
     GFXMeshInstanceID _mesh_id;
     RSMResourceID _mesh_resource_id;
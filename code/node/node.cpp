@@ -1,6 +1,7 @@
 #include "node.h"
 #include "node_system_impl.h"
 #include "node_serialize.h"
+#include "node_comp.h"
 
 #include "../memory/memory.h"
 #include "../foundation/array.h"
@@ -38,6 +39,53 @@ NODECompSpan NODE::Components() const
     return to_array_span(_components->begin(), _components->size );
 }
 
+void BuildFlatTree( NODEFlatTree* tree, NODE* root )
+{
+    array::clear( tree->nodes );
+    array::clear( tree->parent );
+    array::clear( tree->first_child );
+    array::clear( tree->next_sibling );
+
+    array::push_back( tree->nodes, root );
+    array::push_back( tree->parent, NODEFlatTree::INVALID );
+
+    // nodes array is the queue, children of each node are pushed together
+    for( u32 i = 0; i < array::size( tree->nodes ); ++i )
+    {
+        const NODESpan children = tree->nodes[i]->Children();
+        const u32 first = array::size( tree->nodes );
+        const u32 count = children.size();
+
+        array::push_back( tree->first_child, ( count ) ? first : NODEFlatTree::INVALID );
+        for( u32 ichild = 0; ichild < count; ++ichild )
+        {
+            array::push_back( tree->nodes, children[ichild] );
+            array::push_back( tree->parent, i );
+        }
+    }
+
+    const u32 num_nodes = array::size( tree->nodes );
+    array::resize( tree->next_sibling, num_nodes );
+    for( u32 i = 0; i < num_nodes; ++i )
+    {
+        const bool has_next = ( i + 1 < num_nodes ) && tree->parent[i] != NODEFlatTree::INVALID && tree->parent[i + 1] == tree->parent[i];
+        tree->next_sibling[i] = ( has_next ) ? i + 1 : NODEFlatTree::INVALID;
+    }
+}
+
+NODESpan Children( const NODEFlatTree& tree, u32 index )
+{
+    const u32 first = tree.first_child[index];
+    if( first == NODEFlatTree::INVALID )
+        return NODESpan();
+
+    u32 count = 1;
+    for( u32 i = first; tree.next_sibling[i] != NODEFlatTree::INVALID; i = tree.next_sibling[i] )
+        ++count;
+
+    return NODESpan( tree.nodes.data + first, count );
+}
+
 
 NODE* NODEContainer::CreateNode( const char* node_name, NODE* parent )
 {
@@ -55,6 +103,11 @@ NODE* NODEContainer::CreateNode( const guid_t& guid, const char* node_name, NODE
     return node;
 }
 
+void NODEContainer::CreateNodes( NODE** out_nodes, const NODECreateDesc* descs, u32 count, NODE* parent )
+{
+    impl->CreateNodes( out_nodes, descs, count, ( parent ) ? parent : impl->_root );
+}
+
 void NODEContainer::DestroyNode( NODE** hnode )
 {
     if( !hnode[0] )
@@ -86,7 +139,12 @@ void NODEContainer::UnlinkNode( NODE* child )
 
 NODEComp* NODEContainer::CreateComponent( NODE* parent, const char* type_name )
 {
-    return impl->CreateComponent( parent, type_name );
+    return impl->CreateComponent( parent, NODECompAlloc( type_name ) );
+}
+
+NODEComp* NODEContainer::CreateComponent( NODE* parent, u64 type_hash_code )
+{
+    return impl->CreateComponent( parent, NODECompAlloc( type_hash_code ) );
 }
 
 void NODEContainer::DestroyComponent( NODEComp** comp )
@@ -118,8 +176,9 @@ void NODEContainer::Tick( NODESystemContext* ctx, f32 dt )
     NODEAttachContext attach_ctx;
     InitContext( &attach_ctx, ctx );
 
-    impl->UninitializePendingComponents( &init_ctx );
     impl->DetachPendingComponents( &attach_ctx );
+    impl->UninitializePendingComponents( &init_ctx );
+    impl->DestroyPendingComponents( ctx );
     impl->DestroyPendingNodes( ctx );
 
     impl->InitializePendingComponents( &init_ctx );
@@ -11,6 +11,7 @@ struct NODEContainer
 {
     NODE* CreateNode( const char* node_name, NODE* parent = nullptr );
     NODE* CreateNode( const guid_t& guid, const char* node_name, NODE* parent = nullptr );
+    void  CreateNodes( NODE** out_nodes, const NODECreateDesc* descs, u32 count, NODE* parent = nullptr );
     void DestroyNode( NODE** node );
 
     void SetName( NODE* node, const char* name );
@@ -18,8 +19,9 @@ struct NODEContainer
     void UnlinkNode( NODE* child );
 
     NODEComp* CreateComponent( NODE* parent, const char* type_name );
+    NODEComp* CreateComponent( NODE* parent, u64 type_hash_code );
     template< typename T >
-    T* CreateComponent( NODE* parent ) {  return CreateComponent( parent, T::TypeNameStatic() ); }
+    T* CreateComponent( NODE* parent ) {  return (T*)CreateComponent( parent, T::__type_info.type_hash_code ); }
     
     void DestroyComponent( NODEComp** comp );
 
@@ -46,6 +48,7 @@ struct NODE
 
     const guid_t&  Guid () const { return _guid; }
     u32            Index() const { return _index; }
+    const NODEFlags& Flags() const { return _flags; }
 
     const char* Name  () const { return _name; }
           NODE* Parent()       { return _parent; }
@@ -70,6 +73,20 @@ private:
     friend struct NODEContainerImpl;
 };
 
+// Breadth first snapshot of a branch. Children of a node are packed next to each other,
+// so they are nodes[first_child[i]] and following ones linked with next_sibling.
+struct NODEFlatTree
+{
+    static constexpr u32 INVALID = UINT32_MAX;
+
+    array_t<NODE*> nodes;
+    array_t<u32>   parent;
+    array_t<u32>   first_child;
+    array_t<u32>   next_sibling;
+};
+void     BuildFlatTree( NODEFlatTree* tree, NODE* root );
+NODESpan Children( const NODEFlatTree& tree, u32 index );
+
 struct NODEComp
 {
     virtual ~NODEComp() {}
@@ -79,6 +96,17 @@ struct NODEComp
     virtual void OnDetach      ( NODE* node, NODEAttachContext* ctx ) {}
     virtual void OnTick        ( NODE* node, NODETickContext* ctx ) {}
     virtual void OnSerialize   ( NODE* node, NODETextSerializer* serializer ) {}
+    virtual void OnSerialize   ( NODE* node, NODEBinarySerializer* serializer ) {}
+
+    // Optional type level hooks. Called once per Tick on one component of the type with all pending
+    // components of that type. Returning false falls back to calling per component hooks above.
+    virtual bool OnInitializeBatch  ( NODECompBatch batch, NODEInitContext* ctx ) { return false; }
+    virtual bool OnUninitializeBatch( NODECompBatch batch, NODEInitContext* ctx ) { return false; }
+    virtual bool OnAttachBatch      ( NODECompBatch batch, NODEAttachContext* ctx ) { return false; }
+    virtual bool OnDetachBatch      ( NODECompBatch batch, NODEAttachContext* ctx ) { return false; }
+
+    // true when hooks of this type can run concurrently with hooks of other types
+    virtual bool IsThreadSafe() const { return false; }
 
     virtual u64 TypeHashCode() const = 0;
     virtual const char* TypeName() const = 0;
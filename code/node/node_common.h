@@ -36,10 +36,12 @@ struct NODEFlags
 
 struct NODEContainer;
 struct GFX;
+struct thread_pool_t;
 struct NODESystemContext
 {
     BXIFilesystem* fsys;
     GFX* gfx;
+    thread_pool_t* pool = nullptr; // optional, thread safe component types are processed in parallel
 };
 
 struct NODEInitContext : NODESystemContext
@@ -56,10 +58,27 @@ struct NODETickContext : NODESystemContext
 };
 
 struct NODETextSerializer;
+struct NODEBinarySerializer;
 struct NODE;
 struct NODEComp;
 
 using NODEGuid = guid_t;
+
+// bulk creation, parent is index of earlier desc in the same batch or UINT32_MAX for batch parent
+struct NODECreateDesc
+{
+    guid_t guid;
+    const char* name = nullptr;
+    u32 parent = UINT32_MAX;
+};
 using NODESpan = array_span_t<NODE*>;
 using NODECompSpan = array_span_t<NODEComp*>;
 
+// pending components of one type with their nodes
+struct NODECompBatch
+{
+    NODEComp** comps;
+    NODE** nodes;
+    u32 size;
+};
+
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../foundation/type.h"
+#include "../foundation/hashed_string.h"
 
 struct NODEComp;
 
@@ -23,6 +24,7 @@ struct NODEComp__TypeInfo
     using Destructor = void( NODEComp* comp );
     const u64 type_hash_code;
     const char* name;
+    const hashed_string_t name_hash;
     const u32 alignment;
     const u32 size;
     const u32 num_chunks;
@@ -31,7 +33,7 @@ struct NODEComp__TypeInfo
     Destructor* const destructor;
 
     NODEComp__TypeInfo( u64 t_hashcode, const char* n, u32 align, u32 siz, u32 nchunks, Constructor ctor, Destructor dtor )
-        : type_hash_code( t_hashcode ), name( n ), alignment( align ), size( siz ), num_chunks( nchunks ), constructor( ctor ), destructor( dtor )
+        : type_hash_code( t_hashcode ), name( n ), name_hash( hashed_string( n ) ), alignment( align ), size( siz ), num_chunks( nchunks ), constructor( ctor ), destructor( dtor )
     {
         NODECompRegisterType( this );
     }
@@ -26,6 +26,7 @@ struct NODECompTypeRegistry
     static_array_t<NODECompAllocator, MAX_TYPES> type_allocator;
     static_array_t<rw_spin_lock_t, MAX_TYPES> type_lock;
     hash_t<const NODECompTypeDesc*> hash_code_map;
+    hash_t<const NODECompTypeDesc*> name_hash_map;
 
     mutex_t lock;
 };
@@ -55,8 +56,10 @@ void NODECompRegisterType( const NODEComp__TypeInfo* tinfo )
     
     SYS_ASSERT( reg->type_allocator.size == reg->type_desc.size );
     SYS_ASSERT( hash::has( reg->hash_code_map, tinfo->type_hash_code ) == false );
+    SYS_ASSERT( hash::has( reg->name_hash_map, tinfo->name_hash ) == false );
     
     hash::set( reg->hash_code_map, tinfo->type_hash_code, (const NODECompTypeDesc*)&desc );
+    hash::set( reg->name_hash_map, tinfo->name_hash, (const NODECompTypeDesc*)&desc );
     
     reg->lock.unlock();
 
@@ -69,16 +72,16 @@ void NODECompRegisterType( const NODEComp__TypeInfo* tinfo )
 const NODECompTypeDesc* FindType( const char* name )
 {
     NODECompTypeRegistry* reg = TypeReg();
-    for( const NODECompTypeDesc& desc : reg->type_desc )
+    const NODECompTypeDesc* null_info = nullptr;
+    const NODECompTypeDesc* desc = hash::get( reg->name_hash_map, hashed_string( name ), null_info );
+
+    if( !desc || !string::equal( desc->info->name, name ) )
     {
-        if( string::equal( desc.info->name, name ) )
-        {
-            return &desc;
-        }
+        SYS_LOG_ERROR( "NODEComp type '%s' not found!", name );
+        return nullptr;
     }
 
-    SYS_LOG_ERROR( "NODEComp type '%s' not found!", name );
-    return nullptr;
+    return desc;
 }
 
 const NODECompTypeDesc* FindType( u64 hash_code )
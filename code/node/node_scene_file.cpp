@@ -0,0 +1,419 @@
+#include "node_scene_file.h"
+#include "node_serialize.h"
+#include "node.h"
+#include "node_system_impl.h"
+#include "filesystem/filesystem_plugin.h"
+#include "foundation/array.h"
+#include "foundation/hashmap.h"
+#include "foundation/buffer.h"
+#include "foundation/string_util.h"
+#include "../3rd_party/pugixml/pugixml.hpp"
+
+SRL_TYPE_DEFINE( NODESceneFile );
+
+bool IsBinarySceneFile( const char* filename )
+{
+    const char* ext = strrchr( filename, '.' );
+    return ext && string::equal( ext + 1, NODE_SCENE_FILE_EXT );
+}
+
+bool Write( NODEBinarySerializer* serializer, const void* data, u32 size )
+{
+    SYS_ASSERT( !serializer->is_reader );
+    array_t<u8>& output = *serializer->output;
+    const u32 offset = array::size( output );
+    array::resize( output, offset + size );
+    memcpy( array::begin( output ) + offset, data, size );
+    return true;
+}
+
+bool WriteString( NODEBinarySerializer* serializer, const char* value )
+{
+    const u32 size = (u32)( ( value ) ? strlen( value ) + 1 : 1 );
+    return Write( serializer, &size, sizeof( u32 ) ) && Write( serializer, ( value ) ? value : "", size );
+}
+
+bool Read( NODEBinarySerializer* serializer, void* data, u32 size )
+{
+    SYS_ASSERT( serializer->is_reader );
+    if( serializer->input_offset + size > serializer->input_size )
+        return false;
+
+    memcpy( data, serializer->input + serializer->input_offset, size );
+    serializer->input_offset += size;
+    return true;
+}
+
+bool ReadString( NODEBinarySerializer* serializer, string_t* value )
+{
+    u32 size = 0;
+    if( !Read( serializer, &size, sizeof( u32 ) ) || size == 0 )
+        return false;
+
+    if( serializer->input_offset + size > serializer->input_size )
+        return false;
+
+    const char* str = (const char*)serializer->input + serializer->input_offset;
+    if( str[size - 1] != 0 )
+        return false;
+
+    string::create( value, str, serializer->allocator );
+    serializer->input_offset += size;
+    return true;
+}
+
+//
+// writer
+//
+namespace
+{
+    struct SceneComp
+    {
+        u32 type;
+        u32 node;
+        const NODE* owner;
+        const NODEComp* comp;
+    };
+
+    struct SceneBuilder
+    {
+        SceneBuilder( BXIAllocator* allocator )
+            : nodes( allocator ), strings( allocator ), type_names( allocator ), comps( allocator )
+        {}
+
+        array_t<NODESceneNode> nodes;
+        array_t<char> strings;
+        array_t<u32> type_names;    // offsets in strings
+        array_t<SceneComp> comps;
+    };
+
+    static u32 AddString( SceneBuilder* builder, const char* str )
+    {
+        str = ( str ) ? str : "";
+        const u32 offset = array::size( builder->strings );
+        const u32 size = (u32)strlen( str ) + 1;
+        array::resize( builder->strings, offset + size );
+        memcpy( array::begin( builder->strings ) + offset, str, size );
+        return offset;
+    }
+
+    static u32 AddNode( SceneBuilder* builder, const guid_t& guid, const char* name, u32 parent )
+    {
+        NODESceneNode scene_node;
+        scene_node.guid = guid;
+        scene_node.parent = parent;
+        scene_node.name = AddString( builder, name );
+        return array::push_back( builder->nodes, scene_node );
+    }
+
+    static u32 FindOrAddType( SceneBuilder* builder, const char* type_name )
+    {
+        for( u32 i = 0; i < array::size( builder->type_names ); ++i )
+        {
+            if( string::equal( array::begin( builder->strings ) + builder->type_names[i], type_name ) )
+                return i;
+        }
+        return array::push_back( builder->type_names, AddString( builder, type_name ) );
+    }
+
+    static void AddNodeR( SceneBuilder* builder, const NODE* node, u32 parent )
+    {
+        const u32 index = AddNode( builder, node->Guid(), node->Name(), parent );
+        for( const NODEComp* comp : node->Components() )
+        {
+            SceneComp scene_comp;
+            scene_comp.type = FindOrAddType( builder, comp->TypeName() );
+            scene_comp.node = index;
+            scene_comp.owner = node;
+            scene_comp.comp = comp;
+            array::push_back( builder->comps, scene_comp );
+        }
+
+        for( const NODE* child : node->Children() )
+        {
+            AddNodeR( builder, child, index );
+        }
+    }
+
+    static srl_file_t* BuildSceneFile( const SceneBuilder& builder, BXIAllocator* allocator )
+    {
+        const u32 num_nodes = array::size( builder.nodes );
+        const u32 num_types = array::size( builder.type_names );
+        const u32 num_comps = array::size( builder.comps );
+
+        // component data grouped by type
+        array_t<u8> comp_data( allocator );
+        array_t<u32> comp_nodes( allocator );
+        array_t<u32> comp_data_offsets( allocator );
+        array_t<u32> type_first_comp( allocator );
+        array_t<u32> type_data_begin( allocator );
+        array::reserve( comp_nodes, num_comps );
+        array::reserve( comp_data_offsets, num_comps + num_types );
+
+        NODEBinarySerializer writer;
+        writer.output = &comp_data;
+        writer.allocator = allocator;
+        writer.is_reader = 0;
+
+        for( u32 itype = 0; itype < num_types; ++itype )
+        {
+            const u32 data_begin = array::size( comp_data );
+            array::push_back( type_first_comp, array::size( comp_nodes ) );
+            array::push_back( type_data_begin, data_begin );
+
+            for( const SceneComp& scene_comp : builder.comps )
+            {
+                if( scene_comp.type != itype )
+                    continue;
+
+                array::push_back( comp_nodes, scene_comp.node );
+                array::push_back( comp_data_offsets, array::size( comp_data ) - data_begin );
+
+                // serialization doesn't modify anything, interface is shared with reading
+                NODEComp* comp = const_cast<NODEComp*>( scene_comp.comp );
+                comp->OnSerialize( const_cast<NODE*>( scene_comp.owner ), &writer );
+            }
+            array::push_back( comp_data_offsets, array::size( comp_data ) - data_begin );
+        }
+        array::push_back( type_first_comp, array::size( comp_nodes ) );
+        array::push_back( type_data_begin, array::size( comp_data ) );
+
+        const u32 nodes_size = num_nodes * sizeof( NODESceneNode );
+        const u32 types_size = num_types * sizeof( NODESceneCompType );
+        const u32 comp_nodes_size = array::size_in_bytes( comp_nodes );
+        const u32 comp_data_offsets_size = array::size_in_bytes( comp_data_offsets );
+        const u32 comp_data_size = array::size_in_bytes( comp_data );
+        const u32 strings_size = array::size_in_bytes( builder.strings );
+
+        u32 memory_size = 0;
+        memory_size += sizeof( NODESceneFile );
+        memory_size += nodes_size;
+        memory_size += types_size;
+        memory_size += comp_nodes_size;
+        memory_size += comp_data_offsets_size;
+        memory_size += comp_data_size;
+        memory_size += strings_size;
+
+        u8* memory = (u8*)BX_MALLOC( allocator, memory_size, 16 );
+        memset( memory, 0, memory_size );
+
+        BufferChunker chunker( memory, memory_size );
+        NODESceneFile* file = chunker.Add<NODESceneFile>();
+        NODESceneNode* nodes = chunker.Add<NODESceneNode>( num_nodes, 4 );
+        NODESceneCompType* types = chunker.Add<NODESceneCompType>( num_types );
+        u32* comp_nodes_address = chunker.Add<u32>( array::size( comp_nodes ) );
+        u32* comp_data_offsets_address = chunker.Add<u32>( array::size( comp_data_offsets ) );
+        u8* comp_data_address = chunker.Add<u8>( comp_data_size );
+        char* strings_address = chunker.Add<char>( strings_size );
+        chunker.Check();
+
+        memcpy( nodes, array::begin( builder.nodes ), nodes_size );
+        memcpy( comp_nodes_address, array::begin( comp_nodes ), comp_nodes_size );
+        memcpy( comp_data_offsets_address, array::begin( comp_data_offsets ), comp_data_offsets_size );
+        memcpy( comp_data_address, array::begin( comp_data ), comp_data_size );
+        memcpy( strings_address, array::begin( builder.strings ), strings_size );
+
+        file->numNodes = num_nodes;
+        file->numCompTypes = num_types;
+        file->offsetNodes = TYPE_POINTER_GET_OFFSET( &file->offsetNodes, nodes );
+        file->offsetCompTypes = TYPE_POINTER_GET_OFFSET( &file->offsetCompTypes, types );
+        file->offsetStrings = TYPE_POINTER_GET_OFFSET( &file->offsetStrings, strings_address );
+        file->stringsSize = strings_size;
+
+        for( u32 itype = 0; itype < num_types; ++itype )
+        {
+            NODESceneCompType& type = types[itype];
+            const u32 first_comp = type_first_comp[itype];
+
+            type.typeName = builder.type_names[itype];
+            type.numComps = type_first_comp[itype + 1] - first_comp;
+            type.offsetNodeIndices = TYPE_POINTER_GET_OFFSET( &type.offsetNodeIndices, comp_nodes_address + first_comp );
+            type.offsetDataOffsets = TYPE_POINTER_GET_OFFSET( &type.offsetDataOffsets, comp_data_offsets_address + first_comp + itype );
+            type.offsetData = TYPE_POINTER_GET_OFFSET( &type.offsetData, comp_data_address + type_data_begin[itype] );
+            type.dataSize = type_data_begin[itype + 1] - type_data_begin[itype];
+        }
+
+        srl_file_t* output = srl_file::serialize<NODESceneFile>( file, memory_size, allocator );
+        BX_FREE( allocator, memory );
+        return output;
+    }
+
+    static bool WriteSceneFile( const char* filename, const SceneBuilder& builder, BXIFilesystem* fsys, BXIAllocator* allocator )
+    {
+        srl_file_t* file = BuildSceneFile( builder, allocator );
+        const int32_t result = WriteFileSync( fsys, filename, file, file->size );
+        BX_FREE( allocator, file );
+        return result >= 0;
+    }
+}//
+
+bool WriteSceneFile( const char* filename, const NODE* root, BXIFilesystem* fsys, BXIAllocator* allocator )
+{
+    SceneBuilder builder( allocator );
+    AddNodeR( &builder, root, UINT32_MAX );
+    return WriteSceneFile( filename, builder, fsys, allocator );
+}
+
+//
+// reader
+//
+namespace
+{
+    // whole file is checked before any node is created, so bad scene never leaves half built tree
+    static bool ValidateSceneFile( const NODESceneFile* file )
+    {
+        if( file->numNodes == 0 )
+        {
+            SYS_LOG_ERROR( "Scene has no nodes" );
+            return false;
+        }
+
+        // node 0 is the only root, every other node comes after its parent
+        const NODESceneNode* scene_nodes = SceneNodes( file );
+        for( u32 i = 0; i < file->numNodes; ++i )
+        {
+            const u32 parent = scene_nodes[i].parent;
+            const bool parent_ok = ( i == 0 ) ? parent == UINT32_MAX : parent < i;
+            if( !parent_ok || scene_nodes[i].name >= file->stringsSize )
+            {
+                SYS_LOG_ERROR( "Scene node %u is invalid (parent: %u)", i, parent );
+                return false;
+            }
+        }
+
+        const NODESceneCompType* types = SceneCompTypes( file );
+        for( u32 itype = 0; itype < file->numCompTypes; ++itype )
+        {
+            const NODESceneCompType& type = types[itype];
+            if( type.typeName >= file->stringsSize )
+            {
+                SYS_LOG_ERROR( "Scene component type %u has invalid name", itype );
+                return false;
+            }
+
+            const u32* node_indices = NodeIndices( &type );
+            const u32* data_offsets = DataOffsets( &type );
+            for( u32 icomp = 0; icomp < type.numComps; ++icomp )
+            {
+                if( node_indices[icomp] >= file->numNodes || data_offsets[icomp] > data_offsets[icomp + 1] || data_offsets[icomp + 1] > type.dataSize )
+                {
+                    SYS_LOG_ERROR( "Scene component %u of type '%s' is invalid", icomp, SceneString( file, type.typeName ) );
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}//
+
+NODE* ReadSceneTree( NODEContainerImpl* node_sys, const NODESceneFile* file, BXIAllocator* allocator )
+{
+    if( !ValidateSceneFile( file ) )
+        return nullptr;
+
+    const NODESceneNode* scene_nodes = SceneNodes( file );
+
+    // scene node table has the same layout as bulk creation descs
+    array_t<NODECreateDesc> descs( allocator );
+    array::resize( descs, file->numNodes );
+    for( u32 i = 0; i < file->numNodes; ++i )
+    {
+        descs[i].guid = scene_nodes[i].guid;
+        descs[i].name = SceneString( file, scene_nodes[i].name );
+        descs[i].parent = scene_nodes[i].parent;
+    }
+
+    array_t<NODE*> nodes( allocator );
+    array::resize( nodes, file->numNodes );
+    node_sys->CreateNodes( array::begin( nodes ), array::begin( descs ), file->numNodes, nullptr );
+
+    const NODESceneCompType* types = SceneCompTypes( file );
+    for( u32 itype = 0; itype < file->numCompTypes; ++itype )
+    {
+        const NODESceneCompType& type = types[itype];
+        const char* type_name = SceneString( file, type.typeName );
+        const u32* node_indices = NodeIndices( &type );
+        const u32* data_offsets = DataOffsets( &type );
+        const u8* data = CompData( &type );
+
+        for( u32 icomp = 0; icomp < type.numComps; ++icomp )
+        {
+            NODE* node = nodes[node_indices[icomp]];
+            NODEComp* comp = node_sys->CreateComponent( node, type_name );
+            if( !comp )
+            {
+                SYS_LOG_ERROR( "Unknown component type '%s' in scene", type_name );
+                break;
+            }
+
+            NODEBinarySerializer reader;
+            reader.input = data + data_offsets[icomp];
+            reader.input_size = data_offsets[icomp + 1] - data_offsets[icomp];
+            reader.allocator = allocator;
+            reader.is_reader = 1;
+            comp->OnSerialize( node, &reader );
+        }
+    }
+
+    return nodes[0];
+}
+
+const NODESceneFile* LoadSceneFile( BXFileWaitResult* file, const char* filename, BXIFilesystem* fsys, BXIAllocator* allocator )
+{
+    file[0] = LoadFileSync( fsys, filename, BXEFIleMode::BIN, allocator );
+    if( file->status != BXEFileStatus::READY )
+        return nullptr;
+
+    const srl_file_t* srl_file = (const srl_file_t*)file->file.bin;
+    if( srl_file->tag != NODESceneFile::TAG || srl_file->version != NODESceneFile::VERSION )
+    {
+        SYS_LOG_ERROR( "Scene file (%s) has wrong tag or version", filename );
+        return nullptr;
+    }
+
+    return srl_file->data<NODESceneFile>();
+}
+
+//
+// converter
+//
+bool ConvertSceneXmlToBinary( const char* xml_filename, const char* scene_filename, BXIFilesystem* fsys, BXIAllocator* allocator )
+{
+    NODETextSerializer serializer;
+    if( !ReadFromFile( &serializer, xml_filename, fsys, allocator ) )
+        return false;
+
+    NODEXml xml_nodes = serializer.xml_root.child( "NODE" );
+    if( xml_nodes.empty() )
+        return false;
+
+    SceneBuilder builder( allocator );
+    hash_t<u32, guid_t> guid_to_index( allocator );
+
+    // xml nodes are written in depth first order, so parent is always known before its children
+    for( NODEXml xml_node : xml_nodes.children() )
+    {
+        guid_t guid;
+        FromString( &guid, xml_node.attribute( "guid" ).as_string() );
+
+        u32 parent = UINT32_MAX;
+        auto parent_attr = xml_node.attribute( "parent" );
+        if( !parent_attr.empty() )
+        {
+            guid_t parent_guid;
+            FromString( &parent_guid, parent_attr.as_string() );
+            parent = hash::get( guid_to_index, parent_guid, UINT32_MAX );
+            if( parent == UINT32_MAX )
+            {
+                SYS_LOG_ERROR( "XML scene (%s): parent of node '%s' not found", xml_filename, xml_node.attribute( "name" ).as_string() );
+                return false;
+            }
+        }
+
+        const u32 index = AddNode( &builder, guid, xml_node.attribute( "name" ).as_string(), parent );
+        hash::set( guid_to_index, guid, index );
+    }
+
+    return WriteSceneFile( scene_filename, builder, fsys, allocator );
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../foundation/type.h"
+#include "../foundation/serializer.h"
+#include "../foundation/tag.h"
+#include "../util/guid.h"
+
+// Binary scene. Whole file is one memory block with offsets only, so it's used in place after load.
+// Nodes are stored in depth first order (parent always before its children), first node is the root.
+struct NODESceneNode
+{
+    guid_t guid;
+    u32 parent; // index in node table, UINT32_MAX for root
+    u32 name;   // offset in string pool
+};
+
+// all components of one type
+struct NODESceneCompType
+{
+    u32 typeName;           // offset in string pool
+    u32 numComps;
+    u32 offsetNodeIndices;  // u32 node index per component
+    u32 offsetDataOffsets;  // numComps + 1 offsets in data, component 'i' is [dataOffsets[i], dataOffsets[i+1])
+    u32 offsetData;         // data written by NODEComp::OnSerialize
+    u32 dataSize;
+};
+
+struct NODESceneFile
+{
+    static constexpr u32 VERSION = BX_UTIL_MAKE_VERSION( 1, 0, 0 );
+    static constexpr u32 TAG = BX_UTIL_TAG32( 'S', 'C', 'N', 'E' );
+
+    u32 numNodes;
+    u32 numCompTypes;
+    u32 offsetNodes;
+    u32 offsetCompTypes;
+    u32 offsetStrings;
+    u32 stringsSize;
+
+    SRL_TYPE( NODESceneFile,
+        SRL_PROPERTY( numNodes );
+        SRL_PROPERTY( numCompTypes );
+        SRL_PROPERTY( offsetNodes );
+        SRL_PROPERTY( offsetCompTypes );
+        SRL_PROPERTY( offsetStrings );
+        SRL_PROPERTY( stringsSize );
+    );
+};
+
+inline const NODESceneNode*     SceneNodes    ( const NODESceneFile* file ) { return TYPE_OFFSET_GET_POINTER( NODESceneNode, file->offsetNodes ); }
+inline const NODESceneCompType* SceneCompTypes( const NODESceneFile* file ) { return TYPE_OFFSET_GET_POINTER( NODESceneCompType, file->offsetCompTypes ); }
+inline const char*              SceneString   ( const NODESceneFile* file, u32 offset ) { return TYPE_OFFSET_GET_POINTER( char, file->offsetStrings ) + offset; }
+
+inline const u32* NodeIndices( const NODESceneCompType* type ) { return TYPE_OFFSET_GET_POINTER( u32, type->offsetNodeIndices ); }
+inline const u32* DataOffsets( const NODESceneCompType* type ) { return TYPE_OFFSET_GET_POINTER( u32, type->offsetDataOffsets ); }
+inline const u8*  CompData   ( const NODESceneCompType* type ) { return TYPE_OFFSET_GET_POINTER( u8, type->offsetData ); }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../foundation/type.h"
+#include "../foundation/containers.h"
 #include "../util/guid.h"
 #include "../3rd_party/pugixml/pugixml.hpp"
 
@@ -29,6 +30,7 @@ struct NODE;
 struct NODEContainerImpl;
 struct BXIAllocator;
 struct BXIFilesystem;
+struct string_t;
 
 struct NODETextSerializer
 {
@@ -43,3 +45,36 @@ bool ReadFromFile( NODETextSerializer* serializer, const char* filename, BXIFile
 
 void WriteNodeTree( NODEXml parent, const NODE* root );
 NODE* ReadNodeTree( NODEContainerImpl* node_sys, const NODEXml xml_root );
+
+// Binary scene (see node_scene_file.h). Files with NODE_SCENE_FILE_EXT extension are read and written
+// in binary form by NODEContainer::Serialize/Unserialize, everything else goes through xml.
+static constexpr char NODE_SCENE_FILE_EXT[] = "scene";
+bool IsBinarySceneFile( const char* filename );
+
+// component data in binary scene, values have to be read in the same order they were written
+struct NODEBinarySerializer
+{
+    array_t<u8>* output = nullptr;
+    const u8* input = nullptr;
+    u32 input_size = 0;
+    u32 input_offset = 0;
+    BXIAllocator* allocator = nullptr;
+    u32 is_reader : 1;
+};
+
+bool Write      ( NODEBinarySerializer* serializer, const void* data, u32 size );
+bool WriteString( NODEBinarySerializer* serializer, const char* value );
+bool Read       ( NODEBinarySerializer* serializer, void* data, u32 size );
+bool ReadString ( NODEBinarySerializer* serializer, string_t* value );
+
+struct NODESceneFile;
+struct BXFileWaitResult;
+
+bool WriteSceneFile( const char* filename, const NODE* root, BXIFilesystem* fsys, BXIAllocator* allocator );
+
+// returns scene stored in file memory or null when file can't be loaded or has wrong tag/version, file has to be closed by caller
+const NODESceneFile* LoadSceneFile( BXFileWaitResult* file, const char* filename, BXIFilesystem* fsys, BXIAllocator* allocator );
+NODE* ReadSceneTree( NODEContainerImpl* node_sys, const NODESceneFile* scene, BXIAllocator* allocator );
+
+// offline conversion between xml and binary scene, nodes are converted without creating them in container
+bool ConvertSceneXmlToBinary( const char* xml_filename, const char* scene_filename, BXIFilesystem* fsys, BXIAllocator* allocator );
@@ -7,13 +7,14 @@
 #include "../foundation/hashmap.h"
 #include "../foundation/hash.h"
 #include "../foundation/bitset.h"
+#include "../foundation/common.h"
+#include "../foundation/thread/thread_pool.h"
 #include "node_serialize.h"
+#include "node_scene_file.h"
+#include "../filesystem/filesystem_plugin.h"
 #include "node_comp.h"
 
-inline u32 CalcHash( const guid_t& guid )
-{
-    return murmur3_hash32( &guid, sizeof( guid_t ), 2166136261 );
-}
+#include <algorithm>
 
 void NODEContainerImpl::StartUp( BXIAllocator* alloc )
 {
@@ -26,12 +27,12 @@ void NODEContainerImpl::ShutDown()
 {
 }
 
-NODE* NODEContainerImpl::_AllocateNode()
+NODE* NODEContainerImpl::_AllocateNode( u32 children_capacity )
 {
     void* memory = BX_MALLOC( _node_allocator, sizeof( NODE ), sizeof( void* ) );
     memset( memory, 0x00, sizeof( NODE ) );
     NODE* node = new(memory) NODE();
-    c_array::reserve( node->_children, 4, _allocator );
+    c_array::reserve( node->_children, max_of_2( children_capacity, 1u ), _allocator );
     c_array::reserve( node->_components, 4, _allocator );
 
     return node;
@@ -50,8 +51,9 @@ void NODEContainerImpl::_FreeNode( NODE* node )
 
 NODE* NODEContainerImpl::FindParent( NODEComp* comp )
 {
-    SYS_ASSERT( false );
-    return nullptr;
+    scoped_read_spin_lock_t guard( _comp_lock );
+    SYS_ASSERT( comp->_scene_index < _comp_owner.size );
+    return _comp_owner[comp->_scene_index];
 }
 
 NODE* NODEContainerImpl::FindNode( const guid_t& guid )
@@ -99,62 +101,43 @@ void NODEContainerImpl::DestroyPendingNodes( NODESystemContext* ctx )
 
 void NODEContainerImpl::_DestroyNode( NODESystemContext* ctx, NODE* node )
 {
-    u32 num_nodes_in_branch = 0;
-    u32 num_comps_in_branch = 0;
+    // breadth first order, so popping from back destroys children before their parents
+    NODEFlatTree tree;
+    BuildFlatTree( &tree, node );
+    array_t<NODE*>& nodes_to_destroy = tree.nodes;
 
-    helper::TraverseTree( node, [&num_nodes_in_branch]( const NODE* nod )
-    {
-        num_nodes_in_branch += 1;
-    } );
-    helper::TraverseTree( node, [&num_comps_in_branch]( const NODE* nod )
+    u32 num_comps_in_branch = 0;
+    for( const NODE* nod : nodes_to_destroy )
     {
         num_comps_in_branch += nod->Components().size();
-    } );
+    }
 
-    array_t<NODE*> nodes_to_destroy;
     array_t<NODEComp*> comps_to_destroy;
-
-    array::reserve( nodes_to_destroy, num_nodes_in_branch );
     array::reserve( comps_to_destroy, num_comps_in_branch );
-
-    helper::TraverseTree( node, [&nodes_to_destroy]( NODE* node )
-    {
-        array::push_back( nodes_to_destroy, node );
-    } );
-
-    helper::TraverseTree( node, [&comps_to_destroy]( NODE* node )
+    for( NODE* nod : nodes_to_destroy )
     {
-        for( NODEComp* comp : node->Components() )
+        for( NODEComp* comp : nod->Components() )
         {
             array::push_back( comps_to_destroy, comp );
         }
-    } );
-
-    NODEAttachContext detach_ctx;
-    NODEInitContext uninit_ctx;
-    InitContext( &detach_ctx, ctx );
-    InitContext( &uninit_ctx, ctx );
+    }
 
     while( !array::empty( comps_to_destroy ) )
     {
         NODEComp* comp = array::back( comps_to_destroy );
         array::pop_back( comps_to_destroy );
 
-        NODE* parent_node = FindParent( comp );
-
-        comp->OnDetach( parent_node, &detach_ctx );
-        comp->OnUninitialize( parent_node, &uninit_ctx );
-
-        NODECompFree( comp );
+        _DestroyComponent( ctx, comp, FindParent( comp ) );
     }
 
+    // children are freed together with the branch, only branch root has to be unlinked
+    _UnlinkNode( node );
+
     while( !array::empty( nodes_to_destroy ) )
     {
         NODE* nod = array::back( nodes_to_destroy );
         array::pop_back( nodes_to_destroy );
 
-        UnlinkNode( node );
-
         SetName( nod, nullptr );
         u32 node_index = nod->Index();
 
@@ -185,6 +168,56 @@ NODE* NODEContainerImpl::CreateNode( const guid_t& guid, const char* node_name )
     return node;
 }
 
+void NODEContainerImpl::CreateNodes( NODE** out_nodes, const NODECreateDesc* descs, u32 count, NODE* parent )
+{
+    // children are counted up front, so each children array is allocated once
+    array_t<u32> num_children( _allocator );
+    array::resize( num_children, count );
+    memset( array::begin( num_children ), 0x00, array::size_in_bytes( num_children ) );
+
+    u32 num_top_nodes = 0;
+    for( u32 i = 0; i < count; ++i )
+    {
+        const u32 desc_parent = descs[i].parent;
+        if( desc_parent == UINT32_MAX )
+        {
+            num_top_nodes += 1;
+        }
+        else
+        {
+            SYS_ASSERT( desc_parent < i );
+            num_children[desc_parent] += 1;
+        }
+    }
+
+    scoped_write_spin_lock_t lck( _node_lock );
+    _ReserveLookup( count );
+    if( parent )
+    {
+        c_array::reserve( parent->_children, parent->_children->size + num_top_nodes, _allocator );
+    }
+
+    for( u32 i = 0; i < count; ++i )
+    {
+        const NODECreateDesc& desc = descs[i];
+
+        NODE* node = _AllocateNode( num_children[i] );
+        node->_guid = desc.guid;
+        SetName( node, desc.name );
+        _AddToLookup( node );
+
+        // nodes are new, so no need to check if they are already linked
+        NODE* node_parent = ( desc.parent != UINT32_MAX ) ? out_nodes[desc.parent] : parent;
+        if( node_parent )
+        {
+            node->_parent = node_parent;
+            c_array::push_back( node_parent->_children, node );
+        }
+
+        out_nodes[i] = node;
+    }
+}
+
 void NODEContainerImpl::ScheduleDestroyNode( NODE* node )
 {
     {
@@ -197,6 +230,16 @@ void NODEContainerImpl::ScheduleDestroyNode( NODE* node )
     }
 }
 
+void NODEContainerImpl::_ReserveLookup( u32 count )
+{
+    const u32 num_nodes = array::size( _node_lookup ) + count;
+    array::reserve( _node_lookup, num_nodes );
+    if( array::size( _guid_lookup._hash ) < num_nodes )
+    {
+        hash::reserve( _guid_lookup, num_nodes );
+    }
+}
+
 void NODEContainerImpl::_AddToLookup( NODE* node )
 {
     const guid_t& guid = node->Guid();
@@ -233,13 +276,33 @@ void NODEContainerImpl::_RemoveFromLookup( NODE* node )
     } );
 }
 
+void NODEContainerImpl::_RestoreToLookup( NODE* node )
+{
+    helper::TraverseTree( node, [this]( NODE* node )
+    {
+        SYS_ASSERT( node->_index < array::size( _node_lookup ) );
+        SYS_ASSERT( _node_lookup[node->_index] == nullptr );
+        SYS_ASSERT( hash::has( _guid_lookup, node->_guid ) == false );
+
+        _node_lookup[node->_index] = node;
+        hash::set( _guid_lookup, node->_guid, node );
+    } );
+}
+
 NODEComp* NODEContainerImpl::CreateComponent( NODE* parent, const char* type_name )
 {
-    NODEComp* comp = NODECompAlloc( type_name );
+    return CreateComponent( parent, NODECompAlloc( type_name ) );
+}
+
+NODEComp* NODEContainerImpl::CreateComponent( NODE* parent, NODEComp* comp )
+{
+    if( !comp )
+        return nullptr;
 
     {
         scoped_write_spin_lock_t guard( _comp_lock );
         comp->_scene_index = array::push_back( _comp_storage, comp );
+        array::push_back( _comp_owner, parent );
 
         SYS_ASSERT( bitset::get( _comp_initialized_bitmask, comp->_scene_index ) == false );
         bitset::set( _comp_to_initialize_bitmask, comp->_scene_index );
@@ -297,6 +360,263 @@ void NODEContainerImpl::ScheduleDestroyComponent( NODEComp* comp )
     //}
 }
 
+void NODEContainerImpl::_DestroyComponent( NODESystemContext* ctx, NODEComp* comp, NODE* node )
+{
+    const u32 scene_index = comp->_scene_index;
+    bool attached = false;
+    bool initialized = false;
+    {
+        scoped_write_spin_lock_t guard( _comp_lock );
+        attached = bitset::get( _comp_attached_bitmask, scene_index );
+        initialized = bitset::get( _comp_initialized_bitmask, scene_index );
+
+        bitset::clear( _comp_attached_bitmask, scene_index );
+        bitset::clear( _comp_initialized_bitmask, scene_index );
+        bitset::clear( _comp_to_initialize_bitmask, scene_index );
+        bitset::clear( _comp_to_uninitialize_bitmask, scene_index );
+        bitset::clear( _comp_to_attach_bitmask, scene_index );
+        bitset::clear( _comp_to_detach_bitmask, scene_index );
+        bitset::clear( _comp_to_destroy_bitmask, scene_index );
+
+        _comp_storage[scene_index] = nullptr;
+        _comp_owner[scene_index] = nullptr;
+    }
+
+    if( attached )
+    {
+        NODEAttachContext detach_ctx;
+        InitContext( &detach_ctx, ctx );
+        comp->OnDetach( node, &detach_ctx );
+    }
+    if( initialized )
+    {
+        NODEInitContext uninit_ctx;
+        InitContext( &uninit_ctx, ctx );
+        comp->OnUninitialize( node, &uninit_ctx );
+    }
+
+    NODECompFree( comp );
+}
+
+void NODEContainerImpl::DestroyPendingComponents( NODESystemContext* ctx )
+{
+    array_t<NODEComp*> comps;
+    {
+        scoped_read_spin_lock_t guard( _comp_lock );
+        for( bitset::const_iterator<CompBitmask> it( _comp_to_destroy_bitmask ); it.ok(); it.next() )
+        {
+            if( NODEComp* comp = _comp_storage[it.index()] )
+                array::push_back( comps, comp );
+        }
+    }
+
+    for( NODEComp* comp : comps )
+    {
+        NODE* node = FindParent( comp );
+        {
+            scoped_write_spin_lock_t guard( _node_lock );
+            NODECompSpan components = node->Components();
+            auto it = std::find( components.begin(), components.end(), comp );
+            SYS_ASSERT( it != components.end() );
+            c_array::erase_swap( node->_components, (u32)( it - components.begin() ) );
+        }
+        _DestroyComponent( ctx, comp, node );
+    }
+}
+
+namespace
+{
+    // pending components grouped by type, batch 'i' is [batch_begin[i], batch_begin[i+1])
+    struct NODEPendingBatches
+    {
+        array_t<NODEComp*> comps;
+        array_t<NODE*> nodes;
+        array_t<u8> result;
+        array_t<u32> batch_begin;
+        array_t<u32> parallel_batches;
+        array_t<u32> serial_batches;
+    };
+
+    struct NODEPendingComp
+    {
+        u64 type;
+        u32 scene_index;
+    };
+}//
+
+static void GatherPending( NODEPendingBatches* pb, NODEContainerImpl* impl, NODEContainerImpl::CompBitmask& pending )
+{
+    array_t<NODEPendingComp> sorted;
+    {
+        scoped_write_spin_lock_t guard( impl->_comp_lock );
+        for( bitset::const_iterator<NODEContainerImpl::CompBitmask> it( pending ); it.ok(); it.next() )
+        {
+            if( const NODEComp* comp = impl->_comp_storage[it.index()] )
+                array::push_back( sorted, NODEPendingComp{ comp->TypeHashCode(), it.index() } );
+        }
+        bitset::clear_all( pending );
+    }
+
+    std::sort( sorted.begin(), sorted.end(), []( const NODEPendingComp& a, const NODEPendingComp& b )
+    {
+        return ( a.type != b.type ) ? a.type < b.type : a.scene_index < b.scene_index;
+    } );
+
+    const u32 num_comps = array::size( sorted );
+    array::reserve( pb->comps, num_comps );
+    array::reserve( pb->nodes, num_comps );
+    array::resize( pb->result, num_comps );
+
+    for( u32 i = 0; i < num_comps; ++i )
+    {
+        if( i == 0 || sorted[i].type != sorted[i - 1].type )
+            array::push_back( pb->batch_begin, i );
+
+        array::push_back( pb->comps, impl->_comp_storage[sorted[i].scene_index] );
+        array::push_back( pb->nodes, impl->_comp_owner[sorted[i].scene_index] );
+    }
+    const u32 num_batches = array::size( pb->batch_begin );
+    array::push_back( pb->batch_begin, num_comps );
+
+    for( u32 i = 0; i < num_batches; ++i )
+    {
+        const NODEComp* first = pb->comps[pb->batch_begin[i]];
+        array::push_back( ( first->IsThreadSafe() ) ? pb->parallel_batches : pb->serial_batches, i );
+    }
+}
+
+// batch hook is called once per type, when it returns false component hook is called for each component
+template< typename TCtx, typename TBatchHook, typename TCompHook >
+static void DispatchPending( NODEPendingBatches* pb, TCtx* ctx, TBatchHook batch_hook, TCompHook comp_hook )
+{
+    auto process_batch = [&]( u32 ibatch )
+    {
+        const u32 begin = pb->batch_begin[ibatch];
+        const u32 end = pb->batch_begin[ibatch + 1];
+
+        NODECompBatch batch;
+        batch.comps = array::begin( pb->comps ) + begin;
+        batch.nodes = array::begin( pb->nodes ) + begin;
+        batch.size = end - begin;
+
+        if( batch_hook( batch.comps[0], batch, ctx ) )
+        {
+            memset( array::begin( pb->result ) + begin, 1, batch.size );
+            return;
+        }
+
+        for( u32 i = begin; i < end; ++i )
+        {
+            pb->result[i] = comp_hook( pb->comps[i], pb->nodes[i], ctx, i ) ? 1 : 0;
+        }
+    };
+
+    auto process_parallel = [&]( u32 begin, u32 end, u32 worker_index )
+    {
+        for( u32 i = begin; i < end; ++i )
+            process_batch( pb->parallel_batches[i] );
+    };
+    thread_pool::parallel_for( ctx->pool, array::size( pb->parallel_batches ), 1, process_parallel );
+
+    for( u32 ibatch : pb->serial_batches )
+    {
+        process_batch( ibatch );
+    }
+}
+
+// bits changed between 'before' and 'after' are copied to 'dst', other bits of 'dst' are kept
+static void MergeFlags( NODEFlags* dst, const NODEFlags& before, const NODEFlags& after )
+{
+    u8* d = (u8*)dst;
+    const u8* b = (const u8*)&before;
+    const u8* a = (const u8*)&after;
+    for( u32 i = 0; i < sizeof( NODEFlags ); ++i )
+    {
+        const u8 changed = a[i] ^ b[i];
+        d[i] = ( d[i] & ~changed ) | ( a[i] & changed );
+    }
+}
+
+void NODEContainerImpl::InitializePendingComponents( NODEInitContext* ctx )
+{
+    NODEPendingBatches pb;
+    GatherPending( &pb, this, _comp_to_initialize_bitmask );
+
+    // components of thread safe types can share a node with each other, so every component
+    // gets its own copy of node flags and changes are merged back after dispatch
+    const u32 num_comps = array::size( pb.comps );
+    array_t<NODEFlags> flags_before;
+    array_t<NODEFlags> flags;
+    array::reserve( flags_before, num_comps );
+    array::reserve( flags, num_comps );
+    for( NODE* node : pb.nodes )
+    {
+        array::push_back( flags_before, node->_flags );
+        array::push_back( flags, node->_flags );
+    }
+
+    DispatchPending( &pb, ctx,
+        []( NODEComp* comp, NODECompBatch batch, NODEInitContext* ctx ) { return comp->OnInitializeBatch( batch, ctx ); },
+        [&flags]( NODEComp* comp, NODE* node, NODEInitContext* ctx, u32 i ) { comp->OnInitialize( node, ctx, &flags[i] ); return true; } );
+
+    for( u32 i = 0; i < num_comps; ++i )
+    {
+        MergeFlags( &pb.nodes[i]->_flags, flags_before[i], flags[i] );
+    }
+
+    scoped_write_spin_lock_t guard( _comp_lock );
+    for( const NODEComp* comp : pb.comps )
+    {
+        bitset::set( _comp_initialized_bitmask, comp->_scene_index );
+    }
+}
+
+void NODEContainerImpl::UninitializePendingComponents( NODEInitContext* ctx )
+{
+    NODEPendingBatches pb;
+    GatherPending( &pb, this, _comp_to_uninitialize_bitmask );
+    DispatchPending( &pb, ctx,
+        []( NODEComp* comp, NODECompBatch batch, NODEInitContext* ctx ) { return comp->OnUninitializeBatch( batch, ctx ); },
+        []( NODEComp* comp, NODE* node, NODEInitContext* ctx, u32 ) { comp->OnUninitialize( node, ctx ); return true; } );
+
+    scoped_write_spin_lock_t guard( _comp_lock );
+    for( const NODEComp* comp : pb.comps )
+    {
+        bitset::clear( _comp_initialized_bitmask, comp->_scene_index );
+    }
+}
+
+void NODEContainerImpl::AttachPendingComponents( NODEAttachContext* ctx )
+{
+    NODEPendingBatches pb;
+    GatherPending( &pb, this, _comp_to_attach_bitmask );
+    DispatchPending( &pb, ctx,
+        []( NODEComp* comp, NODECompBatch batch, NODEAttachContext* ctx ) { return comp->OnAttachBatch( batch, ctx ); },
+        []( NODEComp* comp, NODE* node, NODEAttachContext* ctx, u32 ) { return comp->OnAttach( node, ctx ); } );
+
+    scoped_write_spin_lock_t guard( _comp_lock );
+    for( u32 i = 0; i < array::size( pb.comps ); ++i )
+    {
+        if( pb.result[i] )
+            bitset::set( _comp_attached_bitmask, pb.comps[i]->_scene_index );
+    }
+}
+
+void NODEContainerImpl::DetachPendingComponents( NODEAttachContext* ctx )
+{
+    NODEPendingBatches pb;
+    GatherPending( &pb, this, _comp_to_detach_bitmask );
+    DispatchPending( &pb, ctx,
+        []( NODEComp* comp, NODECompBatch batch, NODEAttachContext* ctx ) { return comp->OnDetachBatch( batch, ctx ); },
+        []( NODEComp* comp, NODE* node, NODEAttachContext* ctx, u32 ) { comp->OnDetach( node, ctx ); return true; } );
+
+    scoped_write_spin_lock_t guard( _comp_lock );
+    for( const NODEComp* comp : pb.comps )
+    {
+        bitset::clear( _comp_attached_bitmask, comp->_scene_index );
+    }
+}
+
 bool NODEContainerImpl::LinkNode( NODE* parent, NODE* node )
 {
     {
@@ -331,27 +651,22 @@ bool NODEContainerImpl::LinkNode( NODE* parent, NODE* node )
 
 void NODEContainerImpl::UnlinkNode( NODE* child )
 {
-    u32 index = UINT32_MAX;
-
-    {
-        scoped_read_spin_lock_t guard( _node_lock );
-
-        if( !child->_parent )
-            return;
+    scoped_write_spin_lock_t guard( _node_lock );
+    _UnlinkNode( child );
+}
 
-        const NODESpan children = child->_parent->Children();
-        auto it = std::find( children.begin(), children.end(), child );
-        SYS_ASSERT( it != children.end() );
+void NODEContainerImpl::_UnlinkNode( NODE* child )
+{
+    if( !child->_parent )
+        return;
 
-        index = (u32)((uintptr_t)(it - children.begin()));
-    }
+    const NODESpan children = child->_parent->Children();
+    auto it = std::find( children.begin(), children.end(), child );
+    SYS_ASSERT( it != children.end() );
 
-    {
-        scoped_write_spin_lock_t guard( _node_lock );
-        
-        c_array::erase( child->_parent->_children, index );
-        child->_parent = nullptr;
-    }
+    const u32 index = (u32)((uintptr_t)(it - children.begin()));
+    c_array::erase( child->_parent->_children, index );
+    child->_parent = nullptr;
 }
 
 void NODEContainerImpl::ScheduleSerialize( const char* filename, bool read )
@@ -366,6 +681,30 @@ void NODEContainerImpl::ScheduleSerialize( const char* filename, bool read )
     _serialization_token = token;
 }
 
+// current tree leaves lookup before new one is read, so loading the same scene again doesn't clash on guids.
+// It's destroyed only when new tree was created, otherwise it stays as it was
+template< typename Fn >
+void NODEContainerImpl::_ReplaceRoot( NODESystemContext* ctx, Fn read_tree )
+{
+    NODE* old_root = _root;
+    {
+        scoped_write_spin_lock_t nodes_guard( _node_lock );
+        _RemoveFromLookup( old_root );
+    }
+
+    NODE* new_root = read_tree();
+
+    scoped_write_spin_lock_t nodes_guard( _node_lock );
+    if( !new_root )
+    {
+        _RestoreToLookup( old_root );
+        return;
+    }
+
+    _DestroyNode( ctx, old_root );
+    _root = new_root;
+}
+
 void NODEContainerImpl::ProcessSerialization( NODESystemContext* ctx )
 {
     NODESerializeToken* token = nullptr;
@@ -376,17 +715,33 @@ void NODEContainerImpl::ProcessSerialization( NODESystemContext* ctx )
     if( !token )
         return;
 
+    const char* filename = token->filename.RelativePath();
+    if( IsBinarySceneFile( filename ) )
+    {
+        if( token->is_reader )
+        {
+            BXFileWaitResult file;
+            if( const NODESceneFile* scene = LoadSceneFile( &file, filename, ctx->fsys, _allocator ) )
+            {
+                _ReplaceRoot( ctx, [&]() { return ReadSceneTree( this, scene, _allocator ); } );
+            }
+            ctx->fsys->CloseFile( &file.handle );
+        }
+        else
+        {
+            WriteSceneFile( filename, _root, ctx->fsys, _allocator );
+        }
+
+        BX_DELETE( _allocator, token );
+        return;
+    }
+
     NODETextSerializer serializer;
     if( token->is_reader )
     {
         if( ReadFromFile( &serializer, token->filename.RelativePath(), ctx->fsys, _allocator ) )
         {
-            {
-                scoped_write_spin_lock_t nodes_guard( _node_lock );
-                _RemoveFromLookup( _root );
-                _DestroyNode( ctx, _root );
-            }
-            _root = ReadNodeTree( this, serializer.xml_root );
+            _ReplaceRoot( ctx, [&]() { return ReadNodeTree( this, serializer.xml_root ); } );
         }
     }
     else
@@ -4,11 +4,13 @@
 #include "../foundation/thread/rw_spin_lock.h"
 #include "../util/guid.h"
 #include "../util/file_system_name.h"
+#include "../foundation/hash.h"
 
 struct BXIAllocator;
 struct BXIFilesystem;
 struct NODE;
 struct NODEComp;
+struct NODECreateDesc;
 
 struct NODESystemContext;
 struct NODEInitContext;
@@ -21,6 +23,11 @@ struct NODESerializeToken
     u32 is_reader = 0;
 };
 
+inline u32 CalcHash( const guid_t& guid )
+{
+    return murmur3_hash32( &guid, sizeof( guid_t ), 2166136261 );
+}
+
 static constexpr u32 MAX_ATTACHED_COMPONENTS = 1024 * 16;
 
 struct NODEContainerImpl
@@ -38,7 +45,9 @@ struct NODEContainerImpl
 
     using CompBitmask = bitset_t < MAX_ATTACHED_COMPONENTS >;
     using CompStorage = static_array_t<NODEComp*, MAX_ATTACHED_COMPONENTS>;
+    using CompOwnerStorage = static_array_t<NODE*, MAX_ATTACHED_COMPONENTS>;
     CompStorage _comp_storage;
+    CompOwnerStorage _comp_owner; // same index as _comp_storage
     CompBitmask _comp_attached_bitmask;
     CompBitmask _comp_initialized_bitmask;
     CompBitmask _comp_to_initialize_bitmask;
@@ -62,6 +71,7 @@ struct NODEContainerImpl
     void ShutDown();
 
     NODE* CreateNode( const guid_t& guid, const char* node_name );
+    void  CreateNodes( NODE** out_nodes, const NODECreateDesc* descs, u32 count, NODE* parent );
     void  ScheduleDestroyNode( NODE* node );
 
     bool LinkNode( NODE* parent, NODE* node );
@@ -74,15 +84,23 @@ struct NODEContainerImpl
 
     void DestroyPendingNodes( NODESystemContext* ctx );
 
-    NODE* _AllocateNode();
+    NODE* _AllocateNode( u32 children_capacity = 4 );
     void  _FreeNode( NODE* node );
     void  _DestroyNode( NODESystemContext* ctx, NODE* node );
+    void  _UnlinkNode( NODE* child ); // caller holds _node_lock for writing
 
+    void _ReserveLookup( u32 count );
     void _AddToLookup( NODE* node );
     void _RemoveFromLookup( NODE* node );
+    void _RestoreToLookup( NODE* node ); // undoes _RemoveFromLookup, nodes get their old indices back
+    template< typename Fn >
+    void _ReplaceRoot( NODESystemContext* ctx, Fn read_tree );
 
     NODEComp* CreateComponent( NODE* parent, const char* type_name );
+    NODEComp* CreateComponent( NODE* parent, NODEComp* comp );
     void ScheduleDestroyComponent( NODEComp* comp );
+    void DestroyPendingComponents( NODESystemContext* ctx );
+    void _DestroyComponent( NODESystemContext* ctx, NODEComp* comp, NODE* node );
     
     void InitializePendingComponents( NODEInitContext* ctx );
     void UninitializePendingComponents( NODEInitContext* ctx );
@@ -1,6 +1,10 @@
 #pragma once
 
+#if defined( _WIN32 )
 #define PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
 
 struct BXIAllocator;
 typedef void*( *PluginLoadFunc )( BXIAllocator* );
@@ -1,6 +1,11 @@
 #include "rdi_backend.h"
+#if RDI_BACKEND_NULL == 1
+#include "rdi_backend_null.h"
+#else
 #include "rdi_backend_dx11.h"
+#endif
 #include <stdio.h>
+#include <string.h>
 
 RDIEType::Enum RDIEType::FromName( const char* name )
 {
@@ -68,10 +73,19 @@ bool RDIEVertexSlot::ToString( char* output, uint32_t output_size, RDIEVertexSlo
 
 void Startup( RDIDevice** dev, RDICommandQueue** cmdq, uintptr_t hWnd, int winWidth, int winHeight, int fullScreen, BXIAllocator* allocator )
 {
+#if RDI_BACKEND_NULL == 1
+    (void)hWnd; (void)fullScreen;
+    bx::rdi::StartupNull( dev, cmdq, winWidth, winHeight, allocator );
+#else
     bx::rdi::StartupDX11( dev, cmdq, hWnd, winWidth, winHeight, fullScreen, allocator );
+#endif
 }
 
 void Shutdown( RDIDevice** dev, RDICommandQueue** cmdq, BXIAllocator* allocator )
 {
+#if RDI_BACKEND_NULL == 1
+    bx::rdi::ShutdownNull( dev, cmdq, allocator );
+#else
 	bx::rdi::ShutdownDX11( dev, cmdq, allocator );
+#endif
 }
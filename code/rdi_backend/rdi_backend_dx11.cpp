@@ -1,3 +1,7 @@
+#include "rdi_backend_type.h"
+
+#if RDI_BACKEND_NULL == 0
+
 #include "rdi_backend_dx11.h"
 #include "rdi_shader_reflection.h"
 #include "DirectXTex/DirectXTex.h"
@@ -1638,3 +1642,4 @@ RDITextureRW GetBackBufferTexture( RDICommandQueue* cmdq )
     return tex;
 }
 
+#endif // RDI_BACKEND_NULL
@@ -0,0 +1,932 @@
+#include "rdi_backend_type.h"
+
+#if RDI_BACKEND_NULL == 1
+
+#include "rdi_backend_null.h"
+#include "rdi_shader_reflection.h"
+
+#include <memory/memory.h>
+#include <foundation/data_buffer.h>
+#include <foundation/common.h>
+
+#include <atomic>
+#include <string.h>
+#include <stdio.h>
+
+const char* RDIENullCmd::name[RDIENullCmd::_COUNT_] =
+{
+    "SetViewport",
+    "SetVertexBuffers",
+    "SetIndexBuffer",
+    "SetShaderPass",
+    "SetInputLayout",
+    "SetCbuffers",
+    "SetResourcesRO",
+    "SetResourcesRW",
+    "SetSamplers",
+    "SetDepthState",
+    "SetBlendState",
+    "SetRasterState",
+    "SetHardwareState",
+    "SetScissorRects",
+    "SetTopology",
+    "ChangeToMainFramebuffer",
+    "ChangeRenderTargets",
+    "Map",
+    "Unmap",
+    "UpdateCBuffer",
+    "UpdateTexture",
+    "Draw",
+    "DrawIndexed",
+    "DrawInstanced",
+    "DrawIndexedInstanced",
+    "Dispatch",
+    "ClearState",
+    "ClearBuffers",
+    "ClearDepthBuffer",
+    "ClearColorBuffers",
+    "Swap",
+    "GenerateMipmaps",
+};
+
+// every object created by null backend points to this header
+struct RDINullObject
+{
+    BXIAllocator* allocator;
+    uint32_t size;
+    uint32_t _padding;
+    uint8_t* data;
+};
+
+static std::atomic<uint32_t> g_num_live_objects{ 0 };
+
+static RDINullObject* CreateObject( BXIAllocator* allocator, uint32_t data_size, const void* initial_data = nullptr )
+{
+    const uint32_t mem_size = (uint32_t)TYPE_ALIGN( sizeof( RDINullObject ), 16 ) + data_size;
+    uint8_t* mem = (uint8_t*)BX_MALLOC( allocator, mem_size, 16 );
+
+    RDINullObject* obj = (RDINullObject*)mem;
+    obj->allocator = allocator;
+    obj->size = data_size;
+    obj->_padding = 0;
+    obj->data = ( data_size ) ? mem + TYPE_ALIGN( sizeof( RDINullObject ), 16 ) : nullptr;
+
+    if( data_size )
+    {
+        if( initial_data )
+            memcpy( obj->data, initial_data, data_size );
+        else
+            memset( obj->data, 0x00, data_size );
+    }
+
+    g_num_live_objects.fetch_add( 1 );
+    return obj;
+}
+
+static void DestroyObject( uintptr_t id )
+{
+    if( !id )
+        return;
+
+    RDINullObject* obj = (RDINullObject*)id;
+    BX_FREE( obj->allocator, obj );
+    g_num_live_objects.fetch_sub( 1 );
+}
+
+static inline RDINullObject* Object( uintptr_t id ) { return (RDINullObject*)id; }
+
+template< typename T >
+static inline T* AsView( RDINullObject* obj ) { return (T*)obj; }
+
+// --- recording
+static inline data_buffer_t& CurrentTrace( RDICommandQueue* cmdq ) { return cmdq->_trace[cmdq->_current_frame]; }
+static inline RDINullCounters& CurrentCounters( RDICommandQueue* cmdq ) { return cmdq->_counters[cmdq->_current_frame]; }
+
+static void Record( RDICommandQueue* cmdq, RDINullCmdHeader header, const void* payload0 = nullptr, uint32_t payload0_size = 0, const void* payload1 = nullptr, uint32_t payload1_size = 0 )
+{
+    CurrentCounters( cmdq ).commands[header.type] += 1;
+    if( !cmdq->_record_trace )
+        return;
+
+    // keep headers and payloads 8 byte aligned, so replay can read them in place
+    const uint32_t payload_size = payload0_size + payload1_size;
+    header.payload_size = (uint32_t)TYPE_ALIGN( payload_size, 8 );
+
+    data_buffer_t& trace = CurrentTrace( cmdq );
+    data_buffer::write( &trace, &header, sizeof( header ), 1 );
+    if( payload0_size )
+        data_buffer::write( &trace, payload0, payload0_size, 1 );
+    if( payload1_size )
+        data_buffer::write( &trace, payload1, payload1_size, 1 );
+    if( header.payload_size != payload_size )
+    {
+        const uint8_t zero[8] = {};
+        data_buffer::write( &trace, zero, header.payload_size - payload_size, 1 );
+    }
+}
+
+static inline RDINullCmdHeader Header( RDIENullCmd::E type, uint32_t count = 0, uint32_t slot = 0, uint32_t stage_mask = 0 )
+{
+    RDINullCmdHeader header;
+    header.type = type;
+    header.count = (uint8_t)count;
+    header.slot = slot;
+    header.stage_mask = (uint16_t)stage_mask;
+    return header;
+}
+
+static inline uint32_t FloatBits( float f ) { return TypeReinterpert( f ).u; }
+static inline float BitsFloat( uint32_t u ) { return TypeReinterpert( u ).f; }
+
+SYS_STATIC_ASSERT( ( sizeof( RDINullCmdHeader ) % 8 ) == 0 );
+
+namespace bx{ namespace rdi{
+
+static constexpr uint32_t INITIAL_TRACE_CAPACITY = BIT_KILO_BYTE( 64 );
+
+void StartupNull( RDIDevice** dev, RDICommandQueue** cmdq, int winWidth, int winHeight, BXIAllocator* allocator )
+{
+    RDIDevice* device = BX_NEW( allocator, RDIDevice );
+    device->_allocator = allocator;
+
+    RDICommandQueue* cmd_queue = &device->_immediate_command_queue;
+    for( uint32_t i = 0; i < RDICommandQueue::NUM_FRAMES; ++i )
+    {
+        data_buffer::create( &cmd_queue->_trace[i], INITIAL_TRACE_CAPACITY, allocator );
+    }
+
+    cmd_queue->_main_framebuffer = CreateTexture2D( device, winWidth, winHeight, 1, RDIFormat( RDIEType::UBYTE, 4 ).Normalized( 1 ).Srgb( 1 ), RDIEBind::RENDER_TARGET, 0, nullptr );
+
+    dev[0] = device;
+    cmdq[0] = cmd_queue;
+}
+
+void ShutdownNull( RDIDevice** dev, RDICommandQueue** cmdq, BXIAllocator* allocator )
+{
+    cmdq[0] = nullptr;
+
+    RDICommandQueue* cmd_queue = &dev[0]->_immediate_command_queue;
+    Destroy( &cmd_queue->_main_framebuffer );
+    for( uint32_t i = 0; i < RDICommandQueue::NUM_FRAMES; ++i )
+    {
+        data_buffer::destroy( &cmd_queue->_trace[i] );
+    }
+
+    ReportLiveObjects( dev[0] );
+    BX_DELETE0( allocator, dev[0] );
+}
+
+}}///
+
+void ReportLiveObjects( RDIDevice* dev )
+{
+    (void)dev;
+    const uint32_t n = g_num_live_objects.load();
+    if( n )
+    {
+        SYS_LOG_WARNING( "RDI null backend: %u live objects", n );
+    }
+}
+
+// --- create
+RDIVertexBuffer CreateVertexBuffer( RDIDevice* dev, const RDIVertexBufferDesc& desc, uint32_t numElements, const void* data )
+{
+    RDINullObject* obj = CreateObject( dev->_allocator, numElements * desc.ByteWidth(), data );
+
+    RDIVertexBuffer vBuffer;
+    vBuffer.id          = (uintptr_t)obj;
+    vBuffer.numElements = numElements;
+    vBuffer.desc        = desc;
+    vBuffer.viewSH      = AsView<ID3D11ShaderResourceView>( obj );
+    vBuffer.viewUA      = ( desc.gpuAccess ) ? AsView<ID3D11UnorderedAccessView>( obj ) : nullptr;
+    return vBuffer;
+}
+RDIIndexBuffer CreateIndexBuffer( RDIDevice* dev, RDIEType::Enum dataType, uint32_t numElements, const void* data )
+{
+    SYS_ASSERT( dataType == RDIEType::USHORT || dataType == RDIEType::UINT );
+
+    RDIIndexBuffer iBuffer;
+    iBuffer.id          = (uintptr_t)CreateObject( dev->_allocator, numElements * RDIEType::stride[dataType], data );
+    iBuffer.dataType    = dataType;
+    iBuffer.numElements = numElements;
+    return iBuffer;
+}
+RDIConstantBuffer CreateConstantBuffer( RDIDevice* dev, uint32_t sizeInBytes, const void* data )
+{
+    RDIConstantBuffer b;
+    b.id            = (uintptr_t)CreateObject( dev->_allocator, (uint32_t)TYPE_ALIGN( sizeInBytes, 16 ) );
+    b.size_in_bytes = sizeInBytes;
+    if( data )
+        memcpy( Object( b.id )->data, data, sizeInBytes );
+    return b;
+}
+RDIBufferRO CreateBufferRO( RDIDevice* dev, int numElements, RDIFormat format, unsigned cpuAccessFlag )
+{
+    (void)cpuAccessFlag;
+    RDIBufferRO buffer;
+    buffer.sizeInBytes = numElements * format.ByteWidth();
+    buffer.bind_flags  = RDIEBind::SHADER_RESOURCE;
+    buffer.format      = format;
+
+    RDINullObject* obj = CreateObject( dev->_allocator, buffer.sizeInBytes );
+    buffer.id     = (uintptr_t)obj;
+    buffer.viewSH = AsView<ID3D11ShaderResourceView>( obj );
+    return buffer;
+}
+RDIBufferRO CreateStructuredBufferRO( RDIDevice* dev, uint32_t numElements, uint32_t elementStride, unsigned cpuAccessFlag )
+{
+    (void)cpuAccessFlag;
+    SYS_ASSERT( elementStride > 0 );
+
+    RDIBufferRO buffer;
+    buffer.sizeInBytes   = numElements * elementStride;
+    buffer.bind_flags    = RDIEBind::SHADER_RESOURCE;
+    buffer.elementStride = (uint16_t)elementStride;
+
+    RDINullObject* obj = CreateObject( dev->_allocator, buffer.sizeInBytes );
+    buffer.id     = (uintptr_t)obj;
+    buffer.viewSH = AsView<ID3D11ShaderResourceView>( obj );
+    return buffer;
+}
+
+RDIShaderPass CreateShaderPass( RDIDevice* dev, const RDIShaderPassCreateInfo& info )
+{
+    // bytecode is not interpreted, reflection (if any) has to come from compiled shader file
+    RDIShaderPass pass = {};
+    if( info.bytecode[RDIEPipeline::VERTEX] )
+        pass.vertex = (ID3D11VertexShader*)CreateObject( dev->_allocator, 0 );
+    if( info.bytecode[RDIEPipeline::PIXEL] )
+        pass.pixel = (ID3D11PixelShader*)CreateObject( dev->_allocator, 0 );
+    if( info.bytecode[RDIEPipeline::COMPUTE] )
+        pass.compute = (ID3D11ComputeShader*)CreateObject( dev->_allocator, 0 );
+
+    if( info.reflection )
+        pass.vertex_input_mask = info.reflection->input_mask;
+
+    return pass;
+}
+
+static RDITextureRW CreateTextureInternal( RDIDevice* dev, int w, int h, int d, int mips, RDIFormat format, unsigned bindFlags, const void* data )
+{
+    const uint32_t size = w * h * d * format.ByteWidth();
+
+    RDINullObject* obj = CreateObject( dev->_allocator, size, data );
+
+    RDITextureRW tex;
+    tex.id          = (uintptr_t)obj;
+    tex.viewSH      = AsView<ID3D11ShaderResourceView>( obj );
+    tex.viewUA      = ( bindFlags & RDIEBind::UNORDERED_ACCESS ) ? AsView<ID3D11UnorderedAccessView>( obj ) : nullptr;
+    tex.viewRT      = ( bindFlags & RDIEBind::RENDER_TARGET ) ? AsView<ID3D11RenderTargetView>( obj ) : nullptr;
+    tex.info.width  = (uint16_t)w;
+    tex.info.height = (uint16_t)h;
+    tex.info.depth  = (uint16_t)d;
+    tex.info.mips   = (uint8_t)mips;
+    tex.info.format = format;
+    return tex;
+}
+
+// block compressed formats can't be expressed with RDIFormat and stay UNKNOWN
+static RDIFormat DDSFormat( const uint32_t* header, size_t dataBlobSize )
+{
+    const uint32_t DDPF_FOURCC    = 0x4;
+    const uint32_t DDPF_RGB       = 0x40;
+    const uint32_t DDPF_LUMINANCE = 0x20000;
+    const uint32_t FOURCC_DX10    = 0x30315844; // "DX10"
+
+    // pixel format starts at dword 19 (magic + 18 dwords of DDS_HEADER)
+    if( dataBlobSize < 128 )
+        return RDIFormat();
+
+    const uint32_t flags    = header[20];
+    const uint32_t fourcc   = header[21];
+    const uint32_t bitcount = header[22];
+
+    if( flags & DDPF_FOURCC )
+    {
+        if( fourcc == FOURCC_DX10 )
+        {
+            if( dataBlobSize < 148 )
+                return RDIFormat();
+
+            // DXGI_FORMAT values
+            switch( header[32] )
+            {
+            case 2:  return RDIFormat::Float4();
+            case 6:  return RDIFormat::Float3();
+            case 11: return RDIFormat( RDIEType::USHORT, 4 ).Normalized( 1 );
+            case 16: return RDIFormat::Float2();
+            case 28: return RDIFormat( RDIEType::UBYTE, 4 ).Normalized( 1 );
+            case 29: return RDIFormat( RDIEType::UBYTE, 4 ).Normalized( 1 ).Srgb( 1 );
+            case 41: return RDIFormat::Float();
+            case 49: return RDIFormat( RDIEType::UBYTE, 2 ).Normalized( 1 );
+            case 61: return RDIFormat( RDIEType::UBYTE, 1 ).Normalized( 1 );
+            default: return RDIFormat();
+            }
+        }
+
+        // D3DFMT values
+        switch( fourcc )
+        {
+        case 36:  return RDIFormat( RDIEType::USHORT, 4 ).Normalized( 1 );
+        case 114: return RDIFormat::Float();
+        case 115: return RDIFormat::Float2();
+        case 116: return RDIFormat::Float4();
+        default:  return RDIFormat();
+        }
+    }
+
+    if( flags & ( DDPF_RGB | DDPF_LUMINANCE ) )
+    {
+        switch( bitcount )
+        {
+        case 8:  return RDIFormat( RDIEType::UBYTE, 1 ).Normalized( 1 );
+        case 16: return RDIFormat( RDIEType::UBYTE, 2 ).Normalized( 1 );
+        case 32: return RDIFormat( RDIEType::UBYTE, 4 ).Normalized( 1 );
+        default: return RDIFormat();
+        }
+    }
+
+    return RDIFormat();
+}
+RDITextureRO CreateTextureFromDDS( RDIDevice* dev, const void* dataBlob, size_t dataBlobSize )
+{
+    // only header is parsed, pixels are not needed on CPU side
+    const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+    const uint32_t* header = (const uint32_t*)dataBlob;
+
+    RDITextureRO tex;
+    if( dataBlobSize < 32 || header[0] != DDS_MAGIC )
+    {
+        SYS_LOG_ERROR( "RDI null backend: invalid DDS data" );
+        return tex;
+    }
+
+    const uint32_t height = header[3];
+    const uint32_t width  = header[4];
+    const uint32_t depth  = header[6];
+    const uint32_t mips   = header[7];
+    const RDIFormat format = DDSFormat( header, dataBlobSize );
+
+    RDINullObject* obj = CreateObject( dev->_allocator, 0 );
+    tex.id          = (uintptr_t)obj;
+    tex.viewSH      = AsView<ID3D11ShaderResourceView>( obj );
+    tex.info.width  = (uint16_t)width;
+    tex.info.height = (uint16_t)height;
+    tex.info.depth  = (uint16_t)max_of_2( depth, 1u );
+    tex.info.mips   = (uint8_t)max_of_2( mips, 1u );
+    tex.info.format = format;
+    return tex;
+}
+RDITextureRO CreateTextureFromHDR( RDIDevice* dev, const void* dataBlob, size_t dataBlobSize )
+{
+    // resolution line looks like: "-Y <height> +X <width>"
+    int width = 0;
+    int height = 0;
+
+    const char* txt = (const char*)dataBlob;
+    for( size_t i = 0; i + 2 < dataBlobSize; ++i )
+    {
+        if( txt[i] == '\n' && txt[i + 1] == '-' && txt[i + 2] == 'Y' )
+        {
+            // blob is not null terminated, parse copy of the line
+            char line[64] = {};
+            const size_t line_len = min_of_2( dataBlobSize - ( i + 1 ), sizeof( line ) - 1 );
+            memcpy( line, txt + i + 1, line_len );
+            sscanf( line, "-Y %d +X %d", &height, &width );
+            break;
+        }
+    }
+
+    RDITextureRO tex;
+    RDINullObject* obj = CreateObject( dev->_allocator, 0 );
+    tex.id          = (uintptr_t)obj;
+    tex.viewSH      = AsView<ID3D11ShaderResourceView>( obj );
+    tex.info.width  = (uint16_t)width;
+    tex.info.height = (uint16_t)height;
+    tex.info.depth  = 1;
+    tex.info.mips   = 1;
+    tex.info.format = RDIFormat::Float4();
+    return tex;
+}
+RDITextureRW CreateTexture1D( RDIDevice* dev, int w, int mips, RDIFormat format, unsigned bindFlags, unsigned cpuaFlags, const void* data )
+{
+    (void)cpuaFlags;
+    return CreateTextureInternal( dev, w, 1, 1, mips, format, bindFlags, data );
+}
+RDITextureRW CreateTexture2D( RDIDevice* dev, int w, int h, int mips, RDIFormat format, unsigned bindFlags, unsigned cpuaFlags, const void* data )
+{
+    (void)cpuaFlags;
+    return CreateTextureInternal( dev, w, h, 1, mips, format, bindFlags, data );
+}
+RDITextureDepth CreateTexture2Ddepth( RDIDevice* dev, int w, int h, int mips, RDIEType::Enum dataType )
+{
+    SYS_ASSERT( dataType == RDIEType::DEPTH16 || dataType == RDIEType::DEPTH24_STENCIL8 || dataType == RDIEType::DEPTH32F );
+
+    const RDIFormat format( dataType, 1 );
+    RDINullObject* obj = CreateObject( dev->_allocator, w * h * format.ByteWidth() );
+
+    RDITextureDepth tex;
+    tex.id          = (uintptr_t)obj;
+    tex.viewSH      = AsView<ID3D11ShaderResourceView>( obj );
+    tex.viewDS      = AsView<ID3D11DepthStencilView>( obj );
+    tex.info.width  = (uint16_t)w;
+    tex.info.height = (uint16_t)h;
+    tex.info.depth  = 1;
+    tex.info.mips   = (uint8_t)mips;
+    tex.info.format = format;
+    return tex;
+}
+RDISampler CreateSampler( RDIDevice* dev, const RDISamplerDesc& desc )
+{
+    RDISampler sampler;
+    sampler.id = (uintptr_t)CreateObject( dev->_allocator, sizeof( desc ), &desc );
+    return sampler;
+}
+RDIInputLayout CreateInputLayout( RDIDevice* dev, const RDIVertexLayout vertexLayout, RDIShaderPass shaderPass )
+{
+    (void)shaderPass;
+    RDIInputLayout iLay;
+    iLay.id = (uintptr_t)CreateObject( dev->_allocator, sizeof( vertexLayout ), &vertexLayout );
+    return iLay;
+}
+RDIHardwareState CreateHardwareState( RDIDevice* dev, RDIHardwareStateDesc desc )
+{
+    RDIHardwareState hwstate = {};
+    hwstate.blend  = (ID3D11BlendState*)CreateObject( dev->_allocator, sizeof( desc.blend ), &desc.blend );
+    hwstate.depth  = (ID3D11DepthStencilState*)CreateObject( dev->_allocator, sizeof( desc.depth ), &desc.depth );
+    hwstate.raster = (ID3D11RasterizerState*)CreateObject( dev->_allocator, sizeof( desc.raster ), &desc.raster );
+    return hwstate;
+}
+
+// --- destroy
+void Destroy( RDIVertexBuffer* id )   { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDIIndexBuffer* id )    { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDIInputLayout * id )   { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDIConstantBuffer* id ) { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDIBufferRO* id )       { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDIShaderPass* id )
+{
+    DestroyObject( (uintptr_t)id->vertex );
+    DestroyObject( (uintptr_t)id->pixel );
+    DestroyObject( (uintptr_t)id->compute );
+    id[0] = {};
+}
+void Destroy( RDITextureRO* id )      { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDITextureRW* id )      { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDITextureDepth* id )   { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDISampler* id )        { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDIBlendState* id )     { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDIDepthState* id )     { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDIRasterState * id )   { DestroyObject( id->id ); id[0] = {}; }
+void Destroy( RDIHardwareState* id )
+{
+    DestroyObject( (uintptr_t)id->blend );
+    DestroyObject( (uintptr_t)id->depth );
+    DestroyObject( (uintptr_t)id->raster );
+    id[0] = {};
+}
+
+// ---
+void GetAPIDevice( RDIDevice* dev, ID3D11Device** apiDev, ID3D11DeviceContext** apiCtx )
+{
+    (void)dev;
+    apiDev[0] = nullptr;
+    apiCtx[0] = nullptr;
+}
+RDICommandQueue* GetImmediateCommandQueue( RDIDevice* dev )
+{
+    return &dev->_immediate_command_queue;
+}
+
+void SetViewport( RDICommandQueue* cmdq, RDIViewport vp )
+{
+    RDINullCmdHeader header = Header( RDIENullCmd::SET_VIEWPORT );
+    Record( cmdq, header, &vp, sizeof( vp ) );
+}
+void SetVertexBuffers( RDICommandQueue* cmdq, RDIVertexBuffer* vbuffers, unsigned start, unsigned n )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_VERTEX_BUFFERS, n, start ), vbuffers, n * sizeof( RDIVertexBuffer ) );
+}
+void SetIndexBuffer( RDICommandQueue* cmdq, RDIIndexBuffer ibuffer )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_INDEX_BUFFER ), &ibuffer, sizeof( ibuffer ) );
+}
+void SetShaderPass( RDICommandQueue* cmdq, RDIShaderPass pass )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_SHADER_PASS ), &pass, sizeof( pass ) );
+}
+void SetInputLayout( RDICommandQueue* cmdq, RDIInputLayout ilay )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_INPUT_LAYOUT ), &ilay, sizeof( ilay ) );
+}
+void SetCbuffers( RDICommandQueue* cmdq, RDIConstantBuffer* cbuffers, unsigned startSlot, unsigned n, unsigned stageMask )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_CBUFFERS, n, startSlot, stageMask ), cbuffers, n * sizeof( RDIConstantBuffer ) );
+}
+void SetResourcesRO( RDICommandQueue* cmdq, RDIResourceRO* resources, unsigned startSlot, unsigned n, unsigned stageMask )
+{
+    RDIResourceRO tmp[cRDI_MAX_RESOURCES_RO] = {};
+    SYS_ASSERT( n <= cRDI_MAX_RESOURCES_RO );
+    if( resources )
+        memcpy( tmp, resources, n * sizeof( RDIResourceRO ) );
+
+    Record( cmdq, Header( RDIENullCmd::SET_RESOURCES_RO, n, startSlot, stageMask ), tmp, n * sizeof( RDIResourceRO ) );
+}
+void SetResourcesRW( RDICommandQueue* cmdq, RDIResourceRW* resources, unsigned startSlot, unsigned n, unsigned stageMask )
+{
+    RDIResourceRW tmp[cRDI_MAX_RESOURCES_RW] = {};
+    SYS_ASSERT( n <= cRDI_MAX_RESOURCES_RW );
+    if( resources )
+        memcpy( tmp, resources, n * sizeof( RDIResourceRW ) );
+
+    Record( cmdq, Header( RDIENullCmd::SET_RESOURCES_RW, n, startSlot, stageMask ), tmp, n * sizeof( RDIResourceRW ) );
+}
+void SetSamplers( RDICommandQueue* cmdq, RDISampler* samplers, unsigned startSlot, unsigned n, unsigned stageMask )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_SAMPLERS, n, startSlot, stageMask ), samplers, n * sizeof( RDISampler ) );
+}
+void SetDepthState( RDICommandQueue* cmdq, RDIDepthState state )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_DEPTH_STATE ), &state, sizeof( state ) );
+}
+void SetBlendState( RDICommandQueue* cmdq, RDIBlendState state )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_BLEND_STATE ), &state, sizeof( state ) );
+}
+void SetRasterState( RDICommandQueue* cmdq, RDIRasterState state )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_RASTER_STATE ), &state, sizeof( state ) );
+}
+void SetHardwareState( RDICommandQueue* cmdq, RDIHardwareState hwstate )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_HARDWARE_STATE ), &hwstate, sizeof( hwstate ) );
+}
+void SetScissorRects( RDICommandQueue* cmdq, const RDIRect* rects, int n )
+{
+    Record( cmdq, Header( RDIENullCmd::SET_SCISSOR_RECTS, n ), rects, n * sizeof( RDIRect ) );
+}
+void SetTopology( RDICommandQueue* cmdq, int topology )
+{
+    RDINullCmdHeader header = Header( RDIENullCmd::SET_TOPOLOGY );
+    header.args[0] = topology;
+    Record( cmdq, header );
+}
+
+void ChangeToMainFramebuffer( RDICommandQueue* cmdq )
+{
+    Record( cmdq, Header( RDIENullCmd::CHANGE_TO_MAIN_FRAMEBUFFER ) );
+}
+void ChangeRenderTargets( RDICommandQueue* cmdq, RDITextureRW* colorTex, unsigned nColor, RDITextureDepth depthTex, bool changeViewport )
+{
+    SYS_ASSERT( nColor <= cRDI_MAX_RENDER_TARGETS );
+
+    RDINullCmdHeader header = Header( RDIENullCmd::CHANGE_RENDER_TARGETS, nColor );
+    header.args[0] = changeViewport;
+    Record( cmdq, header, &depthTex, sizeof( depthTex ), colorTex, nColor * sizeof( RDITextureRW ) );
+}
+
+// --- map
+static unsigned char* MapInternal( RDICommandQueue* cmdq, uintptr_t id, uint32_t offsetInBytes, RDIEMapType::Enum mapType )
+{
+    RDINullObject* obj = Object( id );
+    SYS_ASSERT( obj && offsetInBytes <= obj->size );
+
+    RDINullCmdHeader header = Header( RDIENullCmd::MAP );
+    header.args[0] = offsetInBytes;
+    header.args[1] = mapType;
+    Record( cmdq, header, &id, sizeof( id ) );
+
+    CurrentCounters( cmdq ).bytes_mapped += obj->size - offsetInBytes;
+    return obj->data + offsetInBytes;
+}
+
+unsigned char* Map( RDICommandQueue* cmdq, RDIResource resource, int offsetInBytes, RDIEMapType::Enum mapType )
+{
+    return MapInternal( cmdq, resource.id, offsetInBytes, mapType );
+}
+void Unmap( RDICommandQueue* cmdq, RDIResource resource )
+{
+    Record( cmdq, Header( RDIENullCmd::UNMAP ), &resource.id, sizeof( resource.id ) );
+}
+
+unsigned char* Map( RDICommandQueue* cmdq, RDIVertexBuffer vbuffer, int firstElement, int numElements, RDIEMapType::Enum mapType )
+{
+    SYS_ASSERT( (uint32_t)( firstElement + numElements ) <= vbuffer.numElements );
+    const int offsetInBytes = firstElement * vbuffer.desc.ByteWidth();
+    return MapInternal( cmdq, vbuffer.id, offsetInBytes, mapType );
+}
+unsigned char* Map( RDICommandQueue* cmdq, RDIIndexBuffer ibuffer, int firstElement, int numElements, RDIEMapType::Enum mapType )
+{
+    SYS_ASSERT( (uint32_t)( firstElement + numElements ) <= ibuffer.numElements );
+    SYS_ASSERT( ibuffer.dataType == RDIEType::USHORT || ibuffer.dataType == RDIEType::UINT );
+
+    const int offsetInBytes = firstElement * RDIEType::stride[ibuffer.dataType];
+    return MapInternal( cmdq, ibuffer.id, offsetInBytes, mapType );
+}
+
+void UpdateCBuffer( RDICommandQueue* cmdq, RDIConstantBuffer cbuffer, const void* data )
+{
+    RDINullObject* obj = Object( cbuffer.id );
+    memcpy( obj->data, data, cbuffer.size_in_bytes );
+
+    CurrentCounters( cmdq ).bytes_updated += cbuffer.size_in_bytes;
+    Record( cmdq, Header( RDIENullCmd::UPDATE_CBUFFER ), &cbuffer, sizeof( cbuffer ), data, cbuffer.size_in_bytes );
+}
+void UpdateTexture( RDICommandQueue* cmdq, RDITextureRW texture, const void* data )
+{
+    RDINullObject* obj = Object( texture.id );
+    const uint32_t size = texture.info.width * texture.info.height * max_of_2( texture.info.depth, (uint16_t)1 ) * texture.info.format.ByteWidth();
+    SYS_ASSERT( size <= obj->size );
+    memcpy( obj->data, data, size );
+
+    CurrentCounters( cmdq ).bytes_updated += size;
+    Record( cmdq, Header( RDIENullCmd::UPDATE_TEXTURE ), &texture, sizeof( texture ), data, size );
+}
+
+// --- draw
+void Draw( RDICommandQueue* cmdq, unsigned numVertices, unsigned startIndex )
+{
+    RDINullCmdHeader header = Header( RDIENullCmd::DRAW );
+    header.args[0] = numVertices;
+    header.args[1] = startIndex;
+    Record( cmdq, header );
+
+    CurrentCounters( cmdq ).vertices += numVertices;
+    CurrentCounters( cmdq ).instances += 1;
+}
+void DrawIndexed( RDICommandQueue* cmdq, unsigned numIndices, unsigned startIndex, unsigned baseVertex )
+{
+    RDINullCmdHeader header = Header( RDIENullCmd::DRAW_INDEXED );
+    header.args[0] = numIndices;
+    header.args[1] = startIndex;
+    header.args[2] = baseVertex;
+    Record( cmdq, header );
+
+    CurrentCounters( cmdq ).vertices += numIndices;
+    CurrentCounters( cmdq ).instances += 1;
+}
+void DrawInstanced( RDICommandQueue* cmdq, unsigned numVertices, unsigned startIndex, unsigned numInstances )
+{
+    RDINullCmdHeader header = Header( RDIENullCmd::DRAW_INSTANCED );
+    header.args[0] = numVertices;
+    header.args[1] = startIndex;
+    header.args[2] = numInstances;
+    Record( cmdq, header );
+
+    CurrentCounters( cmdq ).vertices += (uint64_t)numVertices * numInstances;
+    CurrentCounters( cmdq ).instances += numInstances;
+}
+void DrawIndexedInstanced( RDICommandQueue* cmdq, unsigned numIndices, unsigned startIndex, unsigned numInstances, unsigned baseVertex )
+{
+    RDINullCmdHeader header = Header( RDIENullCmd::DRAW_INDEXED_INSTANCED );
+    header.args[0] = numIndices;
+    header.args[1] = startIndex;
+    header.args[2] = numInstances;
+    header.args[3] = baseVertex;
+    Record( cmdq, header );
+
+    CurrentCounters( cmdq ).vertices += (uint64_t)numIndices * numInstances;
+    CurrentCounters( cmdq ).instances += numInstances;
+}
+
+void Dispatch( RDICommandQueue* cmdq, unsigned numGroupsX, unsigned numGroupsY, unsigned numGroupsZ )
+{
+    RDINullCmdHeader header = Header( RDIENullCmd::DISPATCH );
+    header.args[0] = numGroupsX;
+    header.args[1] = numGroupsY;
+    header.args[2] = numGroupsZ;
+    Record( cmdq, header );
+
+    CurrentCounters( cmdq ).dispatch_groups += (uint64_t)numGroupsX * numGroupsY * numGroupsZ;
+}
+
+void ClearState( RDICommandQueue* cmdq )
+{
+    Record( cmdq, Header( RDIENullCmd::CLEAR_STATE ) );
+}
+void ClearBuffers( RDICommandQueue* cmdq, RDITextureRW* colorTex, unsigned nColor, RDITextureDepth depthTex, const float rgbad[5], int flag_color, int flag_depth )
+{
+    SYS_ASSERT( nColor <= cRDI_MAX_RENDER_TARGETS );
+
+    RDINullCmdHeader header = Header( RDIENullCmd::CLEAR_BUFFERS, nColor );
+    header.args[0] = flag_color;
+    header.args[1] = flag_depth;
+
+    // rgbad padded to 6 floats to keep color targets aligned
+    uint8_t payload[sizeof( RDITextureDepth ) + sizeof( float ) * 6] = {};
+    memcpy( payload, &depthTex, sizeof( depthTex ) );
+    memcpy( payload + sizeof( depthTex ), rgbad, sizeof( float ) * 5 );
+    Record( cmdq, header, payload, sizeof( payload ), colorTex, nColor * sizeof( RDITextureRW ) );
+}
+void ClearDepthBuffer( RDICommandQueue* cmdq, RDITextureDepth depthTex, float clearValue )
+{
+    RDINullCmdHeader header = Header( RDIENullCmd::CLEAR_DEPTH_BUFFER );
+    header.args[0] = FloatBits( clearValue );
+    Record( cmdq, header, &depthTex, sizeof( depthTex ) );
+}
+void ClearColorBuffers( RDICommandQueue* cmdq, RDITextureRW* colorTex, unsigned nColor, float r, float g, float b, float a )
+{
+    SYS_ASSERT( nColor <= cRDI_MAX_RENDER_TARGETS );
+
+    RDINullCmdHeader header = Header( RDIENullCmd::CLEAR_COLOR_BUFFERS, nColor );
+    header.args[0] = FloatBits( r );
+    header.args[1] = FloatBits( g );
+    header.args[2] = FloatBits( b );
+    header.args[3] = FloatBits( a );
+    Record( cmdq, header, colorTex, nColor * sizeof( RDITextureRW ) );
+}
+
+void Swap( RDICommandQueue* cmdq, unsigned syncInterval )
+{
+    RDINullCmdHeader header = Header( RDIENullCmd::SWAP );
+    header.args[0] = syncInterval;
+    Record( cmdq, header );
+
+    cmdq->_frame_number += 1;
+    cmdq->_current_frame = ( cmdq->_current_frame + 1 ) % RDICommandQueue::NUM_FRAMES;
+    NullResetFrame( cmdq );
+}
+void GenerateMipmaps( RDICommandQueue* cmdq, RDITextureRW texture )
+{
+    Record( cmdq, Header( RDIENullCmd::GENERATE_MIPMAPS ), &texture, sizeof( texture ) );
+}
+RDITextureRW GetBackBufferTexture( RDICommandQueue* cmdq )
+{
+    RDITextureRW tex = cmdq->_main_framebuffer;
+    tex.id = 0;
+    return tex;
+}
+
+// --- recording
+void NullSetTraceEnabled( RDICommandQueue* cmdq, bool enabled )
+{
+    cmdq->_record_trace = enabled;
+}
+const RDINullCounters& NullFrameCounters( const RDICommandQueue* cmdq )
+{
+    return cmdq->_counters[cmdq->_current_frame];
+}
+const RDINullCounters& NullLastCounters( const RDICommandQueue* cmdq )
+{
+    const uint32_t index = ( cmdq->_current_frame + RDICommandQueue::NUM_FRAMES - 1 ) % RDICommandQueue::NUM_FRAMES;
+    return cmdq->_counters[index];
+}
+RDINullTrace NullFrameTrace( const RDICommandQueue* cmdq )
+{
+    const data_buffer_t& buffer = cmdq->_trace[cmdq->_current_frame];
+    RDINullTrace trace;
+    trace.data = buffer.begin();
+    trace.size = data_buffer::size( buffer );
+    return trace;
+}
+RDINullTrace NullLastTrace( const RDICommandQueue* cmdq )
+{
+    const uint32_t index = ( cmdq->_current_frame + RDICommandQueue::NUM_FRAMES - 1 ) % RDICommandQueue::NUM_FRAMES;
+    const data_buffer_t& buffer = cmdq->_trace[index];
+    RDINullTrace trace;
+    trace.data = buffer.begin();
+    trace.size = data_buffer::size( buffer );
+    return trace;
+}
+void NullResetFrame( RDICommandQueue* cmdq )
+{
+    data_buffer::seek_write( &CurrentTrace( cmdq ), 0 );
+    CurrentCounters( cmdq ) = {};
+}
+uint32_t NullNumLiveObjects()
+{
+    return g_num_live_objects.load();
+}
+
+void NullReplayTrace( RDICommandQueue* cmdq, RDINullTrace trace )
+{
+    const uint8_t* ptr = trace.data;
+    const uint8_t* end = trace.data + trace.size;
+    while( ptr < end )
+    {
+        RDINullCmdHeader header;
+        memcpy( &header, ptr, sizeof( header ) );
+        ptr += sizeof( header );
+
+        const uint8_t* payload = ptr;
+        ptr += header.payload_size;
+        SYS_ASSERT( ptr <= end );
+
+        switch( header.type )
+        {
+        case RDIENullCmd::SET_VIEWPORT:
+            SetViewport( cmdq, *(const RDIViewport*)payload );
+            break;
+        case RDIENullCmd::SET_VERTEX_BUFFERS:
+            SetVertexBuffers( cmdq, (RDIVertexBuffer*)payload, header.slot, header.count );
+            break;
+        case RDIENullCmd::SET_INDEX_BUFFER:
+            SetIndexBuffer( cmdq, *(const RDIIndexBuffer*)payload );
+            break;
+        case RDIENullCmd::SET_SHADER_PASS:
+            SetShaderPass( cmdq, *(const RDIShaderPass*)payload );
+            break;
+        case RDIENullCmd::SET_INPUT_LAYOUT:
+            SetInputLayout( cmdq, *(const RDIInputLayout*)payload );
+            break;
+        case RDIENullCmd::SET_CBUFFERS:
+            SetCbuffers( cmdq, (RDIConstantBuffer*)payload, header.slot, header.count, header.stage_mask );
+            break;
+        case RDIENullCmd::SET_RESOURCES_RO:
+            SetResourcesRO( cmdq, (RDIResourceRO*)payload, header.slot, header.count, header.stage_mask );
+            break;
+        case RDIENullCmd::SET_RESOURCES_RW:
+            SetResourcesRW( cmdq, (RDIResourceRW*)payload, header.slot, header.count, header.stage_mask );
+            break;
+        case RDIENullCmd::SET_SAMPLERS:
+            SetSamplers( cmdq, (RDISampler*)payload, header.slot, header.count, header.stage_mask );
+            break;
+        case RDIENullCmd::SET_DEPTH_STATE:
+            SetDepthState( cmdq, *(const RDIDepthState*)payload );
+            break;
+        case RDIENullCmd::SET_BLEND_STATE:
+            SetBlendState( cmdq, *(const RDIBlendState*)payload );
+            break;
+        case RDIENullCmd::SET_RASTER_STATE:
+            SetRasterState( cmdq, *(const RDIRasterState*)payload );
+            break;
+        case RDIENullCmd::SET_HARDWARE_STATE:
+            SetHardwareState( cmdq, *(const RDIHardwareState*)payload );
+            break;
+        case RDIENullCmd::SET_SCISSOR_RECTS:
+            SetScissorRects( cmdq, (const RDIRect*)payload, header.count );
+            break;
+        case RDIENullCmd::SET_TOPOLOGY:
+            SetTopology( cmdq, header.args[0] );
+            break;
+        case RDIENullCmd::CHANGE_TO_MAIN_FRAMEBUFFER:
+            ChangeToMainFramebuffer( cmdq );
+            break;
+        case RDIENullCmd::CHANGE_RENDER_TARGETS:
+            {
+                const RDITextureDepth depth = *(const RDITextureDepth*)payload;
+                RDITextureRW* color = (RDITextureRW*)( payload + sizeof( RDITextureDepth ) );
+                ChangeRenderTargets( cmdq, ( header.count ) ? color : nullptr, header.count, depth, header.args[0] != 0 );
+            }break;
+        case RDIENullCmd::MAP:
+            {
+                const uintptr_t id = *(const uintptr_t*)payload;
+                MapInternal( cmdq, id, header.args[0], (RDIEMapType::Enum)header.args[1] );
+            }break;
+        case RDIENullCmd::UNMAP:
+            {
+                RDIResource resource;
+                resource.id = *(const uintptr_t*)payload;
+                Unmap( cmdq, resource );
+            }break;
+        case RDIENullCmd::UPDATE_CBUFFER:
+            UpdateCBuffer( cmdq, *(const RDIConstantBuffer*)payload, payload + sizeof( RDIConstantBuffer ) );
+            break;
+        case RDIENullCmd::UPDATE_TEXTURE:
+            UpdateTexture( cmdq, *(const RDITextureRW*)payload, payload + sizeof( RDITextureRW ) );
+            break;
+        case RDIENullCmd::DRAW:
+            Draw( cmdq, header.args[0], header.args[1] );
+            break;
+        case RDIENullCmd::DRAW_INDEXED:
+            DrawIndexed( cmdq, header.args[0], header.args[1], header.args[2] );
+            break;
+        case RDIENullCmd::DRAW_INSTANCED:
+            DrawInstanced( cmdq, header.args[0], header.args[1], header.args[2] );
+            break;
+        case RDIENullCmd::DRAW_INDEXED_INSTANCED:
+            DrawIndexedInstanced( cmdq, header.args[0], header.args[1], header.args[2], header.args[3] );
+            break;
+        case RDIENullCmd::DISPATCH:
+            Dispatch( cmdq, header.args[0], header.args[1], header.args[2] );
+            break;
+        case RDIENullCmd::CLEAR_STATE:
+            ClearState( cmdq );
+            break;
+        case RDIENullCmd::CLEAR_BUFFERS:
+            {
+                const RDITextureDepth depth = *(const RDITextureDepth*)payload;
+                const float* rgbad = (const float*)( payload + sizeof( RDITextureDepth ) );
+                RDITextureRW* color = (RDITextureRW*)( payload + sizeof( RDITextureDepth ) + sizeof( float ) * 6 );
+                ClearBuffers( cmdq, ( header.count ) ? color : nullptr, header.count, depth, rgbad, header.args[0], header.args[1] );
+            }break;
+        case RDIENullCmd::CLEAR_DEPTH_BUFFER:
+            ClearDepthBuffer( cmdq, *(const RDITextureDepth*)payload, BitsFloat( header.args[0] ) );
+            break;
+        case RDIENullCmd::CLEAR_COLOR_BUFFERS:
+            ClearColorBuffers( cmdq, (RDITextureRW*)payload, header.count, BitsFloat( header.args[0] ), BitsFloat( header.args[1] ), BitsFloat( header.args[2] ), BitsFloat( header.args[3] ) );
+            break;
+        case RDIENullCmd::SWAP:
+            // frame boundaries are not replayed, caller decides when to swap
+            break;
+        case RDIENullCmd::GENERATE_MIPMAPS:
+            GenerateMipmaps( cmdq, *(const RDITextureRW*)payload );
+            break;
+        default:
+            SYS_NOT_IMPLEMENTED;
+            return;
+        }
+    }
+}
+
+#endif // RDI_BACKEND_NULL
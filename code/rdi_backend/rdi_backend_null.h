@@ -0,0 +1,119 @@
+#pragma once
+
+#include "rdi_backend.h"
+#include <foundation/containers.h>
+
+// Headless backend. Resources live in CPU memory (Map returns real pointers) and every
+// state change / draw is recorded into a trace, which can be replayed on any command queue.
+// Trace and counters are double buffered: Swap() closes current frame and starts new one.
+
+namespace RDIENullCmd
+{
+    enum E : uint8_t
+    {
+        SET_VIEWPORT = 0,
+        SET_VERTEX_BUFFERS,
+        SET_INDEX_BUFFER,
+        SET_SHADER_PASS,
+        SET_INPUT_LAYOUT,
+        SET_CBUFFERS,
+        SET_RESOURCES_RO,
+        SET_RESOURCES_RW,
+        SET_SAMPLERS,
+        SET_DEPTH_STATE,
+        SET_BLEND_STATE,
+        SET_RASTER_STATE,
+        SET_HARDWARE_STATE,
+        SET_SCISSOR_RECTS,
+        SET_TOPOLOGY,
+        CHANGE_TO_MAIN_FRAMEBUFFER,
+        CHANGE_RENDER_TARGETS,
+        MAP,
+        UNMAP,
+        UPDATE_CBUFFER,
+        UPDATE_TEXTURE,
+        DRAW,
+        DRAW_INDEXED,
+        DRAW_INSTANCED,
+        DRAW_INDEXED_INSTANCED,
+        DISPATCH,
+        CLEAR_STATE,
+        CLEAR_BUFFERS,
+        CLEAR_DEPTH_BUFFER,
+        CLEAR_COLOR_BUFFERS,
+        SWAP,
+        GENERATE_MIPMAPS,
+        _COUNT_,
+    };
+
+    // for trace dumps
+    extern const char* name[_COUNT_];
+}//
+
+struct RDINullCmdHeader
+{
+    uint8_t  type = 0;
+    uint8_t  count = 0;
+    uint16_t stage_mask = 0;
+    uint32_t slot = 0;
+    uint32_t args[4] = {};
+    uint32_t payload_size = 0; // bytes following the header (multiple of 8)
+    uint32_t _padding = 0;
+};
+
+struct RDINullCounters
+{
+    uint32_t commands[RDIENullCmd::_COUNT_] = {};
+    uint64_t vertices = 0;        // indices for indexed draws
+    uint64_t instances = 0;
+    uint64_t dispatch_groups = 0;
+    uint64_t bytes_mapped = 0;
+    uint64_t bytes_updated = 0;
+
+    uint32_t NumDrawCalls() const
+    {
+        return commands[RDIENullCmd::DRAW] + commands[RDIENullCmd::DRAW_INDEXED] +
+            commands[RDIENullCmd::DRAW_INSTANCED] + commands[RDIENullCmd::DRAW_INDEXED_INSTANCED];
+    }
+};
+
+struct RDINullTrace
+{
+    const uint8_t* data = nullptr;
+    uint32_t size = 0;
+};
+
+struct RDICommandQueue
+{
+    static constexpr uint32_t NUM_FRAMES = 2;
+
+    RDITextureRW    _main_framebuffer = {};
+    data_buffer_t   _trace[NUM_FRAMES];
+    RDINullCounters _counters[NUM_FRAMES] = {};
+    uint32_t        _current_frame = 0;
+    uint32_t        _frame_number = 0;
+    uint32_t        _record_trace = 1;
+};
+
+struct RDIDevice
+{
+    RDICommandQueue _immediate_command_queue = {};
+    BXIAllocator*   _allocator = nullptr;
+};
+
+namespace bx{ namespace rdi{
+void StartupNull( RDIDevice** dev, RDICommandQueue** cmdq, int winWidth, int winHeight, BXIAllocator* allocator );
+void ShutdownNull( RDIDevice** dev, RDICommandQueue** cmdq, BXIAllocator* allocator );
+}}///
+
+// --- recording
+void                   NullSetTraceEnabled( RDICommandQueue* cmdq, bool enabled );
+const RDINullCounters& NullFrameCounters  ( const RDICommandQueue* cmdq ); // frame in progress
+const RDINullCounters& NullLastCounters   ( const RDICommandQueue* cmdq ); // last finished frame (before Swap)
+RDINullTrace           NullFrameTrace     ( const RDICommandQueue* cmdq );
+RDINullTrace           NullLastTrace      ( const RDICommandQueue* cmdq );
+void                   NullResetFrame     ( RDICommandQueue* cmdq );
+uint32_t               NullNumLiveObjects ();
+
+// executes recorded commands on cmdq. Trace must not be owned by the frame recorded on cmdq.
+void NullReplayTrace( RDICommandQueue* cmdq, RDINullTrace trace );
@@ -3,6 +3,16 @@
 #include <foundation/type.h>
 #include <foundation/debug.h>
 
+// null backend keeps resources in CPU memory and records commands instead of submitting them
+// (headless tests, servers, benchmarks). Always used on non-windows platforms.
+#ifndef RDI_BACKEND_NULL
+    #ifdef _WIN32
+        #define RDI_BACKEND_NULL 0
+    #else
+        #define RDI_BACKEND_NULL 1
+    #endif
+#endif
+
 namespace RDIEPipeline
 {
     enum Enum
@@ -60,6 +70,7 @@ namespace RDIEType
         DEPTH16,
         DEPTH24_STENCIL8,
         DEPTH32F,
+        HALF,
 
         COUNT,
     };
@@ -77,6 +88,7 @@ namespace RDIEType
         2, //DEPTH16,
         4, //DEPTH24_STENCIL8,
         4, //DEPTH32F,
+        2, //HALF,
     };
     static const char* name[] =
     {
@@ -92,6 +104,7 @@ namespace RDIEType
         "depth16",
         "depth24_stencil8",
         "depth32F",
+        "half",
     };
     Enum FromName( const char* name );
     Enum FindBaseType( const char* name );
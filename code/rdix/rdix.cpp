@@ -1,6 +1,7 @@
 #include "rdix.h"
 
 #include "rdix_command_buffer.h"
+#include "rdix_vertex_codec.h"
 
 #include <filesystem/filesystem_plugin.h>
 #include <memory/memory.h>
@@ -71,11 +72,21 @@ uint32_t FindShaderPass( RDIXShaderFile* shaderfile, const char* passname )
 //--- Pipeline
 struct RDIXPipeline
 {
+	static constexpr uint32_t MAX_INPUT_LAYOUT_VARIANTS = 8;
+
 	RDIShaderPass pass;
 	RDIHardwareState hardware_state;
 	RDIInputLayout input_layout;
 	RDIXResourceBinding* resources = nullptr;
 	RDIETopology::Enum topology = RDIETopology::TRIANGLES;
+
+	// input layouts for render sources with packed streams (see InputLayout), created on first use
+	RDIDevice* dev = nullptr;
+	RDIVertexLayout vertex_layout;
+	RDIVertexLayout input_layout_variant_key[MAX_INPUT_LAYOUT_VARIANTS];
+	RDIInputLayout input_layout_variant[MAX_INPUT_LAYOUT_VARIANTS];
+	uint32_t num_input_layout_variants = 0;
+
     BXIAllocator* allocator = nullptr;
 };
 RDIXPipeline* CreatePipeline( RDIDevice* dev, const RDIXPipelineDesc& desc, BXIAllocator* allocator )
@@ -103,6 +114,7 @@ RDIXPipeline* CreatePipeline( RDIDevice* dev, const RDIXPipelineDesc& desc, BXIA
     if( impl->pass.vertex_input_mask )
     {
         impl->input_layout = CreateInputLayout( dev, pass.vertex_layout, impl->pass );
+        impl->vertex_layout = pass.vertex_layout;
     }
     
     if( impl->pass.vertex || impl->pass.pixel )
@@ -119,6 +131,7 @@ RDIXPipeline* CreatePipeline( RDIDevice* dev, const RDIXPipelineDesc& desc, BXIA
 		impl->resources = (RDIXResourceBinding*)resource_desc_memory;
 	}
 
+    impl->dev = dev;
     impl->allocator = allocator;
 	return impl;
 }
@@ -132,6 +145,8 @@ void DestroyPipeline( RDIXPipeline** pipeline )
 	RDIXPipeline* pipe = pipeline[0];
 	BX_FREE0( allocator, pipe->resources );
 	Destroy( &pipe->hardware_state );
+	for( uint32_t i = 0; i < pipe->num_input_layout_variants; ++i )
+		Destroy( &pipe->input_layout_variant[i] );
 	Destroy( &pipe->input_layout );
 	Destroy( &pipe->pass );
         
@@ -149,6 +164,54 @@ void BindPipeline( RDICommandQueue* cmdq, RDIXPipeline* pipeline, bool bindResou
 
 	SetTopology( cmdq, pipeline->topology );
 }
+RDIInputLayout InputLayout( RDIXPipeline* pipeline, const RDIXRenderSource* rsource )
+{
+	if( !rsource || !pipeline->pass.vertex_input_mask )
+		return pipeline->input_layout;
+
+	// stream formats of render source replace float formats reflected from shader
+	RDIVertexLayout key = pipeline->vertex_layout;
+	bool differs = false;
+	for( uint32_t i = 0; i < key.count; ++i )
+	{
+		RDIVertexBufferDesc& desc = key.descs[i];
+		const RDIVertexBuffer vbuffer = FindVertexBuffer( rsource, (RDIEVertexSlot::Enum)desc.slot );
+		if( !vbuffer.id )
+			continue;
+
+		const RDIVertexBufferDesc src = vbuffer.desc;
+		if( src.dataType != desc.dataType || src.numElements != desc.numElements || src.typeNorm != desc.typeNorm )
+		{
+			desc.DataType( (RDIEType::Enum)src.dataType, src.numElements );
+			desc.typeNorm = src.typeNorm;
+			differs = true;
+		}
+	}
+
+	if( !differs )
+		return pipeline->input_layout;
+
+	for( uint32_t i = 0; i < pipeline->num_input_layout_variants; ++i )
+	{
+		if( !memcmp( &pipeline->input_layout_variant_key[i], &key, sizeof( RDIVertexLayout ) ) )
+			return pipeline->input_layout_variant[i];
+	}
+
+	if( pipeline->num_input_layout_variants == RDIXPipeline::MAX_INPUT_LAYOUT_VARIANTS )
+	{
+		SYS_LOG_ERROR( "Pipeline: too many input layout variants" );
+		return pipeline->input_layout;
+	}
+
+	const uint32_t index = pipeline->num_input_layout_variants++;
+	pipeline->input_layout_variant_key[index] = key;
+	pipeline->input_layout_variant[index] = CreateInputLayout( pipeline->dev, key, pipeline->pass );
+	return pipeline->input_layout_variant[index];
+}
+void BindInputLayout( RDICommandQueue* cmdq, RDIXPipeline* pipeline, const RDIXRenderSource* rsource )
+{
+	SetInputLayout( cmdq, InputLayout( pipeline, rsource ) );
+}
 RDIXResourceBinding* ResourceBinding( const RDIXPipeline* p )
 {
 	return p->resources;
@@ -589,12 +652,22 @@ RDITextureDepth TextureDepth( RDIXRenderTarget * rtarget )
 struct RDIXRenderSource
 {
 	uint8_t num_vertex_buffers = 0;
-	uint8_t num_draw_ranges = 0;
+    uint8_t num_lods = 0;
+	uint16_t num_draw_ranges = 0; // LODs x parts of compiled meshes easily go past 255
+    uint16_t num_part_ranges = 0; // ranges from desc. Whole buffer range follows them
     uint16_t managed_buffers_mask = 0;
     
     RDIIndexBuffer index_buffer;
 	RDIVertexBuffer* vertex_buffers = nullptr;
 	RDIXRenderSourceRange* draw_ranges = nullptr;
+    RDIXRenderSourceLod* lods = nullptr;
+    float bounding_sphere[4] = {};
+    float position_min[3] = {};
+    float position_extent[3] = {};
+
+    uint32_t num_meshlets = 0;
+    RDIXMeshlet* meshlets = nullptr;
+    uint32_t* range_meshlets = nullptr; // num_draw_ranges + 1 entries when num_meshlets > 0
 
     BXIAllocator* allocator = nullptr;
 
@@ -607,10 +680,17 @@ RDIXRenderSource* CreateRenderSource( RDIDevice* dev, const RDIXRenderSourceDesc
 {
 	const uint32_t num_streams = desc.vertex_layout.count;
     const uint32_t num_draw_ranges = desc.num_draw_ranges + 1; // max_of_2( 1u, desc.num_draw_ranges );
+    const uint32_t num_lods = desc.num_lods;
+    const uint32_t num_meshlets = desc.num_meshlets;
+    const uint32_t num_range_meshlets = ( num_meshlets ) ? num_draw_ranges + 1 : 0;
+    SYS_ASSERT( num_draw_ranges <= UINT16_MAX && num_lods <= UINT8_MAX );
 
 	uint32_t mem_size = sizeof( RDIXRenderSource );
 	mem_size += (num_streams) * sizeof( RDIVertexBuffer );
 	mem_size += num_draw_ranges * sizeof( RDIXRenderSourceRange );
+	mem_size += num_lods * sizeof( RDIXRenderSourceLod );
+	mem_size += num_meshlets * sizeof( RDIXMeshlet );
+	mem_size += num_range_meshlets * sizeof( uint32_t );
 
 	void* mem = BX_MALLOC( allocator, mem_size, ALIGNOF( RDIXRenderSource ) );
 	memset( mem, 0x00, mem_size );
@@ -619,10 +699,19 @@ RDIXRenderSource* CreateRenderSource( RDIDevice* dev, const RDIXRenderSourceDesc
 	RDIXRenderSource* impl = chunker.Add< RDIXRenderSource >();
 	impl->vertex_buffers   = chunker.Add< RDIVertexBuffer >( num_streams );
 	impl->draw_ranges      = chunker.Add< RDIXRenderSourceRange >( num_draw_ranges );
+	impl->lods             = chunker.Add< RDIXRenderSourceLod >( num_lods );
+	impl->meshlets         = chunker.Add< RDIXMeshlet >( num_meshlets );
+	impl->range_meshlets   = chunker.Add< uint32_t >( num_range_meshlets );
 	chunker.Check();
 
 	impl->num_vertex_buffers = num_streams;
 	impl->num_draw_ranges = num_draw_ranges;
+	impl->num_part_ranges = desc.num_draw_ranges;
+	impl->num_lods = num_lods;
+	impl->num_meshlets = num_meshlets;
+	memcpy( impl->bounding_sphere, desc.bounding_sphere, sizeof( impl->bounding_sphere ) );
+	memcpy( impl->position_min, desc.position_min, sizeof( impl->position_min ) );
+	memcpy( impl->position_extent, desc.position_extent, sizeof( impl->position_extent ) );
 
 	for( uint32_t i = 0; i < num_streams; ++i )
 	{
@@ -631,7 +720,7 @@ RDIXRenderSource* CreateRenderSource( RDIDevice* dev, const RDIXRenderSourceDesc
         impl->managed_buffers_mask |= BIT_OFFSET( i );
 	}
 
-	RDIXRenderSourceRange& default_range = impl->draw_ranges[impl->num_draw_ranges-1];
+	RDIXRenderSourceRange& default_range = impl->draw_ranges[impl->num_part_ranges];
 	if( desc.index_type != RDIEType::UNKNOWN )
 	{
 		impl->index_buffer = CreateIndexBuffer( dev, desc.index_type, desc.num_indices, desc.index_data );
@@ -652,6 +741,18 @@ RDIXRenderSource* CreateRenderSource( RDIDevice* dev, const RDIXRenderSourceDesc
 	{
 		impl->draw_ranges[i] = desc.draw_ranges[i];
 	}
+	for( uint32_t i = 0; i < num_lods; ++i )
+	{
+		SYS_ASSERT( desc.lods[i].first_range + desc.lods[i].num_ranges <= desc.num_draw_ranges );
+		impl->lods[i] = desc.lods[i];
+	}
+	if( num_meshlets )
+	{
+		SYS_ASSERT( desc.range_meshlets[desc.num_draw_ranges] == num_meshlets );
+		memcpy( impl->meshlets, desc.meshlets, num_meshlets * sizeof( RDIXMeshlet ) );
+		memcpy( impl->range_meshlets, desc.range_meshlets, ( desc.num_draw_ranges + 1 ) * sizeof( uint32_t ) );
+		impl->range_meshlets[num_draw_ranges] = num_meshlets; // default range has no meshlets
+	}
 
     impl->allocator = allocator;
 
@@ -665,10 +766,12 @@ static RDIXRenderSource* CloneForSkinning( RDIDevice* dev, const RDIXRenderSourc
     BXIAllocator* allocator = base->allocator;
     const uint32_t num_streams = base->num_vertex_buffers;
     const uint32_t num_draw_ranges = base->num_draw_ranges;
+    const uint32_t num_lods = base->num_lods;
 
     uint32_t mem_size = sizeof( RDIXRenderSource );
     mem_size += num_streams * sizeof( RDIVertexBuffer );
     mem_size += num_draw_ranges * sizeof( RDIXRenderSourceRange );
+    mem_size += num_lods * sizeof( RDIXRenderSourceLod );
 
     void* mem = BX_MALLOC( allocator, mem_size, ALIGNOF( RDIXRenderSource ) );
     memset( mem, 0x00, mem_size );
@@ -677,10 +780,16 @@ static RDIXRenderSource* CloneForSkinning( RDIDevice* dev, const RDIXRenderSourc
     RDIXRenderSource* impl = chunker.Add< RDIXRenderSource >();
     impl->vertex_buffers = chunker.Add< RDIVertexBuffer >( num_streams );
     impl->draw_ranges = chunker.Add< RDIXRenderSourceRange >( num_draw_ranges );
+    impl->lods = chunker.Add< RDIXRenderSourceLod >( num_lods );
     chunker.Check();
 
     impl->num_vertex_buffers = num_streams;
     impl->num_draw_ranges = num_draw_ranges;
+    impl->num_part_ranges = base->num_part_ranges;
+    impl->num_lods = num_lods;
+    memcpy( impl->bounding_sphere, base->bounding_sphere, sizeof( impl->bounding_sphere ) );
+    memcpy( impl->position_min, base->position_min, sizeof( impl->position_min ) );
+    memcpy( impl->position_extent, base->position_extent, sizeof( impl->position_extent ) );
 
     for( uint32_t i = 0; i < num_streams; ++i )
     {
@@ -711,6 +820,10 @@ static RDIXRenderSource* CloneForSkinning( RDIDevice* dev, const RDIXRenderSourc
     {
         impl->draw_ranges[i] = base->draw_ranges[i];
     }
+    for( uint32_t i = 0; i < num_lods; ++i )
+    {
+        impl->lods[i] = base->lods[i];
+    }
 
     impl->index_buffer = base->index_buffer;
     impl->allocator = allocator;
@@ -757,12 +870,43 @@ RDIXRenderSource* CreateRenderSourceFromMemory( RDIDevice* dev, const RDIXMeshFi
     RDIXRenderSourceDesc desc = {};
     desc.Count( header->num_vertices, header->num_indices );
 
+    // quantized streams are uploaded as they are and decoded by input assembler + shader (see InputLayout and InstanceData::vertex_flags).
+    // Skinning reads and writes float positions, normals and weights, so these are expanded for skinned meshes
     const uint32_t num_streams = header->num_streams;
+    const uint32_t float_slot_mask = ( header->num_bones ) ? RDIEVertexSlot::SkinningMaskPosNrm() | BIT_OFFSET( RDIEVertexSlot::BLENDWEIGHT ) : 0;
+
+    uint32_t decoded_size = 0;
+    for( uint32_t i = 0; i < num_streams; ++i )
+    {
+        if( header->encodings[i] != RDIXEVertexEncoding::NONE && ( float_slot_mask & BIT_OFFSET( header->descs[i].slot ) ) )
+            decoded_size += header->descs[i].ByteWidth() * header->num_vertices;
+    }
+
+    uint8_t* decoded_memory = ( decoded_size ) ? (uint8_t*)BX_MALLOC( allocator, decoded_size, 16 ) : nullptr;
+    uint8_t* decoded_iterator = decoded_memory;
+
     for( uint32_t i = 0; i < num_streams; ++i )
     {
-        const RDIVertexBufferDesc& stream_desc = header->descs[i];
+        const RDIXEVertexEncoding::Enum encoding = (RDIXEVertexEncoding::Enum)header->encodings[i];
+        RDIVertexBufferDesc stream_desc = header->descs[i];
         const void* data_pointer = TYPE_OFFSET_GET_POINTER( void, header->offset_streams[i] );
 
+        if( encoding != RDIXEVertexEncoding::NONE && ( float_slot_mask & BIT_OFFSET( stream_desc.slot ) ) )
+        {
+            DecodeVertexStream( decoded_iterator, header, i );
+            data_pointer = decoded_iterator;
+            decoded_iterator += stream_desc.ByteWidth() * header->num_vertices;
+        }
+        else if( encoding != RDIXEVertexEncoding::NONE )
+        {
+            if( encoding == RDIXEVertexEncoding::UNORM16_BOX )
+            {
+                memcpy( desc.position_min, header->position_min, sizeof( desc.position_min ) );
+                memcpy( desc.position_extent, header->position_extent, sizeof( desc.position_extent ) );
+            }
+            stream_desc = EncodedVertexDesc( stream_desc, encoding );
+        }
+
         desc.VertexBuffer( stream_desc, data_pointer );
     }
 
@@ -774,7 +918,29 @@ RDIXRenderSource* CreateRenderSourceFromMemory( RDIDevice* dev, const RDIXMeshFi
         desc.IndexBuffer( type, data_pointer );
     }
 
-    return CreateRenderSource( dev, desc, allocator );
+    if( header->num_draw_ranges )
+    {
+        SYS_ASSERT( header->num_draw_ranges < UINT16_MAX );
+        desc.num_draw_ranges = header->num_draw_ranges;
+        desc.draw_ranges = TYPE_OFFSET_GET_POINTER( const RDIXRenderSourceRange, header->offset_draw_ranges );
+    }
+    if( header->num_lods )
+    {
+        desc.num_lods = header->num_lods;
+        desc.lods = TYPE_OFFSET_GET_POINTER( const RDIXRenderSourceLod, header->offset_lods );
+    }
+    if( header->num_meshlets )
+    {
+        desc.num_meshlets = header->num_meshlets;
+        desc.meshlets = TYPE_OFFSET_GET_POINTER( const RDIXMeshlet, header->offset_meshlets );
+        desc.range_meshlets = TYPE_OFFSET_GET_POINTER( const uint32_t, header->offset_range_meshlets );
+    }
+    memcpy( desc.bounding_sphere, header->bounds.sphere, sizeof( desc.bounding_sphere ) );
+
+    RDIXRenderSource* rsource = CreateRenderSource( dev, desc, allocator );
+    BX_FREE( allocator, decoded_memory );
+
+    return rsource;
 }
 
 void DestroyRenderSource( RDIXRenderSource** rsource )
@@ -827,16 +993,31 @@ void SubmitRenderSource( RDICommandQueue* cmdq, RDIXRenderSource* renderSource,
 {
     SetTopology( cmdq, range.topology );
     if( renderSource->index_buffer.id )
-        DrawIndexed( cmdq, range.count, range.begin, 0 );
+        DrawIndexed( cmdq, range.count, range.begin, range.base_vertex );
     else
         Draw( cmdq, range.count, range.begin );
 }
 
+void SubmitRenderSourceInstanced( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXRenderSource* renderSource, uint32_t numInstances, uint32_t rangeIndex )
+{
+    SYS_ASSERT( rangeIndex < renderSource->num_draw_ranges );
+    SubmitRenderSourceInstanced( cmdq, cache, renderSource, numInstances, renderSource->draw_ranges[rangeIndex] );
+}
+
+void SubmitRenderSourceInstanced( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXRenderSource* renderSource, uint32_t numInstances, const RDIXRenderSourceRange& range )
+{
+    BindTopology( cmdq, cache, range.topology );
+    SubmitRenderSourceInstanced( cmdq, renderSource, numInstances, range );
+}
+
 void SubmitRenderSourceInstanced( RDICommandQueue* cmdq, RDIXRenderSource* renderSource, uint32_t numInstances, uint32_t rangeIndex )
 {
 	SYS_ASSERT( rangeIndex < renderSource->num_draw_ranges );
-	RDIXRenderSourceRange range = renderSource->draw_ranges[rangeIndex];
+	SubmitRenderSourceInstanced( cmdq, renderSource, numInstances, renderSource->draw_ranges[rangeIndex] );
+}
 
+void SubmitRenderSourceInstanced( RDICommandQueue* cmdq, RDIXRenderSource* renderSource, uint32_t numInstances, const RDIXRenderSourceRange& range )
+{
 	if( renderSource->index_buffer.id )
 		DrawIndexedInstanced( cmdq, range.count, range.begin, numInstances, range.base_vertex );
 	else
@@ -847,6 +1028,23 @@ uint32_t NumVertexBuffers( const RDIXRenderSource* rsource ){ return rsource->nu
 uint32_t NumVertices     ( const RDIXRenderSource* rsource ){ return rsource->vertex_buffers[0].numElements; }
 uint32_t NumIndices      ( const RDIXRenderSource* rsource ){ return rsource->index_buffer.numElements; }
 uint32_t NumRanges       ( const RDIXRenderSource* rsource ){ return rsource->num_draw_ranges; }
+uint32_t NumPartRanges   ( const RDIXRenderSource* rsource ){ return rsource->num_part_ranges; }
+uint32_t DefaultRange    ( const RDIXRenderSource* rsource ){ return rsource->num_part_ranges; }
+uint32_t NumLods         ( const RDIXRenderSource* rsource ){ return rsource->num_lods; }
+const float* BoundingSphere( const RDIXRenderSource* rsource ){ return rsource->bounding_sphere; }
+const float* PositionBoxMin( const RDIXRenderSource* rsource ){ return rsource->position_min; }
+const float* PositionBoxExtent( const RDIXRenderSource* rsource ){ return rsource->position_extent; }
+
+array_span_t<const RDIXMeshlet> Meshlets( const RDIXRenderSource* rsource, uint32_t range_index )
+{
+    SYS_ASSERT( range_index < rsource->num_draw_ranges );
+    if( !rsource->num_meshlets )
+        return array_span_t<const RDIXMeshlet>();
+
+    const uint32_t begin = rsource->range_meshlets[range_index];
+    const uint32_t end = rsource->range_meshlets[range_index + 1];
+    return to_array_span( (const RDIXMeshlet*)rsource->meshlets + begin, end - begin );
+}
 
 RDIVertexBuffer FindVertexBuffer( const RDIXRenderSource* rsource, RDIEVertexSlot::Enum slot )
 {
@@ -870,6 +1068,11 @@ RDIXRenderSourceRange Range( const RDIXRenderSource* rsource, uint32_t index )
 	SYS_ASSERT( index < rsource->num_draw_ranges );
 	return rsource->draw_ranges[index];
 }
+RDIXRenderSourceLod Lod( const RDIXRenderSource* rsource, uint32_t index )
+{
+    SYS_ASSERT( index < rsource->num_lods );
+    return rsource->lods[index];
+}
 
 
 // ---
@@ -921,7 +1124,8 @@ RDIXTransformBuffer* CreateTransformBuffer( RDIDevice* dev, const RDIXTransformB
     const RDIFormat gpu_format_mit = RDIFormat::Float3();
     const uint32_t num_elements = 3 * desc.capacity; // 3 x float4 (matrix) or 3 x float3 (matrix it)
 
-	buffer->gpu_instance_offset = CreateConstantBuffer( dev, 16 );
+	SYS_ASSERT( desc.instance_data_size && ( desc.instance_data_size % 16 ) == 0 );
+	buffer->gpu_instance_offset = CreateConstantBuffer( dev, desc.instance_data_size );
 	buffer->gpu_buffer_matrix = CreateBufferRO( dev, num_elements, gpu_format_m, RDIECpuAccess::WRITE );
 	buffer->gpu_buffer_matrix_it = CreateBufferRO( dev, num_elements, gpu_format_mit, RDIECpuAccess::WRITE );
 	buffer->max_elements = desc.capacity;
@@ -1049,3 +1253,217 @@ RDIConstantBuffer GetInstanceOffsetCBuffer( RDIXTransformBuffer * cmdbuff )
 {
     return cmdbuff->gpu_instance_offset;
 }
+
+// --- StateCache
+namespace
+{
+    template< uint32_t N >
+    static bool UpdateSlot( uintptr_t( &slots )[RDIEPipeline::COUNT][N], uint32_t slot, uint32_t stage_mask, uintptr_t key )
+    {
+        SYS_ASSERT( slot < N );
+
+        bool redundant = true;
+        for( uint32_t istage = 0; istage < RDIEPipeline::COUNT; ++istage )
+        {
+            if( ( stage_mask & BIT_OFFSET( istage ) ) == 0 )
+                continue;
+
+            redundant &= slots[istage][slot] == key;
+            slots[istage][slot] = key;
+        }
+        return redundant;
+    }
+
+    template< uint32_t N >
+    static void SetSlotResource( uintptr_t( &ids )[RDIEPipeline::COUNT][N], uint32_t slot, uint32_t stage_mask, uintptr_t resource_id )
+    {
+        for( uint32_t istage = 0; istage < RDIEPipeline::COUNT; ++istage )
+        {
+            if( stage_mask & BIT_OFFSET( istage ) )
+                ids[istage][slot] = resource_id;
+        }
+    }
+
+    // forgets only slots holding a view of 'resource_id'
+    template< uint32_t N >
+    static void InvalidateAliasingSlots( uintptr_t( &slots )[RDIEPipeline::COUNT][N], uintptr_t( &ids )[RDIEPipeline::COUNT][N], uintptr_t resource_id )
+    {
+        if( !resource_id )
+            return;
+
+        for( uint32_t istage = 0; istage < RDIEPipeline::COUNT; ++istage )
+        {
+            for( uint32_t i = 0; i < N; ++i )
+            {
+                if( ids[istage][i] == resource_id )
+                {
+                    slots[istage][i] = RDIXStateCache::UNKNOWN;
+                    ids[istage][i] = RDIXStateCache::UNKNOWN;
+                }
+            }
+        }
+    }
+
+    template< uint32_t N >
+    static void InvalidateSlots( uintptr_t( &slots )[RDIEPipeline::COUNT][N] )
+    {
+        for( uint32_t istage = 0; istage < RDIEPipeline::COUNT; ++istage )
+            for( uint32_t i = 0; i < N; ++i )
+                slots[istage][i] = RDIXStateCache::UNKNOWN;
+    }
+
+    static inline bool CountBind( RDIXStateCache* cache, bool redundant )
+    {
+        cache->stats.skipped_binds += ( redundant ) ? 1 : 0;
+        cache->stats.binds += ( redundant ) ? 0 : 1;
+        return !redundant;
+    }
+
+    // input layout depends on pipeline and on stream formats of render source
+    static void BindCachedInputLayout( RDICommandQueue* cmdq, RDIXStateCache* cache )
+    {
+        if( cache->pipeline == RDIXStateCache::UNKNOWN )
+            return;
+
+        RDIXPipeline* pipeline = (RDIXPipeline*)cache->pipeline;
+        const RDIXRenderSource* rsource = ( cache->render_source != RDIXStateCache::UNKNOWN ) ? (RDIXRenderSource*)cache->render_source : nullptr;
+        const RDIInputLayout layout = InputLayout( pipeline, rsource );
+        if( CountBind( cache, cache->input_layout == layout.id ) )
+        {
+            SetInputLayout( cmdq, layout );
+            cache->input_layout = layout.id;
+        }
+    }
+}///
+
+void InvalidateStateCache( RDIXStateCache* cache )
+{
+    cache->pipeline = RDIXStateCache::UNKNOWN;
+    cache->render_source = RDIXStateCache::UNKNOWN;
+    cache->topology = RDIXStateCache::UNKNOWN;
+    cache->input_layout = RDIXStateCache::UNKNOWN;
+    InvalidateResourcesCache( cache );
+    InvalidateSlots( cache->cbuffers );
+    InvalidateSlots( cache->samplers );
+}
+
+void InvalidateResourcesCache( RDIXStateCache* cache )
+{
+    InvalidateSlots( cache->resources_ro );
+    InvalidateSlots( cache->resources_rw );
+    InvalidateSlots( cache->resources_ro_id );
+    InvalidateSlots( cache->resources_rw_id );
+}
+
+void BindPipeline( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXPipeline* pipeline, bool bindResources )
+{
+    const uintptr_t key = (uintptr_t)pipeline;
+    if( CountBind( cache, cache->pipeline == key ) )
+    {
+        SetShaderPass( cmdq, pipeline->pass );
+        SetHardwareState( cmdq, pipeline->hardware_state );
+        cache->pipeline = key;
+        BindCachedInputLayout( cmdq, cache );
+    }
+
+    // tracked apart from pipeline, because draw ranges can change it under the same pipeline
+    BindTopology( cmdq, cache, pipeline->topology );
+
+    if( pipeline->resources && bindResources )
+    {
+        BindResources( cmdq, cache, pipeline->resources );
+    }
+}
+
+void BindResources( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXResourceBinding* rbind )
+{
+    const RDIXResourceBinding::Binding* bindings = rbind->Bindings();
+    uint8_t* data = rbind->Data();
+    const uint32_t n = rbind->count;
+
+    for( uint32_t i = 0; i < n; ++i )
+    {
+        const RDIXResourceBinding::Binding b = bindings[i];
+        uint8_t* resource_data = data + b.data_offset;
+        switch( b.binding_type )
+        {
+        case RDIXResourceSlot::READ_ONLY:
+            BindResourceRO( cmdq, cache, *(RDIResourceRO*)resource_data, b.slot, b.stage_mask );
+            break;
+        case RDIXResourceSlot::READ_WRITE:
+            BindResourceRW( cmdq, cache, *(RDIResourceRW*)resource_data, b.slot, b.stage_mask );
+            break;
+        case RDIXResourceSlot::UNIFORM:
+            BindConstantBuffer( cmdq, cache, *(RDIConstantBuffer*)resource_data, b.slot, b.stage_mask );
+            break;
+        case RDIXResourceSlot::SAMPLER:
+            BindSampler( cmdq, cache, *(RDISampler*)resource_data, b.slot, b.stage_mask );
+            break;
+        default:
+            SYS_NOT_IMPLEMENTED;
+            break;
+        }
+    }
+}
+
+void BindRenderSource( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXRenderSource* renderSource )
+{
+    const uintptr_t key = (uintptr_t)renderSource;
+    if( CountBind( cache, cache->render_source == key ) )
+    {
+        BindRenderSource( cmdq, renderSource );
+        cache->render_source = key;
+        BindCachedInputLayout( cmdq, cache );
+    }
+}
+
+void BindTopology( RDICommandQueue* cmdq, RDIXStateCache* cache, uint32_t topology )
+{
+    if( cache->topology != topology )
+    {
+        SetTopology( cmdq, topology );
+        cache->topology = topology;
+    }
+}
+
+void BindResourceRO( RDICommandQueue* cmdq, RDIXStateCache* cache, const RDIResourceRO& resource, uint32_t slot, uint32_t stage_mask )
+{
+    const uintptr_t key = (uintptr_t)resource.viewSH;
+    if( CountBind( cache, UpdateSlot( cache->resources_ro, slot, stage_mask, key ) ) )
+    {
+        SetResourcesRO( cmdq, (RDIResourceRO*)&resource, slot, 1, stage_mask );
+        SetSlotResource( cache->resources_ro_id, slot, stage_mask, resource.id );
+
+        // and the other way around
+        InvalidateAliasingSlots( cache->resources_rw, cache->resources_rw_id, resource.id );
+    }
+}
+
+void BindResourceRW( RDICommandQueue* cmdq, RDIXStateCache* cache, const RDIResourceRW& resource, uint32_t slot, uint32_t stage_mask )
+{
+    const uintptr_t key = (uintptr_t)resource.viewUA;
+    if( CountBind( cache, UpdateSlot( cache->resources_rw, slot, stage_mask, key ) ) )
+    {
+        SetResourcesRW( cmdq, (RDIResourceRW*)&resource, slot, 1, stage_mask );
+        SetSlotResource( cache->resources_rw_id, slot, stage_mask, resource.id );
+
+        // binding UAV unbinds SRVs of the same resource on the API side
+        InvalidateAliasingSlots( cache->resources_ro, cache->resources_ro_id, resource.id );
+    }
+}
+
+void BindConstantBuffer( RDICommandQueue* cmdq, RDIXStateCache* cache, const RDIConstantBuffer& cbuffer, uint32_t slot, uint32_t stage_mask )
+{
+    if( CountBind( cache, UpdateSlot( cache->cbuffers, slot, stage_mask, cbuffer.id ) ) )
+    {
+        SetCbuffers( cmdq, (RDIConstantBuffer*)&cbuffer, slot, 1, stage_mask );
+    }
+}
+
+void BindSampler( RDICommandQueue* cmdq, RDIXStateCache* cache, const RDISampler& sampler, uint32_t slot, uint32_t stage_mask )
+{
+    if( CountBind( cache, UpdateSlot( cache->samplers, slot, stage_mask, sampler.id ) ) )
+    {
+        SetSamplers( cmdq, (RDISampler*)&sampler, slot, 1, stage_mask );
+    }
+}
@@ -28,6 +28,10 @@ RDIXPipeline*		 CreatePipeline ( RDIDevice* dev, const RDIXPipelineDesc& desc, B
 void				 DestroyPipeline( RDIXPipeline** pipeline );
 void				 BindPipeline( RDICommandQueue* cmdq, RDIXPipeline* pipeline, bool bindResources );
 RDIXResourceBinding* ResourceBinding( const RDIXPipeline* p );
+// BindPipeline sets layout for float streams. Render sources with packed streams (CreateRenderSourceFromMemory)
+// need layout matching their formats. Cached binds resolve it on their own
+RDIInputLayout		 InputLayout    ( RDIXPipeline* pipeline, const RDIXRenderSource* rsource );
+void				 BindInputLayout( RDICommandQueue* cmdq, RDIXPipeline* pipeline, const RDIXRenderSource* rsource );
 
 
 // --- Resources
@@ -72,20 +76,33 @@ RDIXRenderSource* CreateRenderSourceFromShape( RDIDevice* dev, const poly_shape_
 RDIXRenderSource* CreateRenderSourceFromMemory( RDIDevice* dev, const RDIXMeshFile* header, BXIAllocator* allocator );
 void			  DestroyRenderSource( RDIXRenderSource** rsource );
 void			  BindRenderSource( RDICommandQueue* cmdq, RDIXRenderSource* renderSource );
+// sets topology of range directly. Between cached binds use overload taking RDIXStateCache
 void			  SubmitRenderSource( RDICommandQueue* cmdq, RDIXRenderSource* renderSource, uint32_t rangeIndex = 0 );
 void			  SubmitRenderSource( RDICommandQueue* cmdq, RDIXRenderSource* renderSource, const RDIXRenderSourceRange& range );
 
 void			  SubmitRenderSourceInstanced( RDICommandQueue* cmdq, RDIXRenderSource* renderSource, uint32_t numInstances, uint32_t rangeIndex = 0 );
+void			  SubmitRenderSourceInstanced( RDICommandQueue* cmdq, RDIXRenderSource* renderSource, uint32_t numInstances, const RDIXRenderSourceRange& range );
 
 
 uint32_t             NumVertexBuffers( const RDIXRenderSource* rsource );
 uint32_t             NumVertices     ( const RDIXRenderSource* rsource );
 uint32_t             NumIndices      ( const RDIXRenderSource* rsource );
 uint32_t             NumRanges       ( const RDIXRenderSource* rsource );
+// ranges passed in RDIXRenderSourceDesc (parts). Range covering whole buffer is stored after them at DefaultRange
+uint32_t             NumPartRanges   ( const RDIXRenderSource* rsource );
+uint32_t             DefaultRange    ( const RDIXRenderSource* rsource );
 RDIVertexBuffer      FindVertexBuffer( const RDIXRenderSource* rsource, RDIEVertexSlot::Enum slot );
 RDIVertexBuffer      VertexBuffer    ( const RDIXRenderSource* rsource, uint32_t index );
 RDIIndexBuffer       IndexBuffer     ( const RDIXRenderSource* rsource );
 RDIXRenderSourceRange Range          ( const RDIXRenderSource* rsource, uint32_t index );
+uint32_t             NumLods         ( const RDIXRenderSource* rsource );
+RDIXRenderSourceLod  Lod             ( const RDIXRenderSource* rsource, uint32_t index );
+const float*         BoundingSphere  ( const RDIXRenderSource* rsource );
+// position = min + stream_value * extent. Identity (0 / 1) when POSITION stream is not normalized
+const float*         PositionBoxMin   ( const RDIXRenderSource* rsource );
+const float*         PositionBoxExtent( const RDIXRenderSource* rsource );
+// meshlets of draw range, empty when render source has none (skinned clones never have meshlets)
+array_span_t<const RDIXMeshlet> Meshlets( const RDIXRenderSource* rsource, uint32_t range_index );
 
 // --- TransformBuffer
 struct RDIXTransformBufferBindInfo
@@ -113,4 +130,20 @@ struct RDIXTransformBufferCommands
 	RDIXCommand* last;
 };
 RDIXTransformBufferCommands UploadAndSetTransformBuffer( RDIXCommandBuffer* cmdbuff, RDIXCommand* parentcmd, RDIXTransformBuffer* buffer, const RDIXTransformBufferBindInfo& bind_info );
-RDIConstantBuffer GetInstanceOffsetCBuffer( RDIXTransformBuffer* cmdbuff );
\ No newline at end of file
+RDIConstantBuffer GetInstanceOffsetCBuffer( RDIXTransformBuffer* cmdbuff );
+
+// --- StateCache
+// cached binds skip backend call when the same object is already bound in all stages from stage_mask
+void InvalidateStateCache    ( RDIXStateCache* cache );
+void InvalidateResourcesCache( RDIXStateCache* cache );
+void BindPipeline      ( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXPipeline* pipeline, bool bindResources );
+void BindResources     ( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXResourceBinding* binding );
+void BindRenderSource  ( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXRenderSource* renderSource );
+void BindTopology      ( RDICommandQueue* cmdq, RDIXStateCache* cache, uint32_t topology );
+void BindResourceRO    ( RDICommandQueue* cmdq, RDIXStateCache* cache, const RDIResourceRO& resource, uint32_t slot, uint32_t stage_mask );
+void BindResourceRW    ( RDICommandQueue* cmdq, RDIXStateCache* cache, const RDIResourceRW& resource, uint32_t slot, uint32_t stage_mask );
+void BindConstantBuffer( RDICommandQueue* cmdq, RDIXStateCache* cache, const RDIConstantBuffer& cbuffer, uint32_t slot, uint32_t stage_mask );
+void BindSampler       ( RDICommandQueue* cmdq, RDIXStateCache* cache, const RDISampler& sampler, uint32_t slot, uint32_t stage_mask );
+// like SubmitRenderSourceInstanced, but topology of range goes through cache
+void SubmitRenderSourceInstanced( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXRenderSource* renderSource, uint32_t numInstances, uint32_t rangeIndex );
+void SubmitRenderSourceInstanced( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXRenderSource* renderSource, uint32_t numInstances, const RDIXRenderSourceRange& range );
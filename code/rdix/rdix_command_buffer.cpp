@@ -9,7 +9,7 @@
 #include <algorithm>
 
 #define RDIX_DEFINE_COMMAND( name, block )\
-void Dispatch_##name( RDICommandQueue* cmdq, RDIXCommand* cmdAddr )\
+void Dispatch_##name( RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXCommand* cmdAddr )\
 {\
     name* cmd = (name*)cmdAddr;\
     block\
@@ -17,7 +17,11 @@ void Dispatch_##name( RDICommandQueue* cmdq, RDIXCommand* cmdAddr )\
 const DispatchFunction name::DISPATCH_FUNCTION = Dispatch_##name
 
 RDIX_DEFINE_COMMAND( RDIXSetRenderTargetCmd,
-{ BindRenderTarget( cmdq, cmd->rtarget, cmd->color_textures_mask, cmd->depth ? true : false ); } );
+{
+    BindRenderTarget( cmdq, cmd->rtarget, cmd->color_textures_mask, cmd->depth ? true : false );
+    // API unbinds shader resources which alias new render targets
+    InvalidateResourcesCache( cache );
+} );
 
 RDIX_DEFINE_COMMAND( RDIXClearRenderTargetCmd,
 {
@@ -29,24 +33,33 @@ RDIX_DEFINE_COMMAND( RDIXClearRenderTargetCmd,
 
 
 RDIX_DEFINE_COMMAND( RDIXSetPipelineCmd, 
-{ BindPipeline( cmdq, cmd->pipeline, cmd->bindResources ? true : false ); } );
+{ BindPipeline( cmdq, cache, cmd->pipeline, cmd->bindResources ? true : false ); } );
 
 RDIX_DEFINE_COMMAND( RDIXSetResourcesCmd,
-{ BindResources( cmdq, cmd->rbind ); } );
+{ BindResources( cmdq, cache, cmd->rbind ); } );
 
 RDIX_DEFINE_COMMAND( RDIXSetResourceROCmd,
-{ SetResourcesRO( cmdq, &cmd->resource, cmd->slot, 1, cmd->stage_mask ); } );
+{ BindResourceRO( cmdq, cache, cmd->resource, cmd->slot, cmd->stage_mask ); } );
 
 RDIX_DEFINE_COMMAND( RDIXSetConstantBufferCmd,
-{ SetCbuffers( cmdq, &cmd->resource, cmd->slot, 1, cmd->stage_mask ); } );
+{ BindConstantBuffer( cmdq, cache, cmd->resource, cmd->slot, cmd->stage_mask ); } );
 
 RDIX_DEFINE_COMMAND( RDIXSetRenderSourceCmd, 
-{ BindRenderSource( cmdq, cmd->rsource ); } );
+{ BindRenderSource( cmdq, cache, cmd->rsource ); } );
 
 RDIX_DEFINE_COMMAND( RDIXDrawRenderSourceCmd,
 {
-    BindRenderSource( cmdq, cmd->rsource );
-    SubmitRenderSourceInstanced( cmdq, cmd->rsource, cmd->num_instances, cmd->rsouce_range );
+    BindRenderSource( cmdq, cache, cmd->rsource );
+    for( uint32_t i = 0; i < cmd->num_ranges; ++i )
+        SubmitRenderSourceInstanced( cmdq, cache, cmd->rsource, cmd->num_instances, cmd->rsouce_range + i );
+} );
+
+RDIX_DEFINE_COMMAND( RDIXDrawRenderSourceRangesCmd,
+{
+    BindRenderSource( cmdq, cache, cmd->rsource );
+    const RDIXRenderSourceRange* ranges = cmd->Ranges();
+    for( uint32_t i = 0; i < cmd->num_ranges; ++i )
+        SubmitRenderSourceInstanced( cmdq, cache, cmd->rsource, cmd->num_instances, ranges[i] );
 } );
 
 RDIX_DEFINE_COMMAND( RDIXDrawCmd,
@@ -66,7 +79,11 @@ RDIX_DEFINE_COMMAND( RDIXUpdateBufferCmd,
 } );
 
 RDIX_DEFINE_COMMAND( RDIXDrawCallbackCmd,
-{ (*cmd->ptr)(cmdq, cmd->flags, cmd->user_data); } );
+{
+    (*cmd->ptr)(cmdq, cmd->flags, cmd->user_data);
+    // callback can change anything
+    InvalidateStateCache( cache );
+} );
 
 // ---
 struct RDIXCommandBuffer
@@ -97,6 +114,8 @@ struct RDIXCommandBuffer
 
 	uint32_t _can_add_commands = 0;
 
+	RDIXStateCache _state_cache;
+
 	void AllocateData( uint32_t maxCommands, uint32_t dataCapacity, BXIAllocator* allocator );
 	void FreeData( BXIAllocator* allocator );
 };
@@ -190,16 +209,26 @@ void SubmitCommandBuffer( RDICommandQueue* cmdq, RDIXCommandBuffer* cmdBuff )
 	RDIXCommandBuffer::Data& data = cmdBuff->_data;
 	std::sort( data.commands, data.commands + data.num_commands, CmdInternalCmp() );
 
+	// state could be changed outside command buffer since last submit, so cache starts from scratch
+	RDIXStateCache* cache = &cmdBuff->_state_cache;
+	InvalidateStateCache( cache );
+	cache->stats = {};
+
 	for( uint32_t i = 0; i < data.num_commands; ++i )
 	{
 		RDIXCommand* cmd = data.commands[i].cmd;
 		while( cmd )
 		{
-			(*cmd->_dispatch_ptr)(cmdq, cmd);
+			(*cmd->_dispatch_ptr)(cmdq, cache, cmd);
+			cache->stats.commands += 1;
 			cmd = cmd->_next;
 		}
 	}
 }
+const RDIXDispatchStats& DispatchStats( const RDIXCommandBuffer* cmdBuff )
+{
+	return cmdBuff->_state_cache.stats;
+}
 bool SubmitCommand( RDIXCommandBuffer* cmdbuff, RDIXCommand* cmdPtr, uint64_t sortKey )
 {
 	SYS_ASSERT( cmdbuff->_can_add_commands );
@@ -11,9 +11,12 @@ struct RDIXPipeline;
 struct RDIXResourceBinding;
 struct RDIXRenderTarget;
 struct RDIXRenderSource;
+struct RDIXRenderSourceRange;
+struct RDIXStateCache;
+struct RDIXDispatchStats;
 
 struct RDIXCommand;
-typedef void( *DispatchFunction )(RDICommandQueue* cmdq, RDIXCommand* cmdAddr);
+typedef void( *DispatchFunction )(RDICommandQueue* cmdq, RDIXStateCache* cache, RDIXCommand* cmdAddr);
 
 
 struct RDIXCommand
@@ -125,6 +128,17 @@ struct RDIXDrawRenderSourceCmd : RDIXCommand
 	RDIXRenderSource* rsource = nullptr;
 	uint16_t rsouce_range = 0;
 	uint16_t num_instances = 0;
+	uint16_t num_ranges = 1; // consecutive ranges starting at rsouce_range
+};
+
+// draws ranges stored right after command (eg. visible meshlets compacted on CPU)
+struct RDIXDrawRenderSourceRangesCmd : RDIXCommand
+{
+    RDIX_DECLARE_COMMAND;
+    RDIXRenderSource* rsource = nullptr;
+    uint16_t num_instances = 0;
+    uint16_t num_ranges = 0;
+    RDIXRenderSourceRange* Ranges() { return (RDIXRenderSourceRange*)(this + 1); }
 };
 
 struct RDIXDrawCmd : RDIXCommand
@@ -191,6 +205,8 @@ void EndCommandBuffer    ( RDIXCommandBuffer* cmdBuff );
 bool SubmitCommand       ( RDIXCommandBuffer* cmdbuff, RDIXCommand* cmdPtr, uint64_t sortKey );
 void* _AllocateCommand   ( RDIXCommandBuffer* cmdbuff, uint32_t cmdSize );
 void SubmitCommandBuffer ( RDICommandQueue* cmdq, RDIXCommandBuffer* cmdBuff );
+// stats from last SubmitCommandBuffer
+const RDIXDispatchStats& DispatchStats( const RDIXCommandBuffer* cmdBuff );
 
 template< typename T, class ...CmdArgs >
 T* AllocateCommandWithData( RDIXCommandBuffer* cmdbuff, uint32_t dataSize, RDIXCommand* parent_cmd, CmdArgs&&... cmdargs )
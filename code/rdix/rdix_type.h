@@ -145,6 +145,28 @@ struct RDIXRenderSourceRange
         , begin( b ), count( c ), base_vertex( bv ) {}
 };
 
+// --- consecutive draw ranges making one level of detail
+struct RDIXRenderSourceLod
+{
+    uint16_t first_range = 0;
+    uint16_t num_ranges = 0;
+    float error = 0.f; // object space distance to LOD0 surface
+};
+
+// --- cluster of consecutive triangles of one draw range, culled on CPU as a whole
+struct RDIXMeshlet
+{
+    static constexpr uint32_t MAX_VERTICES = 64;
+    static constexpr uint32_t MAX_TRIANGLES = 124;
+
+    float sphere[4] = {};      // object space, center xyz, radius w
+    float cone_axis[3] = {};   // average triangle normal
+    float cone_cutoff = 1.f;   // sine of normal cone half angle, 1 disables backface test
+    uint32_t first_index = 0;  // into index buffer, draw range's base_vertex applies
+    uint16_t num_indices = 0;
+    uint16_t num_vertices = 0;
+};
+
 struct RDIXRenderSourceDesc
 {
 	uint32_t num_vertices = 0;
@@ -160,6 +182,16 @@ struct RDIXRenderSourceDesc
 
 	const RDIXRenderSourceRange* draw_ranges = nullptr;
 
+	uint32_t num_lods = 0;
+	const RDIXRenderSourceLod* lods = nullptr; // ranges of lods index draw_ranges
+	float bounding_sphere[4] = {};             // used for LOD selection
+	float position_min[3] = { 0.f, 0.f, 0.f }; // dequantization box of normalized positions, see PositionBoxMin
+	float position_extent[3] = { 1.f, 1.f, 1.f };
+
+	uint32_t num_meshlets = 0;
+	const RDIXMeshlet* meshlets = nullptr;
+	const uint32_t* range_meshlets = nullptr; // num_draw_ranges + 1 entries, first meshlet of each draw range
+
 	RDIXRenderSourceDesc& Count( uint32_t nVertices, uint32_t nIndices = 0 )
 	{
 		num_vertices = nVertices;
@@ -191,9 +223,34 @@ struct RDIXRenderSourceDesc
 	}
 };
 
+// --- how vertex stream is stored in RDIXMeshFile. descs[] always describe decoded (runtime) format.
+namespace RDIXEVertexEncoding
+{
+    enum Enum : uint8_t
+    {
+        NONE = 0,       // stored as described by desc
+        UNORM16_BOX,    // 4 x u16 normalized to RDIXMeshFile position box (w unused)
+        OCT_SNORM16,    // unit vector, octahedral mapping, 2 x s16 normalized
+        HALF,           // each component as half float
+        UNORM8,         // each component as u8 normalized, padded to 4 bytes
+
+        COUNT,
+    };
+}//
+
+// --- precomputed bounds stored in RDIXMeshFile (decoded positions, bind pose for skinned meshes)
+struct RDIXMeshBounds
+{
+    float aabb_min[3] = {};
+    float aabb_max[3] = {};
+    float sphere[4] = {}; // center xyz, radius w. Negative radius when nothing is bounded (eg. bone without weighted vertices)
+
+    bool Empty() const { return sphere[3] < 0.f; }
+};
+
 struct BIT_ALIGNMENT_16 RDIXMeshFile
 {
-    static constexpr uint32_t VERSION = BX_UTIL_MAKE_VERSION( 1, 1, 0 );
+    static constexpr uint32_t VERSION = BX_UTIL_MAKE_VERSION( 1, 5, 0 );
     static constexpr uint32_t TAG = BX_UTIL_TAG32( 'M','E','S','H' );
 
     uint32_t num_vertices = 0;
@@ -211,6 +268,21 @@ struct BIT_ALIGNMENT_16 RDIXMeshFile
     uint32_t offset_bones_names = 0;
     uint32_t offset_draw_ranges = 0;   
 
+    uint8_t encodings[RDIEVertexSlot::COUNT] = {}; // RDIXEVertexEncoding per stream
+    float position_min[3] = {};                    // dequantization box for UNORM16_BOX positions
+    float position_extent[3] = {};
+
+    RDIXMeshBounds bounds;                 // whole mesh
+    uint32_t offset_draw_ranges_bounds = 0; // num_draw_ranges x RDIXMeshBounds
+    uint32_t offset_bones_bounds = 0;       // num_bones x RDIXMeshBounds, in bone space (bind pose transformed by bone offset matrix)
+
+    uint16_t num_lods = 0;                  // 0 for non indexed meshes
+    uint32_t offset_lods = 0;               // num_lods x RDIXRenderSourceLod, LOD0 first
+
+    uint32_t num_meshlets = 0;              // 0 when compiled without meshlets
+    uint32_t offset_meshlets = 0;           // num_meshlets x RDIXMeshlet, ordered by draw range
+    uint32_t offset_range_meshlets = 0;     // (num_draw_ranges + 1) x uint32_t, first meshlet of each draw range
+
     SRL_TYPE( RDIXMeshFile,
         SRL_PROPERTY( descs );
         SRL_PROPERTY( num_streams );
@@ -224,6 +296,17 @@ struct BIT_ALIGNMENT_16 RDIXMeshFile
         SRL_PROPERTY( offset_bones );
         SRL_PROPERTY( offset_bones_names );
         SRL_PROPERTY( offset_draw_ranges );
+        SRL_PROPERTY( encodings );
+        SRL_PROPERTY( position_min );
+        SRL_PROPERTY( position_extent );
+        SRL_PROPERTY( bounds );
+        SRL_PROPERTY( offset_draw_ranges_bounds );
+        SRL_PROPERTY( offset_bones_bounds );
+        SRL_PROPERTY( num_lods );
+        SRL_PROPERTY( offset_lods );
+        SRL_PROPERTY( num_meshlets );
+        SRL_PROPERTY( offset_meshlets );
+        SRL_PROPERTY( offset_range_meshlets );
     );
 };
 
@@ -232,6 +315,7 @@ inline array_span_t<const T> GetVertexStream( const RDIXMeshFile* mesh, RDIEVert
 {
     RDIVertexBufferDesc desc = mesh->descs[slot];
     SYS_ASSERT( desc.ByteWidth() == sizeof( T ) );
+    SYS_ASSERT( mesh->encodings[slot] == RDIXEVertexEncoding::NONE ); // use DecodeVertexStream for quantized streams
 
     const T* pointer = Offset2Pointer<T>( mesh->offset_streams[slot] );
     return to_array_span( pointer, mesh->num_vertices );
@@ -255,10 +339,46 @@ inline array_span_t<const u32> GetIndexStream32( const RDIXMeshFile* mesh )
     return GetIndexStream<u32>( mesh );
 }
 
+inline const RDIXMeshBounds& GetBounds( const RDIXMeshFile* mesh )
+{
+    return mesh->bounds;
+}
+inline array_span_t<const RDIXRenderSourceRange> GetDrawRanges( const RDIXMeshFile* mesh )
+{
+    const RDIXRenderSourceRange* pointer = Offset2Pointer<RDIXRenderSourceRange>( mesh->offset_draw_ranges );
+    return to_array_span( pointer, mesh->num_draw_ranges );
+}
+inline array_span_t<const RDIXMeshBounds> GetDrawRangesBounds( const RDIXMeshFile* mesh )
+{
+    const RDIXMeshBounds* pointer = Offset2Pointer<RDIXMeshBounds>( mesh->offset_draw_ranges_bounds );
+    return to_array_span( pointer, mesh->num_draw_ranges );
+}
+inline array_span_t<const RDIXRenderSourceLod> GetLods( const RDIXMeshFile* mesh )
+{
+    const RDIXRenderSourceLod* pointer = Offset2Pointer<RDIXRenderSourceLod>( mesh->offset_lods );
+    return to_array_span( pointer, mesh->num_lods );
+}
+inline array_span_t<const RDIXMeshlet> GetMeshlets( const RDIXMeshFile* mesh, uint32_t range_index )
+{
+    if( !mesh->num_meshlets )
+        return array_span_t<const RDIXMeshlet>();
+
+    SYS_ASSERT( range_index < mesh->num_draw_ranges );
+    const RDIXMeshlet* meshlets = Offset2Pointer<RDIXMeshlet>( mesh->offset_meshlets );
+    const uint32_t* range_meshlets = Offset2Pointer<uint32_t>( mesh->offset_range_meshlets );
+    return to_array_span( meshlets + range_meshlets[range_index], range_meshlets[range_index + 1] - range_meshlets[range_index] );
+}
+inline array_span_t<const RDIXMeshBounds> GetBonesBounds( const RDIXMeshFile* mesh )
+{
+    const RDIXMeshBounds* pointer = Offset2Pointer<RDIXMeshBounds>( mesh->offset_bones_bounds );
+    return to_array_span( pointer, mesh->num_bones );
+}
+
 // --- 
 struct RDIXTransformBufferDesc
 {
 	uint32_t capacity = 1024;
+	uint32_t instance_data_size = 16; // size of per draw constant buffer (GetInstanceOffsetCBuffer), multiple of 16
 };
 
 
@@ -267,3 +387,31 @@ struct RDIXResourceBinding;
 struct RDIXRenderSource;
 struct RDIXRenderTarget;
 struct RDIXTransformBuffer;
+
+// --- state cache used when dispatching command buffers. Tracks what is bound on command queue
+// and drops binds which would not change anything.
+struct RDIXDispatchStats
+{
+    uint32_t commands = 0;
+    uint32_t binds = 0;         // binds forwarded to backend
+    uint32_t skipped_binds = 0; // redundant binds dropped by cache
+};
+
+struct RDIXStateCache
+{
+    static constexpr uintptr_t UNKNOWN = UINTPTR_MAX;
+
+    uintptr_t pipeline = UNKNOWN;
+    uintptr_t render_source = UNKNOWN;
+    uintptr_t topology = UNKNOWN;
+    uintptr_t input_layout = UNKNOWN; // resolved from bound pipeline and render source
+    uintptr_t resources_ro[RDIEPipeline::COUNT][cRDI_MAX_RESOURCES_RO];
+    uintptr_t resources_rw[RDIEPipeline::COUNT][cRDI_MAX_RESOURCES_RW];
+    // underlying resource of view in slot, used to find views aliasing newly bound one
+    uintptr_t resources_ro_id[RDIEPipeline::COUNT][cRDI_MAX_RESOURCES_RO];
+    uintptr_t resources_rw_id[RDIEPipeline::COUNT][cRDI_MAX_RESOURCES_RW];
+    uintptr_t cbuffers[RDIEPipeline::COUNT][cRDI_MAX_CBUFFERS];
+    uintptr_t samplers[RDIEPipeline::COUNT][cRDI_MAX_SAMPLERS];
+
+    RDIXDispatchStats stats;
+};
@@ -0,0 +1,353 @@
+#include "rdix_vertex_codec.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+    inline float Clampf( float v, float a, float b )
+    {
+        return ( v < a ) ? a : ( v > b ) ? b : v;
+    }
+    inline float SignNotZero( float v )
+    {
+        return ( v >= 0.f ) ? 1.f : -1.f;
+    }
+
+    inline uint16_t ToUnorm16( float v ) { return (uint16_t)lroundf( Clampf( v, 0.f, 1.f ) * 65535.f ); }
+    inline int16_t  ToSnorm16( float v ) { return (int16_t)lroundf( Clampf( v, -1.f, 1.f ) * 32767.f ); }
+    inline uint8_t  ToUnorm8 ( float v ) { return (uint8_t)lroundf( Clampf( v, 0.f, 1.f ) * 255.f ); }
+
+    inline float FromUnorm16( uint16_t v ) { return v * ( 1.f / 65535.f ); }
+    inline float FromSnorm16( int16_t v )  { return Clampf( v * ( 1.f / 32767.f ), -1.f, 1.f ); }
+    inline float FromUnorm8 ( uint8_t v )  { return v * ( 1.f / 255.f ); }
+
+    void OctEncode( int16_t out[2], const float n[3] )
+    {
+        const float l1 = fabsf( n[0] ) + fabsf( n[1] ) + fabsf( n[2] );
+        float x = 0.f;
+        float y = 0.f;
+        if( l1 > 0.f )
+        {
+            x = n[0] / l1;
+            y = n[1] / l1;
+            if( n[2] < 0.f )
+            {
+                const float ox = x;
+                x = ( 1.f - fabsf( y ) ) * SignNotZero( ox );
+                y = ( 1.f - fabsf( ox ) ) * SignNotZero( y );
+            }
+        }
+        out[0] = ToSnorm16( x );
+        out[1] = ToSnorm16( y );
+    }
+
+    void OctDecode( float out[3], const int16_t in[2] )
+    {
+        float x = FromSnorm16( in[0] );
+        float y = FromSnorm16( in[1] );
+        const float z = 1.f - fabsf( x ) - fabsf( y );
+        const float t = Clampf( -z, 0.f, 1.f );
+        x += ( x >= 0.f ) ? -t : t;
+        y += ( y >= 0.f ) ? -t : t;
+
+        const float len = sqrtf( x*x + y*y + z*z );
+        const float inv_len = ( len > 0.f ) ? 1.f / len : 0.f;
+        out[0] = x * inv_len;
+        out[1] = y * inv_len;
+        out[2] = z * inv_len;
+    }
+
+    // keeps sum of quantized weights equal to quantized sum of input weights
+    void FixupWeights( uint8_t* q, const float* w, uint32_t n )
+    {
+        float sum = 0.f;
+        int qsum = 0;
+        uint32_t imax = 0;
+        for( uint32_t i = 0; i < n; ++i )
+        {
+            sum += w[i];
+            qsum += q[i];
+            if( q[i] > q[imax] )
+                imax = i;
+        }
+        const int diff = (int)ToUnorm8( sum ) - qsum;
+        q[imax] = (uint8_t)Clampf( (float)( q[imax] + diff ), 0.f, 255.f );
+    }
+}//
+
+RDIXEVertexEncoding::Enum DefaultVertexEncoding( RDIEVertexSlot::Enum slot )
+{
+    switch( slot )
+    {
+    case RDIEVertexSlot::POSITION:
+        return RDIXEVertexEncoding::UNORM16_BOX;
+    case RDIEVertexSlot::NORMAL:
+    case RDIEVertexSlot::TANGENT:
+    case RDIEVertexSlot::BINORMAL:
+        return RDIXEVertexEncoding::OCT_SNORM16;
+    case RDIEVertexSlot::BLENDWEIGHT:
+        return RDIXEVertexEncoding::UNORM8;
+    case RDIEVertexSlot::BLENDINDICES:
+        return RDIXEVertexEncoding::NONE;
+    default:
+        break;
+    }
+
+    if( slot >= RDIEVertexSlot::TEXCOORD0 && slot <= RDIEVertexSlot::TEXCOORD5 )
+        return RDIXEVertexEncoding::HALF;
+
+    return RDIXEVertexEncoding::NONE;
+}
+
+bool CanEncodeVertexStream( const RDIVertexBufferDesc& desc, RDIXEVertexEncoding::Enum encoding )
+{
+    if( encoding == RDIXEVertexEncoding::NONE )
+        return true;
+
+    if( desc.dataType != RDIEType::FLOAT )
+        return false;
+
+    switch( encoding )
+    {
+    case RDIXEVertexEncoding::UNORM16_BOX:
+        return desc.slot == RDIEVertexSlot::POSITION && desc.numElements == 3;
+    case RDIXEVertexEncoding::OCT_SNORM16:
+        return desc.numElements == 3;
+    case RDIXEVertexEncoding::HALF:
+    case RDIXEVertexEncoding::UNORM8:
+        return desc.numElements <= 4;
+    default:
+        break;
+    }
+    return false;
+}
+
+uint32_t EncodedVertexStride( const RDIVertexBufferDesc& desc, RDIXEVertexEncoding::Enum encoding )
+{
+    switch( encoding )
+    {
+    case RDIXEVertexEncoding::UNORM16_BOX: return 4 * sizeof( uint16_t );
+    case RDIXEVertexEncoding::OCT_SNORM16: return 2 * sizeof( int16_t );
+    case RDIXEVertexEncoding::HALF:        return TYPE_ALIGN( desc.numElements * sizeof( uint16_t ), 4 );
+    case RDIXEVertexEncoding::UNORM8:      return TYPE_ALIGN( desc.numElements * sizeof( uint8_t ), 4 );
+    default:
+        break;
+    }
+    return desc.ByteWidth();
+}
+
+RDIVertexBufferDesc EncodedVertexDesc( const RDIVertexBufferDesc& desc, RDIXEVertexEncoding::Enum encoding )
+{
+    RDIVertexBufferDesc result = desc;
+    switch( encoding )
+    {
+    case RDIXEVertexEncoding::UNORM16_BOX:
+        result.DataType( RDIEType::USHORT, 4 ).Normalized();
+        break;
+    case RDIXEVertexEncoding::OCT_SNORM16:
+        result.DataType( RDIEType::SHORT, 2 ).Normalized();
+        break;
+    case RDIXEVertexEncoding::HALF:
+        result.DataType( RDIEType::HALF, TYPE_ALIGN( desc.numElements, 2 ) );
+        break;
+    case RDIXEVertexEncoding::UNORM8:
+        result.DataType( RDIEType::UBYTE, 4 ).Normalized();
+        break;
+    default:
+        break;
+    }
+
+    SYS_ASSERT( result.ByteWidth() == EncodedVertexStride( desc, encoding ) );
+    return result;
+}
+
+void EncodeVertexStream( void* dst, const void* src, uint32_t src_stride, uint32_t num_vertices, const RDIVertexBufferDesc& desc, RDIXEVertexEncoding::Enum encoding, const RDIXPositionBox& box )
+{
+    SYS_ASSERT( CanEncodeVertexStream( desc, encoding ) );
+
+    const uint32_t n = desc.numElements;
+    const uint32_t dst_stride = EncodedVertexStride( desc, encoding );
+
+    uint8_t* dst_bytes = (uint8_t*)dst;
+    const uint8_t* src_bytes = (const uint8_t*)src;
+    memset( dst, 0x00, dst_stride * num_vertices );
+
+    for( uint32_t i = 0; i < num_vertices; ++i, dst_bytes += dst_stride, src_bytes += src_stride )
+    {
+        const float* v = (const float*)src_bytes;
+        switch( encoding )
+        {
+        case RDIXEVertexEncoding::UNORM16_BOX:
+            {
+                uint16_t* q = (uint16_t*)dst_bytes;
+                for( uint32_t c = 0; c < 3; ++c )
+                    q[c] = ( box.extent[c] > 0.f ) ? ToUnorm16( ( v[c] - box.min[c] ) / box.extent[c] ) : 0;
+            }break;
+        case RDIXEVertexEncoding::OCT_SNORM16:
+            {
+                OctEncode( (int16_t*)dst_bytes, v );
+            }break;
+        case RDIXEVertexEncoding::HALF:
+            {
+                uint16_t* q = (uint16_t*)dst_bytes;
+                for( uint32_t c = 0; c < n; ++c )
+                    q[c] = FloatToHalf( v[c] );
+            }break;
+        case RDIXEVertexEncoding::UNORM8:
+            {
+                uint8_t* q = dst_bytes;
+                for( uint32_t c = 0; c < n; ++c )
+                    q[c] = ToUnorm8( v[c] );
+
+                if( desc.slot == RDIEVertexSlot::BLENDWEIGHT )
+                    FixupWeights( q, v, n );
+            }break;
+        default:
+            {
+                memcpy( dst_bytes, src_bytes, dst_stride );
+            }break;
+        }
+    }
+}
+
+void DecodeVertexStream( void* dst, const void* src, uint32_t num_vertices, const RDIVertexBufferDesc& desc, RDIXEVertexEncoding::Enum encoding, const RDIXPositionBox& box )
+{
+    const uint32_t n = desc.numElements;
+    const uint32_t dst_stride = desc.ByteWidth();
+    const uint32_t src_stride = EncodedVertexStride( desc, encoding );
+
+    if( encoding == RDIXEVertexEncoding::NONE )
+    {
+        memcpy( dst, src, dst_stride * num_vertices );
+        return;
+    }
+
+    uint8_t* dst_bytes = (uint8_t*)dst;
+    const uint8_t* src_bytes = (const uint8_t*)src;
+
+    for( uint32_t i = 0; i < num_vertices; ++i, dst_bytes += dst_stride, src_bytes += src_stride )
+    {
+        float* v = (float*)dst_bytes;
+        switch( encoding )
+        {
+        case RDIXEVertexEncoding::UNORM16_BOX:
+            {
+                const uint16_t* q = (const uint16_t*)src_bytes;
+                for( uint32_t c = 0; c < 3; ++c )
+                    v[c] = box.min[c] + FromUnorm16( q[c] ) * box.extent[c];
+            }break;
+        case RDIXEVertexEncoding::OCT_SNORM16:
+            {
+                OctDecode( v, (const int16_t*)src_bytes );
+            }break;
+        case RDIXEVertexEncoding::HALF:
+            {
+                const uint16_t* q = (const uint16_t*)src_bytes;
+                for( uint32_t c = 0; c < n; ++c )
+                    v[c] = HalfToFloat( q[c] );
+            }break;
+        case RDIXEVertexEncoding::UNORM8:
+            {
+                for( uint32_t c = 0; c < n; ++c )
+                    v[c] = FromUnorm8( src_bytes[c] );
+            }break;
+        default:
+            {
+                SYS_NOT_IMPLEMENTED;
+            }break;
+        }
+    }
+}
+
+void DecodeVertexStream( void* dst, const RDIXMeshFile* mesh, uint32_t stream_index )
+{
+    SYS_ASSERT( stream_index < mesh->num_streams );
+
+    RDIXPositionBox box;
+    memcpy( box.min, mesh->position_min, sizeof( box.min ) );
+    memcpy( box.extent, mesh->position_extent, sizeof( box.extent ) );
+
+    const void* src = Offset2Pointer<void>( mesh->offset_streams[stream_index] );
+    DecodeVertexStream( dst, src, mesh->num_vertices, mesh->descs[stream_index], (RDIXEVertexEncoding::Enum)mesh->encodings[stream_index], box );
+}
+
+uint32_t FindVertexStream( const RDIXMeshFile* mesh, RDIEVertexSlot::Enum slot )
+{
+    for( uint32_t i = 0; i < mesh->num_streams; ++i )
+    {
+        if( mesh->descs[i].slot == slot )
+            return i;
+    }
+    return UINT32_MAX;
+}
+
+uint16_t FloatToHalf( float value )
+{
+    uint32_t f;
+    memcpy( &f, &value, sizeof( f ) );
+
+    const uint32_t sign = ( f >> 16 ) & 0x8000;
+    f &= 0x7FFFFFFF;
+
+    // inf / nan
+    if( f >= 0x7F800000 )
+        return (uint16_t)( sign | 0x7C00 | ( ( f > 0x7F800000 ) ? 0x200 : 0 ) );
+
+    // rounds to inf (>= 65520)
+    if( f >= 0x477FF000 )
+        return (uint16_t)( sign | 0x7C00 );
+
+    // half denormals (< 2^-14), round to nearest even
+    if( f < 0x38800000 )
+    {
+        if( f < 0x33000000 )
+            return (uint16_t)sign;
+
+        const uint32_t exponent = f >> 23;
+        const uint32_t mantissa = ( f & 0x7FFFFF ) | 0x800000;
+        const uint32_t shift = 126 - exponent;
+        const uint32_t rem = mantissa & ( ( 1u << shift ) - 1 );
+        const uint32_t half_ulp = 1u << ( shift - 1 );
+
+        uint32_t h = mantissa >> shift;
+        if( rem > half_ulp || ( rem == half_ulp && ( h & 1 ) ) )
+            ++h;
+
+        return (uint16_t)( sign | h );
+    }
+
+    // normals, rebias exponent and round to nearest even (carry into exponent is fine)
+    uint32_t h = ( f - 0x38000000 ) >> 13;
+    const uint32_t rem = f & 0x1FFF;
+    if( rem > 0x1000 || ( rem == 0x1000 && ( h & 1 ) ) )
+        ++h;
+
+    return (uint16_t)( sign | h );
+}
+
+float HalfToFloat( uint16_t value )
+{
+    const uint32_t sign = (uint32_t)( value & 0x8000 ) << 16;
+    const uint32_t exponent = ( value >> 10 ) & 0x1F;
+    const uint32_t mantissa = value & 0x3FF;
+
+    uint32_t f = sign;
+    if( exponent == 0x1F )
+    {
+        f |= 0x7F800000 | ( mantissa << 13 );
+    }
+    else if( exponent )
+    {
+        f |= ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 );
+    }
+    else if( mantissa )
+    {
+        const float r = mantissa * ( 1.f / 16777216.f );
+        return ( sign ) ? -r : r;
+    }
+
+    float result;
+    memcpy( &result, &f, sizeof( result ) );
+    return result;
+}
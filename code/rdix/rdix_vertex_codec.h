@@ -0,0 +1,32 @@
+#pragma once
+
+#include "rdix_type.h"
+
+// --- vertex stream quantization used by mesh compiler and RDIXMeshFile loading.
+// Decoded format is always float, with desc.numElements components per vertex.
+struct RDIXPositionBox
+{
+    float min[3] = {};
+    float extent[3] = {};
+};
+
+RDIXEVertexEncoding::Enum DefaultVertexEncoding( RDIEVertexSlot::Enum slot );
+
+// false when encoding can't represent stream described by desc
+bool     CanEncodeVertexStream( const RDIVertexBufferDesc& desc, RDIXEVertexEncoding::Enum encoding );
+uint32_t EncodedVertexStride  ( const RDIVertexBufferDesc& desc, RDIXEVertexEncoding::Enum encoding );
+// desc of encoded data as seen by input assembler (normalized integer or half types). Shader completes decoding
+RDIVertexBufferDesc EncodedVertexDesc( const RDIVertexBufferDesc& desc, RDIXEVertexEncoding::Enum encoding );
+
+// src: num_vertices elements, src_stride bytes apart, each with at least desc.numElements floats
+void EncodeVertexStream( void* dst, const void* src, uint32_t src_stride, uint32_t num_vertices, const RDIVertexBufferDesc& desc, RDIXEVertexEncoding::Enum encoding, const RDIXPositionBox& box );
+// dst: tightly packed, desc.ByteWidth() bytes per vertex
+void DecodeVertexStream( void* dst, const void* src, uint32_t num_vertices, const RDIVertexBufferDesc& desc, RDIXEVertexEncoding::Enum encoding, const RDIXPositionBox& box );
+
+// decodes stream of mesh file (stream index, not slot)
+void DecodeVertexStream( void* dst, const RDIXMeshFile* mesh, uint32_t stream_index );
+// index of stream with given slot, UINT32_MAX when mesh has no such stream
+uint32_t FindVertexStream( const RDIXMeshFile* mesh, RDIEVertexSlot::Enum slot );
+
+uint16_t FloatToHalf( float value );
+float    HalfToFloat( uint16_t value );
@@ -1,5 +1,5 @@
 #include "resource_loader.h"
-#include <memory\memory.h>
+#include <memory/memory.h>
 #include <string.h>
 
 bool RSMLoader::Load( RSMResourceData* out, const void* data, uint32_t size, BXIAllocator* allocator, void* system )
@@ -1,6 +1,9 @@
 #include "resource_manager.h"
 #include "resource_loader.h"
+#include "resource_watcher.h"
 #include <foundation/containers.h>
+#include <foundation/array.h>
+#include <foundation/common.h>
 #include <foundation/hashmap.h>
 #include <foundation/queue.h>
 #include <foundation/id_table.h>
@@ -16,6 +19,7 @@
 
 #include <rtti/rtti.h>
 
+#include <stdio.h>
 #include <atomic>
 #include <thread>
 
@@ -33,11 +37,28 @@ union RSMResourceHashDecoder
 
 struct RSMPendingResource
 {
-    id_t id;
+    id_handle_t id;
     BXFileHandle hfile;
     void* user_system;
 };
 
+struct RSMReloadedResource
+{
+    id_handle_t id;
+    RSMResourceData data;
+    uint64_t bytes;
+    uint8_t loader_index;
+    uint8_t ok;
+};
+
+struct RSMReloadSubscriber
+{
+    uint32_t handle;
+    RSMResourceID id;
+    RSMReloadCallback* callback;
+    void* user_data;
+};
+
 template< typename T, typename Tlock >
 static inline bool PopFrontQueue( T* out, queue_t<T>& q, Tlock& lock )
 {
@@ -58,29 +79,55 @@ namespace RSMEInternalState
     enum Enum : uint8_t
     {
         MANAGED = BIT_OFFSET(0),
+        RELOADING = BIT_OFFSET(1),
+        CACHED = BIT_OFFSET(2),
     };
 }
 
 struct RSMImpl
 {
-    static constexpr uint32_t MAX_RESOURCES = 1 << 16;
+    // index is 16 bit and id_table uses MAX as end of free list
+    static constexpr uint32_t MAX_RESOURCES = ( 1 << 16 ) - 1;
     static constexpr uint32_t MAX_TYPES = 0x40;
     static constexpr uint8_t INVALID_LOADER_INDEX = 0xFF;
+    static constexpr uint32_t LRU_NONE = UINT32_MAX;
     
     mutex_t id_lock;
     id_table_t<MAX_RESOURCES> id_alloc;
 
     string_t        rname        [MAX_RESOURCES] = {};
     RSMResourceHash rhash        [MAX_RESOURCES] = {};
-    id_t            rid          [MAX_RESOURCES] = {};
+    id_handle_t     rid          [MAX_RESOURCES] = {};
     RSMEState::E    rstate       [MAX_RESOURCES] = {};
     RSMResourceData rdata        [MAX_RESOURCES] = {};
     uint8_t         rloader_index[MAX_RESOURCES] = {};
     uint16_t        rrefcount    [MAX_RESOURCES] = {};
     uint8_t         rflags       [MAX_RESOURCES] = {};
+    void*           rsystem      [MAX_RESOURCES] = {};
+    uint64_t        rbytes       [MAX_RESOURCES] = {};
 
     mutex_t lookup_lock;
-    hash_t<id_t> lookup;
+    hash_t<id_handle_t> lookup;
+
+    // released resources with refcount 0 which are still in lookup. Guarded by lookup_lock, head is the most recent one
+    uint32_t lru_prev[MAX_RESOURCES];
+    uint32_t lru_next[MAX_RESOURCES];
+    uint32_t lru_head = LRU_NONE;
+    uint32_t lru_tail = LRU_NONE;
+    uint64_t cached_bytes = 0;
+    uint32_t num_cached = 0;
+    uint32_t cache_hits = 0;
+    uint32_t evictions = 0;
+
+    // memory, 0 means no limit
+    std::atomic_uint64_t resident_bytes = 0;
+    std::atomic_uint32_t num_resident = 0;
+    std::atomic_uint64_t loader_bytes   [MAX_TYPES] = {};
+    std::atomic_uint32_t loader_resident[MAX_TYPES] = {};
+    uint64_t loader_budget[MAX_TYPES] = {};
+    uint64_t budget = 0;
+    uint64_t cache_budget = 0;
+    bool over_budget_reported = false;
 
     mutex_t to_load_lock;
     mutex_t to_unload_lock;
@@ -88,6 +135,20 @@ struct RSMImpl
     queue_t<RSMPendingResource> to_load;
     queue_t<RSMPendingResource> to_unload;
 
+    // hot reload
+    mutex_t changed_lock;
+    mutex_t to_reload_lock;
+    mutex_t reloaded_lock;
+
+    queue_t<RSMResourceHash> changed;       // reported by watcher thread
+    queue_t<RSMPendingResource> to_reload;  // file loaded, waits for loader on background thread
+    queue_t<RSMReloadedResource> reloaded;  // waits for swap in RSM::Update
+
+    mutex_t subscribers_lock;
+    array_t<RSMReloadSubscriber> subscribers;
+    uint32_t next_subscription = 0;
+    RSMWatcher* watcher = nullptr;
+
     RSMLoader* loader[MAX_TYPES] = {};
     uint32_t loader_supported_type[MAX_TYPES] = {};
     uint32_t nb_loaders = 0;
@@ -102,13 +163,14 @@ struct RSMImpl
     std::thread background_thread;
     semaphore_t sema;
     std::atomic_uint32_t is_running = 0;
+    std::atomic_uint32_t num_reloads_in_flight = 0;
 
-    bool IsAlive( id_t id ) const { return id_table::has( id_alloc, id ); }
+    bool IsAlive( id_handle_t id ) const { return id_table::has( id_alloc, id ); }
 };
 
 static RSMImpl* _rsm = nullptr;
 
-static void RemoveResourceEntry( RSMImpl* rsm, id_t id )
+static void RemoveResourceEntry( RSMImpl* rsm, id_handle_t id )
 {
     string::free( &rsm->rname[id.index] );
     rsm->rhash        [id.index] = { 0 };
@@ -122,6 +184,60 @@ static void RemoveResourceEntry( RSMImpl* rsm, id_t id )
     }
 }
 
+// sets memory used by resource and updates totals. Called from main and background thread
+static void TrackBytes( RSMImpl* rsm, uint32_t index, uint64_t bytes )
+{
+    const uint64_t old_bytes = rsm->rbytes[index];
+    if( old_bytes == bytes )
+        return;
+
+    rsm->rbytes[index] = bytes;
+
+    const uint8_t loader_index = rsm->rloader_index[index];
+    rsm->resident_bytes += bytes - old_bytes;
+    rsm->loader_bytes[loader_index] += bytes - old_bytes;
+    if( !old_bytes )
+    {
+        rsm->num_resident += 1;
+        rsm->loader_resident[loader_index] += 1;
+    }
+    else if( !bytes )
+    {
+        rsm->num_resident -= 1;
+        rsm->loader_resident[loader_index] -= 1;
+    }
+}
+
+static void FreeResourceData( RSMLoader* loader, RSMResourceData* data )
+{
+    loader->Unload( data );
+    if( data->allocator )
+    {
+        BX_FREE( data->allocator, (void*)data->pointer );
+    }
+}
+
+static void ProcessUnloads( RSMImpl* rsm )
+{
+    RSMPendingResource pending = {};
+    while( PopFrontQueue( &pending, rsm->to_unload, rsm->to_unload_lock ) )
+    {
+        if( rsm->IsAlive( pending.id ) )
+        {
+            SYS_ASSERT( rsm->rrefcount[pending.id.index] == 0 );
+
+            const uint32_t loader_index = rsm->rloader_index[pending.id.index];
+            FreeResourceData( rsm->loader[loader_index], &rsm->rdata[pending.id.index] );
+
+            // resource might have finished loading after it was queued for unload
+            TrackBytes( rsm, pending.id.index, 0 );
+            RemoveResourceEntry( rsm, pending.id );
+        }
+    }
+}
+
+static bool MakeRoom( RSMImpl* rsm, uint32_t loader_index, uint64_t bytes );
+
 static void BackgroundThread( RSMImpl* rsm )
 {
     while( rsm->is_running )
@@ -143,9 +259,22 @@ static void BackgroundThread( RSMImpl* rsm )
                 const uint32_t loader_index = rsm->rloader_index[pending.id.index];
                 RSMLoader* loader = rsm->loader[loader_index];
                 const bool load_ok = loader->Load( data, file.pointer, file.size, file.allocator, pending.user_system );
+                const bool owns_file_data = load_ok && ( data->pointer == file.pointer );
                 if( load_ok )
                 {
-                    rsm->rstate[pending.id.index] = RSMEState::READY;
+                    const uint64_t bytes = ( data->size ) ? data->size : file.size;
+                    if( MakeRoom( rsm, loader_index, bytes ) )
+                    {
+                        TrackBytes( rsm, pending.id.index, bytes );
+                        rsm->rstate[pending.id.index] = RSMEState::READY;
+                    }
+                    else
+                    {
+                        SYS_LOG_ERROR( "Resource does not fit memory budget (%s, %llu bytes)", rsm->rname[pending.id.index].c_str(), (unsigned long long)bytes );
+                        FreeResourceData( loader, data );
+                        data[0] = {};
+                        rsm->rstate[pending.id.index] = RSMEState::FAIL;
+                    }
                 }
                 else
                 {
@@ -153,30 +282,47 @@ static void BackgroundThread( RSMImpl* rsm )
                     rsm->rstate[pending.id.index] = RSMEState::FAIL;
                 }
 
-                should_delete_file_data = !load_ok || (data->pointer != file.pointer);
+                should_delete_file_data = !owns_file_data;
             }
             rsm->filesystem->CloseFile( &pending.hfile, should_delete_file_data );
         }
 
-        while( PopFrontQueue( &pending, rsm->to_unload, rsm->to_unload_lock ) )
+        while( PopFrontQueue( &pending, rsm->to_reload, rsm->to_reload_lock ) )
         {
-            if( rsm->IsAlive( pending.id ) )
-            {
-                SYS_ASSERT( rsm->rrefcount[pending.id.index] == 0 );
+            // pushed even when failed, so RSM::Update can clear reloading flag
+            RSMReloadedResource reloaded = {};
+            reloaded.id = pending.id;
+            reloaded.loader_index = RSMImpl::INVALID_LOADER_INDEX;
 
-                const uint32_t loader_index = rsm->rloader_index[pending.id.index];
-                RSMLoader* loader = rsm->loader[loader_index];
-                
-                RSMResourceData* data = &rsm->rdata[pending.id.index];                
-                loader->Unload( data );
-                if( data->allocator )
+            if( IsValid( pending.hfile ) )
+            {
+                bool should_delete_file_data = true;
+                if( rsm->IsAlive( pending.id ) )
                 {
-                    BX_FREE( data->allocator, (void*)data->pointer );
+                    BXFile file = {};
+                    BXEFileStatus::E status = rsm->filesystem->File( &file, pending.hfile );
+                    SYS_ASSERT( status == BXEFileStatus::READY );
+
+                    // entry is alive, so loader index is valid. Kept for freeing data if it's released before swap
+                    reloaded.loader_index = rsm->rloader_index[pending.id.index];
+                    RSMLoader* loader = rsm->loader[reloaded.loader_index];
+                    reloaded.ok = loader->Load( &reloaded.data, file.pointer, file.size, file.allocator, pending.user_system );
+                    reloaded.bytes = ( reloaded.data.size ) ? reloaded.data.size : file.size;
+                    if( !reloaded.ok )
+                    {
+                        SYS_LOG_ERROR( "Resource failed to reload (%s)", rsm->rname[pending.id.index].c_str() );
+                    }
+
+                    should_delete_file_data = !reloaded.ok || ( reloaded.data.pointer != file.pointer );
                 }
-
-                RemoveResourceEntry( rsm, pending.id );
+                rsm->filesystem->CloseFile( &pending.hfile, should_delete_file_data );
             }
+
+            scope_mutex_t guard( rsm->reloaded_lock );
+            queue::push_back( rsm->reloaded, reloaded );
         }
+
+        ProcessUnloads( rsm );
     }
 }
 
@@ -231,7 +377,7 @@ static uint8_t FindLoader( RSMImpl* impl, RSMResourceHash rhash )
 static void FileLoadCallback( BXIFilesystem* fs, BXFileHandle fhandle, BXEFileStatus::E file_status, void* user_data0, void* user_data1, void* user_data2 )
 {
     RSMImpl* rsm = (RSMImpl*)user_data0;
-    id_t id = { (uint32_t)(uintptr_t)user_data1 };
+    id_handle_t id = { (uint32_t)(uintptr_t)user_data1 };
 
     RSMPendingResource pending = {};
     pending.id = id;
@@ -252,7 +398,38 @@ static void FileLoadCallback( BXIFilesystem* fs, BXFileHandle fhandle, BXEFileSt
     rsm->sema.signal();
 }
 
-static void LookpuInsert( RSMImpl* rsm, RSMResourceHash rhash, id_t id )
+static void ReloadFileCallback( BXIFilesystem* fs, BXFileHandle fhandle, BXEFileStatus::E file_status, void* user_data0, void* user_data1, void* user_data2 )
+{
+    RSMImpl* rsm = (RSMImpl*)user_data0;
+
+    RSMPendingResource pending = {};
+    pending.id = { (uint32_t)(uintptr_t)user_data1 };
+    pending.user_system = user_data2;
+    if( file_status == BXEFileStatus::READY )
+    {
+        pending.hfile = fhandle;
+    }
+
+    {
+        scope_mutex_t guard( rsm->to_reload_lock );
+        queue::push_back( rsm->to_reload, pending );
+    }
+    rsm->sema.signal();
+
+    // last access, RSM::ShutDown waits for this
+    rsm->num_reloads_in_flight.fetch_sub( 1 );
+}
+
+static void FileChangedCallback( const char* relative_path, void* user_data )
+{
+    RSMImpl* rsm = (RSMImpl*)user_data;
+    const RSMResourceHash rhash = RSM::CreateHash( relative_path );
+
+    scope_mutex_t guard( rsm->changed_lock );
+    queue::push_back( rsm->changed, rhash );
+}
+
+static void LookpuInsert( RSMImpl* rsm, RSMResourceHash rhash, id_handle_t id )
 {
     scope_mutex_t guard( rsm->lookup_lock );
     SYS_ASSERT( hash::has( rsm->lookup, rhash.h ) == false );
@@ -261,42 +438,199 @@ static void LookpuInsert( RSMImpl* rsm, RSMResourceHash rhash, id_t id )
     hash::set( rsm->lookup, rhash.h, id );
 
 }
-static bool LookupRemove( RSMImpl* rsm, RSMResourceHash rhash )
+// --- cache. All functions below expect lookup_lock to be locked
+static void CacheInsert( RSMImpl* rsm, uint32_t index )
+{
+    rsm->rflags[index] |= RSMEInternalState::CACHED;
+    rsm->lru_prev[index] = RSMImpl::LRU_NONE;
+    rsm->lru_next[index] = rsm->lru_head;
+    if( rsm->lru_head != RSMImpl::LRU_NONE )
+        rsm->lru_prev[rsm->lru_head] = index;
+    else
+        rsm->lru_tail = index;
+    rsm->lru_head = index;
+
+    rsm->cached_bytes += rsm->rbytes[index];
+    rsm->num_cached += 1;
+}
+
+static void CacheRemove( RSMImpl* rsm, uint32_t index )
+{
+    SYS_ASSERT( rsm->rflags[index] & RSMEInternalState::CACHED );
+    rsm->rflags[index] &= ~RSMEInternalState::CACHED;
+
+    const uint32_t prev = rsm->lru_prev[index];
+    const uint32_t next = rsm->lru_next[index];
+    if( prev != RSMImpl::LRU_NONE )
+        rsm->lru_next[prev] = next;
+    else
+        rsm->lru_head = next;
+    if( next != RSMImpl::LRU_NONE )
+        rsm->lru_prev[next] = prev;
+    else
+        rsm->lru_tail = prev;
+
+    rsm->cached_bytes -= rsm->rbytes[index];
+    rsm->num_cached -= 1;
+}
+
+static bool CanCache( const RSMImpl* rsm, uint32_t index )
+{
+    return rsm->cache_budget && ( rsm->rflags[index] & RSMEInternalState::MANAGED ) && rsm->rstate[index] == RSMEState::READY;
+}
+
+static bool FitsBudget( const RSMImpl* rsm, uint32_t loader_index, uint64_t bytes )
+{
+    if( rsm->budget && rsm->resident_bytes + bytes > rsm->budget )
+        return false;
+
+    const uint64_t loader_budget = rsm->loader_budget[loader_index];
+    return !loader_budget || rsm->loader_bytes[loader_index] + bytes <= loader_budget;
+}
+
+static bool IsOverBudget( const RSMImpl* rsm, uint32_t loader_index )
+{
+    if( rsm->cached_bytes > rsm->cache_budget )
+        return true;
+    if( rsm->budget && rsm->resident_bytes > rsm->budget )
+        return true;
+
+    const uint64_t loader_budget = rsm->loader_budget[loader_index];
+    return loader_budget && rsm->loader_bytes[loader_index] > loader_budget;
+}
+
+static void QueueUnload( RSMImpl* rsm, id_handle_t iid )
+{
+    rsm->rstate[iid.index] = RSMEState::UNLOADING;
+
+    // budget sees freed memory right away, so eviction doesn't go further than needed
+    TrackBytes( rsm, iid.index, 0 );
+    {
+        scope_mutex_t guard( rsm->id_lock );
+        iid = id_table::invalidate( rsm->id_alloc, iid );
+    }
+
+    RSMPendingResource pending = {};
+    pending.id = iid;
+    {
+        scope_mutex_t guard( rsm->to_unload_lock );
+        queue::push_back( rsm->to_unload, pending );
+    }
+    rsm->sema.signal();
+}
+
+static void Evict( RSMImpl* rsm, uint32_t index )
+{
+    CacheRemove( rsm, index );
+    hash::remove( rsm->lookup, rsm->rhash[index].h );
+    rsm->evictions += 1;
+
+    QueueUnload( rsm, rsm->rid[index] );
+}
+
+// from the least recently released
+static void EvictOverBudget( RSMImpl* rsm, bool evict_all = false )
+{
+    scope_mutex_t guard( rsm->lookup_lock );
+
+    uint32_t index = rsm->lru_tail;
+    while( index != RSMImpl::LRU_NONE )
+    {
+        const uint32_t prev = rsm->lru_prev[index];
+        if( evict_all || IsOverBudget( rsm, rsm->rloader_index[index] ) )
+        {
+            Evict( rsm, index );
+        }
+        index = prev;
+    }
+
+    const bool over_budget = rsm->budget && rsm->resident_bytes > rsm->budget;
+    if( over_budget && !rsm->over_budget_reported )
+    {
+        SYS_LOG_WARNING( "Resources in use exceed memory budget (%llu / %llu bytes)", (unsigned long long)rsm->resident_bytes.load(), (unsigned long long)rsm->budget );
+    }
+    rsm->over_budget_reported = over_budget;
+}
+
+// evicts cached resources until 'bytes' fit into budgets. Returns false when resources in use don't leave enough room.
+// Called from background thread before newly loaded resource becomes resident
+static bool MakeRoom( RSMImpl* rsm, uint32_t loader_index, uint64_t bytes )
+{
+    scope_mutex_t guard( rsm->lookup_lock );
+
+    uint32_t index = rsm->lru_tail;
+    while( index != RSMImpl::LRU_NONE && !FitsBudget( rsm, loader_index, bytes ) )
+    {
+        const uint32_t prev = rsm->lru_prev[index];
+
+        // type budget is freed only by resources of the same type
+        const bool over_budget = rsm->budget && rsm->resident_bytes + bytes > rsm->budget;
+        if( over_budget || rsm->rloader_index[index] == loader_index )
+        {
+            Evict( rsm, index );
+        }
+        index = prev;
+    }
+
+    return FitsBudget( rsm, loader_index, bytes );
+}
+// ---
+
+static bool LookupRemove( RSMImpl* rsm, RSMResourceHash rhash, bool* cached )
 {
     scope_mutex_t guard( rsm->lookup_lock );
     SYS_ASSERT( hash::has( rsm->lookup, rhash.h ) == true );
 
-    const id_t null_id{ 0 };
-    const id_t id = hash::get( rsm->lookup, rhash.h, null_id );
+    const id_handle_t null_id{ 0 };
+    const id_handle_t id = hash::get( rsm->lookup, rhash.h, null_id );
     if( --rsm->rrefcount[id.index] == 0 )
     {
-        hash::remove( rsm->lookup, rhash.h );
+        cached[0] = CanCache( rsm, id.index );
+        if( cached[0] )
+        {
+            CacheInsert( rsm, id.index );
+        }
+        else
+        {
+            hash::remove( rsm->lookup, rhash.h );
+        }
         return true;
     }
     return false;
 }
 
-static void LookupAcquire( RSMImpl* rsm, RSMResourceHash rhash, id_t id )
+static void AddRef( RSMImpl* rsm, uint32_t index )
+{
+    if( rsm->rflags[index] & RSMEInternalState::CACHED )
+    {
+        SYS_ASSERT( rsm->rrefcount[index] == 0 );
+        CacheRemove( rsm, index );
+        rsm->cache_hits += 1;
+    }
+    rsm->rrefcount[index] += 1;
+}
+
+static void LookupAcquire( RSMImpl* rsm, RSMResourceHash rhash, id_handle_t id )
 {
     scope_mutex_t guard( rsm->lookup_lock );
 
-    const id_t null_id{ 0 };
-    const id_t found_id = hash::get( rsm->lookup, rhash.h, null_id );
+    const id_handle_t null_id{ 0 };
+    const id_handle_t found_id = hash::get( rsm->lookup, rhash.h, null_id );
     if( found_id == id )
     {
-        rsm->rrefcount[id.index] += 1;
+        AddRef( rsm, id.index );
     }
 }
 
-static id_t LookupFind( RSMImpl* rsm, RSMResourceHash rhash )
+static id_handle_t LookupFind( RSMImpl* rsm, RSMResourceHash rhash )
 {
-    const id_t null_id{ 0 };
+    const id_handle_t null_id{ 0 };
 
     scope_mutex_t guard( rsm->lookup_lock );
-    const id_t result = hash::get( rsm->lookup, rhash.h, null_id );
+    const id_handle_t result = hash::get( rsm->lookup, rhash.h, null_id );
     if( result.hash != null_id.hash )
     {
-        rsm->rrefcount[result.index] += 1;
+        AddRef( rsm, result.index );
     }
     return result;
 }
@@ -306,7 +640,7 @@ RSMResourceID RSM::Load( const char* relative_path, void* system )
     RSMResourceID result = { 0 };
     
     const RSMResourceHash rhash = CreateHash( relative_path );
-    const id_t found_id = LookupFind( _rsm, rhash );
+    const id_handle_t found_id = LookupFind( _rsm, rhash );
     if( found_id.hash )
     {
         return { found_id.hash };
@@ -315,7 +649,7 @@ RSMResourceID RSM::Load( const char* relative_path, void* system )
     const uint8_t loader_index = FindLoader( _rsm, rhash );
     if( loader_index != RSMImpl::INVALID_LOADER_INDEX )
     {
-        id_t id = { 0 };
+        id_handle_t id = { 0 };
         {
             scope_mutex_t guard( _rsm->id_lock );
             id = id_table::create( _rsm->id_alloc );
@@ -330,6 +664,7 @@ RSMResourceID RSM::Load( const char* relative_path, void* system )
         _rsm->rloader_index[index] = loader_index;
         _rsm->rstate[index] = RSMEState::LOADING;
         _rsm->rflags[index] = RSMEInternalState::MANAGED;
+        _rsm->rsystem[index] = system;
         
         SYS_ASSERT( _rsm->rdata[index].pointer == nullptr );
 
@@ -351,13 +686,13 @@ RSMResourceID RSM::Create( const char* name, const void* data )
 {
     const RSMResourceHash rhash = CreateHash( name );
 
-    const id_t found_id = LookupFind( _rsm, rhash );
+    const id_handle_t found_id = LookupFind( _rsm, rhash );
     if( found_id.hash )
     {
         return { found_id.hash };
     }
 
-    id_t id = { 0 };
+    id_handle_t id = { 0 };
     {
         scope_mutex_t guard( _rsm->id_lock );
         id = id_table::create( _rsm->id_alloc );
@@ -384,13 +719,13 @@ RSMResourceID RSM::Create( const char* name, const void* data )
 RSMResourceID RSM::Create( const void* data )
 {
     char buff[256];
-    snprintf( buff, 256, "0x%llx", (uintptr_t)data );
+    snprintf( buff, 256, "0x%llx", (unsigned long long)(uintptr_t)data );
     return Create( buff, data );
 }
 
 RSMEState::E RSM::Wait( RSMResourceID rid )
 {
-    id_t id = { rid.i };
+    id_handle_t id = { rid.i };
     if( !_rsm->IsAlive( id ) )
     {
         return RSMEState::FAIL;
@@ -410,7 +745,7 @@ RSMResourceID RSM::Find( const char* relative_path )
 
 RSMResourceID RSM::Find( RSMResourceHash rhash )
 {
-    id_t id = LookupFind( _rsm, rhash );
+    id_handle_t id = LookupFind( _rsm, rhash );
     return { id.hash };
 }
 
@@ -421,39 +756,34 @@ bool RSM::IsAlive( RSMResourceID id )
 
 RSMEState::E RSM::State( RSMResourceID id )
 {
-    id_t iid = { id.i };
+    id_handle_t iid = { id.i };
     return _rsm->IsAlive( iid ) ? _rsm->rstate[iid.index] : RSMEState::UNLOADED;
 }
 
 const void* RSM::Get( RSMResourceID id )
 {
-    id_t iid = { id.i };
+    id_handle_t iid = { id.i };
     return _rsm->IsAlive( iid ) ? _rsm->rdata[iid.index].pointer : nullptr;
 }
 
 bool RSM::Release( RSMResourceID id )
 {
-    id_t iid = { id.i };
+    id_handle_t iid = { id.i };
     if( _rsm->IsAlive( iid ) )
     {
         RSMResourceHash rhash = _rsm->rhash[iid.index];
-        if( LookupRemove( _rsm, rhash ) )
+        bool cached = false;
+        if( LookupRemove( _rsm, rhash, &cached ) )
         {
-            if( _rsm->rflags[iid.index] & RSMEInternalState::MANAGED )
+            if( cached )
             {
-                _rsm->rstate[iid.index] = RSMEState::UNLOADING;
-                {
-                    scope_mutex_t guard( _rsm->id_lock );
-                    iid = id_table::invalidate( _rsm->id_alloc, iid );
-                }
-
-                RSMPendingResource pending = {};
-                pending.id = iid;
-                {
-                    scope_mutex_t guard( _rsm->to_unload_lock );
-                    queue::push_back( _rsm->to_unload, pending );
-                }
-                _rsm->sema.signal();
+                // data stays alive in cache, caller must not destroy it
+                EvictOverBudget( _rsm );
+                return false;
+            }
+            else if( _rsm->rflags[iid.index] & RSMEInternalState::MANAGED )
+            {
+                QueueUnload( _rsm, iid );
             }
             else
             {
@@ -468,7 +798,7 @@ bool RSM::Release( RSMResourceID id )
 
 bool RSM::Release( RSMResourceID id, void** resource_pointer )
 {
-    id_t iid = { id.i };
+    id_handle_t iid = { id.i };
     if( _rsm->IsAlive( iid ) )
     {
         SYS_ASSERT( ( _rsm->rflags[iid.index] & RSMEInternalState::MANAGED )== 0 );
@@ -484,13 +814,217 @@ bool RSM::Release( RSMResourceID id, void** resource_pointer )
 
 void RSM::Acquire( RSMResourceID id )
 {
-    id_t iid = { id.i };
+    id_handle_t iid = { id.i };
     if( _rsm->IsAlive( iid ) )
     {
         LookupAcquire( _rsm, _rsm->rhash[iid.index], iid );
     }
 }
 
+RSMSubscription RSM::Subscribe( RSMResourceID id, RSMReloadCallback* callback, void* user_data )
+{
+    scope_mutex_t guard( _rsm->subscribers_lock );
+
+    RSMReloadSubscriber subscriber;
+    subscriber.handle = ++_rsm->next_subscription;
+    subscriber.id = id;
+    subscriber.callback = callback;
+    subscriber.user_data = user_data;
+    array::push_back( _rsm->subscribers, subscriber );
+
+    return { subscriber.handle };
+}
+
+void RSM::Unsubscribe( RSMSubscription subscription )
+{
+    scope_mutex_t guard( _rsm->subscribers_lock );
+    for( uint32_t i = 0; i < _rsm->subscribers.size; ++i )
+    {
+        if( _rsm->subscribers[i].handle == subscription.i )
+        {
+            array::erase_swap( _rsm->subscribers, i );
+            return;
+        }
+    }
+}
+
+static bool HasSubscriber( RSMImpl* rsm, RSMResourceID id )
+{
+    scope_mutex_t guard( rsm->subscribers_lock );
+    for( const RSMReloadSubscriber& subscriber : rsm->subscribers )
+    {
+        if( subscriber.id.i == id.i )
+            return true;
+    }
+    return false;
+}
+
+static void StartReload( RSMImpl* rsm, RSMResourceHash rhash )
+{
+    id_handle_t id = { 0 };
+    {
+        scope_mutex_t guard( rsm->lookup_lock );
+        id = hash::get( rsm->lookup, rhash.h, id );
+
+        // cached copy is stale, next Load will read the new file
+        if( rsm->IsAlive( id ) && ( rsm->rflags[id.index] & RSMEInternalState::CACHED ) )
+        {
+            Evict( rsm, id.index );
+            return;
+        }
+    }
+    if( !rsm->IsAlive( id ) )
+        return;
+
+    // one save is often reported as several changes
+    const uint32_t index = id.index;
+    const uint8_t flags = rsm->rflags[index];
+    if( !( flags & RSMEInternalState::MANAGED ) || ( flags & RSMEInternalState::RELOADING ) || rsm->rstate[index] != RSMEState::READY )
+        return;
+
+    // old data is freed after swap, so only resources somebody can rebind are reloaded.
+    // For now only gfx textures subscribe, meshes and anim clips need restart
+    if( !HasSubscriber( rsm, { id.hash } ) )
+    {
+        SYS_LOG_WARNING( "Resource changed, but nobody subscribed for reload (%s)", rsm->rname[index].c_str() );
+        return;
+    }
+
+    rsm->rflags[index] |= RSMEInternalState::RELOADING;
+
+    BXPostLoadCallback post_load_cb( ReloadFileCallback, rsm, (void*)(uintptr_t)id.hash, rsm->rsystem[index] );
+
+    RSMLoader* loader = rsm->loader[rsm->rloader_index[index]];
+    BXEFIleMode::E mode = ( loader->IsBinary() ) ? BXEFIleMode::BIN : BXEFIleMode::TXT;
+    rsm->num_reloads_in_flight.fetch_add( 1 );
+    rsm->filesystem->LoadFile( rsm->rname[index].c_str(), mode, post_load_cb, rsm->default_resource_allocator );
+}
+
+static void SwapReloaded( RSMImpl* rsm, const RSMReloadedResource& reloaded )
+{
+    // loader_index is valid only when data was loaded
+    if( !rsm->IsAlive( reloaded.id ) )
+    {
+        // released while reloading
+        if( reloaded.ok )
+        {
+            RSMResourceData data = reloaded.data;
+            FreeResourceData( rsm->loader[reloaded.loader_index], &data );
+        }
+        return;
+    }
+
+    const uint32_t index = reloaded.id.index;
+    rsm->rflags[index] &= ~RSMEInternalState::RELOADING;
+    if( !reloaded.ok )
+        return;
+
+    RSMLoader* loader = rsm->loader[reloaded.loader_index];
+    RSMResourceData old_data = rsm->rdata[index];
+    rsm->rdata[index] = reloaded.data;
+    {
+        // resource could be released and cached while reloading
+        scope_mutex_t guard( rsm->lookup_lock );
+        const bool cached = ( rsm->rflags[index] & RSMEInternalState::CACHED ) != 0;
+        if( cached )
+            rsm->cached_bytes -= rsm->rbytes[index];
+
+        TrackBytes( rsm, index, reloaded.bytes );
+
+        if( cached )
+            rsm->cached_bytes += rsm->rbytes[index];
+    }
+
+    // copy, so callbacks can (un)subscribe
+    const RSMResourceID id = { reloaded.id.hash };
+    array_t<RSMReloadSubscriber> to_notify( rsm->main_allocator );
+    {
+        scope_mutex_t guard( rsm->subscribers_lock );
+        for( const RSMReloadSubscriber& subscriber : rsm->subscribers )
+        {
+            if( subscriber.id.i == 0 || subscriber.id.i == id.i )
+                array::push_back( to_notify, subscriber );
+        }
+    }
+    for( const RSMReloadSubscriber& subscriber : to_notify )
+    {
+        subscriber.callback( id, old_data.pointer, reloaded.data.pointer, subscriber.user_data );
+    }
+
+    FreeResourceData( loader, &old_data );
+}
+
+void RSM::Update()
+{
+    RSMResourceHash rhash;
+    while( PopFrontQueue( &rhash, _rsm->changed, _rsm->changed_lock ) )
+    {
+        StartReload( _rsm, rhash );
+    }
+
+    RSMReloadedResource reloaded;
+    while( PopFrontQueue( &reloaded, _rsm->reloaded, _rsm->reloaded_lock ) )
+    {
+        SwapReloaded( _rsm, reloaded );
+    }
+
+    // loads finished since last frame could push memory over budget
+    EvictOverBudget( _rsm );
+}
+
+void RSM::SetBudget( uint64_t budget, uint64_t cache_budget )
+{
+    {
+        scope_mutex_t guard( _rsm->lookup_lock );
+        _rsm->budget = budget;
+        _rsm->cache_budget = cache_budget;
+    }
+    EvictOverBudget( _rsm, cache_budget == 0 );
+}
+
+void RSM::SetTypeBudget( const char* type, uint64_t budget )
+{
+    const uint32_t type_hash = ResourceTypeHash( type );
+    for( uint32_t i = 0; i < _rsm->nb_loaders; ++i )
+    {
+        if( _rsm->loader_supported_type[i] == type_hash )
+        {
+            scope_mutex_t guard( _rsm->lookup_lock );
+            _rsm->loader_budget[i] = budget;
+        }
+    }
+    EvictOverBudget( _rsm );
+}
+
+RSMResidencyStats RSM::ResidencyStats()
+{
+    RSMResidencyStats stats;
+
+    scope_mutex_t guard( _rsm->lookup_lock );
+    stats.resident_bytes = _rsm->resident_bytes;
+    stats.cached_bytes = _rsm->cached_bytes;
+    stats.budget = _rsm->budget;
+    stats.cache_budget = _rsm->cache_budget;
+    stats.num_resident = _rsm->num_resident;
+    stats.num_cached = _rsm->num_cached;
+    stats.cache_hits = _rsm->cache_hits;
+    stats.evictions = _rsm->evictions;
+    return stats;
+}
+
+uint32_t RSM::TypeStats( RSMTypeStats* stats, uint32_t max_count )
+{
+    const uint32_t count = min_of_2( max_count, _rsm->nb_loaders );
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        stats[i].type = _rsm->loader[i]->SupportedType();
+        stats[i].resident_bytes = _rsm->loader_bytes[i];
+        stats[i].budget = _rsm->loader_budget[i];
+        stats[i].num_resident = _rsm->loader_resident[i];
+    }
+    return _rsm->nb_loaders;
+}
+
 BXIFilesystem* RSM::Filesystem()
 {
     return _rsm->filesystem;
@@ -510,7 +1044,7 @@ void RSM::Internal_AddLoader( RSMLoaderCreator* creator )
     }
 }
 
-void RSM::StartUp( BXIFilesystem* filesystem, BXIAllocator* allocator )
+void RSM::StartUp( BXIFilesystem* filesystem, BXIAllocator* allocator, bool watch_files )
 {
     uint32_t mem_size = 0;
     mem_size += sizeof( RSMImpl );
@@ -527,10 +1061,19 @@ void RSM::StartUp( BXIFilesystem* filesystem, BXIAllocator* allocator )
 
     queue::set_allocator( rsm->to_load, rsm->pending_resources_allocator );
     queue::set_allocator( rsm->to_unload, rsm->pending_resources_allocator );
+    queue::set_allocator( rsm->changed, rsm->pending_resources_allocator );
+    queue::set_allocator( rsm->to_reload, rsm->pending_resources_allocator );
+    queue::set_allocator( rsm->reloaded, rsm->pending_resources_allocator );
+    rsm->subscribers.allocator = allocator;
 
     rsm->is_running = 1;
     rsm->background_thread = std::thread( BackgroundThread, rsm );
 
+    if( watch_files )
+    {
+        rsm->watcher = RSMWatch::Start( filesystem->GetRoot(), FileChangedCallback, rsm, allocator );
+    }
+
     _rsm = rsm;
 }
 
@@ -541,10 +1084,44 @@ void RSM::ShutDown()
 
     RSMImpl* rsm = _rsm;
 
+    RSMWatch::Stop( &rsm->watcher, rsm->main_allocator );
+    EvictOverBudget( rsm, true );
+
+    // filesystem still owns reload callbacks which point to rsm
+    while( rsm->num_reloads_in_flight.load() )
+    {
+        std::this_thread::yield();
+    }
+
     rsm->is_running = 0;
     rsm->sema.signal();
     rsm->background_thread.join();
 
+    // background thread could quit before it got to evicted resources
+    ProcessUnloads( rsm );
+
+    {
+        RSMPendingResource pending;
+        while( PopFrontQueue( &pending, rsm->to_reload, rsm->to_reload_lock ) )
+        {
+            if( IsValid( pending.hfile ) )
+            {
+                rsm->filesystem->CloseFile( &pending.hfile, true );
+            }
+        }
+    }
+
+    {
+        RSMReloadedResource reloaded;
+        while( PopFrontQueue( &reloaded, rsm->reloaded, rsm->reloaded_lock ) )
+        {
+            if( reloaded.ok )
+            {
+                FreeResourceData( rsm->loader[reloaded.loader_index], &reloaded.data );
+            }
+        }
+    }
+
     for( uint32_t i = 0; i < rsm->nb_loaders; ++i )
     {
         BX_DELETE0( rsm->main_allocator, rsm->loader[i] );
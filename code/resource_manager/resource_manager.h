@@ -29,11 +29,39 @@ struct RSMResourceID
     static constexpr RSMResourceID Null() { return { 0 }; }
 };
 
+struct RSMSubscription
+{
+    uint32_t i;
+};
+
+// called from RSM::Update after resource has been reloaded. 'old_data' is valid only during the call
+using RSMReloadCallback = void( RSMResourceID id, const void* old_data, const void* new_data, void* user_data );
+
+// bytes are taken from RSMResourceData::size (file size when loader doesn't set it)
+struct RSMResidencyStats
+{
+    uint64_t resident_bytes = 0;    // all loaded resources, cached included
+    uint64_t cached_bytes = 0;      // released resources kept for reuse
+    uint64_t budget = 0;
+    uint64_t cache_budget = 0;
+    uint32_t num_resident = 0;
+    uint32_t num_cached = 0;
+    uint32_t cache_hits = 0;
+    uint32_t evictions = 0;
+};
+
+struct RSMTypeStats
+{
+    const char* type = nullptr;
+    uint64_t resident_bytes = 0;
+    uint64_t budget = 0;
+    uint32_t num_resident = 0;
+};
+
 template< typename T >
 struct RSMResourceRef
 {
     const T* Data() const;
-    T* Data() const;
 
     RSMEState::E Data( void** payload ) const;
 
@@ -63,7 +91,9 @@ namespace RSM
     RSMEState::E State( RSMResourceID id );
     const void* Get( RSMResourceID id );
     
-    // returns true when ref count has reached zero 
+    // returns true when ref count has reached zero and the entry was removed.
+    // Loaded resources are kept in LRU cache instead if it has a budget, so loading it again doesn't touch the disk.
+    // Then false is returned, because cached data is still owned by RSM
     bool Release( RSMResourceID id );
     bool Release( RSMResourceID id, void** resource_pointer );
 
@@ -75,16 +105,37 @@ namespace RSM
 
     void Acquire( RSMResourceID id );
 
+    // --- hot reload
+    // Old data is freed right after callbacks, so only resources with subscriber of their own are reloaded.
+    // Subscribe with RSMResourceID::Null() to be notified about every reloaded resource. Callbacks run in RSM::Update.
+    RSMSubscription Subscribe( RSMResourceID id, RSMReloadCallback* callback, void* user_data = nullptr );
+    void Unsubscribe( RSMSubscription subscription );
+
+    // frame boundary. Starts reloading of changed files, swaps already reloaded data in and evicts cache over budget
+    void Update();
+
+    // --- memory
+    // 0 means no limit. 'cache_budget' is memory for released resources, 0 disables the cache.
+    // Cached resources are evicted to make room for new loads. Load which doesn't fit into 'budget' (or type budget) even then
+    // ends in RSMEState::FAIL. Resources in use are never evicted, so lowering budget below them is only reported as warning.
+    void SetBudget( uint64_t budget, uint64_t cache_budget );
+    void SetTypeBudget( const char* type, uint64_t budget );
+
+    RSMResidencyStats ResidencyStats();
+    // fills stats for every registered loader, returns number of loaders
+    uint32_t TypeStats( RSMTypeStats* stats, uint32_t max_count );
+
    
+    void Internal_AddLoader( RSMLoaderCreator* creator );
     template<typename T>
     inline void RegisterLoader() { Internal_AddLoader( T::Internal_Creator ); }
     
     // --- private
 
     BXIFilesystem* Filesystem();
-    void Internal_AddLoader( RSMLoaderCreator* creator );
     
-    void StartUp( BXIFilesystem* filesystem, BXIAllocator* allocator );
+    // 'watch_files' starts watcher thread on filesystem root, so changed files are reloaded
+    void StartUp( BXIFilesystem* filesystem, BXIAllocator* allocator, bool watch_files = false );
     void ShutDown( );
 }//
 
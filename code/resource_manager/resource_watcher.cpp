@@ -0,0 +1,295 @@
+#include "resource_watcher.h"
+#include <memory/memory.h>
+#include <foundation/array.h>
+#include <foundation/debug.h>
+
+#include <atomic>
+#include <thread>
+#include <stdio.h>
+#include <string.h>
+
+#if defined( __linux__ )
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <dirent.h>
+#elif defined( _WIN32 )
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+static constexpr uint32_t WATCHER_MAX_PATH = 512;
+static constexpr int WATCHER_POLL_TIMEOUT_MS = 100;
+
+#if defined( __linux__ )
+
+// inotify is not recursive, so every directory has its own watch
+struct RSMWatchedDir
+{
+    int wd;
+    char relative_path[WATCHER_MAX_PATH]; // empty or ends with '/'
+};
+
+struct RSMWatcher
+{
+    RSMWatcherCallback* callback = nullptr;
+    void* user_data = nullptr;
+
+    char root[WATCHER_MAX_PATH] = {}; // ends with '/'
+    int fd = -1;
+    array_t<RSMWatchedDir> dirs;
+
+    std::thread thread;
+    std::atomic_uint32_t is_running = 0;
+
+    RSMWatcher( BXIAllocator* allocator )
+        : dirs( allocator ) {}
+};
+
+static void AddWatchRecursive( RSMWatcher* w, const char* relative_dir )
+{
+    char abs_path[WATCHER_MAX_PATH];
+    snprintf( abs_path, WATCHER_MAX_PATH, "%s%s", w->root, relative_dir );
+
+    const int wd = inotify_add_watch( w->fd, abs_path, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE );
+    if( wd < 0 )
+    {
+        SYS_LOG_ERROR( "Can not watch directory (%s)", abs_path );
+        return;
+    }
+
+    RSMWatchedDir entry;
+    entry.wd = wd;
+    snprintf( entry.relative_path, WATCHER_MAX_PATH, "%s", relative_dir );
+    array::push_back( w->dirs, entry );
+
+    DIR* dir = opendir( abs_path );
+    if( !dir )
+        return;
+
+    while( const dirent* de = readdir( dir ) )
+    {
+        if( de->d_type != DT_DIR || !strcmp( de->d_name, "." ) || !strcmp( de->d_name, ".." ) )
+            continue;
+
+        char child[WATCHER_MAX_PATH];
+        snprintf( child, WATCHER_MAX_PATH, "%s%s/", relative_dir, de->d_name );
+        AddWatchRecursive( w, child );
+    }
+    closedir( dir );
+}
+
+static const char* FindWatchedDir( const RSMWatcher* w, int wd )
+{
+    for( const RSMWatchedDir& dir : w->dirs )
+    {
+        if( dir.wd == wd )
+            return dir.relative_path;
+    }
+    return nullptr;
+}
+
+static void WatcherThread( RSMWatcher* w )
+{
+    alignas( inotify_event ) char buffer[4096];
+
+    pollfd pfd = {};
+    pfd.fd = w->fd;
+    pfd.events = POLLIN;
+
+    while( w->is_running )
+    {
+        if( poll( &pfd, 1, WATCHER_POLL_TIMEOUT_MS ) <= 0 )
+            continue;
+
+        const ssize_t n = read( w->fd, buffer, sizeof( buffer ) );
+        for( ssize_t offset = 0; offset < n; )
+        {
+            const inotify_event* ev = (const inotify_event*)( buffer + offset );
+            offset += sizeof( inotify_event ) + ev->len;
+
+            const char* dir = FindWatchedDir( w, ev->wd );
+            if( !dir || !ev->len )
+                continue;
+
+            char relative_path[WATCHER_MAX_PATH];
+            snprintf( relative_path, WATCHER_MAX_PATH, "%s%s", dir, ev->name );
+
+            if( ev->mask & IN_ISDIR )
+            {
+                if( ev->mask & IN_CREATE )
+                {
+                    strncat( relative_path, "/", WATCHER_MAX_PATH - strlen( relative_path ) - 1 );
+                    AddWatchRecursive( w, relative_path );
+                }
+            }
+            else if( ev->mask & ( IN_CLOSE_WRITE | IN_MOVED_TO ) )
+            {
+                w->callback( relative_path, w->user_data );
+            }
+        }
+    }
+}
+
+RSMWatcher* RSMWatch::Start( const char* root_dir, RSMWatcherCallback* callback, void* user_data, BXIAllocator* allocator )
+{
+    const int fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if( fd < 0 )
+        return nullptr;
+
+    RSMWatcher* w = BX_NEW( allocator, RSMWatcher, allocator );
+    w->callback = callback;
+    w->user_data = user_data;
+    w->fd = fd;
+
+    const size_t len = strlen( root_dir );
+    const char* separator = ( len && root_dir[len - 1] != '/' ) ? "/" : "";
+    snprintf( w->root, WATCHER_MAX_PATH, "%s%s", root_dir, separator );
+
+    AddWatchRecursive( w, "" );
+    if( array::empty( w->dirs ) )
+    {
+        close( fd );
+        BX_DELETE( allocator, w );
+        return nullptr;
+    }
+
+    w->is_running = 1;
+    w->thread = std::thread( WatcherThread, w );
+    return w;
+}
+
+void RSMWatch::Stop( RSMWatcher** watcher, BXIAllocator* allocator )
+{
+    RSMWatcher* w = watcher[0];
+    if( !w )
+        return;
+
+    w->is_running = 0;
+    w->thread.join();
+    close( w->fd );
+
+    BX_DELETE0( allocator, watcher[0] );
+}
+
+#elif defined( _WIN32 )
+
+struct RSMWatcher
+{
+    RSMWatcherCallback* callback = nullptr;
+    void* user_data = nullptr;
+
+    HANDLE dir = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped = {};
+
+    std::thread thread;
+    std::atomic_uint32_t is_running = 0;
+};
+
+static bool IssueRead( RSMWatcher* w, DWORD* buffer, DWORD buffer_size )
+{
+    const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+    return ReadDirectoryChangesW( w->dir, buffer, buffer_size, TRUE, filter, nullptr, &w->overlapped, nullptr ) != 0;
+}
+
+static void WatcherThread( RSMWatcher* w )
+{
+    // DWORD aligned as required by ReadDirectoryChangesW
+    DWORD buffer[4096];
+    bool pending = IssueRead( w, buffer, sizeof( buffer ) );
+
+    while( w->is_running && pending )
+    {
+        if( WaitForSingleObject( w->overlapped.hEvent, WATCHER_POLL_TIMEOUT_MS ) != WAIT_OBJECT_0 )
+            continue;
+
+        DWORD n = 0;
+        const BOOL ok = GetOverlappedResult( w->dir, &w->overlapped, &n, FALSE );
+        ResetEvent( w->overlapped.hEvent );
+
+        for( const uint8_t* it = (const uint8_t*)buffer; ok && n; )
+        {
+            const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)it;
+            if( info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME )
+            {
+                char relative_path[WATCHER_MAX_PATH];
+                const int len = WideCharToMultiByte( CP_UTF8, 0, info->FileName, info->FileNameLength / sizeof( WCHAR ), relative_path, WATCHER_MAX_PATH - 1, nullptr, nullptr );
+                relative_path[len] = 0;
+                for( char* c = relative_path; *c; ++c )
+                {
+                    if( *c == '\\' )
+                        *c = '/';
+                }
+
+                // directories are reported too, they just don't match any resource
+                if( len )
+                {
+                    w->callback( relative_path, w->user_data );
+                }
+            }
+
+            if( !info->NextEntryOffset )
+                break;
+            it += info->NextEntryOffset;
+        }
+
+        pending = IssueRead( w, buffer, sizeof( buffer ) );
+    }
+
+    if( !pending )
+        return;
+
+    // pending read writes to 'buffer', wait until it's cancelled
+    DWORD n = 0;
+    CancelIo( w->dir );
+    GetOverlappedResult( w->dir, &w->overlapped, &n, TRUE );
+}
+
+RSMWatcher* RSMWatch::Start( const char* root_dir, RSMWatcherCallback* callback, void* user_data, BXIAllocator* allocator )
+{
+    const DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    HANDLE dir = CreateFileA( root_dir, FILE_LIST_DIRECTORY, share, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr );
+    if( dir == INVALID_HANDLE_VALUE )
+    {
+        SYS_LOG_ERROR( "Can not watch directory (%s)", root_dir );
+        return nullptr;
+    }
+
+    RSMWatcher* w = BX_NEW( allocator, RSMWatcher );
+    w->callback = callback;
+    w->user_data = user_data;
+    w->dir = dir;
+    w->overlapped.hEvent = CreateEventA( nullptr, TRUE, FALSE, nullptr );
+
+    w->is_running = 1;
+    w->thread = std::thread( WatcherThread, w );
+    return w;
+}
+
+void RSMWatch::Stop( RSMWatcher** watcher, BXIAllocator* allocator )
+{
+    RSMWatcher* w = watcher[0];
+    if( !w )
+        return;
+
+    w->is_running = 0;
+    w->thread.join();
+    CloseHandle( w->overlapped.hEvent );
+    CloseHandle( w->dir );
+
+    BX_DELETE0( allocator, watcher[0] );
+}
+
+#else
+
+RSMWatcher* RSMWatch::Start( const char*, RSMWatcherCallback*, void*, BXIAllocator* )
+{
+    return nullptr;
+}
+
+void RSMWatch::Stop( RSMWatcher** watcher, BXIAllocator* )
+{
+    watcher[0] = nullptr;
+}
+
+#endif
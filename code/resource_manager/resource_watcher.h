@@ -0,0 +1,16 @@
+#pragma once
+
+#include <foundation/type.h>
+
+struct BXIAllocator;
+struct RSMWatcher;
+
+// called from watcher thread for every modified or created file. Path is relative to watched root and uses '/'
+using RSMWatcherCallback = void( const char* relative_path, void* user_data );
+
+namespace RSMWatch
+{
+    // watches 'root_dir' recursively on dedicated thread. Returns nullptr when platform is not supported or directory can't be watched
+    RSMWatcher* Start( const char* root_dir, RSMWatcherCallback* callback, void* user_data, BXIAllocator* allocator );
+    void Stop( RSMWatcher** watcher, BXIAllocator* allocator );
+}//
@@ -1,7 +1,11 @@
 #pragma once
 
+#if defined( _WIN32 )
 #ifdef BX_DLL_rtti
 #define RTTI_EXPORT __declspec(dllexport)
 #else
 #define RTTI_EXPORT __declspec(dllimport)
 #endif
+#else
+#define RTTI_EXPORT __attribute__((visibility("default")))
+#endif
@@ -3,6 +3,8 @@
 #include <foundation/string_util.h>
 #include <foundation/tag.h>
 #include <foundation/hash.h>
+#include <foundation/hashed_string.h>
+#include <memory/memory.h>
 
 #include <string.h>
 #include <memory>
@@ -12,19 +14,27 @@
 static constexpr uint32_t MAX_TYPES = 1024 * 16;
 static uint64_t __typed_name_hash[MAX_TYPES] = {};
 
-static RTTITypeInfo __types[MAX_TYPES] = {};
+// open addressing, name hash -> type index + 1, 0 is empty slot
+static constexpr uint32_t TYPE_INDEX_SIZE = MAX_TYPES * 2;
+static uint32_t __type_index[TYPE_INDEX_SIZE] = {};
+
+// raw storage is zero initialized before any constructor runs, so types registered from static
+// initializers in other translation units aren't wiped when this file's statics are initialized
+alignas( RTTITypeInfo ) static uint8_t __types_memory[MAX_TYPES * sizeof( RTTITypeInfo )] = {};
+static inline RTTITypeInfo* Types() { return (RTTITypeInfo*)__types_memory; }
 static uint32_t __nb_types = 0;
 
 static constexpr uint32_t ATTR_MEMORY_BUDGET = 1024 * 1024;
-static uint8_t __attributes_memory[ATTR_MEMORY_BUDGET] = {};
+static BIT_ALIGNMENT_16 uint8_t __attributes_memory[ATTR_MEMORY_BUDGET] = {};
 static uint32_t __attributes_offset = 0;
 
 // ---
-static uint8_t* AllocateAttributeData( uint32_t size )
+// attribute values are packed (alignment 1), structures holding pointers or 64bit fields ask for 8
+static uint8_t* AllocateAttributeData( uint32_t size, uint32_t alignment = 1 )
 {
-    SYS_ASSERT( __attributes_offset + size <= ATTR_MEMORY_BUDGET );
-    const uint32_t local_offset = __attributes_offset;
-    __attributes_offset += size;
+    const uint32_t local_offset = TYPE_ALIGN( __attributes_offset, alignment );
+    SYS_ASSERT( local_offset + size <= ATTR_MEMORY_BUDGET );
+    __attributes_offset = local_offset + size;
     return __attributes_memory + local_offset;
 }
 
@@ -46,7 +56,7 @@ static inline uint8_t* ValuePtr( const uint16_t& offset )
 template< typename T >
 static inline const std::type_info& TypeInfoHelper( const T& value )
 {
-    return typeid( std::decay<decltype(value)>::type);
+    return typeid( typename std::decay<T>::type );
 }
 
 static inline uint32_t DataSize( const RTTIAttr& attr, const void* data, const std::type_info& data_type_info )
@@ -102,13 +112,150 @@ static void InitDefaultsHashCode( RTTIAttr* attr, size_t hash_code )
     }
 }
 
-static uint64_t ComputeTypeNameHash( const char* name )
+// --- codec
+struct RTTICodec
 {
-    const uint32_t len = (uint32_t)strlen( name );
-    uint32_t lo = murmur3_hash32( name, len, tag32_t( "RTTI" ) );
-    uint32_t hi = murmur3_hash32( name, len, lo );
+    struct Run
+    {
+        uint32_t obj_offset;
+        uint32_t record_offset;
+        uint32_t size;
+    };
+
+    uint64_t schema_hash;
+    uint32_t record_size;   // pod attributes packed in offset order
+    uint32_t nb_runs;       // attributes contiguous in object and record are merged to one run
+    uint32_t nb_strings;
+    const Run* runs;
+    const uint32_t* record_offset;  // per attribute, UINT32_MAX for strings
+    const uint32_t* strings;        // attribute indices of strings in declaration order
+};
 
-    return uint64_t( hi ) << 32 | uint64_t( lo );
+static constexpr uint32_t MAX_CODEC_ATTRIBUTES = 256;
+
+static const RTTICodec* BuildCodec( const RTTIAttr* const* attributes, uint32_t nb_attributes )
+{
+    uint32_t nb_strings = 0;
+    for( uint32_t i = 0; i < nb_attributes; ++i )
+        nb_strings += attributes[i]->_flags._is_string;
+
+    const uint32_t nb_pods = nb_attributes - nb_strings;
+
+    uint32_t mem_size = sizeof( RTTICodec );
+    mem_size += nb_pods * sizeof( RTTICodec::Run );
+    mem_size += nb_attributes * sizeof( uint32_t );
+    mem_size += nb_strings * sizeof( uint32_t );
+
+    uint8_t* memory = AllocateAttributeData( mem_size, ALIGNOF( RTTICodec ) );
+    RTTICodec* codec = (RTTICodec*)memory;
+    RTTICodec::Run* runs = (RTTICodec::Run*)( codec + 1 );
+    uint32_t* record_offset = (uint32_t*)( runs + nb_pods );
+    uint32_t* strings = record_offset + nb_attributes;
+
+    // pod attributes sorted by offset in object
+    SYS_ASSERT( nb_pods <= MAX_CODEC_ATTRIBUTES );
+    uint32_t order[MAX_CODEC_ATTRIBUTES];
+    uint32_t nb_ordered = 0;
+    uint32_t istring = 0;
+    for( uint32_t i = 0; i < nb_attributes; ++i )
+    {
+        record_offset[i] = UINT32_MAX;
+        if( attributes[i]->_flags._is_string )
+        {
+            strings[istring++] = i;
+            continue;
+        }
+
+        uint32_t j = nb_ordered++;
+        for( ; j > 0 && attributes[order[j - 1]]->_offset > attributes[i]->_offset; --j )
+            order[j] = order[j - 1];
+        order[j] = i;
+    }
+
+    uint32_t record_size = 0;
+    uint32_t nb_runs = 0;
+    for( uint32_t i = 0; i < nb_pods; ++i )
+    {
+        const RTTIAttr* attr = attributes[order[i]];
+        record_offset[order[i]] = record_size;
+
+        RTTICodec::Run* last = ( nb_runs ) ? &runs[nb_runs - 1] : nullptr;
+        if( last && last->obj_offset + last->size == attr->_offset )
+        {
+            last->size += attr->_size;
+        }
+        else
+        {
+            runs[nb_runs++] = { attr->_offset, record_size, attr->_size };
+        }
+        record_size += attr->_size;
+    }
+
+    // hash doesn't use type_info names, they are compiler specific
+    uint32_t lo = BX_UTIL_TAG32( 'R', 'T', 'T', 'C' );
+    uint32_t hi = ~lo;
+    for( uint32_t i = 0; i < nb_attributes; ++i )
+    {
+        const RTTIAttr* attr = attributes[i];
+        const char* name = attr->Name();
+        RTTITypeFlags type_flags = attr->_flags;
+        type_flags._is_pointer_default = 0;
+        type_flags._is_filename = 0;
+
+        const uint32_t desc[3] = { attr->_offset, attr->_size, type_flags._all };
+        lo = murmur3_hash32( name, (uint32_t)strlen( name ), lo );
+        lo = murmur3_hash32( desc, sizeof( desc ), lo );
+        hi = murmur3_hash32( desc, sizeof( desc ), hi );
+        hi = murmur3_hash32( name, (uint32_t)strlen( name ), hi );
+    }
+
+    codec->schema_hash = uint64_t( hi ) << 32 | uint64_t( lo );
+    codec->record_size = record_size;
+    codec->nb_runs = nb_runs;
+    codec->nb_strings = nb_strings;
+    codec->runs = runs;
+    codec->record_offset = record_offset;
+    codec->strings = strings;
+    return codec;
+}
+
+// --- attribute lookup
+struct RTTIAttrIndex
+{
+    uint32_t nb_attributes;
+    const hashed_string_t* name_hash;   // sorted
+    const RTTIAttr* const* attributes;  // in name_hash order
+};
+
+static const RTTIAttrIndex* BuildAttrIndex( const RTTIAttr* const* attributes, uint32_t nb_attributes )
+{
+    uint32_t mem_size = sizeof( RTTIAttrIndex );
+    mem_size += nb_attributes * sizeof( hashed_string_t );
+    mem_size += nb_attributes * sizeof( RTTIAttr* );
+
+    uint8_t* memory = AllocateAttributeData( mem_size, ALIGNOF( RTTIAttrIndex ) );
+    RTTIAttrIndex* index = (RTTIAttrIndex*)memory;
+    hashed_string_t* name_hash = (hashed_string_t*)( index + 1 );
+    const RTTIAttr** sorted = (const RTTIAttr**)( name_hash + nb_attributes );
+
+    for( uint32_t i = 0; i < nb_attributes; ++i )
+    {
+        const hashed_string_t hash = hashed_string( attributes[i]->Name() );
+        uint32_t j = i;
+        for( ; j > 0 && name_hash[j - 1] > hash; --j )
+        {
+            name_hash[j] = name_hash[j - 1];
+            sorted[j] = sorted[j - 1];
+        }
+        SYS_ASSERT( j == 0 || name_hash[j - 1] != hash ); // duplicated name or hash collision
+        name_hash[j] = hash;
+        sorted[j] = attributes[i];
+    }
+
+    index->nb_attributes = nb_attributes;
+    index->name_hash = name_hash;
+    index->attributes = sorted;
+    return index;
 }
 
 RTTITypeInfo::RTTITypeInfo( const std::type_info& ti, const std::type_info& parent_ti, const RTTIAttr* const* attribs, uint32_t nb_attribs )
@@ -118,6 +265,8 @@ RTTITypeInfo::RTTITypeInfo( const std::type_info& ti, const std::type_info& pare
     , attributes( attribs )
     , nb_attributes( nb_attribs )
     , _index( UINT32_MAX )
+    , _codec( nullptr )
+    , _attr_index( nullptr )
 {}
 
 RTTITypeInfo::RTTITypeInfo()
@@ -127,38 +276,77 @@ RTTITypeInfo::RTTITypeInfo()
     , nb_attributes(0)
     , creator(nullptr)
     , _index(UINT32_MAX)
+    , _codec(nullptr)
+    , _attr_index(nullptr)
 {}
 
 void RTTI::RegisterType( const RTTITypeInfo& info )
 {
-    const uint64_t hash = ComputeTypeNameHash( info.type_name );
+    const uint64_t hash = hashed_string( info.type_name );
 #if BX_RTTI_TYPE_NAME_HASH_CHECK == 1
-    for( uint32_t i = 0; i < __nb_types; ++i )
-        SYS_ASSERT( __typed_name_hash[i] != hash );
+    SYS_ASSERT( FindType( hash ) == nullptr );
 #endif
+    SYS_ASSERT( __nb_types < MAX_TYPES );
 
     const uint32_t index = __nb_types++;
-    RTTITypeInfo* new_info = __types + index;
+    RTTITypeInfo* new_info = Types() + index;
     memcpy( new_info, &info, sizeof( RTTITypeInfo ) );
     new_info->_index = index;
+    new_info->_codec = BuildCodec( info.attributes, info.nb_attributes );
+    new_info->_attr_index = BuildAttrIndex( info.attributes, info.nb_attributes );
 
     __typed_name_hash[index] = hash;
+
+    uint32_t slot = (uint32_t)hash & ( TYPE_INDEX_SIZE - 1 );
+    while( __type_index[slot] )
+        slot = ( slot + 1 ) & ( TYPE_INDEX_SIZE - 1 );
+
+    __type_index[slot] = index + 1;
 }
 
 const RTTITypeInfo* RTTI::FindType( const char* name )
 {
-    const uint64_t hash = ComputeTypeNameHash( name );
-    for( uint32_t i = 0; i < __nb_types; ++i )
+    return FindType( hashed_string( name ) );
+}
+
+const RTTITypeInfo* RTTI::FindType( hashed_string_t name_hash )
+{
+    uint32_t slot = (uint32_t)name_hash & ( TYPE_INDEX_SIZE - 1 );
+    while( __type_index[slot] )
     {
-        if( __typed_name_hash[i] == hash )
-        {
-            return &__types[i];
-        }
+        const uint32_t index = __type_index[slot] - 1;
+        if( __typed_name_hash[index] == name_hash )
+            return &Types()[index];
+
+        slot = ( slot + 1 ) & ( TYPE_INDEX_SIZE - 1 );
     }
 
     return nullptr;
 }
 
+const RTTIAttr* RTTI::FindAttr( const RTTITypeInfo& tinfo, hashed_string_t name_hash )
+{
+    const RTTIAttrIndex* index = tinfo._attr_index;
+    uint32_t begin = 0;
+    uint32_t end = index->nb_attributes;
+    while( begin < end )
+    {
+        const uint32_t mid = ( begin + end ) / 2;
+        if( index->name_hash[mid] < name_hash )
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+
+    return ( begin < index->nb_attributes && index->name_hash[begin] == name_hash ) ? index->attributes[begin] : nullptr;
+}
+const RTTIAttr* RTTI::FindAttr( const RTTITypeInfo& tinfo, const char* name )
+{
+    // name which is not an attribute can still collide with one
+    const RTTIAttr* attr = FindAttr( tinfo, hashed_string( name ) );
+    return ( attr && string::equal( attr->Name(), name ) ) ? attr : nullptr;
+}
+
 const RTTITypeInfo* RTTI::FindChildType( const std::type_info& parent_ti, const RTTITypeInfo* current )
 {
     uint32_t current_index = (current) ? current->_index + 1 : 0;
@@ -167,7 +355,7 @@ const RTTITypeInfo* RTTI::FindChildType( const std::type_info& parent_ti, const
     
     while( current_index < __nb_types )
     {
-        const RTTITypeInfo& type = __types[current_index];
+        const RTTITypeInfo& type = Types()[current_index];
         if( type.parent_info == parent_ti )
             return &type;
 
@@ -180,7 +368,7 @@ const RTTITypeInfo* RTTI::FindChildType( const std::type_info& parent_ti, const
 // ---
 RTTIAttr* RTTI::AllocateAttribute( uint32_t size )
 {
-    return (RTTIAttr*)AllocateAttributeData( size );
+    return (RTTIAttr*)AllocateAttributeData( size, ALIGNOF( RTTIAttr ) );
 }
 
 
@@ -381,6 +569,237 @@ uint32_t RTTI::_Unserialize( void* obj, const RTTIAttr** attributes, uint32_t nb
     return nb_unserialized_attributes;
 }
 
+// --- span
+struct RTTISpanHeader
+{
+    uint32_t tag;
+    uint32_t nb_objects;
+    uint64_t schema_hash;
+    uint32_t record_size;
+    uint32_t nb_fields;
+    uint32_t names_size;
+    uint32_t data_size;
+};
+struct RTTISpanField
+{
+    uint32_t name_offset;   // in names block
+    uint32_t record_offset; // UINT32_MAX for strings
+    uint32_t size;
+    uint32_t is_string;
+};
+static inline uint32_t StringSize( const string_t* str )
+{
+    return ( str->c_str() ) ? string::length( str->c_str() ) + 1 : 0;
+}
+
+static constexpr uint32_t RTTI_SPAN_TAG = BX_UTIL_TAG32( 'R', 'T', 'T', 'S' );
+
+uint64_t RTTI::SchemaHash( const RTTITypeInfo& tinfo )
+{
+    return tinfo._codec->schema_hash;
+}
+
+uint32_t RTTI::_SerializeSpan( uint8_t* buffer, uint32_t buffer_capacity, const RTTITypeInfo& tinfo, const void* objs, uint32_t stride, uint32_t count )
+{
+    const RTTICodec* codec = tinfo._codec;
+    const RTTIAttr* const* attributes = tinfo.attributes;
+    const uint32_t nb_attributes = tinfo.nb_attributes;
+
+    uint32_t names_size = 0;
+    for( uint32_t i = 0; i < nb_attributes; ++i )
+        names_size += (uint32_t)strlen( attributes[i]->Name() ) + 1;
+
+    uint32_t data_size = count * ( codec->record_size + codec->nb_strings * sizeof( uint32_t ) );
+    for( uint32_t iobj = 0; iobj < count; ++iobj )
+    {
+        const uint8_t* obj = (const uint8_t*)objs + iobj * stride;
+        for( uint32_t i = 0; i < codec->nb_strings; ++i )
+        {
+            const RTTIAttr* attr = attributes[codec->strings[i]];
+            data_size += StringSize( (const string_t*)attr->ValuePtr( obj ) );
+        }
+    }
+
+    const uint32_t schema_bytes = sizeof( RTTISpanHeader ) + nb_attributes * sizeof( RTTISpanField ) + names_size;
+    const uint32_t total_bytes = schema_bytes + data_size;
+    if( total_bytes > buffer_capacity )
+        return UINT32_MAX;
+
+    RTTISpanHeader* header = (RTTISpanHeader*)buffer;
+    header->tag = RTTI_SPAN_TAG;
+    header->nb_objects = count;
+    header->schema_hash = codec->schema_hash;
+    header->record_size = codec->record_size;
+    header->nb_fields = nb_attributes;
+    header->names_size = names_size;
+    header->data_size = data_size;
+
+    RTTISpanField* fields = (RTTISpanField*)( header + 1 );
+    char* names = (char*)( fields + nb_attributes );
+    uint32_t name_offset = 0;
+    for( uint32_t i = 0; i < nb_attributes; ++i )
+    {
+        const char* name = attributes[i]->Name();
+        const uint32_t name_size = (uint32_t)strlen( name ) + 1;
+        memcpy( names + name_offset, name, name_size );
+
+        fields[i].name_offset = name_offset;
+        fields[i].record_offset = codec->record_offset[i];
+        fields[i].size = attributes[i]->_size;
+        fields[i].is_string = attributes[i]->_flags._is_string;
+        name_offset += name_size;
+    }
+
+    uint8_t* ptr = buffer + schema_bytes;
+    for( uint32_t iobj = 0; iobj < count; ++iobj )
+    {
+        const uint8_t* obj = (const uint8_t*)objs + iobj * stride;
+        for( uint32_t irun = 0; irun < codec->nb_runs; ++irun )
+        {
+            const RTTICodec::Run& run = codec->runs[irun];
+            memcpy( ptr + run.record_offset, obj + run.obj_offset, run.size );
+        }
+        ptr += codec->record_size;
+
+        for( uint32_t i = 0; i < codec->nb_strings; ++i )
+        {
+            const RTTIAttr* attr = attributes[codec->strings[i]];
+            const string_t* str = (const string_t*)attr->ValuePtr( obj );
+            const uint32_t str_size = StringSize( str );
+            memcpy( ptr, &str_size, sizeof( uint32_t ) );
+            memcpy( ptr + sizeof( uint32_t ), str->c_str(), str_size );
+            ptr += sizeof( uint32_t ) + str_size;
+        }
+    }
+
+    SYS_ASSERT( ( buffer + total_bytes ) == ptr );
+    return total_bytes;
+}
+
+static const uint8_t* ReadSpanString( string_t* str, const uint8_t* ptr, const uint8_t* end, BXIAllocator* allocator )
+{
+    uint32_t str_size = 0;
+    if( ptr + sizeof( uint32_t ) > end )
+        return nullptr;
+
+    memcpy( &str_size, ptr, sizeof( uint32_t ) );
+    ptr += sizeof( uint32_t );
+    if( str_size > (size_t)( end - ptr ) )
+        return nullptr;
+
+    // string::create runs strlen, so terminator has to be inside the stored size
+    if( str_size && ptr[str_size - 1] != 0 )
+        return nullptr;
+
+    if( str )
+    {
+        string::free( str );
+        if( str_size )
+            string::create( str, (const char*)ptr, allocator );
+    }
+    return ptr + str_size;
+}
+
+uint32_t RTTI::_UnserializeSpan( void* objs, uint32_t stride, uint32_t count, const RTTITypeInfo& tinfo, const uint8_t* buffer, uint32_t buffer_size, BXIAllocator* allocator )
+{
+    if( buffer_size < sizeof( RTTISpanHeader ) )
+        return 0;
+
+    const RTTISpanHeader* header = (const RTTISpanHeader*)buffer;
+    if( header->tag != RTTI_SPAN_TAG )
+        return 0;
+
+    // sizes come from the buffer, so they are summed in 64 bits before any pointer is formed
+    const uint64_t total_size = (uint64_t)sizeof( RTTISpanHeader ) + (uint64_t)header->nb_fields * sizeof( RTTISpanField ) + header->names_size + header->data_size;
+    if( total_size > buffer_size )
+        return 0;
+
+    const RTTISpanField* fields = (const RTTISpanField*)( header + 1 );
+    const char* names = (const char*)( fields + header->nb_fields );
+    const uint8_t* ptr = (const uint8_t*)names + header->names_size;
+    const uint8_t* end = ptr + header->data_size;
+
+    // every name has to end inside names block and every pod field has to fit in the record
+    if( header->nb_fields && ( header->names_size == 0 || names[header->names_size - 1] != 0 ) )
+        return 0;
+
+    for( uint32_t i = 0; i < header->nb_fields; ++i )
+    {
+        const RTTISpanField& field = fields[i];
+        if( field.name_offset >= header->names_size )
+            return 0;
+        if( !field.is_string && (uint64_t)field.record_offset + field.size > header->record_size )
+            return 0;
+    }
+
+    const RTTICodec* codec = tinfo._codec;
+    const RTTIAttr* const* attributes = tinfo.attributes;
+    const uint32_t nb_objects = ( count < header->nb_objects ) ? count : header->nb_objects;
+
+    if( header->schema_hash == codec->schema_hash && header->record_size == codec->record_size )
+    {
+        for( uint32_t iobj = 0; iobj < nb_objects; ++iobj )
+        {
+            if( ptr + codec->record_size > end )
+                return iobj;
+
+            uint8_t* obj = (uint8_t*)objs + iobj * stride;
+            for( uint32_t irun = 0; irun < codec->nb_runs; ++irun )
+            {
+                const RTTICodec::Run& run = codec->runs[irun];
+                memcpy( obj + run.obj_offset, ptr + run.record_offset, run.size );
+            }
+            ptr += codec->record_size;
+
+            for( uint32_t i = 0; i < codec->nb_strings; ++i )
+            {
+                string_t* str = (string_t*)attributes[codec->strings[i]]->ValuePtr( obj );
+                ptr = ReadSpanString( str, ptr, end, allocator );
+                if( !ptr )
+                    return iobj;
+            }
+        }
+        return nb_objects;
+    }
+
+    // schema changed: match stored fields with current attributes by name once, then copy field by field.
+    // Fields which don't exist anymore or changed size are skipped.
+    const uint32_t nb_fields = header->nb_fields;
+    const RTTIAttr** remap = (const RTTIAttr**)BX_MALLOC( allocator, nb_fields * sizeof( RTTIAttr* ), sizeof( void* ) );
+    for( uint32_t i = 0; i < nb_fields; ++i )
+    {
+        const RTTIAttr* attr = FindAttr( tinfo, names + fields[i].name_offset );
+        const bool compatible = attr && attr->_flags._is_string == fields[i].is_string && ( fields[i].is_string || attr->_size == fields[i].size );
+        remap[i] = ( compatible ) ? attr : nullptr;
+    }
+
+    uint32_t iobj = 0;
+    for( ; iobj < nb_objects; ++iobj )
+    {
+        if( ptr + header->record_size > end )
+            break;
+
+        uint8_t* obj = (uint8_t*)objs + iobj * stride;
+        for( uint32_t i = 0; i < nb_fields; ++i )
+        {
+            if( remap[i] && !fields[i].is_string )
+                memcpy( obj + remap[i]->_offset, ptr + fields[i].record_offset, fields[i].size );
+        }
+        ptr += header->record_size;
+
+        for( uint32_t i = 0; i < nb_fields && ptr; ++i )
+        {
+            if( fields[i].is_string )
+                ptr = ReadSpanString( ( remap[i] ) ? (string_t*)remap[i]->ValuePtr( obj ) : nullptr, ptr, end, allocator );
+        }
+        if( !ptr )
+            break;
+    }
+
+    BX_FREE( allocator, remap );
+    return iobj;
+}
+
 const RTTIAttr* RTTI::_FindAttr( const RTTIAttr** attributes, uint32_t nb_attributes, const char* name )
 {
     for( uint32_t i = 0; i < nb_attributes; ++i )
@@ -389,6 +808,14 @@ const RTTIAttr* RTTI::_FindAttr( const RTTIAttr** attributes, uint32_t nb_attrib
 
     return nullptr;
 }
+const RTTIAttr* RTTI::_FindAttr( const RTTIAttr** attributes, uint32_t nb_attributes, hashed_string_t name_hash )
+{
+    for( uint32_t i = 0; i < nb_attributes; ++i )
+        if( hashed_string( attributes[i]->Name() ) == name_hash )
+            return attributes[i];
+
+    return nullptr;
+}
 
 RTTI_EXPORT void* BXLoad_rtti( BXIAllocator* allocator )
 {
@@ -4,7 +4,11 @@
 #include <plugin/plugin_interface.h>
 #include <foundation/type.h>
 #include <foundation/debug.h>
+#include <foundation/hashed_string.h>
+#include <foundation/string_util.h>
 #include <typeinfo>
+#include <type_traits>
+#include <new>
 #include <string.h>
 
 struct BXIAllocator;
@@ -19,6 +23,7 @@ struct BXIAllocator;
 #define _RTTI_DECLARE_TYPE_( name )\
     static const std::type_info& __parent_type;\
     static const char* TypeName() { return #name; };\
+    static constexpr hashed_string_t TypeNameHash() { return hashed_string( #name ); };\
     static void* __Creator( BXIAllocator* allocator )
 
 #define RTTI_DECLARE_TYPE( name ) \
@@ -123,15 +128,15 @@ struct RTTI_EXPORT RTTIAttr
     template< typename T >
     RTTIAttr* SetDefault( const T& value ) 
     { 
-        _flags._is_pointer_default = std::is_pointer< std::decay<decltype(value)>::type >::value;
-        return SetDefaultData( &value, (uint32_t)sizeof(T), typeid( std::decay<decltype(value)>::type )); 
+        _flags._is_pointer_default = std::is_pointer< typename std::decay<T>::type >::value;
+        return SetDefaultData( &value, (uint32_t)sizeof(T), typeid( typename std::decay<T>::type )); 
     }
 
     template< typename T >
-    RTTIAttr* SetMin( const T& value ) { return SetMinData( &value, (uint32_t)sizeof( T ), typeid(std::decay<T>::type) ); }
+    RTTIAttr* SetMin( const T& value ) { return SetMinData( &value, (uint32_t)sizeof( T ), typeid(typename std::decay<T>::type) ); }
     
     template< typename T >
-    RTTIAttr* SetMax( const T& value ) { return SetMaxData( &value, (uint32_t)sizeof( T ), typeid(std::decay<T>::type) ); }
+    RTTIAttr* SetMax( const T& value ) { return SetMaxData( &value, (uint32_t)sizeof( T ), typeid(typename std::decay<T>::type) ); }
 
     RTTIAttr* EnableFilename() { _flags._is_filename = 1; return this; }
 
@@ -147,29 +152,29 @@ struct RTTI_EXPORT RTTIAttr
     const T& Default() const
     {
         const uint8_t* ptr = DefaultPtr();
-        SYS_ASSERT( typeid(std::decay<T>::type).hash_code() == _defaults_storage_hashcode );
-        return (_is_pointer_default) ? (const T&)ptr : (const T&)(*(T*)ptr);
+        SYS_ASSERT( typeid(typename std::decay<T>::type).hash_code() == _defaults_storage_hashcode );
+        return (_flags._is_pointer_default) ? (const T&)ptr : (const T&)(*(T*)ptr);
     }
     template< typename T >
     const T& Min() const
     {
-        SYS_ASSERT( _is_pointer_default == 0 );
-        SYS_ASSERT( typeid(std::decay<T>::type).hash_code() == _defaults_storage_hashcode );
+        SYS_ASSERT( _flags._is_pointer_default == 0 );
+        SYS_ASSERT( typeid(typename std::decay<T>::type).hash_code() == _defaults_storage_hashcode );
         return (const T&)(*(T*)MinPtr());
     }
     template< typename T >
     const T& Max() const
     {
-        SYS_ASSERT( _is_pointer_default == 0 );
+        SYS_ASSERT( _flags._is_pointer_default == 0 );
         const uint8_t* ptr = MaxPtr();
-        SYS_ASSERT( typeid(std::decay<T>::type).hash_code() == _defaults_storage_hashcode );
+        SYS_ASSERT( typeid(typename std::decay<T>::type).hash_code() == _defaults_storage_hashcode );
         return (const T&)(*(T*)ptr);
     }
 
     template< typename T >
     const T& Value( const void* obj ) const
     {
-        SYS_ASSERT( typeid(std::decay<T>::type) == _type_info );
+        SYS_ASSERT( typeid(typename std::decay<T>::type) == _type_info );
         const uint8_t* ptr = ValuePtr( obj );
         return *(const T*)(ptr);
     }
@@ -190,6 +195,8 @@ struct RTTI_EXPORT RTTIAttr
 };
 
 typedef void*(*RTTIObjectCreator)( BXIAllocator* allocator );
+struct RTTICodec;
+struct RTTIAttrIndex;
 struct RTTI_EXPORT RTTITypeInfo
 {
     const char* type_name;
@@ -202,6 +209,8 @@ struct RTTI_EXPORT RTTITypeInfo
 
     RTTITypeFlags flags;
     uint32_t _index;
+    const RTTICodec* _codec;
+    const RTTIAttrIndex* _attr_index;
 
     RTTITypeInfo();
     RTTITypeInfo( const std::type_info& ti, const std::type_info& parent_ti, const RTTIAttr* const* attribs, uint32_t nb_attribs );
@@ -226,6 +235,7 @@ struct RTTI_EXPORT RTTI
     }
     
     static const RTTITypeInfo* FindType( const char* name );
+    static const RTTITypeInfo* FindType( hashed_string_t name_hash );
     static const RTTITypeInfo* FindChildType( const std::type_info& parent_ti, const RTTITypeInfo* current );
     template <typename Tparent>
     static const RTTITypeInfo* FindChildType( const RTTITypeInfo* current )
@@ -271,16 +281,32 @@ struct RTTI_EXPORT RTTI
     }
 
 
+    // Returned attribute is valid for program lifetime, hot code should keep it instead of resolving name each time.
+    // Types not registered (yet) fall back to linear search over T::__attributes.
     template< typename T >
     static const RTTIAttr* Find( const char* name )
     {
-        return _FindAttr( T::__attributes, T::__nb_attributes, name );
+        const RTTITypeInfo* tinfo = FindType( T::TypeNameHash() );
+        return ( tinfo ) ? FindAttr( *tinfo, name ) : _FindAttr( T::__attributes, T::__nb_attributes, name );
     }
+    template< typename T >
+    static const RTTIAttr* Find( hashed_string_t name_hash )
+    {
+        const RTTITypeInfo* tinfo = FindType( T::TypeNameHash() );
+        return ( tinfo ) ? FindAttr( *tinfo, name_hash ) : _FindAttr( T::__attributes, T::__nb_attributes, name_hash );
+    }
+    static const RTTIAttr* FindAttr( const RTTITypeInfo& tinfo, const char* name );
+    static const RTTIAttr* FindAttr( const RTTITypeInfo& tinfo, hashed_string_t name_hash );
 
     template< typename F, typename T >
     static bool Value( F* dst, const T& obj, const char* attr_name )
     {
-        const RTTIAttr* attr = Find<T>( attr_name );
+        return Value( dst, obj, Find<T>( attr_name ) );
+    }
+
+    template< typename F, typename T >
+    static bool Value( F* dst, const T& obj, const RTTIAttr* attr )
+    {
         if( attr )
         {
             dst[0] = attr->Value<F>( &obj );
@@ -308,10 +334,48 @@ struct RTTI_EXPORT RTTI
         return _Unserialize( obj, T::__attributes, T::__nb_attributes, buffer, buffer_size, allocator );
     }
 
+    //
+    // --- compiled binary codec
+    // Schema (attribute names, sizes, offsets) is stored once per call, followed by one record per object.
+    // When stored schema hash matches current type, attributes are copied in contiguous runs,
+    // otherwise fields are remapped by name once per call.
+    //
+    template< typename T >
+    static uint32_t SerializeSpan( uint8_t* buffer, uint32_t buffer_capacity, const T* objs, uint32_t count )
+    {
+        return _SerializeSpan( buffer, buffer_capacity, *_TypeInfo<T>(), objs, (uint32_t)sizeof( T ), count );
+    }
+
+    // returns number of unserialized objects
+    template< typename T >
+    static uint32_t UnserializeSpan( T* objs, uint32_t count, const uint8_t* buffer, uint32_t buffer_size, BXIAllocator* allocator )
+    {
+        return _UnserializeSpan( objs, (uint32_t)sizeof( T ), count, *_TypeInfo<T>(), buffer, buffer_size, allocator );
+    }
+
+    template< typename T >
+    static uint64_t SchemaHash() { return SchemaHash( *_TypeInfo<T>() ); }
+    static uint64_t SchemaHash( const RTTITypeInfo& tinfo );
+
+    template< typename T >
+    static const RTTITypeInfo* _TypeInfo()
+    {
+        // only successful lookup is cached, type can be registered after first call
+        static const RTTITypeInfo* cached = nullptr;
+        const RTTITypeInfo* tinfo = ( cached ) ? cached : FindType( T::TypeNameHash() );
+        SYS_ASSERT( tinfo != nullptr );
+        cached = tinfo;
+        return tinfo;
+    }
+
+    static uint32_t _SerializeSpan  ( uint8_t* buffer, uint32_t buffer_capacity, const RTTITypeInfo& tinfo, const void* objs, uint32_t stride, uint32_t count );
+    static uint32_t _UnserializeSpan( void* objs, uint32_t stride, uint32_t count, const RTTITypeInfo& tinfo, const uint8_t* buffer, uint32_t buffer_size, BXIAllocator* allocator );
+
     static uint32_t _Serialize  ( uint8_t* buffer, uint32_t buffer_capacity, const RTTIAttr** attributes, uint32_t nb_attributes, const void* obj );
     static uint32_t _Unserialize( void* obj, const RTTIAttr** attributes, uint32_t nb_attributes, const uint8_t* buffer, uint32_t buffer_size, BXIAllocator* allocator );
 
     static const RTTIAttr* _FindAttr( const RTTIAttr** attributes, uint32_t nb_attributes, const char* name );
+    static const RTTIAttr* _FindAttr( const RTTIAttr** attributes, uint32_t nb_attributes, hashed_string_t name_hash );
 };
 
 #define BX_RTTI_PLUGIN_NAME "rtti"
@@ -21,6 +21,7 @@
 #include "3rd_party\imgui\imgui.h"
 #include "rdix\rdix.h"
 #include "rdix\rdix_debug_draw.h"
+#include "resource_manager\resource_manager.h"
 #include "foundation\time.h"
 #include "anim\anim_player.h"
 #include "common\common.h"
@@ -68,6 +69,7 @@ bool BXSandboxApp::Update( BXWindow* win, unsigned long long deltaTimeUS, BXIAll
         return false;
 	
     GUI::NewFrame();
+    RSM::Update();
 
     const float delta_time_sec = (float)BXTime::Micro_2_Sec( deltaTimeUS );
     if( ImGui::Begin( "Frame info" ) )
@@ -73,8 +73,8 @@ IN_PS vs_base( IN_VS input )
 	LoadWorld( world_0, world_1, world_2, input.instanceID );
 	LoadWorldIT( world_it_0, world_it_1, world_it_2, input.instanceID );
 
-	float4 pos_ls = float4(input.pos, 1.0);
-	float3 nrm_ls = input.nrm;
+	float4 pos_ls = float4( DecodePosition( input.pos ), 1.0);
+	float3 nrm_ls = DecodeNormal( input.nrm, INSTANCE_VERTEX_OCT_NORMAL );
     float3 pos_ws = TransformPosition( world_0, world_1, world_2, pos_ls );
 
     uint camera_index = _idata.camera_index;
@@ -84,8 +84,8 @@ IN_PS vs_base( IN_VS input )
     output.nrm_ws = TransformNormal( world_it_0, world_it_1, world_it_2, nrm_ls );
 
 #if USE_TANGENTS == 1
-    output.tan_ws = TransformNormal( world_it_0, world_it_1, world_it_2, input.tan );
-    output.bin_ws = TransformNormal( world_it_0, world_it_1, world_it_2, input.bin );
+    output.tan_ws = TransformNormal( world_it_0, world_it_1, world_it_2, DecodeNormal( input.tan, INSTANCE_VERTEX_OCT_TANGENT ) );
+    output.bin_ws = TransformNormal( world_it_0, world_it_1, world_it_2, DecodeNormal( input.bin, INSTANCE_VERTEX_OCT_BINORMAL ) );
 #endif
 
 	output.uv0 = input.uv0;
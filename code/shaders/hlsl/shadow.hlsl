@@ -136,7 +136,7 @@ IN_PS_SHADOW_DEPTH vs_shadow_depth( in IN_VS_SHADOW_DEPTH input )
 
     float4 world_0, world_1, world_2;
     LoadWorld( world_0, world_1, world_2, input.instanceID );
-    float4 pos_ls = float4(input.pos, 1.0);
+    float4 pos_ls = float4( DecodePosition( input.pos ), 1.0 );
     float3 pos_ws = TransformPosition( world_0, world_1, world_2, pos_ls );
 
     output.pos_hs = mul( _fdata.camera_view_proj, float4(pos_ws, 1.0) );
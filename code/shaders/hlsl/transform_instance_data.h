@@ -6,12 +6,21 @@
 #define TRANSFORM_INSTANCE_WORLD_SLOT 0
 #define TRANSFORM_INSTANCE_WORLD_IT_SLOT 1
 
+// vertex_flags, set for streams stored with octahedral encoding (2 x snorm16)
+#define INSTANCE_VERTEX_OCT_NORMAL   0x1
+#define INSTANCE_VERTEX_OCT_TANGENT  0x2
+#define INSTANCE_VERTEX_OCT_BINORMAL 0x4
+
 struct InstanceData
 {
 	uint offset;
     uint camera_index;
     uint material_index;
-    uint __padding[1];
+    uint vertex_flags;
+    float3 position_min;    // local position = position_min + input position * position_extent
+    float __padding0;
+    float3 position_extent;
+    float __padding1;
 };
 
 #ifdef SHADER_IMPLEMENTATION
@@ -46,6 +55,22 @@ float3 TransformNormal( in float3 row0IT, in float3 row1IT, in float3 row2IT, in
 {
 	return float3( dot( row0IT, normal ), dot( row1IT, normal ), dot( row2IT, normal ) );
 }
+
+float3 DecodePosition( in float3 pos )
+{
+    return _idata.position_min + pos * _idata.position_extent;
+}
+// input assembler delivers oct encoded vector in xy
+float3 DecodeNormal( in float3 nrm, uint flag )
+{
+    if( ( _idata.vertex_flags & flag ) == 0 )
+        return nrm;
+
+    float3 n = float3( nrm.xy, 1.0 - abs( nrm.x ) - abs( nrm.y ) );
+    float t = saturate( -n.z );
+    n.xy += ( n.xy >= 0.0 ) ? -t : t;
+    return normalize( n );
+}
 #endif
 
 #endif
\ No newline at end of file
@@ -372,6 +372,7 @@ bool SnakeApp::Update( BXWindow* win, unsigned long long deltaTimeUS, BXIAllocat
         return false;
 
     GUI::NewFrame();
+    RSM::Update();
 
     const float delta_time_sec = (float)BXTime::Micro_2_Sec( deltaTimeUS );
 
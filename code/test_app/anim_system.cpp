@@ -225,15 +225,13 @@ namespace anim_system
         {
             const InJointSpan in_joints = in_poses[i];
             const ANIMSkel* skel = skels[i];
-            const u16* parent_indices = (u16*)ParentIndices( skel );
             const ANIMJoint root = (i < (u64)root_joints.size()) ? root_joints[i] : ANIMJoint::identity();
             OutJointSpan out_joints = out_poses[i];
 
             SYS_ASSERT( out_joints.size() == in_joints.size() );
             SYS_ASSERT( out_joints.size() == skel->numJoints );
 
-            const u32 num_joints = (u32)out_joints.size();
-            LocalJointsToWorldJoints( out_joints.data(), in_joints.data(), parent_indices, num_joints, root );
+            LocalJointsToWorldJoints( out_joints.data(), in_joints.data(), skel, root );
         }
     }
 
@@ -247,15 +245,13 @@ namespace anim_system
         {
             const InJointSpan in_joints = in_poses[i];
             const ANIMSkel* skel = skels[i];
-            const u16* parent_indices = (u16*)ParentIndices( skel );
             const ANIMJoint root = (i < (u64)root_joints.size()) ? root_joints[i] : ANIMJoint::identity();
             OutMatrixSpan out_matrices = out_poses[i];
 
             SYS_ASSERT( out_matrices.size() == in_joints.size() );
             SYS_ASSERT( out_matrices.size() == skel->numJoints );
 
-            const u32 num_joints = (u32)out_matrices.size();
-            LocalJointsToWorldMatrices4x4( out_matrices.data(), in_joints.data(), parent_indices, num_joints, root );
+            LocalJointsToWorldMatrices4x4( out_matrices.data(), in_joints.data(), skel, root );
         }
     }
 
@@ -28,6 +28,7 @@
 #include "foundation\array.h"
 #include "util\color.h"
 #include "anim\anim_debug.h"
+#include "anim\anim_stream.h"
 #include "foundation\eastl\vector.h"
 #include "foundation\eastl\span.h"
 
@@ -615,6 +616,9 @@ bool BXTestApp::Startup( int argc, const char** argv, BXPluginRegistry* plugins,
 {
     CMNEngine::Startup( this, argc, argv, plugins, allocator );
 
+    RSM::RegisterLoader<ANIMClipStreamLoader>();
+    RSM::RegisterLoader<ANIMClipSegmentLoader>();
+
     ANIMClipID clipId = ToID<ANIMClipID>( 666u );
     u32 hash = ToHash( clipId );
 
@@ -668,6 +672,7 @@ bool BXTestApp::Update( BXWindow* win, unsigned long long deltaTimeUS, BXIAlloca
         return false;
 	
     GUI::NewFrame();
+    RSM::Update();
 
     const float delta_time_sec = (float)BXTime::Micro_2_Sec( deltaTimeUS );
     if( ImGui::Begin( "Frame info" ) )
@@ -0,0 +1,195 @@
+#include <3rd_party/googletest/include/gtest/gtest.h>
+#include <anim/anim.h>
+#include <foundation/math/vmath.h>
+
+#include <string.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // skeleton blob laid out like compiled one: header followed by arrays addressed with self relative offsets
+    struct TestSkel
+    {
+        std::vector<uint8_t> blob;
+
+        const ANIMSkel* skel() const { return (const ANIMSkel*)blob.data(); }
+        const uint16_t* parent_indices() const { return (const uint16_t*)ParentIndices( skel() ); }
+    };
+
+    TestSkel BuildSkel( const std::vector<uint16_t>& parents, bool with_levels )
+    {
+        const uint32_t num_joints = (uint32_t)parents.size();
+
+        std::vector<uint16_t> depth( num_joints, 0 );
+        uint16_t num_levels = 0;
+        for( uint32_t i = 0; i < num_joints; ++i )
+        {
+            depth[i] = ( parents[i] == 0xFFFF ) ? 0 : depth[parents[i]] + 1;
+            num_levels = max_of_2( num_levels, (uint16_t)( depth[i] + 1 ) );
+        }
+
+        std::vector<uint16_t> level_joints;
+        std::vector<uint16_t> level_begin;
+        for( uint16_t ilevel = 0; ilevel < num_levels; ++ilevel )
+        {
+            level_begin.push_back( (uint16_t)level_joints.size() );
+            for( uint32_t i = 0; i < num_joints; ++i )
+            {
+                if( depth[i] == ilevel )
+                    level_joints.push_back( (uint16_t)i );
+            }
+        }
+        level_begin.push_back( (uint16_t)level_joints.size() );
+
+        const uint32_t parents_offset = sizeof( ANIMSkel );
+        const uint32_t level_joints_offset = parents_offset + num_joints * sizeof( uint16_t );
+        const uint32_t level_begin_offset = level_joints_offset + num_joints * sizeof( uint16_t );
+        const uint32_t blob_size = level_begin_offset + (uint32_t)level_begin.size() * sizeof( uint16_t );
+
+        TestSkel result;
+        result.blob.resize( blob_size, 0 );
+        uint8_t* base = result.blob.data();
+        ANIMSkel* skel = (ANIMSkel*)base;
+        memcpy( base + parents_offset, parents.data(), num_joints * sizeof( uint16_t ) );
+        memcpy( base + level_joints_offset, level_joints.data(), num_joints * sizeof( uint16_t ) );
+        memcpy( base + level_begin_offset, level_begin.data(), level_begin.size() * sizeof( uint16_t ) );
+
+        skel->numJoints = (uint16_t)num_joints;
+        skel->offsetParentIndices = TYPE_POINTER_GET_OFFSET( &skel->offsetParentIndices, base + parents_offset );
+        if( with_levels )
+        {
+            skel->numLevels = num_levels;
+            skel->offsetLevelJoints = TYPE_POINTER_GET_OFFSET( &skel->offsetLevelJoints, base + level_joints_offset );
+            skel->offsetLevelBegin = TYPE_POINTER_GET_OFFSET( &skel->offsetLevelBegin, base + level_begin_offset );
+        }
+        return result;
+    }
+
+    // parents always precede children, like in compiled skeletons
+    std::vector<uint16_t> RandomHierarchy( uint32_t num_joints, std::default_random_engine& generator )
+    {
+        std::vector<uint16_t> parents( num_joints );
+        parents[0] = 0xFFFF;
+        for( uint32_t i = 1; i < num_joints; ++i )
+        {
+            // bias towards recent joints to get long chains (spine, fingers) next to wide levels
+            std::uniform_int_distribution<uint32_t> dist( ( i > 8 ) ? i - 8 : 0, i - 1 );
+            parents[i] = (uint16_t)dist( generator );
+        }
+        return parents;
+    }
+
+    std::vector<ANIMJoint> RandomPose( uint32_t num_joints, bool uniform_scale, std::default_random_engine& generator )
+    {
+        std::uniform_real_distribution<float> unit( -1.f, 1.f );
+        std::uniform_real_distribution<float> scale( 0.5f, 1.5f );
+
+        std::vector<ANIMJoint> pose( num_joints );
+        for( ANIMJoint& joint : pose )
+        {
+            const vec3_t axis = normalize( vec3_t( unit( generator ), unit( generator ), unit( generator ) ) + vec3_t( 0.f, 0.f, 0.01f ) );
+            joint.rotation = quat_t::rotation( unit( generator ) * PI, axis );
+            joint.position = vec4_t( unit( generator ), unit( generator ), unit( generator ), 1.f );
+            joint.scale = ( uniform_scale ) ? vec4_t( vec3_t( scale( generator ) ), 1.f ) : vec4_t( scale( generator ), scale( generator ), scale( generator ), 1.f );
+        }
+        return pose;
+    }
+
+    ANIMJoint RootJoint()
+    {
+        ANIMJoint root;
+        root.rotation = quat_t::rotation( 0.5f, normalize( vec3_t( 1.f, 2.f, 3.f ) ) );
+        root.position = vec4_t( 1.f, -2.f, 0.5f, 1.f );
+        root.scale = vec4_t( 1.f );
+        return root;
+    }
+
+    // error relative to magnitude, world positions grow with chain length
+    float RelativeError( const vec4_t& a, const vec4_t& b )
+    {
+        const vec4_t d = a - b;
+        const float scale = max_of_2( 1.f, max_elem( abs_per_elem( a ) ) );
+        return max_elem( abs_per_elem( d ) ) / scale;
+    }
+
+    static constexpr uint32_t NUM_JOINTS = 150;
+    static constexpr float MAX_ERROR = 1e-5f;
+}
+
+class LocalJointsToWorldLevels : public ::testing::TestWithParam<bool> // uniform scale
+{};
+
+TEST_P( LocalJointsToWorldLevels, levels_match_parent_indices_joints )
+{
+    std::default_random_engine generator( 1234 );
+    for( uint32_t iround = 0; iround < 16; ++iround )
+    {
+        const TestSkel ts = BuildSkel( RandomHierarchy( NUM_JOINTS, generator ), true );
+        const std::vector<ANIMJoint> local = RandomPose( NUM_JOINTS, GetParam(), generator );
+        const ANIMJoint root = RootJoint();
+
+        std::vector<ANIMJoint> expected( NUM_JOINTS );
+        std::vector<ANIMJoint> actual( NUM_JOINTS );
+        LocalJointsToWorldJoints( expected.data(), local.data(), ts.parent_indices(), NUM_JOINTS, root );
+        LocalJointsToWorldJoints( actual.data(), local.data(), ts.skel(), root );
+
+        for( uint32_t i = 0; i < NUM_JOINTS; ++i )
+        {
+            // q and -q are the same rotation
+            const float rot_error = min_of_2( RelativeError( expected[i].rotation.to_vec4(), actual[i].rotation.to_vec4() ),
+                                              RelativeError( expected[i].rotation.to_vec4(), -actual[i].rotation.to_vec4() ) );
+            EXPECT_LE( rot_error, MAX_ERROR ) << "joint " << i;
+            EXPECT_LE( RelativeError( expected[i].position, actual[i].position ), MAX_ERROR ) << "joint " << i;
+            EXPECT_LE( RelativeError( expected[i].scale, actual[i].scale ), MAX_ERROR ) << "joint " << i;
+        }
+    }
+}
+
+TEST_P( LocalJointsToWorldLevels, levels_match_parent_indices_matrices )
+{
+    std::default_random_engine generator( 4321 );
+    for( uint32_t iround = 0; iround < 16; ++iround )
+    {
+        const TestSkel ts = BuildSkel( RandomHierarchy( NUM_JOINTS, generator ), true );
+        const std::vector<ANIMJoint> local = RandomPose( NUM_JOINTS, GetParam(), generator );
+        const ANIMJoint root = RootJoint();
+
+        std::vector<mat44_t> expected( NUM_JOINTS );
+        std::vector<mat44_t> actual( NUM_JOINTS );
+        LocalJointsToWorldMatrices4x4( expected.data(), local.data(), ts.parent_indices(), NUM_JOINTS, root );
+        LocalJointsToWorldMatrices4x4( actual.data(), local.data(), ts.skel(), root );
+
+        for( uint32_t i = 0; i < NUM_JOINTS; ++i )
+        {
+            EXPECT_LE( RelativeError( expected[i].c0, actual[i].c0 ), MAX_ERROR ) << "joint " << i;
+            EXPECT_LE( RelativeError( expected[i].c1, actual[i].c1 ), MAX_ERROR ) << "joint " << i;
+            EXPECT_LE( RelativeError( expected[i].c2, actual[i].c2 ), MAX_ERROR ) << "joint " << i;
+            EXPECT_LE( RelativeError( expected[i].c3, actual[i].c3 ), MAX_ERROR ) << "joint " << i;
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P( anim, LocalJointsToWorldLevels, ::testing::Bool() );
+
+// skeletons compiled before level tables existed have numLevels == 0
+TEST( LocalJointsToWorld, no_levels_falls_back_to_parent_indices )
+{
+    std::default_random_engine generator( 42 );
+    const TestSkel ts = BuildSkel( RandomHierarchy( NUM_JOINTS, generator ), false );
+    const std::vector<ANIMJoint> local = RandomPose( NUM_JOINTS, false, generator );
+    const ANIMJoint root = RootJoint();
+
+    std::vector<ANIMJoint> expected( NUM_JOINTS );
+    std::vector<ANIMJoint> actual( NUM_JOINTS );
+    LocalJointsToWorldJoints( expected.data(), local.data(), ts.parent_indices(), NUM_JOINTS, root );
+    LocalJointsToWorldJoints( actual.data(), local.data(), ts.skel(), root );
+    EXPECT_EQ( 0, memcmp( expected.data(), actual.data(), NUM_JOINTS * sizeof( ANIMJoint ) ) );
+
+    std::vector<mat44_t> expected_m( NUM_JOINTS );
+    std::vector<mat44_t> actual_m( NUM_JOINTS );
+    LocalJointsToWorldMatrices4x4( expected_m.data(), local.data(), ts.parent_indices(), NUM_JOINTS, root );
+    LocalJointsToWorldMatrices4x4( actual_m.data(), local.data(), ts.skel(), root );
+    EXPECT_EQ( 0, memcmp( expected_m.data(), actual_m.data(), NUM_JOINTS * sizeof( mat44_t ) ) );
+}
+
@@ -0,0 +1,455 @@
+#include <3rd_party/googletest/include/gtest/gtest.h>
+#include <foundation/serializer.h>
+#include <memory/memory.h>
+
+#include <stdlib.h>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+    std::vector<uint8_t> Compress( const std::vector<uint8_t>& src )
+    {
+        std::vector<uint8_t> packed( srl_lz4::compress_bound( (uint32_t)src.size() ) );
+        const uint32_t packed_size = srl_lz4::compress( packed.data(), (uint32_t)packed.size(), src.data(), (uint32_t)src.size() );
+        packed.resize( packed_size );
+        return packed;
+    }
+
+    void ExpectLZ4RoundTrip( const std::vector<uint8_t>& src )
+    {
+        const std::vector<uint8_t> packed = Compress( src );
+        ASSERT_GT( packed.size(), 0u );
+        ASSERT_LE( packed.size(), srl_lz4::compress_bound( (uint32_t)src.size() ) );
+
+        // one extra byte, decompressed size has to come from the data, not from capacity
+        std::vector<uint8_t> unpacked( src.size() + 1, 0xcd );
+        const int32_t n = srl_lz4::decompress( unpacked.data(), (uint32_t)unpacked.size(), packed.data(), (uint32_t)packed.size() );
+        ASSERT_EQ( n, (int32_t)src.size() );
+        EXPECT_TRUE( std::equal( src.begin(), src.end(), unpacked.begin() ) );
+    }
+}
+
+TEST( srl_lz4, empty_input )
+{
+    ExpectLZ4RoundTrip( {} );
+}
+
+TEST( srl_lz4, input_shorter_than_mf_limit )
+{
+    for( uint32_t size = 1; size <= 13; ++size )
+    {
+        std::vector<uint8_t> src( size, 'a' );
+        ExpectLZ4RoundTrip( src );
+    }
+}
+
+TEST( srl_lz4, long_runs )
+{
+    // match and literal lengths well above 15 + 255 to exercise length continuation bytes
+    std::vector<uint8_t> src( 100000, 7 );
+    for( uint32_t i = 50000; i < 50600; ++i )
+        src[i] = (uint8_t)( i * 31 );
+
+    const std::vector<uint8_t> packed = Compress( src );
+    EXPECT_LT( packed.size(), src.size() / 50 );
+    ExpectLZ4RoundTrip( src );
+}
+
+TEST( srl_lz4, repeated_pattern )
+{
+    std::vector<uint8_t> src;
+    const char pattern[] = "abcdefgh0123";
+    for( uint32_t i = 0; i < 10000; ++i )
+        src.push_back( (uint8_t)pattern[i % ( sizeof( pattern ) - 1 )] );
+
+    ExpectLZ4RoundTrip( src );
+}
+
+TEST( srl_lz4, incompressible_input )
+{
+    std::default_random_engine generator( 1234 );
+    std::uniform_int_distribution<uint32_t> distribution( 0, 255 );
+
+    std::vector<uint8_t> src( 70000 );
+    for( uint8_t& b : src )
+        b = (uint8_t)distribution( generator );
+
+    ExpectLZ4RoundTrip( src );
+}
+
+TEST( srl_lz4, dst_too_small )
+{
+    std::vector<uint8_t> src( 1000, 1 );
+    uint8_t packed[4];
+    EXPECT_EQ( srl_lz4::compress( packed, sizeof( packed ), src.data(), (uint32_t)src.size() ), 0u );
+
+    const std::vector<uint8_t> valid = Compress( src );
+    std::vector<uint8_t> unpacked( src.size() - 1 );
+    EXPECT_EQ( srl_lz4::decompress( unpacked.data(), (uint32_t)unpacked.size(), valid.data(), (uint32_t)valid.size() ), -1 );
+}
+
+TEST( srl_lz4, malformed_input )
+{
+    uint8_t unpacked[256];
+
+    // literal length says 4, only 2 bytes follow
+    const uint8_t truncated_literals[] = { 0x40, 'a', 'b' };
+    EXPECT_EQ( srl_lz4::decompress( unpacked, sizeof( unpacked ), truncated_literals, sizeof( truncated_literals ) ), -1 );
+
+    // literal length continuation byte is missing
+    const uint8_t truncated_length[] = { 0xf0 };
+    EXPECT_EQ( srl_lz4::decompress( unpacked, sizeof( unpacked ), truncated_length, sizeof( truncated_length ) ), -1 );
+
+    // offset is cut in half
+    const uint8_t truncated_offset[] = { 0x10, 'a', 0x01 };
+    EXPECT_EQ( srl_lz4::decompress( unpacked, sizeof( unpacked ), truncated_offset, sizeof( truncated_offset ) ), -1 );
+
+    // offset points before output begin
+    const uint8_t offset_out_of_range[] = { 0x10, 'a', 0x02, 0x00 };
+    EXPECT_EQ( srl_lz4::decompress( unpacked, sizeof( unpacked ), offset_out_of_range, sizeof( offset_out_of_range ) ), -1 );
+
+    // zero offset
+    const uint8_t zero_offset[] = { 0x10, 'a', 0x00, 0x00 };
+    EXPECT_EQ( srl_lz4::decompress( unpacked, sizeof( unpacked ), zero_offset, sizeof( zero_offset ) ), -1 );
+
+    // match length continuation byte is missing
+    const uint8_t truncated_match_length[] = { 0x1f, 'a', 0x01, 0x00 };
+    EXPECT_EQ( srl_lz4::decompress( unpacked, sizeof( unpacked ), truncated_match_length, sizeof( truncated_match_length ) ), -1 );
+
+    // match expands past dst capacity
+    const uint8_t match_overflow[] = { 0x1f, 'a', 0x01, 0x00, 0xff, 0x00 };
+    EXPECT_EQ( srl_lz4::decompress( unpacked, sizeof( unpacked ), match_overflow, sizeof( match_overflow ) ), -1 );
+
+    // random garbage must not crash nor write out of bounds
+    std::default_random_engine generator( 42 );
+    std::uniform_int_distribution<uint32_t> distribution( 0, 255 );
+    for( uint32_t iter = 0; iter < 1000; ++iter )
+    {
+        uint8_t garbage[64];
+        for( uint8_t& b : garbage )
+            b = (uint8_t)distribution( generator );
+
+        const int32_t n = srl_lz4::decompress( unpacked, sizeof( unpacked ), garbage, sizeof( garbage ) );
+        EXPECT_LE( n, (int32_t)sizeof( unpacked ) );
+    }
+}
+
+TEST( srl_frame, compressed_round_trip )
+{
+    SRLInstance writer = SRLInstance::CreateWriterDynamic( 3, 64, BXDefaultAllocator() );
+    std::vector<uint32_t> values( 1000, 0xabcd );
+    SerializeSpan( &writer, values.data(), (uint32_t)values.size() );
+
+    data_buffer_t frame;
+    data_buffer::create( &frame, 64, BXDefaultAllocator() );
+    srl_frame::write( &frame, writer, true, BXDefaultAllocator() );
+
+    const srl_frame_t* header = (const srl_frame_t*)frame.begin();
+    EXPECT_TRUE( header->is_compressed() );
+
+    SRLInstance reader;
+    ASSERT_TRUE( SRLInstance::CreateFrameReader( &reader, frame.begin(), data_buffer::size( frame ), BXDefaultAllocator() ) );
+    EXPECT_EQ( reader.version, 3u );
+
+    std::vector<uint32_t> result( values.size() );
+    SerializeSpan( &reader, result.data(), (uint32_t)result.size() );
+    EXPECT_EQ( values, result );
+
+    // truncated frame
+    EXPECT_FALSE( SRLInstance::CreateFrameReader( &reader, frame.begin(), data_buffer::size( frame ) - 1, BXDefaultAllocator() ) );
+}
+
+namespace
+{
+    template< typename T >
+    void ExpectVarintRoundTrip( const std::vector<T>& values )
+    {
+        std::vector<T> input = values;
+        SRLInstance writer = SRLInstance::CreateWriterDynamic( 0, 64, BXDefaultAllocator() );
+        ASSERT_TRUE( SerializeVarint( &writer, input.data(), (uint32_t)input.size() ) );
+        ASSERT_TRUE( SerializeDelta( &writer, input.data(), (uint32_t)input.size() ) );
+
+        SRLInstance reader = SRLInstance::CreateReader( 0, writer.data.begin(), data_buffer::size( writer.data ), BXDefaultAllocator() );
+        std::vector<T> varint( values.size() );
+        std::vector<T> delta( values.size() );
+        ASSERT_TRUE( SerializeVarint( &reader, varint.data(), (uint32_t)varint.size() ) );
+        ASSERT_TRUE( SerializeDelta( &reader, delta.data(), (uint32_t)delta.size() ) );
+
+        EXPECT_EQ( values, varint );
+        EXPECT_EQ( values, delta );
+        EXPECT_EQ( reader.data.read_offset, reader.data.write_offset );
+    }
+
+    template< typename T >
+    std::vector<T> LimitValues()
+    {
+        using limits = std::numeric_limits<T>;
+        std::vector<T> values = { limits::min(), limits::max(), 0, limits::max(), limits::min(), 1, limits::min(), (T)( limits::max() - 1 ) };
+        if( std::is_signed<T>::value )
+            values.insert( values.end(), { (T)-1, (T)( limits::min() + 1 ), (T)-1 } );
+        return values;
+    }
+}
+
+TEST( srl_varint, zigzag )
+{
+    EXPECT_EQ( srl_varint::zigzag_encode( 0 ), 0u );
+    EXPECT_EQ( srl_varint::zigzag_encode( -1 ), 1u );
+    EXPECT_EQ( srl_varint::zigzag_encode( 1 ), 2u );
+    EXPECT_EQ( srl_varint::zigzag_encode( std::numeric_limits<int64_t>::max() ), UINT64_MAX - 1 );
+    EXPECT_EQ( srl_varint::zigzag_encode( std::numeric_limits<int64_t>::min() ), UINT64_MAX );
+
+    const int64_t values[] = { 0, -1, 1, -64, 63, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max() };
+    for( int64_t v : values )
+        EXPECT_EQ( srl_varint::zigzag_decode( srl_varint::zigzag_encode( v ) ), v );
+}
+
+TEST( srl_varint, min_max_values )
+{
+    ExpectVarintRoundTrip( LimitValues<int8_t>() );
+    ExpectVarintRoundTrip( LimitValues<uint8_t>() );
+    ExpectVarintRoundTrip( LimitValues<int16_t>() );
+    ExpectVarintRoundTrip( LimitValues<uint16_t>() );
+    ExpectVarintRoundTrip( LimitValues<int32_t>() );
+    ExpectVarintRoundTrip( LimitValues<uint32_t>() );
+    ExpectVarintRoundTrip( LimitValues<int64_t>() );
+    ExpectVarintRoundTrip( LimitValues<uint64_t>() );
+}
+
+TEST( srl_varint, encoded_size )
+{
+    const uint64_t values[] = { 0, 0x7f, 0x80, 0x3fff, 0x4000, UINT64_MAX };
+    const uint32_t expected_size[] = { 1, 1, 2, 2, 3, srl_varint::MAX_BYTES };
+    for( uint32_t i = 0; i < 6; ++i )
+    {
+        data_buffer_t buff;
+        data_buffer::create( &buff, 16, BXDefaultAllocator() );
+        srl_varint::write( &buff, values + i, 1 );
+        EXPECT_EQ( data_buffer::size( buff ), expected_size[i] );
+    }
+}
+
+TEST( srl_varint, more_values_than_one_chunk )
+{
+    std::vector<int32_t> values( 1000 );
+    for( uint32_t i = 0; i < values.size(); ++i )
+        values[i] = (int32_t)( i * i ) * ( ( i & 1 ) ? -1 : 1 );
+
+    ExpectVarintRoundTrip( values );
+}
+
+TEST( srl_varint, empty_input )
+{
+    ExpectVarintRoundTrip( std::vector<uint32_t>() );
+}
+
+TEST( srl_varint, malformed_input )
+{
+    uint64_t value = 0;
+
+    // continuation bit set on last byte
+    const uint8_t truncated[] = { 0x80, 0x80 };
+    SRLInstance reader = SRLInstance::CreateReader( 0, truncated, sizeof( truncated ), BXDefaultAllocator() );
+    EXPECT_FALSE( srl_varint::read( &value, 1, &reader.data ) );
+    EXPECT_EQ( reader.data.read_offset, 0u );
+
+    // more than 64 bits
+    uint8_t too_long[srl_varint::MAX_BYTES + 1];
+    memset( too_long, 0xff, sizeof( too_long ) );
+    too_long[srl_varint::MAX_BYTES] = 0x01;
+    reader = SRLInstance::CreateReader( 0, too_long, sizeof( too_long ), BXDefaultAllocator() );
+    EXPECT_FALSE( srl_varint::read( &value, 1, &reader.data ) );
+
+    // fewer values than requested
+    const uint8_t two_values[] = { 0x01, 0x02 };
+    uint32_t values[3];
+    reader = SRLInstance::CreateReader( 0, two_values, sizeof( two_values ), BXDefaultAllocator() );
+    EXPECT_FALSE( SerializeVarint( &reader, values, 3 ) );
+
+    reader = SRLInstance::CreateReader( 0, two_values, sizeof( two_values ), BXDefaultAllocator() );
+    EXPECT_FALSE( SerializeDelta( &reader, values, 3 ) );
+}
+
+namespace
+{
+    struct SRLTestTypeV1
+    {
+        static constexpr uint32_t VERSION = BX_UTIL_MAKE_VERSION( 1, 0, 0 );
+        static constexpr uint32_t TAG = BX_UTIL_TAG32( 'S', 'R', 'L', 'T' );
+
+        float a = 1.f;
+        int32_t b = 2;
+        uint16_t arr[4] = { 1, 2, 3, 4 };
+        void* runtime = nullptr;
+
+        SRL_TYPE( SRLTestTypeV1,
+            SRL_PROPERTY( a );
+            SRL_PROPERTY( b );
+            SRL_PROPERTY( arr );
+            SRL_PROPERTY( runtime );
+        );
+    };
+
+    // fields moved, array grown, 'c' added, 'b' changed kind
+    struct SRLTestTypeV2
+    {
+        static constexpr uint32_t VERSION = BX_UTIL_MAKE_VERSION( 2, 0, 0 );
+        static constexpr uint32_t TAG = SRLTestTypeV1::TAG;
+
+        double c = 5.0;
+        uint16_t arr[6] = { 10, 20, 30, 40, 50, 60 };
+        float b = 20.f;
+        float a = 10.f;
+
+        SRL_TYPE( SRLTestTypeV2,
+            SRL_PROPERTY( c );
+            SRL_PROPERTY( arr );
+            SRL_PROPERTY( b );
+            SRL_PROPERTY( a );
+        );
+    };
+}
+SRL_TYPE_DEFINE( SRLTestTypeV1 );
+SRL_TYPE_DEFINE( SRLTestTypeV2 );
+
+TEST( srl_patch, diff_apply_round_trip )
+{
+    SRLTestTypeV1 from;
+    SRLTestTypeV1 to;
+    to.a = 3.f;
+    to.arr[1] = 100;
+    to.arr[2] = 200;
+    to.runtime = &to;
+
+    data_buffer_t patch;
+    data_buffer::create( &patch, 64, BXDefaultAllocator() );
+    EXPECT_EQ( srl_patch::diff( &patch, from, to ), 2u );
+
+    SRLTestTypeV1 result;
+    EXPECT_EQ( srl_patch::apply( &result, (const srl_patch_t*)patch.begin() ), 2u );
+    EXPECT_EQ( result.a, to.a );
+    EXPECT_EQ( result.b, to.b );
+    EXPECT_EQ( memcmp( result.arr, to.arr, sizeof( to.arr ) ), 0 );
+    EXPECT_EQ( result.runtime, nullptr );
+}
+
+TEST( srl_patch, no_changes_writes_nothing )
+{
+    SRLTestTypeV1 from;
+    SRLTestTypeV1 to;
+
+    data_buffer_t patch;
+    data_buffer::create( &patch, 64, BXDefaultAllocator() );
+    EXPECT_EQ( srl_patch::diff( &patch, from, to ), 0u );
+    EXPECT_EQ( data_buffer::size( patch ), 0u );
+}
+
+TEST( srl_patch, apply_to_newer_layout )
+{
+    SRLTestTypeV1 from;
+    SRLTestTypeV1 to;
+    to.a = 3.f;
+    to.b = 7;
+    to.arr[3] = 400;
+
+    data_buffer_t patch;
+    data_buffer::create( &patch, 64, BXDefaultAllocator() );
+    EXPECT_EQ( srl_patch::diff( &patch, from, to ), 3u );
+
+    // entries match by name and element size only, so 'b' is applied too
+    SRLTestTypeV2 result;
+    EXPECT_EQ( srl_patch::apply( &result, (const srl_patch_t*)patch.begin() ), 3u );
+    EXPECT_EQ( result.a, 3.f );
+    EXPECT_EQ( result.c, 5.0 );
+    const uint16_t expected_arr[6] = { 10, 20, 30, 400, 50, 60 };
+    EXPECT_EQ( memcmp( result.arr, expected_arr, sizeof( expected_arr ) ), 0 );
+}
+
+TEST( srl_patch, malformed_patch )
+{
+    SRLTestTypeV1 from;
+    SRLTestTypeV1 to;
+    to.a = 3.f;
+    to.b = 7;
+
+    data_buffer_t patch;
+    data_buffer::create( &patch, 64, BXDefaultAllocator() );
+    ASSERT_EQ( srl_patch::diff( &patch, from, to ), 2u );
+    srl_patch_t* header = (srl_patch_t*)patch.data;
+
+    SRLTestTypeV1 result;
+    const srl_property_t* props = SRLTestTypeV1::__props._array;
+    const uint32_t num_props = SRLTestTypeV1::__props._count;
+
+    // bad tag, also through non template version
+    header->tag = 0;
+    EXPECT_EQ( srl_patch::apply( &result, header ), 0u );
+    EXPECT_EQ( srl_patch::apply( &result, props, num_props, header ), 0u );
+    header->tag = srl_patch_t::TAG;
+
+    // size smaller than header
+    const uint32_t size = header->size;
+    header->size = sizeof( srl_patch_t ) - 1;
+    EXPECT_EQ( srl_patch::apply( &result, props, num_props, header ), 0u );
+
+    // size cuts second entry
+    header->size = size - 1;
+    EXPECT_EQ( srl_patch::apply( &result, props, num_props, header ), 1u );
+    EXPECT_EQ( result.a, to.a );
+    EXPECT_EQ( result.b, from.b );
+}
+
+TEST( srl_file, upgrade_to_newer_layout )
+{
+    SRLTestTypeV1 v1;
+    v1.a = 3.f;
+    v1.b = 7;
+    v1.arr[0] = 100;
+    v1.arr[3] = 400;
+
+    srl_file_t* file = srl_file::serialize( &v1, sizeof( v1 ), BXDefaultAllocator() );
+
+    SRLTestTypeV2 v2;
+    EXPECT_EQ( srl_file::upgrade( &v2, file ), 2u );
+    EXPECT_EQ( v2.a, 3.f );
+    EXPECT_EQ( v2.b, 20.f ); // int32 -> float is different kind
+    EXPECT_EQ( v2.c, 5.0 );
+    const uint16_t expected_arr[6] = { 100, 2, 3, 400, 50, 60 };
+    EXPECT_EQ( memcmp( v2.arr, expected_arr, sizeof( expected_arr ) ), 0 );
+
+    BX_FREE( BXDefaultAllocator(), file );
+}
+
+TEST( srl_file, upgrade_rejects_out_of_bounds )
+{
+    SRLTestTypeV1 v1;
+    v1.a = 3.f;
+    srl_file_t* file = srl_file::serialize( &v1, sizeof( v1 ), BXDefaultAllocator() );
+
+    // property data past the end of file
+    srl_property_t* file_props = const_cast<srl_property_t*>( file->properties() );
+    const uint32_t arr_offset = file_props[2].value_offset;
+    file_props[2].value_offset = sizeof( v1 ) - 2;
+
+    SRLTestTypeV2 v2;
+    EXPECT_EQ( srl_file::upgrade( &v2, file ), 1u );
+    EXPECT_EQ( v2.a, 3.f );
+    EXPECT_EQ( v2.arr[0], 10 );
+
+    file_props[2].value_offset = UINT32_MAX;
+    EXPECT_EQ( srl_file::upgrade( &v2, file ), 1u );
+    file_props[2].value_offset = arr_offset;
+
+    // properties do not fit in file
+    const uint32_t num_properties = file->num_properties;
+    file->num_properties = UINT32_MAX;
+    EXPECT_EQ( srl_file::upgrade( &v2, file ), 0u );
+    file->num_properties = num_properties;
+
+    file->size = srl_file::calc_header_size( num_properties ) - 1;
+    EXPECT_EQ( srl_file::upgrade( &v2, file ), 0u );
+
+    BX_FREE( BXDefaultAllocator(), file );
+}
@@ -0,0 +1,261 @@
+#include <3rd_party/googletest/include/gtest/gtest.h>
+#include <memory/memory.h>
+#include <foundation/io.h>
+#include <foundation/string_util.h>
+#include <filesystem/filesystem_plugin.h>
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( _WIN32 )
+#include <filesystem/filesystem_windows.h>
+#include <direct.h>
+#else
+#include <filesystem/filesystem_posix.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct FilesystemTest : ::testing::Test
+    {
+        static constexpr uint32_t NUM_FILES = 40;
+        static constexpr uint32_t NUM_READERS = 4;
+
+        void SetUp() override
+        {
+#if defined( _WIN32 )
+            ASSERT_NE( nullptr, _fullpath( _root, "unit_test_filesystem_data", sizeof( _root ) - 1 ) );
+            CreateDir( _root );
+            strcat( _root, "/" );
+            _fs = BX_NEW( BXDefaultAllocator(), bx::FilesystemWindows, BXDefaultAllocator() );
+            _fs->Startup();
+#else
+            strcpy( _root, "/tmp/bx_fs_XXXXXX" );
+            ASSERT_NE( nullptr, mkdtemp( _root ) );
+            strcat( _root, "/" );
+            _fs = BX_NEW( BXDefaultAllocator(), bx::FilesystemPosix, BXDefaultAllocator() );
+            _fs->Startup( NUM_READERS );
+#endif
+            _fs->SetRoot( _root );
+        }
+        void TearDown() override
+        {
+            _fs->Shutdown();
+            BX_DELETE0( BXDefaultAllocator(), _fs );
+
+            for( uint32_t i = 0; i < _num_written; ++i )
+            {
+                remove( AbsolutePath( _written[i] ) );
+            }
+#if defined( _WIN32 )
+            _rmdir( _root );
+#else
+            rmdir( _root );
+#endif
+        }
+
+        const char* AbsolutePath( const char* name )
+        {
+            snprintf( _path, sizeof( _path ), "%s%s", _root, name );
+            return _path;
+        }
+        void Write( const char* name, const void* data, uint32_t size )
+        {
+            ASSERT_LT( _num_written, NUM_FILES );
+            ASSERT_EQ( (int32_t)size, WriteFile( AbsolutePath( name ), data, size ) );
+            snprintf( _written[_num_written++], sizeof( _written[0] ), "%s", name );
+        }
+        // derived LoadFile hides overload without callback
+        BXIFilesystem* Fs() { return _fs; }
+
+        static void FileName( char* out, size_t size, uint32_t i )
+        {
+            snprintf( out, size, "file%u.bin", i );
+        }
+
+#if defined( _WIN32 )
+        bx::FilesystemWindows* _fs = nullptr;
+#else
+        bx::FilesystemPosix* _fs = nullptr;
+#endif
+        char _root[256] = {};
+        char _path[512] = {};
+        char _written[NUM_FILES][32] = {};
+        uint32_t _num_written = 0;
+    };
+
+    struct CallbackResult
+    {
+        std::atomic_uint32_t num_calls = 0;
+        std::atomic_int32_t status = BXEFileStatus::EMPTY;
+    };
+    static void FileCallback( BXIFilesystem* fs, BXFileHandle hfile, BXEFileStatus::E status, void* user_data0, void* user_data1, void* user_data2 )
+    {
+        CallbackResult* result = (CallbackResult*)user_data0;
+        result->status = status;
+        result->num_calls.fetch_add( 1 );
+    }
+
+    static BXEFileStatus::E WaitFile( BXFile* file, BXIFilesystem* fs, BXFileHandle hfile )
+    {
+        BXEFileStatus::E status = fs->File( file, hfile );
+        while( status == BXEFileStatus::LOADING )
+        {
+            status = fs->File( file, hfile );
+        }
+        return status;
+    }
+}
+
+TEST_F( FilesystemTest, load_bin )
+{
+    const uint8_t data[] = { 0, 1, 2, 3, 0xFF, 0, 7 };
+    Write( "data.bin", data, sizeof( data ) );
+
+    BXFileHandle hfile = Fs()->LoadFile( "data.bin", BXEFIleMode::BIN );
+    ASSERT_TRUE( IsValid( hfile ) );
+
+    BXFile file;
+    ASSERT_EQ( BXEFileStatus::READY, WaitFile( &file, Fs(), hfile ) );
+    ASSERT_EQ( sizeof( data ), file.size );
+    EXPECT_EQ( 0, memcmp( data, file.bin, sizeof( data ) ) );
+    EXPECT_EQ( BXDefaultAllocator(), file.allocator );
+
+    Fs()->CloseFile( &hfile, true );
+    EXPECT_FALSE( IsValid( hfile ) );
+}
+
+TEST_F( FilesystemTest, load_txt_is_null_terminated )
+{
+    const char text[] = "line0\nline1";
+    const uint32_t text_len = (uint32_t)strlen( text );
+    Write( "data.txt", text, text_len );
+
+    BXFileHandle hfile = Fs()->LoadFile( "data.txt", BXEFIleMode::TXT );
+
+    BXFile file;
+    ASSERT_EQ( BXEFileStatus::READY, WaitFile( &file, Fs(), hfile ) );
+
+    // terminator is included in size
+    ASSERT_EQ( text_len + 1, file.size );
+    EXPECT_EQ( 0, file.txt[text_len] );
+    EXPECT_STREQ( text, file.txt );
+
+    Fs()->CloseFile( &hfile, true );
+}
+
+TEST_F( FilesystemTest, load_empty_txt )
+{
+    Write( "empty.txt", "", 0 );
+
+    BXFileHandle hfile = Fs()->LoadFile( "empty.txt", BXEFIleMode::TXT );
+
+    BXFile file;
+    ASSERT_EQ( BXEFileStatus::READY, WaitFile( &file, Fs(), hfile ) );
+    ASSERT_EQ( 1u, file.size );
+    EXPECT_EQ( 0, file.txt[0] );
+
+    Fs()->CloseFile( &hfile, true );
+}
+
+TEST_F( FilesystemTest, not_found_calls_callback )
+{
+    CallbackResult result;
+    BXFileHandle hfile = Fs()->LoadFile( "missing.bin", BXEFIleMode::BIN, BXPostLoadCallback( FileCallback, &result ) );
+
+    BXFile file;
+    EXPECT_EQ( BXEFileStatus::NOT_FOUND, WaitFile( &file, Fs(), hfile ) );
+
+    // status is set before callback is called
+    while( result.num_calls.load() == 0 )
+    {}
+    EXPECT_EQ( 1u, result.num_calls.load() );
+    EXPECT_EQ( BXEFileStatus::NOT_FOUND, result.status.load() );
+
+    Fs()->CloseFile( &hfile, true );
+}
+
+TEST_F( FilesystemTest, load_many_files )
+{
+    // enough requests to be split into batches between readers
+    uint32_t sizes[NUM_FILES];
+    uint8_t buffer[NUM_FILES + 1];
+    for( uint32_t i = 0; i < NUM_FILES; ++i )
+    {
+        sizes[i] = i + 1;
+        memset( buffer, (int)i, sizes[i] );
+
+        char name[32];
+        FileName( name, sizeof( name ), i );
+        Write( name, buffer, sizes[i] );
+    }
+
+    CallbackResult results[NUM_FILES];
+    BXFileHandle hfiles[NUM_FILES];
+    for( uint32_t i = 0; i < NUM_FILES; ++i )
+    {
+        char name[32];
+        FileName( name, sizeof( name ), i );
+        hfiles[i] = Fs()->LoadFile( name, BXEFIleMode::BIN, BXPostLoadCallback( FileCallback, &results[i] ) );
+    }
+
+    for( uint32_t i = 0; i < NUM_FILES; ++i )
+    {
+        BXFile file;
+        ASSERT_EQ( BXEFileStatus::READY, WaitFile( &file, Fs(), hfiles[i] ) );
+        ASSERT_EQ( sizes[i], file.size );
+
+        bool content_ok = true;
+        for( uint32_t j = 0; j < file.size; ++j )
+            content_ok &= file.bin[j] == (uint8_t)i;
+        EXPECT_TRUE( content_ok ) << "file " << i;
+
+        while( results[i].num_calls.load() == 0 )
+        {}
+        EXPECT_EQ( 1u, results[i].num_calls.load() );
+        EXPECT_EQ( BXEFileStatus::READY, results[i].status.load() );
+
+        Fs()->CloseFile( &hfiles[i], true );
+    }
+}
+
+TEST_F( FilesystemTest, list_files )
+{
+    Write( "a.bin", "a", 1 );
+    Write( "b.txt", "b", 1 );
+
+    BXIFilesystem* fs = (BXIFilesystem*)BXLoad_filesystem( BXDefaultAllocator() );
+    fs->SetRoot( _root );
+
+    string_buffer_t s;
+    string::create( &s, 256, BXDefaultAllocator() );
+    fs->ListFiles( fs, &s, "", BXEFileListFlag::ONLY_NAMES, BXDefaultAllocator() );
+
+    uint32_t num_files = 0;
+    bool found_a = false;
+    bool found_b = false;
+    // entries are type string followed by name, iteration can end with empty string
+    for( string_buffer_it it = string::iterate( s ); !it.null(); it = string::iterate( s, it ) )
+    {
+        if( !string::equal( it.pointer, "F" ) )
+        {
+            EXPECT_STREQ( "", it.pointer );
+            continue;
+        }
+        it = string::iterate( s, it );
+        if( it.null() )
+            break;
+        found_a |= string::equal( it.pointer, "a.bin" );
+        found_b |= string::equal( it.pointer, "b.txt" );
+        ++num_files;
+    }
+    EXPECT_EQ( 2u, num_files );
+    EXPECT_TRUE( found_a );
+    EXPECT_TRUE( found_b );
+
+    string::free( &s );
+    BXUnload_filesystem( fs, BXDefaultAllocator() );
+}
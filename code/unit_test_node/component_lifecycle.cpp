@@ -0,0 +1,227 @@
+#include <3rd_party/googletest/include/gtest/gtest.h>
+#include <memory/memory_plugin.h>
+#include <memory/memory.h>
+#include <foundation/thread/thread_pool.h>
+#include <node/node.h>
+#include <node/node_comp.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // events of all test components in order of calls, parallel batches append under the lock
+    struct EventLog
+    {
+        std::mutex lock;
+        std::vector<std::string> events;
+
+        void Add( const char* type, const char* what )
+        {
+            std::lock_guard<std::mutex> guard( lock );
+            events.push_back( std::string( type ) + "." + what );
+        }
+        size_t Count( const std::string& event )
+        {
+            std::lock_guard<std::mutex> guard( lock );
+            return std::count( events.begin(), events.end(), event );
+        }
+        size_t Find( const std::string& event )
+        {
+            std::lock_guard<std::mutex> guard( lock );
+            return std::find( events.begin(), events.end(), event ) - events.begin();
+        }
+    };
+    EventLog g_log;
+    std::vector<u32> g_batch_sizes;
+
+    // test component types register in static constructors below, before main starts memory system
+    const bool g_memory_started = ( BXMemoryStartUp(), true );
+}
+
+// handles whole type in batch hooks
+struct TestBatchComp : NODEComp
+{
+    NODE_COMP_DECLARE();
+    ~TestBatchComp() { g_log.Add( "batch", "destroy" ); }
+
+    void OnInitialize  ( NODE* node, NODEInitContext* ctx, NODEFlags* flags ) override { g_log.Add( "batch", "initialize" ); }
+    void OnUninitialize( NODE* node, NODEInitContext* ctx ) override { g_log.Add( "batch", "uninitialize" ); }
+    bool OnAttach      ( NODE* node, NODEAttachContext* ctx ) override { g_log.Add( "batch", "attach" ); return true; }
+    void OnDetach      ( NODE* node, NODEAttachContext* ctx ) override { g_log.Add( "batch", "detach" ); }
+
+    bool OnInitializeBatch( NODECompBatch batch, NODEInitContext* ctx ) override
+    {
+        g_batch_sizes.push_back( batch.size );
+        g_log.Add( "batch", "initialize_batch" );
+        return true;
+    }
+    bool OnUninitializeBatch( NODECompBatch batch, NODEInitContext* ctx ) override { g_log.Add( "batch", "uninitialize_batch" ); return true; }
+    bool OnAttachBatch      ( NODECompBatch batch, NODEAttachContext* ctx ) override { g_log.Add( "batch", "attach_batch" ); return true; }
+    bool OnDetachBatch      ( NODECompBatch batch, NODEAttachContext* ctx ) override { g_log.Add( "batch", "detach_batch" ); return true; }
+};
+NODE_COMP_DEFINE( TestBatchComp );
+
+// no batch hooks, every component is processed separately
+struct TestSerialComp : NODEComp
+{
+    NODE_COMP_DECLARE();
+    ~TestSerialComp() { g_log.Add( "serial", "destroy" ); }
+
+    void OnInitialize  ( NODE* node, NODEInitContext* ctx, NODEFlags* flags ) override { g_log.Add( "serial", "initialize" ); }
+    void OnUninitialize( NODE* node, NODEInitContext* ctx ) override { g_log.Add( "serial", "uninitialize" ); }
+    bool OnAttach      ( NODE* node, NODEAttachContext* ctx ) override { g_log.Add( "serial", "attach" ); return true; }
+    void OnDetach      ( NODE* node, NODEAttachContext* ctx ) override { g_log.Add( "serial", "detach" ); }
+};
+NODE_COMP_DEFINE( TestSerialComp );
+
+// thread safe types running per component hooks, each one sets different bit of node flags
+struct TestTickFlagComp : NODEComp
+{
+    NODE_COMP_DECLARE();
+    void OnInitialize( NODE* node, NODEInitContext* ctx, NODEFlags* flags ) override { flags->offline.tick = 1; g_log.Add( "tick_flag", "initialize" ); }
+    bool IsThreadSafe() const override { return true; }
+};
+NODE_COMP_DEFINE( TestTickFlagComp );
+
+struct TestReadOnlyFlagComp : NODEComp
+{
+    NODE_COMP_DECLARE();
+    void OnInitialize( NODE* node, NODEInitContext* ctx, NODEFlags* flags ) override { flags->offline.read_only = 1; g_log.Add( "read_only_flag", "initialize" ); }
+    bool IsThreadSafe() const override { return true; }
+};
+NODE_COMP_DEFINE( TestReadOnlyFlagComp );
+
+class NODECompLifecycle : public ::testing::TestWithParam<bool> // with thread pool
+{
+protected:
+    void SetUp() override
+    {
+        g_log.events.clear();
+        g_batch_sizes.clear();
+
+        BXIAllocator* allocator = BXDefaultAllocator();
+        NODEContainer::StartUp( &_container, allocator );
+        if( GetParam() )
+            _pool = thread_pool::create( allocator, 4 );
+
+        _ctx.fsys = nullptr;
+        _ctx.gfx = nullptr;
+        _ctx.pool = _pool;
+    }
+
+    void TearDown() override
+    {
+        NODEInitContext init_ctx;
+        InitContext( &init_ctx, &_ctx );
+        NODEContainer::ShutDown( &_container, &init_ctx );
+        thread_pool::destroy( &_pool );
+    }
+
+    NODEContainer* _container = nullptr;
+    thread_pool_t* _pool = nullptr;
+    NODESystemContext _ctx;
+};
+
+TEST_P( NODECompLifecycle, batch_hook_called_once_per_type )
+{
+    static constexpr u32 N = 8;
+    for( u32 i = 0; i < N; ++i )
+    {
+        NODE* node = _container->CreateNode( "node" );
+        _container->CreateComponent<TestBatchComp>( node );
+        _container->CreateComponent<TestSerialComp>( node );
+    }
+    _container->Tick( &_ctx, 0.f );
+
+    ASSERT_EQ( g_batch_sizes.size(), 1u );
+    EXPECT_EQ( g_batch_sizes[0], N );
+    EXPECT_EQ( g_log.Count( "batch.initialize_batch" ), 1u );
+    EXPECT_EQ( g_log.Count( "batch.attach_batch" ), 1u );
+    EXPECT_EQ( g_log.Count( "batch.initialize" ), 0u );
+    EXPECT_EQ( g_log.Count( "batch.attach" ), 0u );
+
+    // type without batch hooks falls back to per component calls
+    EXPECT_EQ( g_log.Count( "serial.initialize" ), N );
+    EXPECT_EQ( g_log.Count( "serial.attach" ), N );
+
+    // second tick has nothing pending
+    g_log.events.clear();
+    _container->Tick( &_ctx, 0.f );
+    EXPECT_TRUE( g_log.events.empty() );
+}
+
+TEST_P( NODECompLifecycle, initialize_before_attach )
+{
+    NODE* node = _container->CreateNode( "node" );
+    _container->CreateComponent<TestSerialComp>( node );
+    _container->Tick( &_ctx, 0.f );
+
+    ASSERT_EQ( g_log.events.size(), 2u );
+    EXPECT_EQ( g_log.events[0], "serial.initialize" );
+    EXPECT_EQ( g_log.events[1], "serial.attach" );
+}
+
+TEST_P( NODECompLifecycle, destroy_detaches_before_uninitialize )
+{
+    NODE* node = _container->CreateNode( "node" );
+    NODEComp* serial = _container->CreateComponent<TestSerialComp>( node );
+    NODEComp* batch = _container->CreateComponent<TestBatchComp>( node );
+    _container->Tick( &_ctx, 0.f );
+    ASSERT_EQ( node->Components().size(), 2u );
+
+    g_log.events.clear();
+    _container->DestroyComponent( &serial );
+    _container->DestroyComponent( &batch );
+    EXPECT_EQ( serial, nullptr );
+    _container->Tick( &_ctx, 0.f );
+
+    EXPECT_LT( g_log.Find( "serial.detach" ), g_log.Find( "serial.uninitialize" ) );
+    EXPECT_LT( g_log.Find( "serial.uninitialize" ), g_log.Find( "serial.destroy" ) );
+    EXPECT_LT( g_log.Find( "batch.detach_batch" ), g_log.Find( "batch.uninitialize_batch" ) );
+    EXPECT_LT( g_log.Find( "batch.uninitialize_batch" ), g_log.Find( "batch.destroy" ) );
+    EXPECT_EQ( g_log.events.size(), 6u );
+
+    // hooks are not repeated when component is already gone
+    EXPECT_EQ( g_log.Count( "serial.detach" ), 1u );
+    EXPECT_EQ( g_log.Count( "serial.uninitialize" ), 1u );
+    EXPECT_EQ( node->Components().size(), 0u );
+}
+
+TEST_P( NODECompLifecycle, destroy_before_initialize_skips_hooks )
+{
+    NODE* node = _container->CreateNode( "node" );
+    NODEComp* serial = _container->CreateComponent<TestSerialComp>( node );
+    _container->DestroyComponent( &serial );
+    _container->Tick( &_ctx, 0.f );
+
+    ASSERT_EQ( g_log.events.size(), 1u );
+    EXPECT_EQ( g_log.events[0], "serial.destroy" );
+}
+
+TEST_P( NODECompLifecycle, thread_safe_types_merge_node_flags )
+{
+    static constexpr u32 N = 64;
+    std::vector<NODE*> nodes;
+    for( u32 i = 0; i < N; ++i )
+    {
+        NODE* node = _container->CreateNode( "node" );
+        _container->CreateComponent<TestTickFlagComp>( node );
+        _container->CreateComponent<TestReadOnlyFlagComp>( node );
+        nodes.push_back( node );
+    }
+    _container->Tick( &_ctx, 0.f );
+
+    EXPECT_EQ( g_log.Count( "tick_flag.initialize" ), N );
+    EXPECT_EQ( g_log.Count( "read_only_flag.initialize" ), N );
+    for( NODE* node : nodes )
+    {
+        const NODEFlags& flags = node->Flags();
+        EXPECT_EQ( flags.offline.tick, 1 );
+        EXPECT_EQ( flags.offline.read_only, 1 );
+    }
+}
+
+INSTANTIATE_TEST_CASE_P( node, NODECompLifecycle, ::testing::Bool() );
@@ -0,0 +1,111 @@
+#include <3rd_party/googletest/include/gtest/gtest.h>
+#include <memory/memory.h>
+#include <rdi_backend/rdi_backend.h>
+#include <rdi_backend/rdi_backend_null.h>
+
+#include <string.h>
+
+namespace
+{
+    struct NullBackendTest : ::testing::Test
+    {
+        void SetUp() override
+        {
+            _live_objects = NullNumLiveObjects();
+            Startup( &_dev, &_cmdq, 0, 64, 32, 0, BXDefaultAllocator() );
+            ASSERT_NE( nullptr, _dev );
+            ASSERT_NE( nullptr, _cmdq );
+        }
+        void TearDown() override
+        {
+            Shutdown( &_dev, &_cmdq, BXDefaultAllocator() );
+            EXPECT_EQ( _live_objects, NullNumLiveObjects() );
+        }
+
+        RDIDevice* _dev = nullptr;
+        RDICommandQueue* _cmdq = nullptr;
+        uint32_t _live_objects = 0;
+    };
+}
+
+TEST_F( NullBackendTest, startup )
+{
+    EXPECT_EQ( _cmdq, GetImmediateCommandQueue( _dev ) );
+
+    const RDITextureRW back_buffer = GetBackBufferTexture( _cmdq );
+    EXPECT_NE( nullptr, back_buffer.viewRT );
+    EXPECT_EQ( 64, back_buffer.info.width );
+    EXPECT_EQ( 32, back_buffer.info.height );
+}
+
+TEST_F( NullBackendTest, clear_and_draw )
+{
+    const float positions[] = { 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f };
+    const uint16_t indices[] = { 0, 1, 2 };
+    RDIVertexBuffer vbuffer = CreateVertexBuffer( _dev, RDIVertexBufferDesc::POS(), 3, positions );
+    RDIIndexBuffer ibuffer = CreateIndexBuffer( _dev, RDIEType::USHORT, 3, indices );
+
+    RDITextureRW color = CreateTexture2D( _dev, 16, 16, 1, RDIFormat::Float4(), RDIEBind::RENDER_TARGET, 0, nullptr );
+    RDITextureDepth depth = CreateTexture2Ddepth( _dev, 16, 16, 1, RDIEType::DEPTH32F );
+
+    ChangeRenderTargets( _cmdq, &color, 1, depth );
+    const float rgbad[5] = { 0.f, 0.f, 0.f, 1.f, 1.f };
+    ClearBuffers( _cmdq, &color, 1, depth, rgbad, 1, 1 );
+
+    SetVertexBuffers( _cmdq, &vbuffer, 0, 1 );
+    SetIndexBuffer( _cmdq, ibuffer );
+    SetTopology( _cmdq, RDIETopology::TRIANGLES );
+    Draw( _cmdq, 3, 0 );
+    DrawIndexedInstanced( _cmdq, 3, 0, 4, 0 );
+
+    {
+        const RDINullCounters& counters = NullFrameCounters( _cmdq );
+        EXPECT_EQ( 2u, counters.NumDrawCalls() );
+        EXPECT_EQ( 1u, counters.commands[RDIENullCmd::CLEAR_BUFFERS] );
+        EXPECT_EQ( 1u, counters.commands[RDIENullCmd::SET_TOPOLOGY] );
+        EXPECT_EQ( 3u + 3u * 4u, counters.vertices );
+        EXPECT_NE( 0u, NullFrameTrace( _cmdq ).size );
+    }
+
+    Swap( _cmdq );
+    EXPECT_EQ( 0u, NullFrameCounters( _cmdq ).NumDrawCalls() );
+    EXPECT_EQ( 2u, NullLastCounters( _cmdq ).NumDrawCalls() );
+
+    // replayed frame records the same work again
+    NullReplayTrace( _cmdq, NullLastTrace( _cmdq ) );
+    {
+        const RDINullCounters& replayed = NullFrameCounters( _cmdq );
+        const RDINullCounters& recorded = NullLastCounters( _cmdq );
+        EXPECT_EQ( recorded.NumDrawCalls(), replayed.NumDrawCalls() );
+        EXPECT_EQ( recorded.vertices, replayed.vertices );
+        EXPECT_EQ( recorded.commands[RDIENullCmd::CLEAR_BUFFERS], replayed.commands[RDIENullCmd::CLEAR_BUFFERS] );
+    }
+
+    Destroy( &depth );
+    Destroy( &color );
+    Destroy( &ibuffer );
+    Destroy( &vbuffer );
+}
+
+TEST_F( NullBackendTest, map_returns_buffer_memory )
+{
+    const float positions[] = { 1.f, 2.f, 3.f };
+    RDIVertexBuffer vbuffer = CreateVertexBuffer( _dev, RDIVertexBufferDesc::POS().CPUWrite(), 1, positions );
+
+    unsigned char* mapped = Map( _cmdq, vbuffer, RDIEMapType::WRITE );
+    ASSERT_NE( nullptr, mapped );
+    EXPECT_EQ( 0, memcmp( mapped, positions, sizeof( positions ) ) );
+    Unmap( _cmdq, vbuffer );
+
+    Destroy( &vbuffer );
+}
+
+TEST_F( NullBackendTest, hdr_header_without_terminator )
+{
+    const char header[] = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y 8 +X 16";
+    // blob ends right after the width, no null terminator inside the size
+    RDITextureRO tex = CreateTextureFromHDR( _dev, header, sizeof( header ) - 1 );
+    EXPECT_EQ( 16, tex.info.width );
+    EXPECT_EQ( 8, tex.info.height );
+    Destroy( &tex );
+}
@@ -0,0 +1,259 @@
+#include <3rd_party/googletest/include/gtest/gtest.h>
+#include <memory/memory.h>
+#include <foundation/io.h>
+#include <filesystem/filesystem_plugin.h>
+#include <resource_manager/resource_manager.h>
+#include <resource_manager/resource_loader.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( _WIN32 )
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+// default loader keeps file data, so resource size is file size
+struct TestLoaderA : RSMLoader
+{
+    RSM_DEFINE_LOADER( TestLoaderA );
+    const char* SupportedType() const override { return "tsa"; }
+    bool IsBinary() const override { return true; }
+};
+struct TestLoaderB : RSMLoader
+{
+    RSM_DEFINE_LOADER( TestLoaderB );
+    const char* SupportedType() const override { return "tsb"; }
+    bool IsBinary() const override { return true; }
+};
+
+namespace
+{
+    struct ResourceCacheTest : ::testing::Test
+    {
+        static constexpr uint32_t MAX_FILES = 8;
+        static constexpr uint32_t FILE_SIZE = 100;
+
+        void SetUp() override
+        {
+#if defined( _WIN32 )
+            ASSERT_NE( nullptr, _fullpath( _root, "unit_test_resource_manager_data", sizeof( _root ) - 1 ) );
+            CreateDir( _root );
+            strcat( _root, "/" );
+#else
+            strcpy( _root, "/tmp/bx_rsm_XXXXXX" );
+            ASSERT_NE( nullptr, mkdtemp( _root ) );
+            strcat( _root, "/" );
+#endif
+            _fs = (BXIFilesystem*)BXLoad_filesystem( BXDefaultAllocator() );
+            _fs->SetRoot( _root );
+
+            RSM::StartUp( _fs, BXDefaultAllocator() );
+            RSM::RegisterLoader<TestLoaderA>();
+            RSM::RegisterLoader<TestLoaderB>();
+        }
+        void TearDown() override
+        {
+            RSM::ShutDown();
+            BXUnload_filesystem( _fs, BXDefaultAllocator() );
+
+            for( uint32_t i = 0; i < _num_written; ++i )
+            {
+                remove( AbsolutePath( _written[i] ) );
+            }
+#if defined( _WIN32 )
+            _rmdir( _root );
+#else
+            rmdir( _root );
+#endif
+        }
+
+        const char* AbsolutePath( const char* name )
+        {
+            snprintf( _path, sizeof( _path ), "%s%s", _root, name );
+            return _path;
+        }
+        // file is filled with its first letter
+        void Write( const char* name )
+        {
+            ASSERT_LT( _num_written, MAX_FILES );
+
+            uint8_t data[FILE_SIZE];
+            memset( data, name[0], FILE_SIZE );
+            ASSERT_EQ( (int32_t)FILE_SIZE, WriteFile( AbsolutePath( name ), data, FILE_SIZE ) );
+            snprintf( _written[_num_written++], sizeof( _written[0] ), "%s", name );
+        }
+        RSMResourceID LoadReady( const char* name )
+        {
+            const RSMResourceID id = RSM::Load( name );
+            EXPECT_EQ( RSMEState::READY, RSM::Wait( id ) ) << name;
+            return id;
+        }
+        uint64_t TypeBytes( uint32_t loader_index )
+        {
+            RSMTypeStats stats[2];
+            EXPECT_EQ( 2u, RSM::TypeStats( stats, 2 ) );
+            return stats[loader_index].resident_bytes;
+        }
+
+        BXIFilesystem* _fs = nullptr;
+        char _root[256] = {};
+        char _path[512] = {};
+        char _written[MAX_FILES][32] = {};
+        uint32_t _num_written = 0;
+    };
+}
+
+TEST_F( ResourceCacheTest, release_without_cache )
+{
+    Write( "a.tsa" );
+
+    const RSMResourceID id = LoadReady( "a.tsa" );
+    EXPECT_EQ( FILE_SIZE, RSM::ResidencyStats().resident_bytes );
+
+    EXPECT_TRUE( RSM::Release( id ) );
+    EXPECT_FALSE( RSM::IsAlive( id ) );
+    EXPECT_EQ( 0u, RSM::ResidencyStats().resident_bytes );
+}
+
+TEST_F( ResourceCacheTest, release_returns_false_when_cached )
+{
+    Write( "a.tsa" );
+    RSM::SetBudget( 0, 1000 );
+
+    const RSMResourceID id = LoadReady( "a.tsa" );
+    EXPECT_FALSE( RSM::Release( id ) );
+
+    // still owned by RSM
+    EXPECT_TRUE( RSM::IsAlive( id ) );
+    EXPECT_NE( nullptr, RSM::Get( id ) );
+
+    const RSMResidencyStats stats = RSM::ResidencyStats();
+    EXPECT_EQ( 1u, stats.num_cached );
+    EXPECT_EQ( FILE_SIZE, stats.cached_bytes );
+    EXPECT_EQ( FILE_SIZE, stats.resident_bytes );
+
+    // disabling cache evicts everything
+    RSM::SetBudget( 0, 0 );
+    EXPECT_FALSE( RSM::IsAlive( id ) );
+    EXPECT_EQ( 0u, RSM::ResidencyStats().num_cached );
+    EXPECT_EQ( 0u, RSM::ResidencyStats().resident_bytes );
+}
+
+TEST_F( ResourceCacheTest, cache_hit_on_reload )
+{
+    Write( "a.tsa" );
+    RSM::SetBudget( 0, 1000 );
+
+    const RSMResourceID id = LoadReady( "a.tsa" );
+    EXPECT_FALSE( RSM::Release( id ) );
+
+    // loading it again must not touch the disk
+    remove( AbsolutePath( "a.tsa" ) );
+
+    const RSMResourceID id2 = RSM::Load( "a.tsa" );
+    EXPECT_EQ( id.i, id2.i );
+    EXPECT_EQ( RSMEState::READY, RSM::State( id2 ) );
+
+    const uint8_t* data = (const uint8_t*)RSM::Get( id2 );
+    ASSERT_NE( nullptr, data );
+    EXPECT_EQ( 'a', data[0] );
+    EXPECT_EQ( 'a', data[FILE_SIZE - 1] );
+
+    const RSMResidencyStats stats = RSM::ResidencyStats();
+    EXPECT_EQ( 1u, stats.cache_hits );
+    EXPECT_EQ( 0u, stats.num_cached );
+    EXPECT_EQ( 0u, stats.cached_bytes );
+
+    EXPECT_FALSE( RSM::Release( id2 ) );
+}
+
+TEST_F( ResourceCacheTest, eviction_order )
+{
+    Write( "a.tsa" );
+    Write( "b.tsa" );
+    Write( "c.tsa" );
+    Write( "d.tsa" );
+
+    // room for two cached resources
+    RSM::SetBudget( 0, 2 * FILE_SIZE + FILE_SIZE / 2 );
+
+    const RSMResourceID a = LoadReady( "a.tsa" );
+    const RSMResourceID b = LoadReady( "b.tsa" );
+    const RSMResourceID c = LoadReady( "c.tsa" );
+    RSM::Release( a );
+    RSM::Release( b );
+    RSM::Release( c );
+
+    // least recently released goes first
+    EXPECT_FALSE( RSM::IsAlive( a ) );
+    EXPECT_TRUE( RSM::IsAlive( b ) );
+    EXPECT_TRUE( RSM::IsAlive( c ) );
+
+    // hit makes 'b' most recent again, so 'c' goes next
+    EXPECT_EQ( b.i, RSM::Load( "b.tsa" ).i );
+    RSM::Release( b );
+
+    const RSMResourceID d = LoadReady( "d.tsa" );
+    RSM::Release( d );
+
+    EXPECT_FALSE( RSM::IsAlive( c ) );
+    EXPECT_TRUE( RSM::IsAlive( b ) );
+    EXPECT_TRUE( RSM::IsAlive( d ) );
+
+    const RSMResidencyStats stats = RSM::ResidencyStats();
+    EXPECT_EQ( 2u, stats.evictions );
+    EXPECT_EQ( 2u, stats.num_cached );
+    EXPECT_EQ( 2 * FILE_SIZE, stats.cached_bytes );
+}
+
+TEST_F( ResourceCacheTest, type_budget )
+{
+    Write( "a.tsa" );
+    Write( "b.tsa" );
+    Write( "u.tsb" );
+
+    RSM::SetBudget( 0, 1000 );
+    RSM::SetTypeBudget( "tsa", FILE_SIZE + FILE_SIZE / 2 );
+
+    const RSMResourceID u = LoadReady( "u.tsb" );
+    const RSMResourceID a = LoadReady( "a.tsa" );
+    RSM::Release( u );
+    RSM::Release( a );
+
+    // only cached resource of the same type makes room
+    const RSMResourceID b = LoadReady( "b.tsa" );
+    EXPECT_FALSE( RSM::IsAlive( a ) );
+    EXPECT_TRUE( RSM::IsAlive( u ) );
+
+    EXPECT_EQ( FILE_SIZE, TypeBytes( 0 ) );
+    EXPECT_EQ( FILE_SIZE, TypeBytes( 1 ) );
+
+    EXPECT_FALSE( RSM::Release( b ) );
+}
+
+TEST_F( ResourceCacheTest, load_over_budget_fails )
+{
+    Write( "a.tsa" );
+    Write( "b.tsa" );
+    Write( "c.tsa" );
+
+    RSM::SetBudget( FILE_SIZE + FILE_SIZE / 2, FILE_SIZE );
+
+    // cached resource is evicted to make room
+    const RSMResourceID a = LoadReady( "a.tsa" );
+    RSM::Release( a );
+    const RSMResourceID b = LoadReady( "b.tsa" );
+    EXPECT_FALSE( RSM::IsAlive( a ) );
+
+    // 'b' is in use and can't be evicted
+    const RSMResourceID c = RSM::Load( "c.tsa" );
+    EXPECT_EQ( RSMEState::FAIL, RSM::Wait( c ) );
+    EXPECT_EQ( nullptr, RSM::Get( c ) );
+    EXPECT_EQ( FILE_SIZE, RSM::ResidencyStats().resident_bytes );
+    EXPECT_TRUE( RSM::Release( c ) );
+
+    RSM::Release( b );
+}
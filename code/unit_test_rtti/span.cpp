@@ -0,0 +1,165 @@
+#include <3rd_party/googletest/include/gtest/gtest.h>
+#include <rtti/rtti.h>
+#include <foundation/string_util.h>
+#include <memory/memory.h>
+
+#include <string.h>
+#include <vector>
+
+struct SpanTestV1
+{
+    RTTI_DECLARE_TYPE( SpanTestV1 );
+    float a = 0.f;
+    int32_t b = 0;
+    string_t name;
+};
+RTTI_DEFINE_TYPE( SpanTestV1, {
+    RTTI_ATTR( SpanTestV1, a, "a" ),
+    RTTI_ATTR( SpanTestV1, b, "b" ),
+    RTTI_ATTR( SpanTestV1, name, "name" ),
+} );
+
+// same attributes in different order plus new one, read through remap by name
+struct SpanTestV2
+{
+    RTTI_DECLARE_TYPE( SpanTestV2 );
+    string_t name;
+    double extra = -1.0;
+    int32_t b = 0;
+    float a = 0.f;
+};
+RTTI_DEFINE_TYPE( SpanTestV2, {
+    RTTI_ATTR( SpanTestV2, name, "name" ),
+    RTTI_ATTR( SpanTestV2, extra, "extra" ),
+    RTTI_ATTR( SpanTestV2, b, "b" ),
+    RTTI_ATTR( SpanTestV2, a, "a" ),
+} );
+
+namespace
+{
+    static constexpr uint32_t NUM_OBJECTS = 3;
+    static const char* NAMES[NUM_OBJECTS] = { "", "hello", "name longer than static storage" };
+
+    struct RTTISpanTest : ::testing::Test
+    {
+        void SetUp() override
+        {
+            for( uint32_t i = 0; i < NUM_OBJECTS; ++i )
+            {
+                input[i].a = i * 1.5f;
+                input[i].b = -(int32_t)i;
+                string::create( &input[i].name, NAMES[i], BXDefaultAllocator() );
+            }
+
+            buffer.resize( 1024 );
+            size = RTTI::SerializeSpan( buffer.data(), (uint32_t)buffer.size(), input, NUM_OBJECTS );
+            ASSERT_NE( UINT32_MAX, size );
+            buffer.resize( size );
+        }
+        void TearDown() override
+        {
+            for( SpanTestV1& obj : input )
+                string::free( &obj.name );
+        }
+
+        // offset of string bytes in buffer, strings are stored with size prefix right after their record
+        size_t FindString( const char* str ) const
+        {
+            const size_t len = strlen( str ) + 1;
+            for( size_t i = 0; i + len <= buffer.size(); ++i )
+            {
+                if( memcmp( buffer.data() + i, str, len ) == 0 )
+                    return i;
+            }
+            return SIZE_MAX;
+        }
+
+        SpanTestV1 input[NUM_OBJECTS];
+        std::vector<uint8_t> buffer;
+        uint32_t size = 0;
+    };
+}
+
+TEST_F( RTTISpanTest, round_trip )
+{
+    SpanTestV1 output[NUM_OBJECTS];
+    EXPECT_EQ( NUM_OBJECTS, RTTI::UnserializeSpan( output, NUM_OBJECTS, buffer.data(), size, BXDefaultAllocator() ) );
+    for( uint32_t i = 0; i < NUM_OBJECTS; ++i )
+    {
+        EXPECT_EQ( input[i].a, output[i].a );
+        EXPECT_EQ( input[i].b, output[i].b );
+        EXPECT_STREQ( NAMES[i], output[i].name.c_str() );
+        string::free( &output[i].name );
+    }
+}
+
+TEST_F( RTTISpanTest, round_trip_less_objects_than_stored )
+{
+    SpanTestV1 output[1];
+    EXPECT_EQ( 1u, RTTI::UnserializeSpan( output, 1, buffer.data(), size, BXDefaultAllocator() ) );
+    EXPECT_EQ( input[0].b, output[0].b );
+    string::free( &output[0].name );
+}
+
+TEST_F( RTTISpanTest, remap_by_name )
+{
+    SpanTestV2 output[NUM_OBJECTS];
+    EXPECT_NE( RTTI::SchemaHash<SpanTestV1>(), RTTI::SchemaHash<SpanTestV2>() );
+    EXPECT_EQ( NUM_OBJECTS, RTTI::UnserializeSpan( output, NUM_OBJECTS, buffer.data(), size, BXDefaultAllocator() ) );
+    for( uint32_t i = 0; i < NUM_OBJECTS; ++i )
+    {
+        EXPECT_EQ( input[i].a, output[i].a );
+        EXPECT_EQ( input[i].b, output[i].b );
+        EXPECT_EQ( -1.0, output[i].extra );
+        EXPECT_STREQ( NAMES[i], output[i].name.c_str() );
+        string::free( &output[i].name );
+    }
+}
+
+TEST_F( RTTISpanTest, buffer_too_small_for_serialize )
+{
+    std::vector<uint8_t> small( size - 1 );
+    EXPECT_EQ( UINT32_MAX, RTTI::SerializeSpan( small.data(), (uint32_t)small.size(), input, NUM_OBJECTS ) );
+}
+
+TEST_F( RTTISpanTest, truncated_buffer )
+{
+    SpanTestV1 output[NUM_OBJECTS];
+    EXPECT_EQ( 0u, RTTI::UnserializeSpan( output, NUM_OBJECTS, buffer.data(), size - 1, BXDefaultAllocator() ) );
+    EXPECT_EQ( 0u, RTTI::UnserializeSpan( output, NUM_OBJECTS, buffer.data(), 4, BXDefaultAllocator() ) );
+    EXPECT_EQ( 0u, RTTI::UnserializeSpan( output, NUM_OBJECTS, buffer.data(), 0, BXDefaultAllocator() ) );
+}
+
+TEST_F( RTTISpanTest, missing_terminator )
+{
+    const size_t offset = FindString( NAMES[1] );
+    ASSERT_NE( SIZE_MAX, offset );
+    buffer[offset + strlen( NAMES[1] )] = 'x';
+
+    // objects before broken string are read, reading stops at broken one
+    SpanTestV1 output[NUM_OBJECTS];
+    EXPECT_EQ( 1u, RTTI::UnserializeSpan( output, NUM_OBJECTS, buffer.data(), size, BXDefaultAllocator() ) );
+    EXPECT_EQ( input[0].b, output[0].b );
+
+    SpanTestV2 output_v2[NUM_OBJECTS];
+    EXPECT_EQ( 1u, RTTI::UnserializeSpan( output_v2, NUM_OBJECTS, buffer.data(), size, BXDefaultAllocator() ) );
+
+    for( uint32_t i = 0; i < NUM_OBJECTS; ++i )
+    {
+        string::free( &output[i].name );
+        string::free( &output_v2[i].name );
+    }
+}
+
+TEST_F( RTTISpanTest, string_size_past_end )
+{
+    const size_t offset = FindString( NAMES[1] );
+    ASSERT_NE( SIZE_MAX, offset );
+    const uint32_t huge_size = 0xFFFFFFF0u;
+    memcpy( buffer.data() + offset - sizeof( uint32_t ), &huge_size, sizeof( uint32_t ) );
+
+    SpanTestV1 output[NUM_OBJECTS];
+    EXPECT_EQ( 1u, RTTI::UnserializeSpan( output, NUM_OBJECTS, buffer.data(), size, BXDefaultAllocator() ) );
+    for( SpanTestV1& obj : output )
+        string::free( &obj.name );
+}
@@ -27,369 +27,500 @@
 
 #include "aabbtree.h"
 
+#include <foundation/thread/thread_pool.h>
+
 #include <assert.h>
 #include <algorithm>
-#include <iostream>
+#include <xmmintrin.h>
 
 using namespace std;
 
-AABBTree::AABBTree( array_span_t<const Vec3> vertices, array_span_t<const u16> indices, uint32_t numFaces )
+AABBTree::AABBTree( array_span_t<const Vec3> vertices, array_span_t<const u32> indices, uint32_t numFaces, thread_pool_t* pool )
     : m_vertices(vertices)
-    , m_indices(indices)
+    , m_indices(indices.begin())
     , m_numFaces(numFaces)
 {
+    assert(indices.size() >= numFaces*3);
+
     // build stats
     m_treeDepth = 0;
     m_innerNodes = 0;
     m_leafNodes = 0;
 
-    Build();
+    Build(pool);
 }
 
-namespace
+AABBTree::AABBTree( array_span_t<const Vec3> vertices, array_span_t<const u16> indices, uint32_t numFaces, thread_pool_t* pool )
+    : m_vertices(vertices)
+    , m_indices(nullptr)
+    , m_numFaces(numFaces)
 {
+    assert(indices.size() >= numFaces*3);
 
-	struct FaceSorter
-	{
-		FaceSorter(const Vec3* positions, const uint16_t* indices, uint32_t n, uint32_t axis) 
-			: m_vertices(positions)
-			, m_indices(indices)
-			, m_numIndices(n)
-			, m_axis(axis)
-		{        
-		}
-
-		inline bool operator()(uint32_t lhs, uint32_t rhs) const
-		{
-			float a = GetCentroid(lhs);
-			float b = GetCentroid(rhs);
-
-			if (a == b)
-				return lhs < rhs;
-			else
-				return a < b;
-		}
-
-		inline float GetCentroid(uint32_t face) const
-		{
-			const Vec3& a = m_vertices[m_indices[face*3+0]];
-			const Vec3& b = m_vertices[m_indices[face*3+1]];
-			const Vec3& c = m_vertices[m_indices[face*3+2]];
-
-			return (a[m_axis] + b[m_axis] + c[m_axis])/3.0f;
-		}
-
-		const Vec3* m_vertices;
-		const uint16_t* m_indices;
-		uint32_t m_numIndices;
-		uint32_t m_axis;
-	};
-	
-	inline uint32_t LongestAxis(const Vector3& v)
-	{    
-		if (v.x > v.y && v.x > v.z)
-			return 0;
-		else
-			return (v.y > v.z) ? 1 : 2;
-	}
+    m_indices32.assign(indices.begin(), indices.begin() + numFaces*3);
+    m_indices = m_indices32.data();
 
-} // anonymous namespace
+    // build stats
+    m_treeDepth = 0;
+    m_innerNodes = 0;
+    m_leafNodes = 0;
+
+    Build(pool);
+}
 
-void AABBTree::CalculateFaceBounds( const uint16_t* faces, uint32_t numFaces, Vector3& outMinExtents, Vector3& outMaxExtents)
+namespace
 {
-    Vector3 minExtents(FLT_MAX);
-    Vector3 maxExtents(-FLT_MAX);
+    static const uint32_t kNumBins = 16;
 
-    // calculate face bounds
-    for (uint32_t i=0; i < numFaces; ++i)
+    // subtrees smaller than this are not split further on the calling thread
+    static const uint32_t kMinSubtreeFaces = 1024*4;
+
+    // cost of traversal step relative to triangle test
+    static const float kTraversalCost = 1.0f;
+
+    struct Bin
     {
-        Vector3 a = Vector3(m_vertices[m_indices[faces[i]*3+0]]);
-        Vector3 b = Vector3(m_vertices[m_indices[faces[i]*3+1]]);
-        Vector3 c = Vector3(m_vertices[m_indices[faces[i]*3+2]]);
+        Vector3 m_min;
+        Vector3 m_max;
+        uint32_t m_count;
+    };
 
-        minExtents = Min(a, minExtents);
-        maxExtents = Max(a, maxExtents);
+    struct Bins
+    {
+        Bin m_bins[3][kNumBins];
 
-        minExtents = Min(b, minExtents);
-        maxExtents = Max(b, maxExtents);
+        void Clear()
+        {
+            for (uint32_t a=0; a < 3; ++a)
+            {
+                for (uint32_t i=0; i < kNumBins; ++i)
+                {
+                    m_bins[a][i].m_min = Vector3(FLT_MAX);
+                    m_bins[a][i].m_max = Vector3(-FLT_MAX);
+                    m_bins[a][i].m_count = 0;
+                }
+            }
+        }
 
-        minExtents = Min(c, minExtents);
-        maxExtents = Max(c, maxExtents);
+        void Merge(const Bins& other)
+        {
+            for (uint32_t a=0; a < 3; ++a)
+            {
+                for (uint32_t i=0; i < kNumBins; ++i)
+                {
+                    m_bins[a][i].m_min = Min(m_bins[a][i].m_min, other.m_bins[a][i].m_min);
+                    m_bins[a][i].m_max = Max(m_bins[a][i].m_max, other.m_bins[a][i].m_max);
+                    m_bins[a][i].m_count += other.m_bins[a][i].m_count;
+                }
+            }
+        }
+    };
+
+    inline float SurfaceArea(const Vector3& min, const Vector3& max)
+    {
+        const Vector3 e = max-min;
+        return 2.0f*(e.x*e.y + e.x*e.z + e.y*e.z);
     }
 
-    outMinExtents = minExtents;
-    outMaxExtents = maxExtents;
-}
+    inline uint32_t BinIndex(float centroid, float cmin, float scale)
+    {
+        const int32_t i = int32_t((centroid - cmin)*scale);
+        return uint32_t(Max(0, Min(int32_t(kNumBins-1), i)));
+    }
+
+    // avoids 0*inf = NaN in slab test when ray starts exactly at box plane
+    inline float SafeRcp(float x)
+    {
+        const float kMin = 1e-20f;
+        if (fabsf(x) < kMin)
+            x = (x < 0.0f) ? -kMin : kMin;
+        return 1.0f/x;
+    }
+
+} // anonymous namespace
+
+struct AABBTree::BuildContext
+{
+    thread_pool_t* m_pool;
+    uint32_t m_numThreads;
+    uint32_t m_subtreeFaces;
+
+    // subtrees deferred from top level, built in parallel
+    struct Subtree
+    {
+        uint32_t m_begin;
+        uint32_t m_end;
+        uint32_t m_depth;
+        uint32_t m_treeDepth;
+        BuildNodeArray m_nodes;
+    };
+    std::vector<Subtree> m_subtrees;
+
+    // per worker bins used to split top level nodes
+    std::vector<Bins> m_workerBins;
+    uint32_t m_treeDepth;
+};
+
+void AABBTree::CalculateFaceBounds( uint32_t face, Vector3& outMinExtents, Vector3& outMaxExtents ) const
+{
+    const Vector3& a = m_vertices[m_indices[face*3+0]];
+    const Vector3& b = m_vertices[m_indices[face*3+1]];
+    const Vector3& c = m_vertices[m_indices[face*3+2]];
 
-// track current tree depth
-static uint32_t s_depth = 0;
+    outMinExtents = Min(a, Min(b, c));
+    outMaxExtents = Max(a, Max(b, c));
+}
 
-void AABBTree::Build()
+void AABBTree::Build( thread_pool_t* pool )
 {
     assert(m_numFaces*3);
 
     const uint32_t numFaces = m_numFaces;
 
-    // build initial list of faces
-    m_faces.reserve(numFaces);
+    m_faces.resize(numFaces);
+    m_faceBounds.resize(numFaces);
+    m_faceCentroids.resize(numFaces);
 
-    // calculate bounds of each face and store
-    m_faceBounds.reserve(numFaces);   
-    
-	std::vector<Bounds> stack;
-	for (uint16_t i=0; i < numFaces; ++i)
+    BuildContext ctx;
+    ctx.m_pool = pool;
+    ctx.m_numThreads = thread_pool::num_threads(pool);
+    ctx.m_subtreeFaces = Max(numFaces / (ctx.m_numThreads*4), kMinSubtreeFaces);
+    ctx.m_workerBins.resize(ctx.m_numThreads);
+    ctx.m_treeDepth = 0;
+
+    // calculate bounds and centroid of each face
+    auto prepareFaces = [this](uint32_t begin, uint32_t end, uint32_t)
     {
-		Bounds top;
-        CalculateFaceBounds(&i, 1, top.m_min, top.m_max);
-		
-		m_faces.push_back(i);
-		m_faceBounds.push_back(top);
-    }
+        for (uint32_t i=begin; i < end; ++i)
+        {
+            Bounds& b = m_faceBounds[i];
+            CalculateFaceBounds(i, b.m_min, b.m_max);
+            m_faceCentroids[i] = (b.m_min + b.m_max)*0.5f;
+            m_faces[i] = i;
+        }
+    };
+    thread_pool::parallel_for(pool, numFaces, kMinSubtreeFaces, prepareFaces);
 
-	m_nodes.reserve(uint32_t(numFaces*1.5f));
+    // top levels are split on calling thread (with parallel binning), rest of tree in parallel
+    BuildNodeArray top;
+    top.reserve(64);
+    BuildRecursive(ctx, top, 0, numFaces, 0, true);
 
-    // allocate space for all the nodes
-	m_freeNode = 1;
+    auto buildSubtrees = [this, &ctx](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (uint32_t i=begin; i < end; ++i)
+        {
+            BuildContext::Subtree& subtree = ctx.m_subtrees[i];
+            subtree.m_nodes.reserve((subtree.m_end - subtree.m_begin)/2);
+            subtree.m_treeDepth = 0;
+
+            BuildContext localCtx;
+            localCtx.m_pool = nullptr;
+            localCtx.m_numThreads = 1;
+            localCtx.m_subtreeFaces = 0;
+            localCtx.m_treeDepth = subtree.m_depth;
+
+            BuildRecursive(localCtx, subtree.m_nodes, subtree.m_begin, subtree.m_end, subtree.m_depth, false);
+            subtree.m_treeDepth = localCtx.m_treeDepth;
+        }
+    };
+    thread_pool::parallel_for(pool, uint32_t(ctx.m_subtrees.size()), 1, buildSubtrees);
 
-    // start building
-    BuildRecursive(0, &m_faces[0], numFaces);
+    for (const BuildContext::Subtree& subtree : ctx.m_subtrees)
+        ctx.m_treeDepth = Max(ctx.m_treeDepth, subtree.m_treeDepth);
 
-    assert(s_depth == 0);
+    m_bounds = top[0].m_bounds;
+    m_treeDepth = ctx.m_treeDepth;
+
+    // collapse binary tree to 4-wide nodes
+    m_nodes.reserve(Max(numFaces / (MAX_FACES_PER_LEAF*2), 1u));
+    Collapse(ctx, top, 0, 0);
 
     FaceBoundsArray f;
     m_faceBounds.swap(f);
+    std::vector<Vector3> c;
+    m_faceCentroids.swap(c);
 }
 
-// partion faces around the median face
-uint32_t AABBTree::PartitionMedian(Node& n, uint16_t* faces, uint32_t numFaces)
+// binned surface area heuristic. Returns false if node should become a leaf.
+bool AABBTree::Split( BuildContext& ctx, const Bounds& bounds, uint32_t begin, uint32_t end, bool topLevel, uint32_t& outMiddle )
 {
-	FaceSorter predicate(&m_vertices[0], &m_indices[0], m_numFaces*3, LongestAxis(n.m_maxExtents-n.m_minExtents));
-    std::nth_element(faces, faces+numFaces/2, faces+numFaces, predicate);
+    const uint32_t numFaces = end - begin;
 
-	return numFaces/2;
-}
+    Bounds centroidBounds;
+    for (uint32_t i=begin; i < end; ++i)
+        centroidBounds.Union(m_faceCentroids[m_faces[i]]);
 
-// partion faces based on the surface area heuristic
-uint32_t AABBTree::PartitionSAH(Node& n, uint16_t* faces, uint32_t numFaces)
-{
-	uint32_t bestAxis = 0;
-	uint32_t bestIndex = 0;
-	float bestCost = FLT_MAX;
-
-	for (uint32_t a=0; a < 3; ++a)	
-	//uint32_t a = bestAxis;
-	{
-		// sort faces by centroids
-		FaceSorter predicate(&m_vertices[0], &m_indices[0], m_numFaces*3, a);
-		std::sort(faces, faces+numFaces, predicate);
-
-		// two passes over data to calculate upper and lower bounds
-		vector<float> cumulativeLower(numFaces);
-		vector<float> cumulativeUpper(numFaces);
-
-		Bounds lower;
-		Bounds upper;
-
-		for (uint32_t i=0; i < numFaces; ++i)
-		{
-			lower.Union(m_faceBounds[faces[i]]);
-			upper.Union(m_faceBounds[faces[numFaces-i-1]]);
-
-			cumulativeLower[i] = lower.GetSurfaceArea();        
-			cumulativeUpper[numFaces-i-1] = upper.GetSurfaceArea();
-		}
-
-		float invTotalSA = 1.0f / cumulativeUpper[0];
-
-		// test all split positions
-		for (uint32_t i=0; i < numFaces-1; ++i)
-		{
-			float pBelow = cumulativeLower[i] * invTotalSA;
-			float pAbove = cumulativeUpper[i] * invTotalSA;
-
-			float cost = 0.125f + (pBelow*i + pAbove*(numFaces-i));
-			if (cost <= bestCost)
-			{
-				bestCost = cost;
-				bestIndex = i;
-				bestAxis = a;
-			}
-		}
-	}
-
-	// re-sort by best axis
-	FaceSorter predicate(&m_vertices[0], &m_indices[0], m_numFaces*3, bestAxis);
-	std::sort(faces, faces+numFaces, predicate);
-
-	return bestIndex+1;
-}
-
-void AABBTree::BuildRecursive(uint32_t nodeIndex, uint16_t* faces, uint32_t numFaces)
-{
-    const uint32_t kMaxFacesPerLeaf = 6;
-    
-    // if we've run out of nodes allocate some more
-    if (nodeIndex >= m_nodes.size())
+    const Vector3 extents = centroidBounds.m_max - centroidBounds.m_min;
+    if (Max(extents.x, Max(extents.y, extents.z)) <= 0.0f)
     {
-		uint32_t s = std::max(uint32_t(1.5f*m_nodes.size()), 512U);
-
-		//cout << "Resizing tree, current size: " << m_nodes.size()*sizeof(Node) << " new size: " << s*sizeof(Node) << endl;
+        // all centroids in one point, split by count
+        if (numFaces <= MAX_FACES_PER_LEAF)
+            return false;
 
-        m_nodes.resize(s);
+        outMiddle = begin + numFaces/2;
+        return true;
     }
 
-    // a reference to the current node, need to be careful here as this reference may become invalid if array is resized
-	Node& n = m_nodes[nodeIndex];
+    Vector3 scale;
+    for (uint32_t a=0; a < 3; ++a)
+        scale[a] = (extents[a] > 0.0f) ? float(kNumBins)*(1.0f - 1e-5f) / extents[a] : 0.0f;
 
-	// track max tree depth
-    ++s_depth;
-    m_treeDepth = max(m_treeDepth, s_depth);
+    auto binFaces = [this, &ctx, &centroidBounds, &scale, begin](uint32_t rbegin, uint32_t rend, uint32_t worker)
+    {
+        Bins& bins = ctx.m_workerBins[worker];
+        for (uint32_t i=begin+rbegin; i < begin+rend; ++i)
+        {
+            const uint32_t face = m_faces[i];
+            const Vector3& c = m_faceCentroids[face];
+            const Bounds& fb = m_faceBounds[face];
+            for (uint32_t a=0; a < 3; ++a)
+            {
+                Bin& bin = bins.m_bins[a][BinIndex(c[a], centroidBounds.m_min[a], scale[a])];
+                bin.m_min = Min(bin.m_min, fb.m_min);
+                bin.m_max = Max(bin.m_max, fb.m_max);
+                bin.m_count += 1;
+            }
+        }
+    };
 
-	CalculateFaceBounds(faces, numFaces, n.m_minExtents, n.m_maxExtents);
+    if (ctx.m_workerBins.empty())
+        ctx.m_workerBins.resize(1);
 
-	// calculate bounds of faces and add node  
-    if (numFaces <= kMaxFacesPerLeaf)
+    if (topLevel && ctx.m_numThreads > 1)
     {
-        n.m_faces = faces;
-        n.m_numFaces = numFaces;		
+        for (Bins& b : ctx.m_workerBins)
+            b.Clear();
+
+        const uint32_t grain = Max(numFaces / ctx.m_numThreads, 1024u);
+        thread_pool::parallel_for(ctx.m_pool, numFaces, grain, binFaces);
 
-        ++m_leafNodes;
+        for (uint32_t i=1; i < ctx.m_numThreads; ++i)
+            ctx.m_workerBins[0].Merge(ctx.m_workerBins[i]);
     }
     else
     {
-        ++m_innerNodes;        
+        ctx.m_workerBins[0].Clear();
+        binFaces(0, numFaces, 0);
+    }
+    const Bins& bins = ctx.m_workerBins[0];
 
-        // face counts for each branch
-        //const uint32_t leftCount = PartitionMedian(n, faces, numFaces);
-        const uint32_t leftCount = PartitionSAH(n, faces, numFaces);
-        const uint32_t rightCount = numFaces-leftCount;
+    // sweep bins from both sides
+    float bestCost = FLT_MAX;
+    uint32_t bestAxis = 0;
+    uint32_t bestSplit = 0;
 
-		// alloc 2 nodes
-		m_nodes[nodeIndex].m_children = m_freeNode;
+    for (uint32_t a=0; a < 3; ++a)
+    {
+        if (scale[a] == 0.0f)
+            continue;
 
-		// allocate two nodes
-		m_freeNode += 2;
-  
-        // split faces in half and build each side recursively
-        BuildRecursive(m_nodes[nodeIndex].m_children+0, faces, leftCount);
-        BuildRecursive(m_nodes[nodeIndex].m_children+1, faces+leftCount, rightCount);
-    }
+        float areaRight[kNumBins];
+        uint32_t countRight[kNumBins];
 
-    --s_depth;
-}
+        Vector3 rmin(FLT_MAX), rmax(-FLT_MAX);
+        uint32_t rcount = 0;
+        for (uint32_t i=kNumBins-1; i > 0; --i)
+        {
+            const Bin& bin = bins.m_bins[a][i];
+            rmin = Min(rmin, bin.m_min);
+            rmax = Max(rmax, bin.m_max);
+            rcount += bin.m_count;
+            areaRight[i] = (rcount) ? SurfaceArea(rmin, rmax) : 0.0f;
+            countRight[i] = rcount;
+        }
 
-struct StackEntry
-{
-    uint32_t m_node;   
-    float m_dist;
-};
+        Vector3 lmin(FLT_MAX), lmax(-FLT_MAX);
+        uint32_t lcount = 0;
+        for (uint32_t i=0; i < kNumBins-1; ++i)
+        {
+            const Bin& bin = bins.m_bins[a][i];
+            lmin = Min(lmin, bin.m_min);
+            lmax = Max(lmax, bin.m_max);
+            lcount += bin.m_count;
 
+            if (lcount == 0 || countRight[i+1] == 0)
+                continue;
 
-bool AABBTree::TraceRay(const Vec3& start, const Vector3& dir, float& outT, float& u, float& v, float& w, float& faceSign, uint32_t& faceIndex) const
-{   
-    Vector3 rcp_dir(1.0f/dir.x, 1.0f/dir.y, 1.0f/dir.z);
+            const float cost = SurfaceArea(lmin, lmax)*lcount + areaRight[i+1]*countRight[i+1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = a;
+                bestSplit = i;
+            }
+        }
+    }
 
-    outT = FLT_MAX;
-    TraceRecursive(0, start, dir, outT, u, v, w, faceSign, faceIndex);
+    const float leafCost = float(numFaces);
+    const float splitCost = kTraversalCost + bestCost / bounds.GetSurfaceArea();
+    if (bestCost == FLT_MAX || (numFaces <= MAX_FACES_PER_LEAF && splitCost >= leafCost))
+    {
+        if (numFaces <= MAX_FACES_PER_LEAF)
+            return false;
 
-    return (outT != FLT_MAX);
+        // no useful split found, but leaf would be too big
+        outMiddle = begin + numFaces/2;
+        return true;
+    }
+
+    const float cmin = centroidBounds.m_min[bestAxis];
+    const float s = scale[bestAxis];
+    uint32_t* middle = std::partition(&m_faces[0] + begin, &m_faces[0] + end, [this, bestAxis, bestSplit, cmin, s](uint32_t face)
+    {
+        return BinIndex(m_faceCentroids[face][bestAxis], cmin, s) <= bestSplit;
+    });
+
+    outMiddle = uint32_t(middle - &m_faces[0]);
+    assert(outMiddle > begin && outMiddle < end);
+    return true;
 }
 
-inline bool IntersectRayAABB( const Vec3& start, const Vector3& dir, const Vector3& min, const Vector3& max, float& t, Vector3* normal )
+uint32_t AABBTree::BuildRecursive( BuildContext& ctx, BuildNodeArray& nodes, uint32_t begin, uint32_t end, uint32_t depth, bool topLevel )
 {
-    //! calculate candidate plane on each axis
-    float tx = -1.0f, ty = -1.0f, tz = -1.0f;
-    bool inside = true;
+    const uint32_t nodeIndex = uint32_t(nodes.size());
+    nodes.push_back(BuildNode());
 
-    //! use unrolled loops
+    ctx.m_treeDepth = Max(ctx.m_treeDepth, depth+1);
 
-    //! x
-    if( start.x < min.x )
-    {
-        if( dir.x != 0.0f )
-            tx = (min.x - start.x) / dir.x;
-        inside = false;
-    }
-    else if( start.x > max.x )
-    {
-        if( dir.x != 0.0f )
-            tx = (max.x - start.x) / dir.x;
-        inside = false;
-    }
+    Bounds bounds;
+    for (uint32_t i=begin; i < end; ++i)
+        bounds.Union(m_faceBounds[m_faces[i]]);
 
-    //! y
-    if( start.y < min.y )
-    {
-        if( dir.y != 0.0f )
-            ty = (min.y - start.y) / dir.y;
-        inside = false;
-    }
-    else if( start.y > max.y )
-    {
-        if( dir.y != 0.0f )
-            ty = (max.y - start.y) / dir.y;
-        inside = false;
-    }
+    nodes[nodeIndex].m_bounds = bounds;
+    nodes[nodeIndex].m_firstFace = begin;
+    nodes[nodeIndex].m_numFaces = end - begin;
 
-    //! z
-    if( start.z < min.z )
+    // defer building to worker threads
+    if (topLevel && (end - begin) <= ctx.m_subtreeFaces)
     {
-        if( dir.z != 0.0f )
-            tz = (min.z - start.z) / dir.z;
-        inside = false;
+        BuildContext::Subtree subtree;
+        subtree.m_begin = begin;
+        subtree.m_end = end;
+        subtree.m_depth = depth;
+        subtree.m_treeDepth = 0;
+        ctx.m_subtrees.push_back(std::move(subtree));
+
+        nodes[nodeIndex].m_subtree = uint32_t(ctx.m_subtrees.size());
+        return nodeIndex;
     }
-    else if( start.z > max.z )
+
+    uint32_t middle = 0;
+    if (!Split(ctx, bounds, begin, end, topLevel, middle))
+        return nodeIndex;
+
+    // careful, nodes can be reallocated in recursive calls
+    const uint32_t left = BuildRecursive(ctx, nodes, begin, middle, depth+1, topLevel);
+    const uint32_t right = BuildRecursive(ctx, nodes, middle, end, depth+1, topLevel);
+    nodes[nodeIndex].m_left = left;
+    nodes[nodeIndex].m_right = right;
+    nodes[nodeIndex].m_numFaces = 0;
+
+    return nodeIndex;
+}
+
+uint32_t AABBTree::EncodeLeaf( const BuildNode& node ) const
+{
+    assert(node.m_numFaces <= LEAF_COUNT_MASK);
+    assert((node.m_firstFace << LEAF_COUNT_BITS >> LEAF_COUNT_BITS) == node.m_firstFace);
+    return LEAF_BIT | (node.m_firstFace << LEAF_COUNT_BITS) | node.m_numFaces;
+}
+
+uint32_t AABBTree::Collapse( const BuildContext& ctx, const BuildNodeArray& nodes, uint32_t nodeIndex, uint32_t depth )
+{
+    struct Ref
     {
-        if( dir.z != 0.0f )
-            tz = (max.z - start.z) / dir.z;
-        inside = false;
-    }
+        const BuildNodeArray* m_nodes;
+        uint32_t m_index;
 
-    //! if point inside all planes
-    if( inside )
+        const BuildNode& Get() const { return (*m_nodes)[m_index]; }
+        bool IsLeaf() const { return Get().m_numFaces != 0; }
+    };
+
+    // top level leaves point to subtrees
+    auto resolve = [&ctx](Ref ref) -> Ref
     {
-        t = 0.0f;
-        return true;
-    }
+        const uint32_t subtree = ref.Get().m_subtree;
+        if (subtree)
+        {
+            ref.m_nodes = &ctx.m_subtrees[subtree-1].m_nodes;
+            ref.m_index = 0;
+        }
+        return ref;
+    };
 
-    //! we now have t values for each of possible intersection planes
-    //! find the maximum to get the intersection point
-    float tmax = tx;
-    int taxis = 0;
+    Ref children[4];
+    uint32_t numChildren = 0;
 
-    if( ty > tmax )
+    const Ref root = resolve({ &nodes, nodeIndex });
+    if (root.IsLeaf())
     {
-        tmax = ty;
-        taxis = 1;
+        children[numChildren++] = root;
     }
-    if( tz > tmax )
+    else
     {
-        tmax = tz;
-        taxis = 2;
+        children[numChildren++] = resolve({ root.m_nodes, root.Get().m_left });
+        children[numChildren++] = resolve({ root.m_nodes, root.Get().m_right });
     }
 
-    if( tmax < 0.0f )
-        return false;
+    // open inner child with the biggest area until node is full
+    while (numChildren < 4)
+    {
+        int32_t best = -1;
+        float bestArea = -1.0f;
+        for (uint32_t i=0; i < numChildren; ++i)
+        {
+            if (children[i].IsLeaf())
+                continue;
 
-    //! check that the intersection point lies on the plane we picked
-    //! we don't test the axis of closest intersection for precision reasons
+            const float area = children[i].Get().m_bounds.GetSurfaceArea();
+            if (area > bestArea)
+            {
+                bestArea = area;
+                best = int32_t(i);
+            }
+        }
 
-    //! no eps for now
-    float eps = 0.0f;
+        if (best < 0)
+            break;
 
-    Vec3 hit = start + dir * tmax;
+        const Ref opened = children[best];
+        children[best] = resolve({ opened.m_nodes, opened.Get().m_left });
+        children[numChildren++] = resolve({ opened.m_nodes, opened.Get().m_right });
+    }
 
-    if( (hit.x < min.x - eps || hit.x > max.x + eps) && taxis != 0 )
-        return false;
-    if( (hit.y < min.y - eps || hit.y > max.y + eps) && taxis != 1 )
-        return false;
-    if( (hit.z < min.z - eps || hit.z > max.z + eps) && taxis != 2 )
-        return false;
+    const uint32_t index = uint32_t(m_nodes.size());
+    m_nodes.push_back(Node());
+    ++m_innerNodes;
 
-    //! output results
-    t = tmax;
+    for (uint32_t i=0; i < 4; ++i)
+    {
+        // careful, m_nodes can be reallocated in recursive call
+        uint32_t child = EMPTY_CHILD;
+        Bounds b;
 
-    return true;
+        if (i < numChildren)
+        {
+            const BuildNode& bnode = children[i].Get();
+            b = bnode.m_bounds;
+            if (children[i].IsLeaf())
+            {
+                child = EncodeLeaf(bnode);
+                ++m_leafNodes;
+            }
+            else
+            {
+                child = Collapse(ctx, *children[i].m_nodes, children[i].m_index, depth+1);
+            }
+        }
+
+        Node& n = m_nodes[index];
+        n.m_minX[i] = b.m_min.x; n.m_minY[i] = b.m_min.y; n.m_minZ[i] = b.m_min.z;
+        n.m_maxX[i] = b.m_max.x; n.m_maxY[i] = b.m_max.y; n.m_maxZ[i] = b.m_max.z;
+        n.m_children[i] = child;
+    }
+
+    return index;
 }
 
 inline bool IntersectRayTriTwoSided( const Vec3& p, const Vec3& dir, const Vec3& a, const Vec3& b, const Vec3& c, float& t, float& u, float& v, float& w, float& sign )//Vec3* normal)
@@ -422,61 +553,278 @@ inline bool IntersectRayTriTwoSided( const Vec3& p, const Vec3& dir, const Vec3&
     return true;
 }
 
-void AABBTree::TraceRecursive(uint32_t nodeIndex, const Vec3& start, const Vector3& dir, float& outT, float& outU, float& outV, float& outW, float& faceSign, uint32_t& faceIndex) const
+
+void AABBTree::IntersectLeaf( uint32_t leaf, const Vec3& start, const Vector3& dir, float& outT, float& outU, float& outV, float& outW, float& faceSign, uint32_t& faceIndex ) const
 {
-	const Node& node = m_nodes[nodeIndex];
+    const uint32_t first = (leaf & ~LEAF_BIT) >> LEAF_COUNT_BITS;
+    const uint32_t count = leaf & LEAF_COUNT_MASK;
 
-    if (node.m_faces == NULL)
+    float t, u, v, w, s;
+    for (uint32_t i=first; i < first+count; ++i)
     {
-        // find closest node
-        const Node& leftChild = m_nodes[node.m_children+0];
-        const Node& rightChild = m_nodes[node.m_children+1];
+        const uint32_t face = m_faces[i];
+        const Vec3& a = m_vertices[m_indices[face*3+0]];
+        const Vec3& b = m_vertices[m_indices[face*3+1]];
+        const Vec3& c = m_vertices[m_indices[face*3+2]];
 
-        float dist[2] = {FLT_MAX, FLT_MAX};
+        if (IntersectRayTriTwoSided(start, dir, a, b, c, t, u, v, w, s))
+        {
+            if (t < outT)
+            {
+                outT = t;
+                outU = u;
+                outV = v;
+                outW = w;
+                faceSign = s;
+                faceIndex = face;
+            }
+        }
+    }
+}
+
+struct StackEntry
+{
+    uint32_t m_node;   
+    float m_dist;
+};
+
+// traversal stack living on the call stack, spills to heap only for trees deeper than local storage allows
+template <typename T>
+struct TraversalStack
+{
+    static const uint32_t kLocalSize = 128;
+
+    T m_local[kLocalSize];
+    std::vector<T> m_heap;
+    T* m_data = m_local;
+    uint32_t m_capacity = kLocalSize;
+    uint32_t m_size = 0;
+
+    bool Empty() const { return m_size == 0; }
+    T Pop() { return m_data[--m_size]; }
+    void Push(const T& entry)
+    {
+        if (m_size == m_capacity)
+            Grow();
+
+        m_data[m_size++] = entry;
+    }
+
+    void Grow()
+    {
+        m_capacity *= 2;
+        m_heap.resize(m_capacity);
+        if (m_data == m_local)
+            std::copy(m_local, m_local + m_size, m_heap.begin());
+
+        m_data = m_heap.data();
+    }
+};
 
-        IntersectRayAABB(start, dir, leftChild.m_minExtents, leftChild.m_maxExtents, dist[0], NULL);
-        IntersectRayAABB(start, dir, rightChild.m_minExtents, rightChild.m_maxExtents, dist[1], NULL);
-        
-        uint32_t closest = 0;
-        uint32_t furthest = 1;
-		
-        if (dist[1] < dist[0])
+bool AABBTree::TraceRay(const Vec3& start, const Vector3& dir, float& outT, float& u, float& v, float& w, float& faceSign, uint32_t& faceIndex) const
+{   
+    outT = FLT_MAX;
+    if (m_nodes.empty())
+        return false;
+
+    const __m128 ox = _mm_set1_ps(start.x);
+    const __m128 oy = _mm_set1_ps(start.y);
+    const __m128 oz = _mm_set1_ps(start.z);
+    const __m128 rx = _mm_set1_ps(SafeRcp(dir.x));
+    const __m128 ry = _mm_set1_ps(SafeRcp(dir.y));
+    const __m128 rz = _mm_set1_ps(SafeRcp(dir.z));
+    const __m128 zero = _mm_setzero_ps();
+
+    TraversalStack<StackEntry> stack;
+    stack.Push({ 0, 0.0f });
+
+    while (!stack.Empty())
+    {
+        const StackEntry entry = stack.Pop();
+        if (entry.m_dist > outT)
+            continue;
+
+        const Node& node = m_nodes[entry.m_node];
+
+        // slab test against 4 boxes
+        const __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_minX), ox), rx);
+        const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_maxX), ox), rx);
+        const __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_minY), oy), ry);
+        const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_maxY), oy), ry);
+        const __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_minZ), oz), rz);
+        const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.m_maxZ), oz), rz);
+
+        __m128 tnear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_max_ps(_mm_min_ps(tz0, tz1), zero));
+        __m128 tfar  = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_min_ps(_mm_max_ps(tz0, tz1), _mm_set1_ps(outT)));
+
+        const int mask = _mm_movemask_ps(_mm_cmple_ps(tnear, tfar));
+        if (!mask)
+            continue;
+
+        float dist[4];
+        _mm_storeu_ps(dist, tnear);
+
+        // leaves are tested immediately, inner nodes are pushed far to near
+        uint32_t inner[4];
+        uint32_t numInner = 0;
+        for (uint32_t i=0; i < 4; ++i)
+        {
+            if (!(mask & (1 << i)))
+                continue;
+
+            const uint32_t child = node.m_children[i];
+            if (child == EMPTY_CHILD)
+            {
+                // inverted box of empty slot would pass slab test
+                continue;
+            }
+            else if (child & LEAF_BIT)
+            {
+                IntersectLeaf(child, start, dir, outT, u, v, w, faceSign, faceIndex);
+            }
+            else
+            {
+                uint32_t j = numInner++;
+                for (; j > 0 && dist[inner[j-1]] < dist[i]; --j)
+                    inner[j] = inner[j-1];
+                inner[j] = i;
+            }
+        }
+
+        for (uint32_t i=0; i < numInner; ++i)
         {
-            closest = 1;
-            furthest = 0;
-        }		
+            const uint32_t c = inner[i];
+            if (dist[c] > outT)
+                continue;
+
+            stack.Push({ node.m_children[c], dist[c] });
+        }
+    }
+
+    return (outT != FLT_MAX);
+}
 
-        if (dist[closest] < outT)
-            TraceRecursive(node.m_children+closest, start, dir, outT, outU, outV, outW, faceSign, faceIndex);
+namespace
+{
+    // twice the signed area of (a, b, p) projected on xy plane
+    inline float Edge2D(const Vec3& a, const Vec3& b, float px, float py)
+    {
+        return (b.x - a.x)*(py - a.y) - (b.y - a.y)*(px - a.x);
+    }
 
-        if (dist[furthest] < outT)
-            TraceRecursive(node.m_children+furthest, start, dir, outT, outU, outV, outW, faceSign, faceIndex);
+    // top-left rule for counter clockwise triangles, point on shared edge belongs to exactly one of them
+    inline bool EdgeInside(float e, const Vec3& a, const Vec3& b)
+    {
+        if (e != 0.0f)
+            return e > 0.0f;
 
+        const float dx = b.x - a.x;
+        const float dy = b.y - a.y;
+        return (dy < 0.0f) || (dy == 0.0f && dx < 0.0f);
     }
-    else
+} // anonymous namespace
+
+void AABBTree::IntersectLeafColumns( uint32_t leaf, const float x[4], const float y[4], uint32_t rayMask, ColumnHitArray hits[4] ) const
+{
+    const uint32_t first = (leaf & ~LEAF_BIT) >> LEAF_COUNT_BITS;
+    const uint32_t count = leaf & LEAF_COUNT_MASK;
+
+    for (uint32_t i=first; i < first+count; ++i)
+    {
+        const uint32_t face = m_faces[i];
+        const Vec3* a = &m_vertices[m_indices[face*3+0]];
+        const Vec3* b = &m_vertices[m_indices[face*3+1]];
+        const Vec3* c = &m_vertices[m_indices[face*3+2]];
+
+        float area = Edge2D(*a, *b, c->x, c->y);
+        if (area == 0.0f)
+            continue;
+
+        if (area < 0.0f)
+        {
+            std::swap(b, c);
+            area = -area;
+        }
+        const float invArea = 1.0f / area;
+
+        for (uint32_t r=0; r < 4; ++r)
+        {
+            if (!(rayMask & (1 << r)))
+                continue;
+
+            const float e0 = Edge2D(*b, *c, x[r], y[r]);
+            const float e1 = Edge2D(*c, *a, x[r], y[r]);
+            const float e2 = Edge2D(*a, *b, x[r], y[r]);
+            if (!EdgeInside(e0, *b, *c) || !EdgeInside(e1, *c, *a) || !EdgeInside(e2, *a, *b))
+                continue;
+
+            ColumnHit hit;
+            hit.m_z = (e0*a->z + e1*b->z + e2*c->z) * invArea;
+            hit.m_face = face;
+            hits[r].push_back(hit);
+        }
+    }
+}
+
+void AABBTree::TraceColumns4( const float x[4], const float y[4], uint32_t rayMask, ColumnHitArray hits[4] ) const
+{
+    for (uint32_t r=0; r < 4; ++r)
+        hits[r].clear();
+
+    if (m_nodes.empty() || !rayMask)
+        return;
+
+    struct ColumnStackEntry
     {
-        Vector3 normal;
-        float t, u, v, w, s;
+        uint32_t m_node;
+        uint32_t m_rayMask;
+    };
+
+    TraversalStack<ColumnStackEntry> stack;
+    stack.Push({ 0, rayMask & 0xF });
+
+    while (!stack.Empty())
+    {
+        const ColumnStackEntry entry = stack.Pop();
+        const Node& node = m_nodes[entry.m_node];
+
+        const __m128 minX = _mm_loadu_ps(node.m_minX);
+        const __m128 minY = _mm_loadu_ps(node.m_minY);
+        const __m128 maxX = _mm_loadu_ps(node.m_maxX);
+        const __m128 maxY = _mm_loadu_ps(node.m_maxY);
 
-        for (uint32_t i=0; i < node.m_numFaces; ++i)
+        // only xy extents matter for lines parallel to z, empty slots have inverted boxes and never pass
+        uint32_t childRays[4] = { 0, 0, 0, 0 };
+        for (uint32_t r=0; r < 4; ++r)
         {
-            uint32_t indexStart = node.m_faces[i]*3;
+            if (!(entry.m_rayMask & (1 << r)))
+                continue;
+
+            const __m128 px = _mm_set1_ps(x[r]);
+            const __m128 py = _mm_set1_ps(y[r]);
+            const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(minX, px), _mm_cmpge_ps(maxX, px)),
+                                             _mm_and_ps(_mm_cmple_ps(minY, py), _mm_cmpge_ps(maxY, py)));
+            const int mask = _mm_movemask_ps(inside);
+            for (uint32_t c=0; c < 4; ++c)
+                childRays[c] |= ((mask >> c) & 1) << r;
+        }
+
+        for (uint32_t c=0; c < 4; ++c)
+        {
+            if (!childRays[c])
+                continue;
 
-            const Vec3& a = m_vertices[m_indices[indexStart+0]];
-            const Vec3& b = m_vertices[m_indices[indexStart+1]];
-            const Vec3& c = m_vertices[m_indices[indexStart+2]];
+            const uint32_t child = node.m_children[c];
+            if (child == EMPTY_CHILD)
+                continue;
 
-            if (IntersectRayTriTwoSided(start, dir, a, b, c, t, u, v, w, s))
+            if (child & LEAF_BIT)
             {
-                if (t < outT)
-                {
-                    outT = t;
-					outU = u;
-					outV = v;
-					outW = w;
-					faceSign = s;
-					faceIndex = node.m_faces[i];
-                }
+                IntersectLeafColumns(child, x, y, childRays[c], hits);
+            }
+            else
+            {
+                stack.Push({ child, childRays[c] });
             }
         }
     }
@@ -28,6 +28,7 @@
 #pragma once
 
 #include <vector>
+#include <float.h>
 
 #include "../foundation/math/vmath_type.h"
 #include "../foundation/math/vec3.h"
@@ -48,6 +49,10 @@ inline vec3_t Min( const vec3_t& a, const vec3_t& b ) { return min_per_elem( a,
 template<>
 inline vec3_t Max( const vec3_t& a, const vec3_t& b ) { return max_per_elem( a, b ); }
 
+struct thread_pool_t;
+
+// BVH4 over mesh triangles. Built with binned SAH (top levels split in parallel when thread pool is given),
+// binary tree is then collapsed to 4-wide nodes which are tested against ray with SSE.
 class AABBTree
 {
 	AABBTree(const AABBTree&);
@@ -55,42 +60,57 @@ class AABBTree
 
 public:
 
-    AABBTree( array_span_t<const Vec3> vertices, array_span_t<const u16> indices, uint32_t numFaces );
+    AABBTree( array_span_t<const Vec3> vertices, array_span_t<const u32> indices, uint32_t numFaces, thread_pool_t* pool = nullptr );
+    AABBTree( array_span_t<const Vec3> vertices, array_span_t<const u16> indices, uint32_t numFaces, thread_pool_t* pool = nullptr );
 
 	bool TraceRaySlow(const Vec3& start, const Vector3& dir, float& outT, float& u, float& v, float& w, float& faceSign, uint32_t& faceIndex) const;
     bool TraceRay(const Vec3& start, const Vector3& dir, float& outT, float& u, float& v, float& w, float& faceSign, uint32_t& faceIndex) const;
 
-    Vector3 GetCenter() const { return (m_nodes[0].m_minExtents+m_nodes[0].m_maxExtents)*0.5f; }
-    Vector3 GetMinExtents() const { return m_nodes[0].m_minExtents; }
-    Vector3 GetMaxExtents() const { return m_nodes[0].m_maxExtents; }
+    Vector3 GetCenter() const { return (m_bounds.m_min+m_bounds.m_max)*0.5f; }
+    Vector3 GetMinExtents() const { return m_bounds.m_min; }
+    Vector3 GetMaxExtents() const { return m_bounds.m_max; }
+
+    // hit of ray parallel to +z axis
+    struct ColumnHit
+    {
+        float m_z;
+        uint32_t m_face;
+    };
+    typedef std::vector<ColumnHit> ColumnHitArray;
+
+    // packet query used by voxelizer: finds all faces crossed by (up to) 4 lines parallel to z axis, passing through (x[i], y[i]).
+    // Shared edges are counted once (top-left rule), hits are not sorted.
+    void TraceColumns4( const float x[4], const float y[4], uint32_t rayMask, ColumnHitArray hits[4] ) const;
+
+    uint32_t GetNumFaces() const { return m_numFaces; }
+	uint32_t GetNumNodes() const { return uint32_t(m_nodes.size()); }
+    uint32_t GetTreeDepth() const { return m_treeDepth; }
 	
 private:
 
+    // 4 children boxes in SoA layout
     struct Node
     {
-        Node() 	
-            : m_numFaces(0)
-            , m_faces(NULL)
-            , m_minExtents(0.0f)
-            , m_maxExtents(0.0f)
-        {
-        }
-
-		union
-		{
-			uint32_t m_children;
-			uint32_t m_numFaces;			
-		};
-
-		const uint16_t* m_faces;        
-        Vector3 m_minExtents;
-        Vector3 m_maxExtents;
+        float m_minX[4];
+        float m_minY[4];
+        float m_minZ[4];
+        float m_maxX[4];
+        float m_maxY[4];
+        float m_maxZ[4];
+
+        // inner: node index, leaf: LEAF_BIT | (first face << LEAF_COUNT_BITS) | num faces
+        uint32_t m_children[4];
     };
 
+    static constexpr uint32_t EMPTY_CHILD = UINT32_MAX;
+    static constexpr uint32_t LEAF_BIT = 0x80000000;
+    static constexpr uint32_t LEAF_COUNT_BITS = 3;
+    static constexpr uint32_t LEAF_COUNT_MASK = ( 1 << LEAF_COUNT_BITS ) - 1;
+    static constexpr uint32_t MAX_FACES_PER_LEAF = 6;
 
     struct Bounds
     {
-        Bounds() : m_min(0.0f), m_max(0.0f)
+        Bounds() : m_min(FLT_MAX), m_max(-FLT_MAX)
         {
         }
 
@@ -116,37 +136,54 @@ private:
             m_max = Max(m_max, b.m_max);
         }
 
+        inline void Union(const Vector3& p)
+        {
+            m_min = Min(m_min, p);
+            m_max = Max(m_max, p);
+        }
+
         Vector3 m_min;
         Vector3 m_max;
     };
 
-    typedef std::vector<Vec3> PositionArray;
+    // binary node used during build
+    struct BuildNode
+    {
+        Bounds m_bounds;
+        uint32_t m_left = 0;    // index in the same array, 0 for leaf (root is never a child)
+        uint32_t m_right = 0;
+        uint32_t m_firstFace = 0;
+        uint32_t m_numFaces = 0;
+        uint32_t m_subtree = 0; // top level only: 1 + index of subtree built on worker thread
+    };
+    typedef std::vector<BuildNode> BuildNodeArray;
+
+    struct BuildContext;
+
     typedef std::vector<Node> NodeArray;
-    typedef std::vector<uint16_t> FaceArray;
+    typedef std::vector<uint32_t> FaceArray;
     typedef std::vector<Bounds> FaceBoundsArray;
 
-	// partition the objects and return the number of objects in the lower partition
-	uint32_t PartitionMedian(Node& n, uint16_t* faces, uint32_t numFaces);
-	uint32_t PartitionSAH   (Node& n, uint16_t* faces, uint32_t numFaces);
-
-    void Build();
-    void BuildRecursive(uint32_t nodeIndex, uint16_t* faces, uint32_t numFaces);
-    void TraceRecursive(uint32_t nodeIndex, const Vec3& start, const Vector3& dir, float& outT, float& u, float& v, float& w, float& faceSign, uint32_t& faceIndex) const;
- 
-    void CalculateFaceBounds(const uint16_t* faces, uint32_t numFaces, Vector3& outMinExtents, Vector3& outMaxExtents);
-    uint32_t GetNumFaces() const { return m_numFaces; }
-	uint32_t GetNumNodes() const { return uint32_t(m_nodes.size()); }
+    void Build( thread_pool_t* pool );
+    uint32_t BuildRecursive( BuildContext& ctx, BuildNodeArray& nodes, uint32_t begin, uint32_t end, uint32_t depth, bool topLevel );
+    bool Split( BuildContext& ctx, const Bounds& bounds, uint32_t begin, uint32_t end, bool topLevel, uint32_t& outMiddle );
+    uint32_t Collapse( const BuildContext& ctx, const BuildNodeArray& nodes, uint32_t nodeIndex, uint32_t depth );
+    uint32_t EncodeLeaf( const BuildNode& node ) const;
 
-	// track the next free node
-	uint32_t m_freeNode;
+    void IntersectLeafColumns( uint32_t leaf, const float x[4], const float y[4], uint32_t rayMask, ColumnHitArray hits[4] ) const;
+    void IntersectLeaf( uint32_t leaf, const Vec3& start, const Vector3& dir, float& outT, float& u, float& v, float& w, float& faceSign, uint32_t& faceIndex ) const;
+    void CalculateFaceBounds( uint32_t face, Vector3& outMinExtents, Vector3& outMaxExtents ) const;
 
     array_span_t<const Vec3> m_vertices;
-    array_span_t<const u16> m_indices;
+    const uint32_t* m_indices;
+    std::vector<uint32_t> m_indices32; // used when tree is created from 16bit indices
     const uint32_t m_numFaces;
 
+    Bounds m_bounds;
     FaceArray m_faces;
     NodeArray m_nodes;
-    FaceBoundsArray m_faceBounds;    
+    FaceBoundsArray m_faceBounds;
+    std::vector<Vector3> m_faceCentroids;
 
     // stats
     uint32_t m_treeDepth;
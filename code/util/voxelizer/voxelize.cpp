@@ -28,72 +28,366 @@
 #include "aabbtree.h"
 #include "voxelize.h"
 
-void Voxelize( array_span_t<u8> volume, u32 width, u32 height, u32 depth, const AABB& bounds, array_span_t<const Vec3> vertices, array_span_t<const u16> indices )
+#include "../foundation/array.h"
+#include <foundation/thread/thread_pool.h>
+
+#include <algorithm>
+#include <vector>
+#include <math.h>
+#include <string.h>
+
+namespace
 {
-	//memset(volume, 0, sizeof(uint32_t)*width*height*depth);
-
-	// build an aabb tree of the mesh
-	AABBTree tree(vertices, indices, indices.size() /3 ); 
-
-	// parity count method, single pass
-    const Vec3 extents = AABB::Size( bounds );
-	const Vec3 delta(extents.x/width, extents.y/height, extents.z/depth);
-	const Vec3 offset(0.5f*delta.x, 0.5f*delta.y, 0.5f*delta.z);
-	
-	// this is the bias we apply to step 'off' a triangle we hit, not very robust
-	const float eps = 0.00001f*extents.z;
-
-	for (uint32_t x=0; x < width; ++x)
-	{
-		for (uint32_t y=0; y < height; ++y)
-		{
-			bool inside = false;
-
-			Vec3 rayDir = Vec3(0.0f, 0.0f, 1.0f);
-			Vec3 rayStart = bounds.pmin + Vec3(x*delta.x + offset.x, y*delta.y + offset.y, 0.0f);
-
-			uint32_t lastTri = uint32_t(-1);
-			for (;;)
-			{
-				// calculate ray start
-				float t, u, v, w, s;
-				uint32_t tri;
-
-				if (tree.TraceRay(rayStart, rayDir, t, u, v, w, s, tri))
-				{
-					// calculate cell in which intersection occurred
-					const float zpos = rayStart.z + t*rayDir.z;
-					const float zhit = (zpos- bounds.pmin.z)/delta.z;
-					
-					const uint32_t z = uint32_t(floorf((rayStart.z- bounds.pmin.z)/delta.z + 0.5f));
-					const uint32_t zend = Min(uint32_t(floorf(zhit + 0.5f)), depth-1);
-
-					if (inside)
-					{
-                        volume[z*width*height + y * width + x] = u8( -1 );
-                        if( zend )
+    struct VoxelGrid
+    {
+        uint32_t m_width;
+        uint32_t m_height;
+        uint32_t m_depth;
+        uint32_t m_pitch; // words per row of bit volume
+        Vec3 m_origin;
+        Vec3 m_delta;
+        Vec3 m_invDelta;
+    };
+
+    VoxelGrid MakeGrid(const VoxelizeDesc& desc)
+    {
+        const Vec3 extents = AABB::Size(desc.bounds);
+
+        VoxelGrid grid;
+        grid.m_width = desc.width;
+        grid.m_height = desc.height;
+        grid.m_depth = desc.depth;
+        grid.m_pitch = VoxelBitsPitch(desc.width);
+        grid.m_origin = desc.bounds.pmin;
+        grid.m_delta = Vec3(extents.x/desc.width, extents.y/desc.height, extents.z/desc.depth);
+        grid.m_invDelta = Vec3(1.0f/grid.m_delta.x, 1.0f/grid.m_delta.y, 1.0f/grid.m_delta.z);
+        return grid;
+    }
+
+    // caller must be the only writer of the word (see VoxelBitsPitch)
+    inline void SetBit(uint32_t* bits, const VoxelGrid& grid, uint32_t x, uint32_t y, uint32_t z)
+    {
+        bits[(z*grid.m_height + y)*grid.m_pitch + x/32] |= 1u << (x & 31);
+    }
+
+    inline bool GetBit(const uint32_t* bits, const VoxelGrid& grid, uint32_t x, uint32_t y, uint32_t z)
+    {
+        return (bits[(z*grid.m_height + y)*grid.m_pitch + x/32] >> (x & 31)) & 1;
+    }
+
+    // cell containing coordinate, clamped to [0, count)
+    inline uint32_t CellIndex(float p, float origin, float invDelta, uint32_t count)
+    {
+        const float f = floorf((p - origin)*invDelta);
+        if (f <= 0.0f)
+            return 0;
+        return (f >= float(count - 1)) ? count - 1 : uint32_t(f);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // solid: lines parallel to z through voxel centers are traced in packets of 4,
+    // voxels with centers between pairs of hits are inside
+    void VoxelizeSolid(uint32_t* bits, const VoxelGrid& grid, thread_pool_t* pool, array_span_t<const Vec3> vertices, array_span_t<const u32> indices)
+    {
+        const AABBTree tree(vertices, indices, indices.size()/3, pool);
+
+        const uint32_t packetsPerRow = (grid.m_width + 3) / 4;
+
+        // whole rows per task, so packets sharing a word of bit volume are always processed by the same thread
+        auto traceRows = [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            AABBTree::ColumnHitArray hits[4];
+
+            for (uint32_t y=begin; y < end; ++y)
+            {
+                const float py = grid.m_origin.y + (y + 0.5f)*grid.m_delta.y;
+
+                for (uint32_t packet=0; packet < packetsPerRow; ++packet)
+                {
+                    const uint32_t x0 = packet*4;
+
+                    float rayX[4];
+                    float rayY[4] = { py, py, py, py };
+                    uint32_t rayMask = 0;
+                    for (uint32_t r=0; r < 4; ++r)
+                    {
+                        rayX[r] = grid.m_origin.x + (x0 + r + 0.5f)*grid.m_delta.x;
+                        if (x0 + r < grid.m_width)
+                            rayMask |= 1 << r;
+                    }
+
+                    tree.TraceColumns4(rayX, rayY, rayMask, hits);
+
+                    for (uint32_t r=0; r < 4; ++r)
+                    {
+                        AABBTree::ColumnHitArray& columnHits = hits[r];
+                        if (columnHits.size() < 2)
+                            continue;
+
+                        std::sort(columnHits.begin(), columnHits.end(), [](const AABBTree::ColumnHit& a, const AABBTree::ColumnHit& b) { return a.m_z < b.m_z; });
+
+                        // unpaired last hit means open mesh, it's ignored
+                        for (size_t i=0; i+1 < columnHits.size(); i += 2)
                         {
-                            const uint32_t last_z = zend - 1;
-                            volume[last_z*width*height + y * width + x] = u8( -1 );
+                            const float zbegin = ceilf((columnHits[i].m_z - grid.m_origin.z)*grid.m_invDelta.z - 0.5f);
+                            const float zend = ceilf((columnHits[i+1].m_z - grid.m_origin.z)*grid.m_invDelta.z - 0.5f);
+
+                            const uint32_t zfirst = uint32_t(Min(Max(zbegin, 0.0f), float(grid.m_depth)));
+                            const uint32_t zlast = uint32_t(Min(Max(zend, 0.0f), float(grid.m_depth)));
+                            for (uint32_t z=zfirst; z < zlast; ++z)
+                                SetBit(bits, grid, x0 + r, y, z);
                         }
-						// march along column setting bits 
-						//for (uint32_t k=z; k < zend; ++k)
-						//	volume[k*width*height + y*width + x] = u8(-1);
-					}
-					
-					inside = !inside;
-					
-					// we hit the tri we started from
-					if (tri == lastTri)
-						printf("Error self-intersect\n");
-					lastTri = tri;
-
-					rayStart += rayDir*(t+eps);
-
-				}
-				else
-					break;
-			}
-		}
-	}	
+                    }
+                }
+            }
+        };
+        thread_pool::parallel_for(pool, grid.m_height, 1, traceRows);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // triangle/box overlap based on separating axis theorem (Akenine-Moller)
+    inline bool AxisSeparates(float p0, float p1, float p2, float r)
+    {
+        const float pmin = Min(p0, Min(p1, p2));
+        const float pmax = Max(p0, Max(p1, p2));
+        return pmin > r || pmax < -r;
+    }
+
+    bool TriangleBoxOverlap(const Vec3& center, const Vec3& h, const Vec3& a, const Vec3& b, const Vec3& c)
+    {
+        const Vec3 v[3] = { a - center, b - center, c - center };
+        const Vec3 e[3] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+
+        // edge x box axis
+        for (uint32_t i=0; i < 3; ++i)
+        {
+            const Vec3& ei = e[i];
+            const float ax = fabsf(ei.x);
+            const float ay = fabsf(ei.y);
+            const float az = fabsf(ei.z);
+
+            if (AxisSeparates(ei.y*v[0].z - ei.z*v[0].y, ei.y*v[1].z - ei.z*v[1].y, ei.y*v[2].z - ei.z*v[2].y, h.y*az + h.z*ay))
+                return false;
+            if (AxisSeparates(ei.z*v[0].x - ei.x*v[0].z, ei.z*v[1].x - ei.x*v[1].z, ei.z*v[2].x - ei.x*v[2].z, h.x*az + h.z*ax))
+                return false;
+            if (AxisSeparates(ei.x*v[0].y - ei.y*v[0].x, ei.x*v[1].y - ei.y*v[1].x, ei.x*v[2].y - ei.y*v[2].x, h.x*ay + h.y*ax))
+                return false;
+        }
+
+        // box axes
+        if (AxisSeparates(v[0].x, v[1].x, v[2].x, h.x) ||
+            AxisSeparates(v[0].y, v[1].y, v[2].y, h.y) ||
+            AxisSeparates(v[0].z, v[1].z, v[2].z, h.z))
+            return false;
+
+        // triangle plane
+        const Vec3 n(e[0].y*e[1].z - e[0].z*e[1].y, e[0].z*e[1].x - e[0].x*e[1].z, e[0].x*e[1].y - e[0].y*e[1].x);
+        const float d = n.x*v[0].x + n.y*v[0].y + n.z*v[0].z;
+        const float r = h.x*fabsf(n.x) + h.y*fabsf(n.y) + h.z*fabsf(n.z);
+        return fabsf(d) <= r;
+    }
+
+    struct TriangleCells
+    {
+        uint32_t m_min[3];
+        uint32_t m_max[3];
+        uint32_t m_valid;
+    };
+
+    // conservative surface: every voxel overlapped by a triangle is set.
+    // Work is split into z slabs, each slab owns its words of bit volume.
+    void VoxelizeSurface(uint32_t* bits, const VoxelGrid& grid, thread_pool_t* pool, array_span_t<const Vec3> vertices, array_span_t<const u32> indices)
+    {
+        const uint32_t numFaces = indices.size() / 3;
+        const Vec3 gridMax(grid.m_origin.x + grid.m_width*grid.m_delta.x, grid.m_origin.y + grid.m_height*grid.m_delta.y, grid.m_origin.z + grid.m_depth*grid.m_delta.z);
+
+        std::vector<TriangleCells> cells(numFaces);
+        auto computeCells = [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            for (uint32_t f=begin; f < end; ++f)
+            {
+                const Vec3& a = vertices[indices[f*3+0]];
+                const Vec3& b = vertices[indices[f*3+1]];
+                const Vec3& c = vertices[indices[f*3+2]];
+
+                const float lo[3] = { Min(a.x, Min(b.x, c.x)), Min(a.y, Min(b.y, c.y)), Min(a.z, Min(b.z, c.z)) };
+                const float hi[3] = { Max(a.x, Max(b.x, c.x)), Max(a.y, Max(b.y, c.y)), Max(a.z, Max(b.z, c.z)) };
+                const float origin[3] = { grid.m_origin.x, grid.m_origin.y, grid.m_origin.z };
+                const float limit[3] = { gridMax.x, gridMax.y, gridMax.z };
+                const float invDelta[3] = { grid.m_invDelta.x, grid.m_invDelta.y, grid.m_invDelta.z };
+                const uint32_t count[3] = { grid.m_width, grid.m_height, grid.m_depth };
+
+                TriangleCells& tc = cells[f];
+                tc.m_valid = 1;
+                for (uint32_t i=0; i < 3; ++i)
+                {
+                    if (hi[i] < origin[i] || lo[i] > limit[i])
+                        tc.m_valid = 0;
+
+                    tc.m_min[i] = CellIndex(lo[i], origin[i], invDelta[i], count[i]);
+                    tc.m_max[i] = CellIndex(hi[i], origin[i], invDelta[i], count[i]);
+                }
+            }
+        };
+        thread_pool::parallel_for(pool, numFaces, 4096, computeCells);
+
+        const uint32_t kSlabDepth = VoxelBrick::SIZE;
+        const uint32_t numSlabs = (grid.m_depth + kSlabDepth - 1) / kSlabDepth;
+        const Vec3 halfSize = grid.m_delta * 0.5f;
+
+        auto rasterizeSlabs = [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            for (uint32_t slab=begin; slab < end; ++slab)
+            {
+                const uint32_t slabBegin = slab*kSlabDepth;
+                const uint32_t slabEnd = Min(slabBegin + kSlabDepth, grid.m_depth) - 1;
+
+                for (uint32_t f=0; f < numFaces; ++f)
+                {
+                    const TriangleCells& tc = cells[f];
+                    if (!tc.m_valid || tc.m_max[2] < slabBegin || tc.m_min[2] > slabEnd)
+                        continue;
+
+                    const Vec3& a = vertices[indices[f*3+0]];
+                    const Vec3& b = vertices[indices[f*3+1]];
+                    const Vec3& c = vertices[indices[f*3+2]];
+
+                    const uint32_t zfirst = Max(tc.m_min[2], slabBegin);
+                    const uint32_t zlast = Min(tc.m_max[2], slabEnd);
+                    for (uint32_t z=zfirst; z <= zlast; ++z)
+                    {
+                        for (uint32_t y=tc.m_min[1]; y <= tc.m_max[1]; ++y)
+                        {
+                            for (uint32_t x=tc.m_min[0]; x <= tc.m_max[0]; ++x)
+                            {
+                                if (GetBit(bits, grid, x, y, z))
+                                    continue;
+
+                                const Vec3 center = grid.m_origin + Vec3((x + 0.5f)*grid.m_delta.x, (y + 0.5f)*grid.m_delta.y, (z + 0.5f)*grid.m_delta.z);
+                                if (TriangleBoxOverlap(center, halfSize, a, b, c))
+                                    SetBit(bits, grid, x, y, z);
+                            }
+                        }
+                    }
+                }
+            }
+        };
+        thread_pool::parallel_for(pool, numSlabs, 1, rasterizeSlabs);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    void WriteBytes(array_span_t<u8> bytes, const uint32_t* bits, const VoxelGrid& grid, thread_pool_t* pool)
+    {
+        auto writeRows = [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            for (uint32_t row=begin; row < end; ++row)
+            {
+                const uint32_t* src = bits + row*grid.m_pitch;
+                u8* dst = bytes.begin() + row*grid.m_width;
+                for (uint32_t x=0; x < grid.m_width; ++x)
+                    dst[x] = ((src[x/32] >> (x & 31)) & 1) ? u8(-1) : 0;
+            }
+        };
+        thread_pool::parallel_for(pool, grid.m_height*grid.m_depth, 64, writeRows);
+    }
+
+    void WriteBricks(array_t<VoxelBrick>* bricks, const uint32_t* bits, const VoxelGrid& grid)
+    {
+        const uint32_t N = VoxelBrick::SIZE;
+        const uint32_t bricksX = (grid.m_width + N - 1) / N;
+        const uint32_t bricksY = (grid.m_height + N - 1) / N;
+        const uint32_t bricksZ = (grid.m_depth + N - 1) / N;
+
+        for (uint32_t bz=0; bz < bricksZ; ++bz)
+        {
+            for (uint32_t by=0; by < bricksY; ++by)
+            {
+                for (uint32_t bx=0; bx < bricksX; ++bx)
+                {
+                    VoxelBrick brick = {};
+                    u64 any = 0;
+
+                    const uint32_t x = bx*N;
+                    for (uint32_t lz=0; lz < N && bz*N + lz < grid.m_depth; ++lz)
+                    {
+                        for (uint32_t ly=0; ly < N && by*N + ly < grid.m_height; ++ly)
+                        {
+                            // bits past the width are never set, so no masking is needed
+                            const uint32_t word = bits[((bz*N + lz)*grid.m_height + by*N + ly)*grid.m_pitch + x/32];
+                            brick.bits[lz] |= u64((word >> (x & 31)) & 0xFF) << (ly*N);
+                        }
+                        any |= brick.bits[lz];
+                    }
+
+                    if (!any)
+                        continue;
+
+                    brick.x = u16(bx);
+                    brick.y = u16(by);
+                    brick.z = u16(bz);
+                    array::push_back(*bricks, brick);
+                }
+            }
+        }
+    }
+} // anonymous namespace
+
+void Voxelize( const VoxelizeDesc& desc, const VoxelizeOutput& output, array_span_t<const Vec3> vertices, array_span_t<const u32> indices )
+{
+    if (!desc.width || !desc.height || !desc.depth)
+        return;
+
+    const VoxelGrid grid = MakeGrid(desc);
+    const uint32_t numWords = VoxelBitsSize(desc.width, desc.height, desc.depth);
+
+    std::vector<uint32_t> scratch;
+    uint32_t* bits = nullptr;
+    if (output.bits.size())
+    {
+        SYS_ASSERT(output.bits.size() >= numWords);
+        bits = (uint32_t*)output.bits.begin();
+    }
+    else
+    {
+        scratch.resize(numWords);
+        bits = scratch.data();
+    }
+    memset(bits, 0, numWords*sizeof(uint32_t));
+
+    if (indices.size() >= 3)
+    {
+        if (desc.mode == VoxelizeMode::SURFACE_CONSERVATIVE)
+            VoxelizeSurface(bits, grid, desc.pool, vertices, indices);
+        else
+            VoxelizeSolid(bits, grid, desc.pool, vertices, indices);
+    }
+
+    if (output.bytes.size())
+    {
+        SYS_ASSERT(output.bytes.size() >= desc.width*desc.height*desc.depth);
+        WriteBytes(output.bytes, bits, grid, desc.pool);
+    }
+
+    if (output.bricks)
+        WriteBricks(output.bricks, bits, grid);
+}
+
+void Voxelize( const VoxelizeDesc& desc, const VoxelizeOutput& output, array_span_t<const Vec3> vertices, array_span_t<const u16> indices )
+{
+    std::vector<u32> indices32(indices.begin(), indices.end());
+    Voxelize(desc, output, vertices, array_span_t<const u32>(indices32.data(), (uint32_t)indices32.size()));
+}
+
+void Voxelize( array_span_t<u8> volume, u32 width, u32 height, u32 depth, const AABB& bounds, array_span_t<const Vec3> vertices, array_span_t<const u16> indices )
+{
+    VoxelizeDesc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.depth = depth;
+    desc.bounds = bounds;
+
+    VoxelizeOutput output;
+    output.bytes = volume;
+
+    Voxelize(desc, output, vertices, indices);
 }
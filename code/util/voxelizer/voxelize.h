@@ -34,7 +34,55 @@
 
 using Vec3 = vec3_t;
 
+struct thread_pool_t;
+
+namespace VoxelizeMode
+{
+    enum E : u8
+    {
+        SOLID = 0,            // parity count along z columns, mesh should be closed
+        SURFACE_CONSERVATIVE, // every voxel touched by a triangle
+    };
+}//
+
+struct VoxelBrick
+{
+    static constexpr u32 SIZE = 8; // voxels per axis
+
+    u16 x, y, z;    // brick coords (voxel coords / SIZE)
+    u16 _padding;
+    u64 bits[SIZE]; // one word per z layer, bit index: x + y*SIZE
+};
+
+struct VoxelizeDesc
+{
+    u32 width = 0;
+    u32 height = 0;
+    u32 depth = 0;
+    AABB bounds;
+    VoxelizeMode::E mode = VoxelizeMode::SOLID;
+    thread_pool_t* pool = nullptr; // optional, columns/slabs are split across pool threads
+};
+
+// all outputs are optional and any combination can be requested
+struct VoxelizeOutput
+{
+    array_span_t<u8>     bytes;            // width*height*depth, 0 or 0xFF, index: x + y*width + z*width*height
+    array_span_t<u32>    bits;             // VoxelBitsSize() words, index: VoxelBitIndex()
+    array_t<VoxelBrick>* bricks = nullptr; // non empty bricks are appended
+};
+
+// rows of bit volume are padded to whole words, so threads working on different rows never touch the same word
+inline u32 VoxelBitsPitch( u32 width )                    { return ( width + 31 ) / 32; }
+inline u32 VoxelBitsSize ( u32 width, u32 height, u32 depth ) { return VoxelBitsPitch( width ) * height * depth; }
+inline u32 VoxelBitIndex ( u32 x, u32 y, u32 z, u32 width, u32 height ) { return ( z * height + y ) * VoxelBitsPitch( width ) + x / 32; }
+inline bool VoxelBit( const u32* bits, u32 x, u32 y, u32 z, u32 width, u32 height )
+{
+    return ( bits[VoxelBitIndex( x, y, z, width, height )] >> ( x & 31 ) ) & 1;
+}
+
+void Voxelize( const VoxelizeDesc& desc, const VoxelizeOutput& output, array_span_t<const Vec3> vertices, array_span_t<const u32> indices );
+void Voxelize( const VoxelizeDesc& desc, const VoxelizeOutput& output, array_span_t<const Vec3> vertices, array_span_t<const u16> indices );
+
 // voxelizes a mesh using a single pass parity algorithm
 void Voxelize( array_span_t<u8> volume, u32 width, u32 height, u32 depth, const AABB& bounds, array_span_t<const Vec3> vertices, array_span_t<const u16> indices );
-
-//void Voxelize(const Vec3* vertices, int numVertices, const int* indices, int numTriangleIndices, uint32_t width, uint32_t height, uint32_t depth, uint32_t* volume, Vec3 minExtents, Vec3 maxExtents);
\ No newline at end of file